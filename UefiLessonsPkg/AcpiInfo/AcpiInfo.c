@@ -8,11 +8,90 @@
 #include <Library/UefiLib.h>
 
 #include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
 #include <Protocol/Shell.h>
+#include <Protocol/ShellParameters.h>
 
 EFI_SHELL_PROTOCOL* ShellProtocol;
 
-EFI_STATUS SaveACPITable(UINT32 Signature, VOID* addr, UINTN size) {
+//
+// Archive file layout:
+//   ACPI_ARCHIVE_HEADER
+//   table data, tables follow each other without padding
+//   ACPI_ARCHIVE_ENTRY[TableCount] (at IndexOffset)
+// Use scripts/acpi_archive.py to list/extract the tables on the host.
+//
+#define ACPI_ARCHIVE_SIGNATURE  SIGNATURE_64('A','C','P','I','A','R','C','H')
+#define ACPI_ARCHIVE_VERSION    1
+
+#define ACPI_ARCHIVE_CHECKSUM_INVALID  0
+#define ACPI_ARCHIVE_CHECKSUM_VALID    1
+#define ACPI_ARCHIVE_CHECKSUM_NONE     2   // Table has no checksum (FACS)
+
+#pragma pack(1)
+typedef struct {
+  UINT64 Signature;
+  UINT32 Version;
+  UINT32 TableCount;
+  UINT64 IndexOffset;
+} ACPI_ARCHIVE_HEADER;
+
+typedef struct {
+  UINT32 Signature;
+  UINT32 Index;           // Instance number among the tables with the same signature
+  UINT64 OemTableId;      // 0 for FACS
+  UINT64 Address;
+  UINT64 Offset;          // Table data offset from the start of the file
+  UINT32 Length;
+  UINT8  ChecksumState;
+  UINT8  Reserved[3];
+} ACPI_ARCHIVE_ENTRY;
+#pragma pack()
+
+#define ARCHIVE_WRITE_BUFFER_SIZE  SIZE_64KB
+
+typedef struct {
+  EFI_ACPI_6_3_COMMON_HEADER* Table;
+  UINT32 Index;           // Instance number among the tables with the same signature
+  UINT32 Instances;       // Count of the tables with the same signature
+} ACPI_TABLE_REF;
+
+ACPI_TABLE_REF* Tables;
+UINTN TableCount;
+
+BOOLEAN HasDescriptionHeader(EFI_ACPI_6_3_COMMON_HEADER* table)
+{
+  return (table->Signature != EFI_ACPI_6_3_FIRMWARE_ACPI_CONTROL_STRUCTURE_SIGNATURE);
+}
+
+VOID AddTable(EFI_ACPI_6_3_COMMON_HEADER* table)
+{
+  Tables[TableCount].Table = table;
+  Tables[TableCount].Index = 0;
+  for (UINTN i=0; i<TableCount; i++) {
+    if (Tables[i].Table->Signature == table->Signature) {
+      Tables[TableCount].Index++;
+    }
+  }
+  TableCount++;
+
+  for (UINTN i=0; i<TableCount; i++) {
+    if (Tables[i].Table->Signature == table->Signature) {
+      Tables[i].Instances = Tables[TableCount-1].Index + 1;
+    }
+  }
+}
+
+//
+// Unique tables are saved as <SIGN>.aml, tables with the same signature (like SSDT) as
+// <SIGN>_<index>_<OemTableId>.aml so they don't overwrite each other.
+// In OemTableId every byte that is not an ASCII letter or digit becomes '_', and the trailing
+// non-alphanumeric bytes are dropped. scripts/acpi_archive.py uses the same rule.
+//
+VOID GetTableFileName(ACPI_TABLE_REF* ref, CHAR16* FileName, UINTN FileNameSize)
+{
+  UINT32 Signature = ref->Table->Signature;
   CHAR16 TableName[5];
   TableName[0] = (CHAR16)((Signature>> 0)&0xFF);
   TableName[1] = (CHAR16)((Signature>> 8)&0xFF);
@@ -20,9 +99,29 @@ EFI_STATUS SaveACPITable(UINT32 Signature, VOID* addr, UINTN size) {
   TableName[3] = (CHAR16)((Signature>>24)&0xFF);
   TableName[4] = 0;
 
-  CHAR16 FileName[9] = {0};
-  StrCpyS(FileName, 9, TableName);
-  StrCatS(FileName, 9, L".aml");
+  if ((ref->Instances == 1) || !HasDescriptionHeader(ref->Table)) {
+    UnicodeSPrint(FileName, FileNameSize, L"%s.aml", TableName);
+    return;
+  }
+
+  UINT64 OemTableId = ((EFI_ACPI_DESCRIPTION_HEADER*)ref->Table)->OemTableId;
+  CHAR16 OemTableIdStr[9];
+  UINTN Length = 0;
+  for (UINTN i=0; i<8; i++) {
+    CHAR8 c = (CHAR8)((OemTableId >> (i*8)) & 0xFF);
+    if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9'))) {
+      OemTableIdStr[i] = (CHAR16)c;
+      Length = i + 1;
+    } else {
+      OemTableIdStr[i] = L'_';
+    }
+  }
+  OemTableIdStr[Length] = 0;   // Drop trailing padding
+
+  UnicodeSPrint(FileName, FileNameSize, L"%s_%d_%s.aml", TableName, ref->Index, OemTableIdStr);
+}
+
+EFI_STATUS SaveACPITable(CHAR16* FileName, VOID* addr, UINTN size) {
   SHELL_FILE_HANDLE FileHandle;
   EFI_STATUS Status = ShellProtocol->OpenFileByName(FileName,
                                                     &FileHandle,
@@ -44,6 +143,149 @@ EFI_STATUS SaveACPITable(UINT32 Signature, VOID* addr, UINTN size) {
   return Status;
 }
 
+typedef struct {
+  SHELL_FILE_HANDLE FileHandle;
+  UINT8* Buffer;
+  UINTN Used;
+} ARCHIVE_WRITER;
+
+EFI_STATUS FlushArchive(ARCHIVE_WRITER* Writer)
+{
+  if (Writer->Used == 0) {
+    return EFI_SUCCESS;
+  }
+  UINTN Size = Writer->Used;
+  EFI_STATUS Status = ShellProtocol->WriteFile(Writer->FileHandle, &Size, Writer->Buffer);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error in WriteFile: %r\n", Status);
+    return Status;
+  }
+  if (Size != Writer->Used) {
+    Print(L"Error! Not all data was written\n");
+    return EFI_DEVICE_ERROR;
+  }
+  Writer->Used = 0;
+  return EFI_SUCCESS;
+}
+
+//
+// Copy data to the write buffer and return the byte sum of the copied data, so the
+// table checksum is verified in the same pass
+//
+EFI_STATUS WriteArchive(ARCHIVE_WRITER* Writer, VOID* Data, UINTN Size, UINT8* Sum)
+{
+  UINT8* Src = (UINT8*)Data;
+  UINT8 Acc = 0;
+  while (Size != 0) {
+    UINTN Chunk = MIN(Size, ARCHIVE_WRITE_BUFFER_SIZE - Writer->Used);
+    UINT8* Dst = Writer->Buffer + Writer->Used;
+    for (UINTN i=0; i<Chunk; i++) {
+      Dst[i] = Src[i];
+      Acc += Src[i];
+    }
+    Writer->Used += Chunk;
+    Src += Chunk;
+    Size -= Chunk;
+    if (Writer->Used == ARCHIVE_WRITE_BUFFER_SIZE) {
+      EFI_STATUS Status = FlushArchive(Writer);
+      if (EFI_ERROR(Status)) {
+        return Status;
+      }
+    }
+  }
+  if (Sum != NULL) {
+    *Sum = Acc;
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS SaveACPIArchive(CHAR16* FileName)
+{
+  ACPI_ARCHIVE_HEADER Header;
+  Header.Signature = ACPI_ARCHIVE_SIGNATURE;
+  Header.Version = ACPI_ARCHIVE_VERSION;
+  Header.TableCount = (UINT32)TableCount;
+  Header.IndexOffset = sizeof(ACPI_ARCHIVE_HEADER);
+  for (UINTN i=0; i<TableCount; i++) {
+    Header.IndexOffset += Tables[i].Table->Length;
+  }
+
+  ACPI_ARCHIVE_ENTRY* Entries = AllocateZeroPool(TableCount * sizeof(ACPI_ARCHIVE_ENTRY));
+  ARCHIVE_WRITER Writer;
+  Writer.Used = 0;
+  Writer.Buffer = AllocatePool(ARCHIVE_WRITE_BUFFER_SIZE);
+  if ((Entries == NULL) || (Writer.Buffer == NULL)) {
+    if (Entries != NULL) {
+      FreePool(Entries);
+    }
+    if (Writer.Buffer != NULL) {
+      FreePool(Writer.Buffer);
+    }
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  EFI_STATUS Status = ShellProtocol->OpenFileByName(FileName,
+                                                    &Writer.FileHandle,
+                                                    EFI_FILE_MODE_CREATE |
+                                                    EFI_FILE_MODE_WRITE |
+                                                    EFI_FILE_MODE_READ);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error in OpenFileByName: %r\n", Status);
+    FreePool(Entries);
+    FreePool(Writer.Buffer);
+    return Status;
+  }
+
+  UINTN BadChecksums = 0;
+  Status = WriteArchive(&Writer, &Header, sizeof(Header), NULL);
+  UINT64 Offset = sizeof(ACPI_ARCHIVE_HEADER);
+  for (UINTN i=0; (i<TableCount) && !EFI_ERROR(Status); i++) {
+    EFI_ACPI_6_3_COMMON_HEADER* table = Tables[i].Table;
+    UINT8 Sum;
+    Status = WriteArchive(&Writer, table, table->Length, &Sum);
+
+    Entries[i].Signature = table->Signature;
+    Entries[i].Index = Tables[i].Index;
+    Entries[i].Address = (UINT64)(UINTN)table;
+    Entries[i].Offset = Offset;
+    Entries[i].Length = table->Length;
+    if (HasDescriptionHeader(table)) {
+      Entries[i].OemTableId = ((EFI_ACPI_DESCRIPTION_HEADER*)table)->OemTableId;
+      Entries[i].ChecksumState = (Sum == 0) ? ACPI_ARCHIVE_CHECKSUM_VALID : ACPI_ARCHIVE_CHECKSUM_INVALID;
+    } else {
+      Entries[i].ChecksumState = ACPI_ARCHIVE_CHECKSUM_NONE;
+    }
+    if (Entries[i].ChecksumState == ACPI_ARCHIVE_CHECKSUM_INVALID) {
+      Print(L"Error! %c%c%c%c table #%d has invalid checksum!\n", (CHAR8)((table->Signature>> 0)&0xFF),
+                                                                  (CHAR8)((table->Signature>> 8)&0xFF),
+                                                                  (CHAR8)((table->Signature>>16)&0xFF),
+                                                                  (CHAR8)((table->Signature>>24)&0xFF),
+                                                                  Tables[i].Index);
+      BadChecksums++;
+    }
+    Offset += table->Length;
+  }
+  if (!EFI_ERROR(Status)) {
+    Status = WriteArchive(&Writer, Entries, TableCount * sizeof(ACPI_ARCHIVE_ENTRY), NULL);
+  }
+  if (!EFI_ERROR(Status)) {
+    Status = FlushArchive(&Writer);
+  }
+
+  EFI_STATUS CloseStatus = ShellProtocol->CloseFile(Writer.FileHandle);
+  if (EFI_ERROR(CloseStatus)) {
+    Print(L"Error in CloseFile: %r\n", CloseStatus);
+  }
+
+  if (!EFI_ERROR(Status)) {
+    Print(L"%d tables were saved to %s (%d with invalid checksum)\n", TableCount, FileName, BadChecksums);
+  }
+
+  FreePool(Entries);
+  FreePool(Writer.Buffer);
+  return Status;
+}
+
 
 VOID CheckSubtables(EFI_ACPI_6_3_COMMON_HEADER* table)
 {
@@ -59,7 +301,7 @@ VOID CheckSubtables(EFI_ACPI_6_3_COMMON_HEADER* table)
         ((CHAR8)((DSDT->Signature >> 16) & 0xFF) == 'D') &&
         ((CHAR8)((DSDT->Signature >> 24) & 0xFF) == 'T')) {
       Print(L"\tDSDT table is placed at address %p with length 0x%x\n", DSDT, DSDT->Length);
-      SaveACPITable(DSDT->Signature, DSDT, DSDT->Length);
+      AddTable(DSDT);
     } else {
       Print(L"\tError! DSDT signature is not valid!\n");
     }
@@ -70,13 +312,20 @@ VOID CheckSubtables(EFI_ACPI_6_3_COMMON_HEADER* table)
         ((CHAR8)((FACS->Signature >> 16) & 0xFF) == 'C') &&
         ((CHAR8)((FACS->Signature >> 24) & 0xFF) == 'S')) {
       Print(L"\tFACS table is placed at address %p with length 0x%x\n", FACS, FACS->Length);
-      SaveACPITable(FACS->Signature, FACS, FACS->Length);
+      AddTable(FACS);
     } else {
       Print(L"\tError! FACS signature is not valid!\n");
     }
   }
 }
 
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"AcpiInfo.efi                    - save every ACPI table to a separate file\n");
+  Print(L"AcpiInfo.efi archive [<file>]   - save all ACPI tables to a single archive file\n");
+}
+
 
 EFI_STATUS
 EFIAPI
@@ -96,6 +345,28 @@ UefiMain (
     return EFI_SUCCESS;
   }
 
+  EFI_SHELL_PARAMETERS_PROTOCOL* ShellParameters;
+  Status = gBS->HandleProtocol(
+    ImageHandle,
+    &gEfiShellParametersProtocolGuid,
+    (VOID **) &ShellParameters
+  );
+
+  CHAR16* ArchiveName = NULL;
+  if (Status == EFI_SUCCESS) {
+    if ((ShellParameters->Argc >= 2) && !StrCmp(ShellParameters->Argv[1], L"archive")) {
+      if (ShellParameters->Argc == 2) {
+        ArchiveName = L"acpi.bin";
+      } else if (ShellParameters->Argc == 3) {
+        ArchiveName = ShellParameters->Argv[2];
+      }
+    }
+    if ((ShellParameters->Argc > 1) && (ArchiveName == NULL)) {
+      Usage();
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
   EFI_ACPI_6_3_ROOT_SYSTEM_DESCRIPTION_POINTER* RSDP = NULL;
 
   for (UINTN i=0; i<SystemTable->NumberOfTableEntries; i++) {
@@ -136,6 +407,15 @@ UefiMain (
     return EFI_SUCCESS;
   }
 
+  // Every XSDT entry plus DSDT and FACS for an entry that is FADT
+  UINTN MaxTables = (XSDT->Length - sizeof(EFI_ACPI_DESCRIPTION_HEADER)) / sizeof(UINT64) * 3;
+  Tables = AllocateZeroPool(MaxTables * sizeof(ACPI_TABLE_REF));
+  if (Tables == NULL) {
+    Print(L"Error! Can't allocate memory for the table list\n");
+    return EFI_OUT_OF_RESOURCES;
+  }
+  TableCount = 0;
+
   Print(L"Main ACPI tables:\n");
   UINT64 offset = sizeof(EFI_ACPI_DESCRIPTION_HEADER);
   while (offset < XSDT->Length) {
@@ -149,12 +429,24 @@ UefiMain (
                                              table,
                                              table->Length);
 
-    SaveACPITable(table->Signature, table, table->Length);
+    AddTable(table);
 
     CheckSubtables(table);
 
     offset += sizeof(UINT64);
   }
 
+  if (ArchiveName != NULL) {
+    Print(L"\n");
+    SaveACPIArchive(ArchiveName);
+  } else {
+    for (UINTN i=0; i<TableCount; i++) {
+      CHAR16 FileName[30];
+      GetTableFileName(&Tables[i], FileName, sizeof(FileName));
+      SaveACPITable(FileName, Tables[i].Table, Tables[i].Table->Length);
+    }
+  }
+
+  FreePool(Tables);
   return EFI_SUCCESS;
 }
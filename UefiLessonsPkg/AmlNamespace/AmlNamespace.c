@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/BenchmarkLib.h>
+#include <Library/SaveFileLib.h>
+
+#include <IndustryStandard/Acpi.h>
+
+#include "AmlParser.h"
+
+#define LINE_SIZE  256
+
+typedef struct {
+  CHAR8    *Buffer;       // NULL if output goes to the console
+  UINTN    Size;
+  UINTN    Capacity;
+  BOOLEAN  Error;
+} OUTPUT;
+
+VOID Output(OUTPUT* Out, CHAR8* Line, UINTN Length)
+{
+  if (Out->Buffer == NULL) {
+    AsciiPrint("%a", Line);
+    return;
+  }
+  if (Out->Error) {
+    return;
+  }
+  if (Out->Size + Length > Out->Capacity) {
+    UINTN NewCapacity = Out->Capacity * 2;
+    while (Out->Size + Length > NewCapacity) {
+      NewCapacity *= 2;
+    }
+    CHAR8* NewBuffer = ReallocatePool(Out->Capacity, NewCapacity, Out->Buffer);
+    if (NewBuffer == NULL) {
+      Out->Error = TRUE;
+      return;
+    }
+    Out->Buffer = NewBuffer;
+    Out->Capacity = NewCapacity;
+  }
+  CopyMem(Out->Buffer + Out->Size, Line, Length);
+  Out->Size += Length;
+}
+
+VOID
+PrintNode (
+  IN AML_NODE  *Node,
+  IN UINTN     Depth,
+  IN VOID      *Context
+  )
+{
+  CHAR8 Line[LINE_SIZE];
+  CHAR8 Name[5];
+  CopyMem(Name, &Node->Name, 4);
+  Name[4] = 0;
+
+  UINTN Indent = MIN(Depth * 2, 64);
+  SetMem(Line, Indent, ' ');
+  UINTN Length = Indent;
+  Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, "%a %a", Name, AmlNodeTypeName(Node->Type));
+
+  switch (Node->Type) {
+    case AmlNodeMethod:
+      Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, " Args=%d%a%a",
+                            Node->Flags & 0x07,
+                            (Node->Flags & BIT3) ? " Serialized" : "",
+                            (Node->Body == NULL) ? " (external)" : "");
+      break;
+    case AmlNodeOpRegion:
+      Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, " %a", AmlRegionSpaceName(Node->Flags));
+      if (Node->Value.Type == AmlValueInteger) {
+        Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, " Offset=0x%lx", Node->Value.Integer);
+      }
+      Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, " Length=0x%lx", Node->Length);
+      break;
+    case AmlNodeField:
+    case AmlNodeBufferField:
+      CopyMem(Name, &Node->Region, 4);
+      Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, " %a BitOffset=0x%lx Width=%ld",
+                            (Node->Type == AmlNodeField) ? Name : "",
+                            Node->Offset,
+                            Node->Length);
+      break;
+    case AmlNodeName:
+      switch (Node->Value.Type) {
+        case AmlValueInteger:
+          Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, " 0x%lx", Node->Value.Integer);
+          break;
+        case AmlValueString:
+          Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, " \"%a\"", Node->Value.String);
+          break;
+        case AmlValueBuffer:
+          Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, " Buffer(%ld)", Node->Value.Integer);
+          break;
+        case AmlValuePackage:
+          Length += AsciiSPrint(&Line[Length], LINE_SIZE - Length, " Package(%ld)", Node->Value.Integer);
+          break;
+      }
+      break;
+  }
+
+  if (Length > LINE_SIZE - 2) {
+    Length = LINE_SIZE - 2;
+  }
+  Line[Length++] = '\n';
+  Line[Length] = 0;
+  Output((OUTPUT*)Context, Line, Length);
+}
+
+UINTN LoadTables(AML_NAMESPACE* Ns, UINT32 Signature)
+{
+  UINTN Count = AcpiTableIndexCount(Signature);
+  for (UINTN i = 0; i < Count; i++) {
+    EFI_ACPI_DESCRIPTION_HEADER* Table = (EFI_ACPI_DESCRIPTION_HEADER*)AcpiTableIndexFind(Signature, i);
+    if (Table != NULL) {
+      AmlNamespaceLoadTable(Ns, Table);
+    }
+  }
+  return Count;
+}
+
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"  AmlNamespace [-m] [-o <file>]\n");
+  Print(L"    -m         decode method bodies and show objects declared inside methods\n");
+  Print(L"    -o <file>  save namespace to the file instead of printing it\n");
+}
+
+INTN EFIAPI ShellAppMain(IN UINTN Argc, IN CHAR16 **Argv)
+{
+  BOOLEAN DecodeMethods = FALSE;
+  CHAR16* FileName = NULL;
+  for (UINTN i = 1; i < Argc; i++) {
+    if (!StrCmp(Argv[i], L"-m")) {
+      DecodeMethods = TRUE;
+    } else if (!StrCmp(Argv[i], L"-o") && ((i + 1) < Argc)) {
+      FileName = Argv[++i];
+    } else {
+      Usage();
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  EFI_STATUS Status = AcpiTableIndexInit();
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't find ACPI tables: %r\n", Status);
+    return Status;
+  }
+
+  AML_NAMESPACE Ns;
+  Status = AmlNamespaceInit(&Ns);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't initialize namespace: %r\n", Status);
+    return Status;
+  }
+
+  UINT64 Start = BenchmarkGetTicks();
+  if (LoadTables(&Ns, EFI_ACPI_6_3_DIFFERENTIATED_SYSTEM_DESCRIPTION_TABLE_SIGNATURE) == 0) {
+    Print(L"Error! DSDT is not found\n");
+  }
+  LoadTables(&Ns, EFI_ACPI_6_3_SECONDARY_SYSTEM_DESCRIPTION_TABLE_SIGNATURE);
+  if (DecodeMethods) {
+    AmlNamespaceDecodeMethods(&Ns);
+  }
+  UINT64 ParseTime = BenchmarkTicksToNs(BenchmarkGetTicks() - Start);
+
+  OUTPUT Out;
+  ZeroMem(&Out, sizeof(Out));
+  if (FileName != NULL) {
+    Out.Capacity = SIZE_64KB;
+    Out.Buffer = AllocatePool(Out.Capacity);
+    if (Out.Buffer == NULL) {
+      Print(L"Error! Can't allocate output buffer\n");
+      AmlNamespaceFree(&Ns);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  AmlNamespaceWalk(&Ns, PrintNode, &Out);
+
+  if (FileName != NULL) {
+    if (Out.Error) {
+      Print(L"Error! Not enough memory for the output\n");
+      Status = EFI_OUT_OF_RESOURCES;
+    } else {
+      Status = SaveFile(FileName, Out.Buffer, &Out.Size);
+    }
+    FreePool(Out.Buffer);
+  }
+
+  Print(L"Objects: %d, tables: %d, methods: %d (decoded %d), errors: %d, parse time: %ld us\n",
+        Ns.NodeCount,
+        Ns.TableCount,
+        Ns.MethodCount,
+        Ns.MethodsDecoded,
+        Ns.ErrorCount,
+        DivU64x32(ParseTime, 1000));
+
+  AmlNamespaceFree(&Ns);
+  return Status;
+}
@@ -0,0 +1,1134 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include "AmlParser.h"
+
+#define AML_NODE_CHUNK_SIZE  512
+#define AML_HASH_SIZE        4096       // Must be a power of 2
+#define AML_MAX_DEPTH        64         // Max nesting of the terms
+
+struct _AML_NODE_CHUNK {
+  AML_NODE_CHUNK  *Next;
+  AML_NODE        Nodes[AML_NODE_CHUNK_SIZE];
+};
+
+typedef struct {
+  AML_NAMESPACE   *Ns;
+  CONST UINT8     *Cur;
+  CONST UINT8     *End;
+  AML_NODE        *Scope;
+  UINTN           Depth;
+} AML_PARSER;
+
+typedef struct {
+  BOOLEAN         Root;
+  UINTN           Parents;
+  UINTN           SegCount;
+  CONST UINT8     *Segs;
+} AML_NAME;
+
+//
+// Operand encoding of the opcodes that don't declare named objects:
+//   b/w/d/q - byte/word/dword/qword data
+//   s       - null-terminated string
+//   n       - NameString
+//   t       - TermArg
+//   S       - SuperName/Target
+//   p       - PkgLength, the following operands are limited by the package
+//   L       - TermList till the end of the package
+//   *       - skip till the end of the package
+//
+typedef struct {
+  UINT8         Opcode;
+  CONST CHAR8   *Operands;
+} AML_OPCODE_INFO;
+
+STATIC CONST AML_OPCODE_INFO mOpcodes[] = {
+  { 0x00, ""       },  // Zero
+  { 0x01, ""       },  // One
+  { 0x0A, "b"      },  // BytePrefix
+  { 0x0B, "w"      },  // WordPrefix
+  { 0x0C, "d"      },  // DWordPrefix
+  { 0x0D, "s"      },  // StringPrefix
+  { 0x0E, "q"      },  // QWordPrefix
+  { 0x11, "pt*"    },  // Buffer
+  { 0x12, "pb*"    },  // Package
+  { 0x13, "pt*"    },  // VarPackage
+  { 0x70, "tS"     },  // Store
+  { 0x71, "S"      },  // RefOf
+  { 0x72, "ttS"    },  // Add
+  { 0x73, "ttS"    },  // Concat
+  { 0x74, "ttS"    },  // Subtract
+  { 0x75, "S"      },  // Increment
+  { 0x76, "S"      },  // Decrement
+  { 0x77, "ttS"    },  // Multiply
+  { 0x78, "ttSS"   },  // Divide
+  { 0x79, "ttS"    },  // ShiftLeft
+  { 0x7A, "ttS"    },  // ShiftRight
+  { 0x7B, "ttS"    },  // And
+  { 0x7C, "ttS"    },  // Nand
+  { 0x7D, "ttS"    },  // Or
+  { 0x7E, "ttS"    },  // Nor
+  { 0x7F, "ttS"    },  // Xor
+  { 0x80, "tS"     },  // Not
+  { 0x81, "tS"     },  // FindSetLeftBit
+  { 0x82, "tS"     },  // FindSetRightBit
+  { 0x83, "t"      },  // DerefOf
+  { 0x84, "ttS"    },  // ConcatRes
+  { 0x85, "ttS"    },  // Mod
+  { 0x86, "St"     },  // Notify
+  { 0x87, "S"      },  // SizeOf
+  { 0x88, "ttS"    },  // Index
+  { 0x89, "tbtbtt" },  // Match
+  { 0x8E, "S"      },  // ObjectType
+  { 0x90, "tt"     },  // LAnd
+  { 0x91, "tt"     },  // LOr
+  { 0x92, "t"      },  // LNot
+  { 0x93, "tt"     },  // LEqual
+  { 0x94, "tt"     },  // LGreater
+  { 0x95, "tt"     },  // LLess
+  { 0x96, "tS"     },  // ToBuffer
+  { 0x97, "tS"     },  // ToDecimalString
+  { 0x98, "tS"     },  // ToHexString
+  { 0x99, "tS"     },  // ToInteger
+  { 0x9C, "ttS"    },  // ToString
+  { 0x9D, "tS"     },  // CopyObject
+  { 0x9E, "tttS"   },  // Mid
+  { 0x9F, ""       },  // Continue
+  { 0xA0, "ptL"    },  // If
+  { 0xA1, "pL"     },  // Else
+  { 0xA2, "ptL"    },  // While
+  { 0xA3, ""       },  // Noop
+  { 0xA4, "t"      },  // Return
+  { 0xA5, ""       },  // Break
+  { 0xCC, ""       },  // BreakPoint
+  { 0xFF, ""       },  // Ones
+};
+
+STATIC CONST AML_OPCODE_INFO mExtOpcodes[] = {
+  { 0x12, "SS"     },  // CondRefOf
+  { 0x1F, "tttttt" },  // LoadTable
+  { 0x20, "nS"     },  // Load
+  { 0x21, "t"      },  // Stall
+  { 0x22, "t"      },  // Sleep
+  { 0x23, "Sw"     },  // Acquire
+  { 0x24, "S"      },  // Signal
+  { 0x25, "St"     },  // Wait
+  { 0x26, "S"      },  // Reset
+  { 0x27, "S"      },  // Release
+  { 0x28, "tS"     },  // FromBCD
+  { 0x29, "tS"     },  // ToBCD
+  { 0x2A, "S"      },  // Unload
+  { 0x30, ""       },  // Revision
+  { 0x31, ""       },  // Debug
+  { 0x32, "bdt"    },  // Fatal
+  { 0x33, ""       },  // Timer
+};
+
+STATIC CONST CHAR8* mOperands[256];
+STATIC CONST CHAR8* mExtOperands[256];
+
+STATIC CONST CHAR8* mNodeTypeNames[AmlNodeTypeMax] = {
+  "Scope",
+  "Device",
+  "Method",
+  "Name",
+  "OperationRegion",
+  "Field",
+  "Processor",
+  "PowerResource",
+  "ThermalZone",
+  "Mutex",
+  "Event",
+  "Alias",
+  "BufferField",
+  "External",
+  "DataRegion",
+};
+
+STATIC CONST CHAR8* mRegionSpaceNames[] = {
+  "SystemMemory",
+  "SystemIO",
+  "PCI_Config",
+  "EmbeddedControl",
+  "SMBus",
+  "SystemCMOS",
+  "PciBarTarget",
+  "IPMI",
+  "GeneralPurposeIO",
+  "GenericSerialBus",
+  "PCC",
+};
+
+CONST CHAR8*
+AmlNodeTypeName (
+  IN UINT8  Type
+  )
+{
+  return (Type < AmlNodeTypeMax) ? mNodeTypeNames[Type] : "Unknown";
+}
+
+CONST CHAR8*
+AmlRegionSpaceName (
+  IN UINT8  Space
+  )
+{
+  if (Space < ARRAY_SIZE(mRegionSpaceNames)) {
+    return mRegionSpaceNames[Space];
+  }
+  return (Space == 0x7F) ? "FFixedHW" : "OEM";
+}
+
+//
+// Namespace nodes
+//
+
+STATIC
+UINTN
+NodeHash (
+  IN AML_NODE  *Parent,
+  IN UINT32    Name
+  )
+{
+  UINT64 Key = ((UINT64)(UINTN)Parent >> 4) ^ MultU64x32(Name, 0x9E3779B1);
+  return (UINTN)(Key ^ RShiftU64(Key, 17)) & (AML_HASH_SIZE - 1);
+}
+
+STATIC
+AML_NODE*
+FindChild (
+  IN AML_NAMESPACE  *Ns,
+  IN AML_NODE       *Parent,
+  IN UINT32         Name
+  )
+{
+  AML_NODE* Node = Ns->Hash[NodeHash(Parent, Name)];
+  while ((Node != NULL) && ((Node->Parent != Parent) || (Node->Name != Name))) {
+    Node = Node->HashNext;
+  }
+  return Node;
+}
+
+STATIC
+AML_NODE*
+AllocateNode (
+  IN AML_NAMESPACE  *Ns
+  )
+{
+  if ((Ns->Chunks == NULL) || (Ns->ChunkUsed == AML_NODE_CHUNK_SIZE)) {
+    AML_NODE_CHUNK* Chunk = AllocatePool(sizeof(AML_NODE_CHUNK));
+    if (Chunk == NULL) {
+      return NULL;
+    }
+    Chunk->Next = Ns->Chunks;
+    Ns->Chunks = Chunk;
+    Ns->ChunkUsed = 0;
+  }
+  AML_NODE* Node = &Ns->Chunks->Nodes[Ns->ChunkUsed++];
+  ZeroMem(Node, sizeof(AML_NODE));
+  return Node;
+}
+
+STATIC
+AML_NODE*
+AddChild (
+  IN AML_NAMESPACE  *Ns,
+  IN AML_NODE       *Parent,
+  IN UINT32         Name,
+  IN UINT8          Type
+  )
+{
+  AML_NODE* Node = FindChild(Ns, Parent, Name);
+  if (Node != NULL) {
+    // Scope/External only declare that the object exists, the real definition wins
+    if ((Node->Type == AmlNodeScope) || (Node->Type == AmlNodeExternal)) {
+      Node->Type = Type;
+    }
+    return Node;
+  }
+
+  Node = AllocateNode(Ns);
+  if (Node == NULL) {
+    return NULL;
+  }
+  Node->Name = Name;
+  Node->Type = Type;
+  Node->Parent = Parent;
+  if (Parent != NULL) {
+    if (Parent->LastChild == NULL) {
+      Parent->FirstChild = Node;
+    } else {
+      Parent->LastChild->Next = Node;
+    }
+    Parent->LastChild = Node;
+  }
+
+  UINTN Bucket = NodeHash(Parent, Name);
+  Node->HashNext = Ns->Hash[Bucket];
+  Ns->Hash[Bucket] = Node;
+  Ns->NodeCount++;
+  return Node;
+}
+
+STATIC
+UINT32
+NameSeg (
+  IN CONST UINT8  *Seg
+  )
+{
+  return ReadUnaligned32((CONST UINT32*)Seg);
+}
+
+STATIC
+AML_NODE*
+StartNode (
+  IN AML_PARSER  *Parser,
+  IN AML_NAME    *Name
+  )
+{
+  AML_NODE* Node = Name->Root ? Parser->Ns->Root : Parser->Scope;
+  for (UINTN i = 0; (i < Name->Parents) && (Node->Parent != NULL); i++) {
+    Node = Node->Parent;
+  }
+  return Node;
+}
+
+//
+// Get the node for the object declaration. Missing path components are created as scopes.
+//
+STATIC
+AML_NODE*
+DeclareNode (
+  IN AML_PARSER  *Parser,
+  IN AML_NAME    *Name,
+  IN UINT8       Type
+  )
+{
+  AML_NODE* Node = StartNode(Parser, Name);
+  if (Name->SegCount == 0) {
+    return Node;
+  }
+  for (UINTN i = 0; (i + 1 < Name->SegCount) && (Node != NULL); i++) {
+    Node = AddChild(Parser->Ns, Node, NameSeg(Name->Segs + i * 4), AmlNodeScope);
+  }
+  if (Node == NULL) {
+    return NULL;
+  }
+  return AddChild(Parser->Ns, Node, NameSeg(Name->Segs + (Name->SegCount - 1) * 4), Type);
+}
+
+//
+// Find the referenced object. Single segment relative names are searched
+// in the current scope and all its parents.
+//
+STATIC
+AML_NODE*
+LookupNode (
+  IN AML_PARSER  *Parser,
+  IN AML_NAME    *Name
+  )
+{
+  if (Name->SegCount == 0) {
+    return NULL;
+  }
+
+  AML_NODE* Node;
+  if (!Name->Root && (Name->Parents == 0) && (Name->SegCount == 1)) {
+    UINT32 Seg = NameSeg(Name->Segs);
+    for (AML_NODE* Scope = Parser->Scope; Scope != NULL; Scope = Scope->Parent) {
+      Node = FindChild(Parser->Ns, Scope, Seg);
+      if (Node != NULL) {
+        return Node;
+      }
+    }
+    return NULL;
+  }
+
+  Node = StartNode(Parser, Name);
+  for (UINTN i = 0; (i < Name->SegCount) && (Node != NULL); i++) {
+    Node = FindChild(Parser->Ns, Node, NameSeg(Name->Segs + i * 4));
+  }
+  return Node;
+}
+
+//
+// Encoding primitives
+//
+
+STATIC
+BOOLEAN
+IsLeadNameChar (
+  IN UINT8  c
+  )
+{
+  return ((c >= 'A') && (c <= 'Z')) || (c == '_');
+}
+
+STATIC
+BOOLEAN
+IsNameStringStart (
+  IN UINT8  c
+  )
+{
+  return IsLeadNameChar(c) || (c == '\\') || (c == '^') || (c == 0x2E) || (c == 0x2F);
+}
+
+STATIC
+BOOLEAN
+ParseBytes (
+  IN  AML_PARSER  *Parser,
+  IN  UINTN       Count,
+  OUT UINT64      *Value
+  )
+{
+  if ((UINTN)(Parser->End - Parser->Cur) < Count) {
+    return FALSE;
+  }
+  UINT64 Result = 0;
+  for (UINTN i = 0; i < Count; i++) {
+    Result |= LShiftU64(Parser->Cur[i], i * 8);
+  }
+  Parser->Cur += Count;
+  if (Value != NULL) {
+    *Value = Result;
+  }
+  return TRUE;
+}
+
+//
+// PkgLength value. For the packages the length includes the PkgLength bytes themselves.
+//
+STATIC
+BOOLEAN
+ParsePkgLength (
+  IN  AML_PARSER  *Parser,
+  OUT UINT32      *Length
+  )
+{
+  if (Parser->Cur >= Parser->End) {
+    return FALSE;
+  }
+  UINT8 Lead = *Parser->Cur++;
+  UINTN Count = Lead >> 6;
+  if (Count == 0) {
+    *Length = Lead & 0x3F;
+    return TRUE;
+  }
+  if (((Lead & 0x30) != 0) || ((UINTN)(Parser->End - Parser->Cur) < Count)) {
+    return FALSE;
+  }
+  UINT32 Result = Lead & 0x0F;
+  for (UINTN i = 0; i < Count; i++) {
+    Result |= (UINT32)Parser->Cur[i] << (4 + i * 8);
+  }
+  Parser->Cur += Count;
+  *Length = Result;
+  return TRUE;
+}
+
+STATIC
+BOOLEAN
+ParsePackage (
+  IN  AML_PARSER   *Parser,
+  OUT CONST UINT8  **PkgEnd
+  )
+{
+  CONST UINT8* Start = Parser->Cur;
+  UINT32 Length;
+  if (!ParsePkgLength(Parser, &Length)) {
+    return FALSE;
+  }
+  if ((Length < (UINT32)(Parser->Cur - Start)) || (Length > (UINTN)(Parser->End - Start))) {
+    return FALSE;
+  }
+  *PkgEnd = Start + Length;
+  return TRUE;
+}
+
+STATIC
+BOOLEAN
+ParseNameString (
+  IN  AML_PARSER  *Parser,
+  OUT AML_NAME    *Name
+  )
+{
+  ZeroMem(Name, sizeof(AML_NAME));
+  if (Parser->Cur >= Parser->End) {
+    return FALSE;
+  }
+  if (*Parser->Cur == '\\') {
+    Name->Root = TRUE;
+    Parser->Cur++;
+  } else {
+    while ((Parser->Cur < Parser->End) && (*Parser->Cur == '^')) {
+      Name->Parents++;
+      Parser->Cur++;
+    }
+  }
+  if (Parser->Cur >= Parser->End) {
+    return FALSE;
+  }
+
+  UINT8 c = *Parser->Cur;
+  if (c == 0x00) {            // NullName
+    Parser->Cur++;
+    return TRUE;
+  } else if (c == 0x2E) {     // DualNamePrefix
+    Name->SegCount = 2;
+    Parser->Cur++;
+  } else if (c == 0x2F) {     // MultiNamePrefix
+    if ((UINTN)(Parser->End - Parser->Cur) < 2) {
+      return FALSE;
+    }
+    Name->SegCount = Parser->Cur[1];
+    Parser->Cur += 2;
+  } else if (IsLeadNameChar(c)) {
+    Name->SegCount = 1;
+  } else {
+    return FALSE;
+  }
+
+  if ((UINTN)(Parser->End - Parser->Cur) < Name->SegCount * 4) {
+    return FALSE;
+  }
+  Name->Segs = Parser->Cur;
+  Parser->Cur += Name->SegCount * 4;
+  return TRUE;
+}
+
+//
+// Terms
+//
+
+STATIC
+BOOLEAN
+ParseTerm (
+  IN  AML_PARSER  *Parser,
+  OUT AML_VALUE   *Value
+  );
+
+STATIC
+VOID
+ParseTermList (
+  IN AML_PARSER   *Parser,
+  IN CONST UINT8  *End,
+  IN AML_NODE     *Scope
+  )
+{
+  CONST UINT8* SavedEnd = Parser->End;
+  AML_NODE* SavedScope = Parser->Scope;
+  Parser->End = End;
+  Parser->Scope = Scope;
+
+  while (Parser->Cur < End) {
+    if (!ParseTerm(Parser, NULL)) {
+      //
+      // All the lists are limited by the package length, so the rest of the
+      // list is skipped and parsing continues after it
+      //
+      Parser->Ns->ErrorCount++;
+      break;
+    }
+  }
+
+  Parser->Cur = End;
+  Parser->End = SavedEnd;
+  Parser->Scope = SavedScope;
+}
+
+STATIC
+BOOLEAN
+ParseSuperName (
+  IN AML_PARSER  *Parser
+  )
+{
+  if ((Parser->Cur < Parser->End) && IsNameStringStart(*Parser->Cur)) {
+    AML_NAME Name;
+    return ParseNameString(Parser, &Name);
+  }
+  return ParseTerm(Parser, NULL);
+}
+
+STATIC
+BOOLEAN
+ParseOperands (
+  IN  AML_PARSER   *Parser,
+  IN  CONST CHAR8  *Operands,
+  OUT AML_VALUE    *Value
+  )
+{
+  CONST UINT8* PkgEnd = Parser->End;
+  CONST UINT8* SavedEnd = Parser->End;
+  BOOLEAN Result = TRUE;
+  BOOLEAN Captured = (Value == NULL);
+  AML_NAME Name;
+  AML_VALUE Operand;
+
+  for (; (*Operands != '\0') && Result; Operands++) {
+    Operand.Integer = 0;
+    Operand.String = NULL;
+    switch (*Operands) {
+      case 'b':
+        Result = ParseBytes(Parser, 1, &Operand.Integer);
+        break;
+      case 'w':
+        Result = ParseBytes(Parser, 2, &Operand.Integer);
+        break;
+      case 'd':
+        Result = ParseBytes(Parser, 4, &Operand.Integer);
+        break;
+      case 'q':
+        Result = ParseBytes(Parser, 8, &Operand.Integer);
+        break;
+      case 's':
+        Operand.String = (CONST CHAR8*)Parser->Cur;
+        while ((Parser->Cur < Parser->End) && (*Parser->Cur != 0)) {
+          Parser->Cur++;
+        }
+        Result = (Parser->Cur < Parser->End);
+        Parser->Cur++;
+        break;
+      case 'n':
+        Result = ParseNameString(Parser, &Name);
+        break;
+      case 't':
+        Result = ParseTerm(Parser, &Operand);
+        break;
+      case 'S':
+        Result = ParseSuperName(Parser);
+        break;
+      case 'p':
+        Result = ParsePackage(Parser, &PkgEnd);
+        Parser->End = PkgEnd;
+        continue;
+      case 'L':
+        ParseTermList(Parser, PkgEnd, Parser->Scope);
+        continue;
+      case '*':
+        Parser->Cur = PkgEnd;
+        continue;
+    }
+    //
+    // The first operand is the value of the data objects: integer, string,
+    // buffer size or package element count
+    //
+    if (!Captured) {
+      Value->Integer = Operand.Integer;
+      Value->String = Operand.String;
+      Captured = TRUE;
+    }
+  }
+
+  Parser->End = SavedEnd;
+  return Result;
+}
+
+STATIC
+BOOLEAN
+ParseFieldList (
+  IN AML_PARSER   *Parser,
+  IN CONST UINT8  *End,
+  IN UINT32       Region,
+  IN UINT8        Flags
+  )
+{
+  CONST UINT8* SavedEnd = Parser->End;
+  Parser->End = End;
+
+  UINT64 BitOffset = 0;
+  BOOLEAN Result = TRUE;
+  while ((Parser->Cur < End) && Result) {
+    UINT8 c = *Parser->Cur;
+    UINT32 Length;
+    if (c == 0x00) {                        // ReservedField
+      Parser->Cur++;
+      Result = ParsePkgLength(Parser, &Length);
+      BitOffset += Length;
+    } else if (c == 0x01) {                 // AccessField
+      Result = ParseBytes(Parser, 3, NULL);
+    } else if (c == 0x03) {                 // ExtendedAccessField
+      Result = ParseBytes(Parser, 4, NULL);
+    } else if (c == 0x02) {                 // ConnectField
+      Parser->Cur++;
+      if ((Parser->Cur < End) && (*Parser->Cur == 0x11)) {
+        CONST UINT8* PkgEnd;
+        Parser->Cur++;
+        Result = ParsePackage(Parser, &PkgEnd);
+        Parser->Cur = PkgEnd;
+      } else {
+        AML_NAME Name;
+        Result = ParseNameString(Parser, &Name);
+      }
+    } else if (IsLeadNameChar(c) && ((UINTN)(End - Parser->Cur) >= 4)) {    // NamedField
+      UINT32 Seg = NameSeg(Parser->Cur);
+      Parser->Cur += 4;
+      Result = ParsePkgLength(Parser, &Length);
+      if (Result) {
+        AML_NODE* Node = AddChild(Parser->Ns, Parser->Scope, Seg, AmlNodeField);
+        if (Node != NULL) {
+          Node->Region = Region;
+          Node->Flags = Flags;
+          Node->Offset = BitOffset;
+          Node->Length = Length;
+        }
+        BitOffset += Length;
+      }
+    } else {
+      Result = FALSE;
+    }
+  }
+
+  Parser->Cur = End;
+  Parser->End = SavedEnd;
+  return Result;
+}
+
+//
+// Objects that have a TermList and open a new scope: Scope, Device, Processor,
+// PowerResource, ThermalZone
+//
+STATIC
+BOOLEAN
+ParseScopeObject (
+  IN AML_PARSER  *Parser,
+  IN UINT8       Type,
+  IN UINTN       FixedBytes
+  )
+{
+  CONST UINT8* PkgEnd;
+  AML_NAME Name;
+  if (!ParsePackage(Parser, &PkgEnd)) {
+    return FALSE;
+  }
+  CONST UINT8* SavedEnd = Parser->End;
+  Parser->End = PkgEnd;
+  BOOLEAN Result = ParseNameString(Parser, &Name) && ParseBytes(Parser, FixedBytes, NULL);
+  Parser->End = SavedEnd;
+  if (!Result) {
+    return FALSE;
+  }
+
+  AML_NODE* Node = DeclareNode(Parser, &Name, Type);
+  if (Node == NULL) {
+    return FALSE;
+  }
+  ParseTermList(Parser, PkgEnd, Node);
+  return TRUE;
+}
+
+STATIC
+BOOLEAN
+ParseExtOpcode (
+  IN  AML_PARSER  *Parser,
+  OUT AML_VALUE   *Value
+  )
+{
+  if (Parser->Cur >= Parser->End) {
+    return FALSE;
+  }
+  UINT8 Opcode = *Parser->Cur++;
+  AML_NAME Name;
+  AML_NAME Name2;
+  AML_NODE* Node;
+  CONST UINT8* PkgEnd;
+  CONST UINT8* SavedEnd;
+  AML_VALUE Offset;
+  AML_VALUE Length;
+  UINT64 Flags;
+  BOOLEAN Result;
+
+  switch (Opcode) {
+    case 0x01:    // Mutex
+      if (!ParseNameString(Parser, &Name) || !ParseBytes(Parser, 1, NULL)) {
+        return FALSE;
+      }
+      return (DeclareNode(Parser, &Name, AmlNodeMutex) != NULL);
+    case 0x02:    // Event
+      if (!ParseNameString(Parser, &Name)) {
+        return FALSE;
+      }
+      return (DeclareNode(Parser, &Name, AmlNodeEvent) != NULL);
+    case 0x13:    // CreateField
+      if (!ParseTerm(Parser, NULL) || !ParseTerm(Parser, &Offset) || !ParseTerm(Parser, &Length) ||
+          !ParseNameString(Parser, &Name)) {
+        return FALSE;
+      }
+      Node = DeclareNode(Parser, &Name, AmlNodeBufferField);
+      if (Node != NULL) {
+        Node->Offset = (Offset.Type == AmlValueInteger) ? Offset.Integer : 0;
+        Node->Length = (Length.Type == AmlValueInteger) ? Length.Integer : 0;
+      }
+      return (Node != NULL);
+    case 0x80:    // OpRegion
+      if (!ParseNameString(Parser, &Name) || !ParseBytes(Parser, 1, &Flags) ||
+          !ParseTerm(Parser, &Offset) || !ParseTerm(Parser, &Length)) {
+        return FALSE;
+      }
+      Node = DeclareNode(Parser, &Name, AmlNodeOpRegion);
+      if (Node != NULL) {
+        Node->Flags = (UINT8)Flags;
+        Node->Value = Offset;
+        Node->Length = (Length.Type == AmlValueInteger) ? Length.Integer : 0;
+      }
+      return (Node != NULL);
+    case 0x81:    // Field
+    case 0x86:    // IndexField
+    case 0x87:    // BankField
+      if (!ParsePackage(Parser, &PkgEnd)) {
+        return FALSE;
+      }
+      SavedEnd = Parser->End;
+      Parser->End = PkgEnd;
+      Result = ParseNameString(Parser, &Name);
+      if (Result && (Opcode != 0x81)) {
+        Result = ParseNameString(Parser, &Name2);
+      }
+      if (Result && (Opcode == 0x87)) {
+        Result = ParseTerm(Parser, NULL);
+      }
+      Result = Result && ParseBytes(Parser, 1, &Flags);
+      Parser->End = SavedEnd;
+      if (!Result) {
+        return FALSE;
+      }
+      return ParseFieldList(Parser,
+                            PkgEnd,
+                            (Name.SegCount != 0) ? NameSeg(Name.Segs + (Name.SegCount - 1) * 4) : 0,
+                            (UINT8)Flags);
+    case 0x82:    // Device
+      return ParseScopeObject(Parser, AmlNodeDevice, 0);
+    case 0x83:    // Processor
+      return ParseScopeObject(Parser, AmlNodeProcessor, 6);
+    case 0x84:    // PowerResource
+      return ParseScopeObject(Parser, AmlNodePowerResource, 3);
+    case 0x85:    // ThermalZone
+      return ParseScopeObject(Parser, AmlNodeThermalZone, 0);
+    case 0x88:    // DataRegion
+      if (!ParseNameString(Parser, &Name) ||
+          !ParseTerm(Parser, NULL) || !ParseTerm(Parser, NULL) || !ParseTerm(Parser, NULL)) {
+        return FALSE;
+      }
+      return (DeclareNode(Parser, &Name, AmlNodeDataRegion) != NULL);
+  }
+
+  if (mExtOperands[Opcode] == NULL) {
+    return FALSE;
+  }
+  return ParseOperands(Parser, mExtOperands[Opcode], NULL);
+}
+
+STATIC
+BOOLEAN
+ParseTerm (
+  IN  AML_PARSER  *Parser,
+  OUT AML_VALUE   *Value
+  )
+{
+  AML_VALUE Dummy;
+  if (Value == NULL) {
+    Value = &Dummy;
+  }
+  Value->Type = AmlValueOther;
+  Value->Integer = 0;
+  Value->String = NULL;
+
+  if ((Parser->Cur >= Parser->End) || (Parser->Depth >= AML_MAX_DEPTH)) {
+    return FALSE;
+  }
+
+  UINT8 Opcode = *Parser->Cur;
+  if ((Opcode >= 0x60) && (Opcode <= 0x6E)) {     // LocalX, ArgX
+    Parser->Cur++;
+    return TRUE;
+  }
+
+  AML_NAME Name;
+  AML_NAME Name2;
+  AML_NODE* Node;
+  CONST UINT8* PkgEnd;
+  CONST UINT8* SavedEnd;
+  AML_VALUE Operand;
+  UINT64 Flags;
+  BOOLEAN Result = FALSE;
+
+  Parser->Depth++;
+  if (IsNameStringStart(Opcode)) {
+    //
+    // Name reference or method invocation. Invocation arguments are not marked in AML
+    // at all, so the argument count comes from the method declaration.
+    //
+    Result = ParseNameString(Parser, &Name);
+    if (Result) {
+      Node = LookupNode(Parser, &Name);
+      if ((Node != NULL) && (Node->Type == AmlNodeMethod)) {
+        for (UINTN i = 0; (i < (Node->Flags & 0x07U)) && Result; i++) {
+          Result = ParseTerm(Parser, NULL);
+        }
+      }
+    }
+    Parser->Depth--;
+    return Result;
+  }
+
+  Parser->Cur++;
+  switch (Opcode) {
+    case 0x06:    // Alias
+      Result = ParseNameString(Parser, &Name) && ParseNameString(Parser, &Name2);
+      Result = Result && (DeclareNode(Parser, &Name2, AmlNodeAlias) != NULL);
+      break;
+    case 0x08:    // Name
+      Result = ParseNameString(Parser, &Name) && ParseTerm(Parser, &Operand);
+      if (Result) {
+        Node = DeclareNode(Parser, &Name, AmlNodeName);
+        if (Node != NULL) {
+          Node->Value = Operand;
+        }
+        Result = (Node != NULL);
+      }
+      break;
+    case 0x10:    // Scope
+      Result = ParseScopeObject(Parser, AmlNodeScope, 0);
+      break;
+    case 0x14:    // Method
+      Result = ParsePackage(Parser, &PkgEnd);
+      if (Result) {
+        SavedEnd = Parser->End;
+        Parser->End = PkgEnd;
+        Result = ParseNameString(Parser, &Name) && ParseBytes(Parser, 1, &Flags);
+        Parser->End = SavedEnd;
+      }
+      if (Result) {
+        Node = DeclareNode(Parser, &Name, AmlNodeMethod);
+        if (Node != NULL) {
+          if (Node->Body == NULL) {
+            Parser->Ns->MethodCount++;
+          }
+          Node->Flags = (UINT8)Flags;
+          Node->Body = Parser->Cur;
+          Node->BodySize = PkgEnd - Parser->Cur;
+        }
+        // Method bodies are decoded separately
+        Parser->Cur = PkgEnd;
+        Result = (Node != NULL);
+      }
+      break;
+    case 0x15:    // External
+      Result = ParseNameString(Parser, &Name) && ParseBytes(Parser, 2, &Flags);
+      if (Result) {
+        Node = DeclareNode(Parser, &Name, AmlNodeExternal);
+        //
+        // Keep method argument count of the external methods,
+        // it is necessary to parse their invocations
+        //
+        if ((Node != NULL) && (Node->Type == AmlNodeExternal) && ((Flags & 0xFF) == 8)) {
+          Node->Type = AmlNodeMethod;
+          Node->Flags = (UINT8)(RShiftU64(Flags, 8) & 0x07);
+        }
+        Result = (Node != NULL);
+      }
+      break;
+    case 0x8A:    // CreateDWordField
+    case 0x8B:    // CreateWordField
+    case 0x8C:    // CreateByteField
+    case 0x8D:    // CreateBitField
+    case 0x8F:    // CreateQWordField
+      Result = ParseTerm(Parser, NULL) && ParseTerm(Parser, &Operand) && ParseNameString(Parser, &Name);
+      if (Result) {
+        Node = DeclareNode(Parser, &Name, AmlNodeBufferField);
+        if (Node != NULL) {
+          UINT64 Bits = (Opcode == 0x8A) ? 32 : (Opcode == 0x8B) ? 16 : (Opcode == 0x8C) ? 8 : (Opcode == 0x8D) ? 1 : 64;
+          UINT64 Index = (Operand.Type == AmlValueInteger) ? Operand.Integer : 0;
+          Node->Offset = (Opcode == 0x8D) ? Index : MultU64x32(Index, 8);
+          Node->Length = Bits;
+        }
+        Result = (Node != NULL);
+      }
+      break;
+    case 0x5B:    // ExtOpPrefix
+      Result = ParseExtOpcode(Parser, Value);
+      break;
+    default:
+      if (mOperands[Opcode] != NULL) {
+        Result = ParseOperands(Parser, mOperands[Opcode], Value);
+        switch (Opcode) {
+          case 0x00:
+            Value->Type = AmlValueInteger;
+            Value->Integer = 0;
+            break;
+          case 0x01:
+            Value->Type = AmlValueInteger;
+            Value->Integer = 1;
+            break;
+          case 0xFF:
+            Value->Type = AmlValueInteger;
+            Value->Integer = MAX_UINT64;
+            break;
+          case 0x0A:
+          case 0x0B:
+          case 0x0C:
+          case 0x0E:
+            Value->Type = AmlValueInteger;
+            break;
+          case 0x0D:
+            Value->Type = AmlValueString;
+            break;
+          case 0x11:
+            Value->Type = AmlValueBuffer;
+            break;
+          case 0x12:
+          case 0x13:
+            Value->Type = AmlValuePackage;
+            break;
+          default:
+            Value->Integer = 0;
+            Value->String = NULL;
+            break;
+        }
+      }
+      break;
+  }
+
+  Parser->Depth--;
+  return Result;
+}
+
+//
+// Public interface
+//
+
+EFI_STATUS
+AmlNamespaceInit (
+  OUT AML_NAMESPACE  *Ns
+  )
+{
+  for (UINTN i = 0; i < ARRAY_SIZE(mOpcodes); i++) {
+    mOperands[mOpcodes[i].Opcode] = mOpcodes[i].Operands;
+  }
+  for (UINTN i = 0; i < ARRAY_SIZE(mExtOpcodes); i++) {
+    mExtOperands[mExtOpcodes[i].Opcode] = mExtOpcodes[i].Operands;
+  }
+
+  ZeroMem(Ns, sizeof(AML_NAMESPACE));
+  Ns->Hash = AllocateZeroPool(AML_HASH_SIZE * sizeof(AML_NODE*));
+  if (Ns->Hash == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Ns->Root = AddChild(Ns, NULL, SIGNATURE_32('\\', '_', '_', '_'), AmlNodeScope);
+  if (Ns->Root == NULL) {
+    AmlNamespaceFree(Ns);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Predefined namespace objects
+  //
+  AddChild(Ns, Ns->Root, SIGNATURE_32('_', 'G', 'P', 'E'), AmlNodeScope);
+  AddChild(Ns, Ns->Root, SIGNATURE_32('_', 'P', 'R', '_'), AmlNodeScope);
+  AddChild(Ns, Ns->Root, SIGNATURE_32('_', 'S', 'B', '_'), AmlNodeScope);
+  AddChild(Ns, Ns->Root, SIGNATURE_32('_', 'S', 'I', '_'), AmlNodeScope);
+  AddChild(Ns, Ns->Root, SIGNATURE_32('_', 'T', 'Z', '_'), AmlNodeScope);
+  AML_NODE* Osi = AddChild(Ns, Ns->Root, SIGNATURE_32('_', 'O', 'S', 'I'), AmlNodeMethod);
+  if (Osi != NULL) {
+    Osi->Flags = 1;
+  }
+  return EFI_SUCCESS;
+}
+
+VOID
+AmlNamespaceFree (
+  IN AML_NAMESPACE  *Ns
+  )
+{
+  while (Ns->Chunks != NULL) {
+    AML_NODE_CHUNK* Chunk = Ns->Chunks;
+    Ns->Chunks = Chunk->Next;
+    FreePool(Chunk);
+  }
+  if (Ns->Hash != NULL) {
+    FreePool(Ns->Hash);
+  }
+  ZeroMem(Ns, sizeof(AML_NAMESPACE));
+}
+
+EFI_STATUS
+AmlNamespaceLoadTable (
+  IN AML_NAMESPACE                *Ns,
+  IN EFI_ACPI_DESCRIPTION_HEADER  *Table
+  )
+{
+  if (Table->Length < sizeof(EFI_ACPI_DESCRIPTION_HEADER)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  AML_PARSER Parser;
+  Parser.Ns = Ns;
+  Parser.Cur = (CONST UINT8*)Table + sizeof(EFI_ACPI_DESCRIPTION_HEADER);
+  Parser.End = (CONST UINT8*)Table + Table->Length;
+  Parser.Scope = Ns->Root;
+  Parser.Depth = 0;
+  ParseTermList(&Parser, Parser.End, Ns->Root);
+
+  Ns->TableCount++;
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+DecodeMethods (
+  IN AML_NAMESPACE  *Ns,
+  IN AML_NODE       *Node
+  )
+{
+  for (AML_NODE* Child = Node->FirstChild; Child != NULL; Child = Child->Next) {
+    if ((Child->Type == AmlNodeMethod) && (Child->Body != NULL)) {
+      AML_PARSER Parser;
+      Parser.Ns = Ns;
+      Parser.Cur = Child->Body;
+      Parser.End = Child->Body + Child->BodySize;
+      Parser.Scope = Child;
+      Parser.Depth = 0;
+      ParseTermList(&Parser, Parser.End, Child);
+      Ns->MethodsDecoded++;
+    }
+    DecodeMethods(Ns, Child);
+  }
+}
+
+VOID
+AmlNamespaceDecodeMethods (
+  IN AML_NAMESPACE  *Ns
+  )
+{
+  DecodeMethods(Ns, Ns->Root);
+}
+
+STATIC
+VOID
+Walk (
+  IN AML_NODE          *Node,
+  IN UINTN             Depth,
+  IN AML_NODE_VISITOR  Visitor,
+  IN VOID              *Context
+  )
+{
+  for (AML_NODE* Child = Node->FirstChild; Child != NULL; Child = Child->Next) {
+    Visitor(Child, Depth, Context);
+    Walk(Child, Depth + 1, Visitor, Context);
+  }
+}
+
+VOID
+AmlNamespaceWalk (
+  IN AML_NAMESPACE     *Ns,
+  IN AML_NODE_VISITOR  Visitor,
+  IN VOID              *Context
+  )
+{
+  Walk(Ns->Root, 0, Visitor, Context);
+}
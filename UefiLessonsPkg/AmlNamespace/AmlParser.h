@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __AML_PARSER_H__
+#define __AML_PARSER_H__
+
+#include <Uefi.h>
+#include <IndustryStandard/Acpi.h>
+
+typedef enum {
+  AmlNodeScope,             // Root and scopes that are only referenced, but not defined
+  AmlNodeDevice,
+  AmlNodeMethod,
+  AmlNodeName,
+  AmlNodeOpRegion,
+  AmlNodeField,
+  AmlNodeProcessor,
+  AmlNodePowerResource,
+  AmlNodeThermalZone,
+  AmlNodeMutex,
+  AmlNodeEvent,
+  AmlNodeAlias,
+  AmlNodeBufferField,
+  AmlNodeExternal,
+  AmlNodeDataRegion,
+  AmlNodeTypeMax
+} AML_NODE_TYPE;
+
+typedef enum {
+  AmlValueNone,
+  AmlValueInteger,
+  AmlValueString,
+  AmlValueBuffer,
+  AmlValuePackage,
+  AmlValueOther             // Value is not a constant
+} AML_VALUE_TYPE;
+
+typedef struct {
+  UINT8         Type;       // AML_VALUE_TYPE
+  UINT64        Integer;    // Integer value, buffer size or package element count
+  CONST CHAR8   *String;
+} AML_VALUE;
+
+typedef struct _AML_NODE AML_NODE;
+struct _AML_NODE {
+  UINT32        Name;       // NameSeg
+  UINT8         Type;       // AML_NODE_TYPE
+  UINT8         Flags;      // Method flags, region space, field access flags
+  AML_NODE      *Parent;
+  AML_NODE      *FirstChild;
+  AML_NODE      *LastChild;
+  AML_NODE      *Next;
+  AML_NODE      *HashNext;
+  AML_VALUE     Value;      // Name value, region offset
+  UINT64        Length;     // Region length, field width in bits
+  UINT64        Offset;     // Field offset in bits
+  UINT32        Region;     // NameSeg of the field region
+  CONST UINT8   *Body;      // Method body
+  UINTN         BodySize;
+};
+
+typedef struct _AML_NODE_CHUNK AML_NODE_CHUNK;
+
+typedef struct {
+  AML_NODE        *Root;
+  AML_NODE        **Hash;   // (Parent, Name) -> node
+  AML_NODE_CHUNK  *Chunks;
+  UINTN           ChunkUsed;
+  UINTN           NodeCount;
+  UINTN           TableCount;
+  UINTN           MethodCount;
+  UINTN           MethodsDecoded;
+  UINTN           ErrorCount;
+} AML_NAMESPACE;
+
+typedef
+VOID
+(*AML_NODE_VISITOR) (
+  IN AML_NODE  *Node,
+  IN UINTN     Depth,
+  IN VOID      *Context
+  );
+
+EFI_STATUS
+AmlNamespaceInit (
+  OUT AML_NAMESPACE  *Ns
+  );
+
+VOID
+AmlNamespaceFree (
+  IN AML_NAMESPACE  *Ns
+  );
+
+/**
+  Add objects of the DSDT/SSDT table to the namespace. Method bodies are skipped.
+**/
+EFI_STATUS
+AmlNamespaceLoadTable (
+  IN AML_NAMESPACE                *Ns,
+  IN EFI_ACPI_DESCRIPTION_HEADER  *Table
+  );
+
+/**
+  Decode all method bodies and add objects that they declare to the namespace.
+  Call it after all the tables are loaded, so every method invocation can be
+  matched with the method argument count.
+**/
+VOID
+AmlNamespaceDecodeMethods (
+  IN AML_NAMESPACE  *Ns
+  );
+
+/**
+  Pre-order walk of the namespace tree. Root itself is not visited.
+**/
+VOID
+AmlNamespaceWalk (
+  IN AML_NAMESPACE     *Ns,
+  IN AML_NODE_VISITOR  Visitor,
+  IN VOID              *Context
+  );
+
+CONST CHAR8*
+AmlNodeTypeName (
+  IN UINT8  Type
+  );
+
+CONST CHAR8*
+AmlRegionSpaceName (
+  IN UINT8  Space
+  );
+
+#endif
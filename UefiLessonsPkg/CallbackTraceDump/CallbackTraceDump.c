@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BaseLib.h>
+#include <Library/PrintLib.h>
+#include <Library/BenchmarkLib.h>
+#include <Library/SaveFileLib.h>
+#include <Protocol/CallbackTrace.h>
+
+#define READ_CHUNK   256
+#define LINE_SIZE    160
+
+CONST CHAR8* ActionToStr(UINT32 Action)
+{
+  switch (Action) {
+    case EFI_BROWSER_ACTION_CHANGING:              return "CHANGING";
+    case EFI_BROWSER_ACTION_CHANGED:               return "CHANGED";
+    case EFI_BROWSER_ACTION_RETRIEVE:              return "RETRIEVE";
+    case EFI_BROWSER_ACTION_FORM_OPEN:             return "FORM_OPEN";
+    case EFI_BROWSER_ACTION_FORM_CLOSE:            return "FORM_CLOSE";
+    case EFI_BROWSER_ACTION_SUBMITTED:             return "SUBMITTED";
+    case EFI_BROWSER_ACTION_DEFAULT_STANDARD:      return "DEFAULT_STANDARD";
+    case EFI_BROWSER_ACTION_DEFAULT_MANUFACTURING: return "DEFAULT_MANUFACTURING";
+    case EFI_BROWSER_ACTION_DEFAULT_SAFE:          return "DEFAULT_SAFE";
+    case EFI_BROWSER_ACTION_DEFAULT_PLATFORM:      return "DEFAULT_PLATFORM";
+    case EFI_BROWSER_ACTION_DEFAULT_HARDWARE:      return "DEFAULT_HARDWARE";
+    case EFI_BROWSER_ACTION_DEFAULT_FIRMWARE:      return "DEFAULT_FIRMWARE";
+    default:                                       return "UNKNOWN";
+  }
+}
+
+CONST CHAR8* TypeToStr(UINT8 Type)
+{
+  switch (Type) {
+    case EFI_IFR_TYPE_NUM_SIZE_8:  return "NUM_SIZE_8";
+    case EFI_IFR_TYPE_NUM_SIZE_16: return "NUM_SIZE_16";
+    case EFI_IFR_TYPE_NUM_SIZE_32: return "NUM_SIZE_32";
+    case EFI_IFR_TYPE_NUM_SIZE_64: return "NUM_SIZE_64";
+    case EFI_IFR_TYPE_BOOLEAN:     return "BOOLEAN";
+    case EFI_IFR_TYPE_TIME:        return "TIME";
+    case EFI_IFR_TYPE_DATE:        return "DATE";
+    case EFI_IFR_TYPE_STRING:      return "STRING";
+    case EFI_IFR_TYPE_OTHER:       return "OTHER";
+    case EFI_IFR_TYPE_UNDEFINED:   return "UNDEFINED";
+    case EFI_IFR_TYPE_ACTION:      return "ACTION";
+    case EFI_IFR_TYPE_BUFFER:      return "BUFFER";
+    case EFI_IFR_TYPE_REF:         return "REF";
+    default:                       return "UNKNOWN";
+  }
+}
+
+typedef struct {
+  CHAR8* Data;
+  UINTN  Size;
+  UINTN  Capacity;
+} TEXT_BUFFER;
+
+EFI_STATUS AppendLine(TEXT_BUFFER* Text, CONST CHAR8* Line)
+{
+  UINTN Length = AsciiStrLen(Line);
+  if ((Text->Size + Length) > Text->Capacity) {
+    UINTN Capacity = MAX(Text->Capacity * 2, Text->Size + Length);
+    CHAR8* Data = ReallocatePool(Text->Capacity, Capacity, Text->Data);
+    if (Data == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Text->Data = Data;
+    Text->Capacity = Capacity;
+  }
+  CopyMem(&Text->Data[Text->Size], Line, Length);
+  Text->Size += Length;
+  return EFI_SUCCESS;
+}
+
+//
+// Drain the trace of one driver, time is counted from the first entry of the trace.
+// Timestamps are BenchmarkLib ticks (see CallbackTraceLib), so they are converted with BenchmarkLib.
+//
+EFI_STATUS DrainTrace(CALLBACK_TRACE_PROTOCOL* Trace, TEXT_BUFFER* Text, UINTN* Total)
+{
+  CALLBACK_TRACE_ENTRY* Entries = AllocatePool(READ_CHUNK * sizeof(CALLBACK_TRACE_ENTRY));
+  if (Entries == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  EFI_STATUS Status;
+  UINT64 DroppedTotal = 0;
+  UINT64 First = 0;
+  UINT64 Previous = 0;
+  UINTN Count = 0;
+  CHAR8 Line[LINE_SIZE];
+  do {
+    UINTN ChunkCount = READ_CHUNK;
+    UINT64 Dropped;
+    Status = Trace->Read(Trace, Entries, &ChunkCount, &Dropped);
+    if (EFI_ERROR(Status)) {
+      break;
+    }
+    DroppedTotal += Dropped;
+    for (UINTN i = 0; (i < ChunkCount) && !EFI_ERROR(Status); i++) {
+      if (Count == 0) {
+        First = Entries[i].Timestamp;
+        Previous = First;
+      }
+      AsciiSPrint(Line,
+                  sizeof(Line),
+                  "%g,%d,%ld,%ld,%a,0x%04x,%a,0x%lx\n",
+                  &Trace->FormSetGuid,
+                  Entries[i].Sequence,
+                  BenchmarkTicksToNs(Entries[i].Timestamp - First),
+                  BenchmarkTicksToNs(Entries[i].Timestamp - Previous),
+                  ActionToStr(Entries[i].Action),
+                  Entries[i].QuestionId,
+                  TypeToStr(Entries[i].Type),
+                  Entries[i].Value);
+      Previous = Entries[i].Timestamp;
+      Count++;
+      Status = AppendLine(Text, Line);
+    }
+    if (ChunkCount == 0) {
+      break;
+    }
+  } while (!EFI_ERROR(Status));
+
+  Print(L"%g: %d entries, %ld dropped\n", &Trace->FormSetGuid, Count, DroppedTotal);
+  *Total += Count;
+  FreePool(Entries);
+  return Status;
+}
+
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"  CallbackTraceDump [<file>]\n");
+  Print(L"\n");
+  Print(L"Read the form callback traces of all drivers and save them as CSV, print them if <file> is not set.\n");
+  Print(L"Columns: formset,sequence,time_ns,delta_ns,action,question_id,type,value\n");
+}
+
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN Argc,
+  IN CHAR16 **Argv
+  )
+{
+  CHAR16* FileName = NULL;
+  if (Argc == 2) {
+    if (Argv[1][0] == L'-') {
+      Usage();
+      return EFI_SUCCESS;
+    }
+    FileName = Argv[1];
+  } else if (Argc > 2) {
+    Usage();
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UINTN HandleCount;
+  EFI_HANDLE* Handles;
+  EFI_STATUS Status = gBS->LocateHandleBuffer(ByProtocol,
+                                              &gCallbackTraceProtocolGuid,
+                                              NULL,
+                                              &HandleCount,
+                                              &Handles);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't find any callback trace: %r\n", Status);
+    return Status;
+  }
+
+  TEXT_BUFFER Text = { NULL, 0, 0 };
+  Status = AppendLine(&Text, "formset,sequence,time_ns,delta_ns,action,question_id,type,value\n");
+  UINTN Total = 0;
+  for (UINTN i = 0; (i < HandleCount) && !EFI_ERROR(Status); i++) {
+    CALLBACK_TRACE_PROTOCOL* Trace;
+    Status = gBS->HandleProtocol(Handles[i], &gCallbackTraceProtocolGuid, (VOID**)&Trace);
+    if (!EFI_ERROR(Status)) {
+      Status = DrainTrace(Trace, &Text, &Total);
+    }
+  }
+  FreePool(Handles);
+
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't read callback trace: %r\n", Status);
+  } else if (FileName != NULL) {
+    Status = SaveFile(FileName, Text.Data, &Text.Size);
+  } else {
+    // The text is not NULL-terminated, print line by line
+    CHAR8* Line = Text.Data;
+    for (UINTN i = 0; i < Text.Size; i++) {
+      if (Text.Data[i] == '\n') {
+        Text.Data[i] = '\0';
+        Print(L"%a\n", Line);
+        Line = &Text.Data[i + 1];
+      }
+    }
+  }
+
+  if (Text.Data != NULL) {
+    FreePool(Text.Data);
+  }
+  return Status;
+}
@@ -9,6 +9,7 @@
 
 #include <Library/MemoryAllocationLib.h>
 #include <Library/HiiLib.h>
+#include <Library/HiiDbIndexLib.h>
 #include <Protocol/FormBrowser2.h>
 
 INTN
@@ -40,13 +41,18 @@ ShellAppMain (
     }
   }
 
-  EFI_HII_HANDLE* HiiHandles = HiiGetHiiHandles(&PackageListGuid);
+  UINTN HandleCount = HiiDbIndexCountByGuid(&PackageListGuid);
+  if (HandleCount == 0) {
+    Print(L"Error! There are no package lists with GUID %g\n", &PackageListGuid);
+    return EFI_NOT_FOUND;
+  }
 
-  EFI_HII_HANDLE* HiiHandle = HiiHandles;
-  UINTN HandleCount=0;
-  while (*HiiHandle != NULL) {
-    HiiHandle++;
-    HandleCount++;
+  EFI_HII_HANDLE* HiiHandles = AllocatePool(HandleCount * sizeof(EFI_HII_HANDLE));
+  if (HiiHandles == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  for (UINTN i = 0; i < HandleCount; i++) {
+    HiiHandles[i] = HiiDbIndexFindByGuid(&PackageListGuid, i)->Handle;
   }
 
   EFI_FORM_BROWSER2_PROTOCOL* FormBrowser2;
@@ -0,0 +1,584 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/ShellLib.h>
+#include <Library/SortLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/SaveFileLib.h>
+
+#include <IndustryStandard/Acpi.h>
+#include <Guid/ExtendedFirmwarePerformance.h>
+
+#define MODULE_BUCKETS_COUNT  256    // Must be a power of 2
+#define CSV_LINE_SIZE         512
+#define MAX_STRING_LENGTH     256    // Record length is UINT8
+
+//
+// Module times that are collected from the paired start/end records
+//
+typedef enum {
+  ModuleLoadImage,
+  ModuleStart,
+  ModuleDbSupported,
+  ModuleDbStart,
+  ModuleDbStop,
+  ModuleTimeMax
+} MODULE_TIME;
+
+typedef struct _MODULE_ENTRY MODULE_ENTRY;
+struct _MODULE_ENTRY {
+  MODULE_ENTRY  *HashNext;
+  EFI_GUID      Guid;
+  UINT64        Time[ModuleTimeMax];
+  UINT64        Total;
+};
+
+//
+// Common view of the EDKII extended performance records
+//
+typedef struct {
+  UINT16         Type;
+  UINT16         ProgressId;
+  UINT32         ApicId;
+  UINT64         Timestamp;
+  CONST EFI_GUID *Guid;
+  CONST EFI_GUID *Guid2;
+  UINT64         Qword;
+  CONST CHAR8    *String;
+  UINTN          StringLength;
+} PERF_EVENT;
+
+typedef struct {
+  UINT16         ProgressId;
+  CONST EFI_GUID *Guid;
+  CONST CHAR8    *String;
+  UINTN          StringLength;
+  UINT64         Timestamp;
+} OPEN_EVENT;
+
+typedef struct {
+  CHAR8    *Buffer;
+  UINTN    Size;
+  UINTN    Capacity;
+  BOOLEAN  Error;
+} CSV_OUTPUT;
+
+MODULE_ENTRY* mModuleBuckets[MODULE_BUCKETS_COUNT];
+MODULE_ENTRY** mModules = NULL;
+UINTN mModuleCount = 0;
+UINTN mModuleCapacity = 0;
+
+OPEN_EVENT* mOpenEvents = NULL;
+UINTN mOpenCount = 0;
+UINTN mOpenCapacity = 0;
+UINTN mUnpairedCount = 0;
+
+BOOLEAN mVerbose = FALSE;
+
+//
+// Print time in ns as milliseconds with microsecond precision
+//
+VOID PrintMs(UINT64 Ns)
+{
+  UINT64 Us = DivU64x32(Ns, 1000);
+  UINT32 Remainder;
+  UINT64 Ms = DivU64x32Remainder(Us, 1000, &Remainder);
+  Print(L"%8ld.%03d ms", Ms, Remainder);
+}
+
+BOOLEAN DecodeEvent(EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER* Header, PERF_EVENT* Event)
+{
+  ZeroMem(Event, sizeof(PERF_EVENT));
+  Event->Type = Header->Type;
+
+  //
+  // All the extended records start with the same fields as FPDT_GUID_EVENT_RECORD
+  //
+  UINTN StringOffset;
+  switch (Header->Type) {
+    case FPDT_GUID_EVENT_TYPE:
+      StringOffset = 0;
+      break;
+    case FPDT_DYNAMIC_STRING_EVENT_TYPE:
+      StringOffset = OFFSET_OF(FPDT_DYNAMIC_STRING_EVENT_RECORD, String);
+      break;
+    case FPDT_DUAL_GUID_STRING_EVENT_TYPE:
+      StringOffset = OFFSET_OF(FPDT_DUAL_GUID_STRING_EVENT_RECORD, String);
+      if (Header->Length < StringOffset) {
+        return FALSE;
+      }
+      Event->Guid2 = &((FPDT_DUAL_GUID_STRING_EVENT_RECORD*)Header)->Guid2;
+      break;
+    case FPDT_GUID_QWORD_EVENT_TYPE:
+      StringOffset = 0;
+      if (Header->Length < sizeof(FPDT_GUID_QWORD_EVENT_RECORD)) {
+        return FALSE;
+      }
+      Event->Qword = ((FPDT_GUID_QWORD_EVENT_RECORD*)Header)->Qword;
+      break;
+    case FPDT_GUID_QWORD_STRING_EVENT_TYPE:
+      StringOffset = OFFSET_OF(FPDT_GUID_QWORD_STRING_EVENT_RECORD, String);
+      if (Header->Length < StringOffset) {
+        return FALSE;
+      }
+      Event->Qword = ((FPDT_GUID_QWORD_STRING_EVENT_RECORD*)Header)->Qword;
+      break;
+    default:
+      return FALSE;
+  }
+  if (Header->Length < sizeof(FPDT_GUID_EVENT_RECORD)) {
+    return FALSE;
+  }
+
+  FPDT_GUID_EVENT_RECORD* Record = (FPDT_GUID_EVENT_RECORD*)Header;
+  Event->ProgressId = Record->ProgressID;
+  Event->ApicId = Record->ApicID;
+  Event->Timestamp = Record->Timestamp;
+  Event->Guid = &Record->Guid;
+  if (StringOffset != 0) {
+    Event->String = (CONST CHAR8*)Header + StringOffset;
+    Event->StringLength = AsciiStrnLenS(Event->String, Header->Length - StringOffset);
+  }
+  return TRUE;
+}
+
+//
+// Start/end progress ID pairs
+//
+UINT16 EndIdForStartId(UINT16 ProgressId)
+{
+  switch (ProgressId) {
+    case MODULE_START_ID:
+    case MODULE_LOADIMAGE_START_ID:
+    case MODULE_DB_START_ID:
+    case MODULE_DB_SUPPORT_START_ID:
+    case MODULE_DB_STOP_START_ID:
+    case PERF_EVENTSIGNAL_START_ID:
+    case PERF_CALLBACK_START_ID:
+    case PERF_FUNCTION_START_ID:
+    case PERF_INMODULE_START_ID:
+    case PERF_CROSSMODULE_START_ID:
+      return ProgressId + 1;
+  }
+  return 0;
+}
+
+UINT16 StartIdForEndId(UINT16 ProgressId)
+{
+  switch (ProgressId) {
+    case MODULE_END_ID:
+    case MODULE_LOADIMAGE_END_ID:
+    case MODULE_DB_END_ID:
+    case MODULE_DB_SUPPORT_END_ID:
+    case MODULE_DB_STOP_END_ID:
+    case PERF_EVENTSIGNAL_END_ID:
+    case PERF_CALLBACK_END_ID:
+    case PERF_FUNCTION_END_ID:
+    case PERF_INMODULE_END_ID:
+    case PERF_CROSSMODULE_END_ID:
+      return ProgressId - 1;
+  }
+  return 0;
+}
+
+MODULE_ENTRY* FindModule(CONST EFI_GUID* Guid)
+{
+  UINTN Bucket = ReadUnaligned32((CONST UINT32*)Guid) & (MODULE_BUCKETS_COUNT - 1);
+  for (MODULE_ENTRY* Module = mModuleBuckets[Bucket]; Module != NULL; Module = Module->HashNext) {
+    if (CompareGuid(&Module->Guid, Guid)) {
+      return Module;
+    }
+  }
+
+  if (mModuleCount == mModuleCapacity) {
+    UINTN NewCapacity = (mModuleCapacity == 0) ? 64 : mModuleCapacity * 2;
+    MODULE_ENTRY** NewModules = ReallocatePool(mModuleCapacity * sizeof(MODULE_ENTRY*),
+                                               NewCapacity * sizeof(MODULE_ENTRY*),
+                                               mModules);
+    if (NewModules == NULL) {
+      return NULL;
+    }
+    mModules = NewModules;
+    mModuleCapacity = NewCapacity;
+  }
+  MODULE_ENTRY* Module = AllocateZeroPool(sizeof(MODULE_ENTRY));
+  if (Module == NULL) {
+    return NULL;
+  }
+  CopyGuid(&Module->Guid, Guid);
+  Module->HashNext = mModuleBuckets[Bucket];
+  mModuleBuckets[Bucket] = Module;
+  mModules[mModuleCount++] = Module;
+  return Module;
+}
+
+VOID AddModuleTime(UINT16 StartId, CONST EFI_GUID* Guid, UINT64 Duration)
+{
+  MODULE_TIME Index;
+  switch (StartId) {
+    case MODULE_LOADIMAGE_START_ID:
+      Index = ModuleLoadImage;
+      break;
+    case MODULE_START_ID:
+      Index = ModuleStart;
+      break;
+    case MODULE_DB_SUPPORT_START_ID:
+      Index = ModuleDbSupported;
+      break;
+    case MODULE_DB_START_ID:
+      Index = ModuleDbStart;
+      break;
+    case MODULE_DB_STOP_START_ID:
+      Index = ModuleDbStop;
+      break;
+    default:
+      return;
+  }
+  MODULE_ENTRY* Module = FindModule(Guid);
+  if (Module != NULL) {
+    Module->Time[Index] += Duration;
+    Module->Total += Duration;
+  }
+}
+
+BOOLEAN IsSameString(OPEN_EVENT* Open, PERF_EVENT* Event)
+{
+  if (Open->StringLength != Event->StringLength) {
+    return FALSE;
+  }
+  return (Open->StringLength == 0) || !CompareMem(Open->String, Event->String, Open->StringLength);
+}
+
+VOID ProcessEvent(PERF_EVENT* Event)
+{
+  if (EndIdForStartId(Event->ProgressId) != 0) {
+    if (mOpenCount == mOpenCapacity) {
+      UINTN NewCapacity = (mOpenCapacity == 0) ? 64 : mOpenCapacity * 2;
+      OPEN_EVENT* NewOpen = ReallocatePool(mOpenCapacity * sizeof(OPEN_EVENT),
+                                           NewCapacity * sizeof(OPEN_EVENT),
+                                           mOpenEvents);
+      if (NewOpen == NULL) {
+        mUnpairedCount++;
+        return;
+      }
+      mOpenEvents = NewOpen;
+      mOpenCapacity = NewCapacity;
+    }
+    OPEN_EVENT* Open = &mOpenEvents[mOpenCount++];
+    Open->ProgressId = Event->ProgressId;
+    Open->Guid = Event->Guid;
+    Open->String = Event->String;
+    Open->StringLength = Event->StringLength;
+    Open->Timestamp = Event->Timestamp;
+    return;
+  }
+
+  UINT16 StartId = StartIdForEndId(Event->ProgressId);
+  if (StartId == 0) {
+    return;
+  }
+
+  //
+  // Measurements can be nested, the end record closes the latest matching start record
+  //
+  for (UINTN i = mOpenCount; i > 0; i--) {
+    OPEN_EVENT* Open = &mOpenEvents[i - 1];
+    if ((Open->ProgressId != StartId) || !CompareGuid(Open->Guid, Event->Guid)) {
+      continue;
+    }
+    if ((Event->StringLength != 0) && !IsSameString(Open, Event)) {
+      continue;
+    }
+
+    UINT64 Duration = (Event->Timestamp > Open->Timestamp) ? Event->Timestamp - Open->Timestamp : 0;
+    AddModuleTime(StartId, Open->Guid, Duration);
+
+    if ((StartId == PERF_CROSSMODULE_START_ID) ||
+        (mVerbose && (StartId >= PERF_EVENTSIGNAL_START_ID))) {
+      Print(L"  ");
+      PrintMs(Open->Timestamp);
+      Print(L"  ");
+      PrintMs(Duration);
+      if (Open->StringLength != 0) {
+        Print(L"  %.*a\n", Open->StringLength, Open->String);
+      } else {
+        Print(L"  %g\n", Open->Guid);
+      }
+    }
+
+    CopyMem(Open, Open + 1, (mOpenCount - i) * sizeof(OPEN_EVENT));
+    mOpenCount--;
+    return;
+  }
+  mUnpairedCount++;
+}
+
+VOID CsvAppend(CSV_OUTPUT* Csv, CONST CHAR8* Format, ...)
+{
+  if ((Csv->Buffer == NULL) || Csv->Error) {
+    return;
+  }
+  if (Csv->Capacity - Csv->Size < CSV_LINE_SIZE) {
+    UINTN NewCapacity = Csv->Capacity * 2;
+    CHAR8* NewBuffer = ReallocatePool(Csv->Capacity, NewCapacity, Csv->Buffer);
+    if (NewBuffer == NULL) {
+      Csv->Error = TRUE;
+      return;
+    }
+    Csv->Buffer = NewBuffer;
+    Csv->Capacity = NewCapacity;
+  }
+  VA_LIST Marker;
+  VA_START(Marker, Format);
+  Csv->Size += AsciiVSPrint(Csv->Buffer + Csv->Size, Csv->Capacity - Csv->Size, Format, Marker);
+  VA_END(Marker);
+}
+
+VOID CsvAppendEvent(CSV_OUTPUT* Csv, PERF_EVENT* Event)
+{
+  CHAR8 String[MAX_STRING_LENGTH];
+  UINTN Length = MIN(Event->StringLength, MAX_STRING_LENGTH - 1);
+  for (UINTN i = 0; i < Length; i++) {
+    // Keep the CSV line well-formed
+    String[i] = ((Event->String[i] == '"') || (Event->String[i] < ' ')) ? '\'' : Event->String[i];
+  }
+  String[Length] = 0;
+
+  CsvAppend(Csv, "0x%04x,0x%04x,%d,%ld,%g,", Event->Type, Event->ProgressId, Event->ApicId, Event->Timestamp, Event->Guid);
+  if (Event->Guid2 != NULL) {
+    CsvAppend(Csv, "%g", Event->Guid2);
+  }
+  CsvAppend(Csv, ",0x%lx,\"%a\"\n", Event->Qword, String);
+}
+
+VOID PrintBasicBootRecord(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD* Record, CSV_OUTPUT* Csv)
+{
+  CONST CHAR16* Names[] = {
+    L"ResetEnd",
+    L"OsLoaderLoadImageStart",
+    L"OsLoaderStartImageStart",
+    L"ExitBootServicesEntry",
+    L"ExitBootServicesExit",
+  };
+  UINT64 Values[] = {
+    Record->ResetEnd,
+    Record->OsLoaderLoadImageStart,
+    Record->OsLoaderStartImageStart,
+    Record->ExitBootServicesEntry,
+    Record->ExitBootServicesExit,
+  };
+
+  Print(L"Firmware basic boot record:\n");
+  for (UINTN i = 0; i < ARRAY_SIZE(Values); i++) {
+    Print(L"  %-24s", Names[i]);
+    if (Values[i] != 0) {
+      PrintMs(Values[i]);
+    } else {
+      Print(L"%15a", "-");
+    }
+    if ((i > 0) && (Values[i] != 0) && (Values[i - 1] != 0) && (Values[i] >= Values[i - 1])) {
+      Print(L"  (+");
+      PrintMs(Values[i] - Values[i - 1]);
+      Print(L")");
+    }
+    Print(L"\n");
+    CsvAppend(Csv, "0x%04x,,,%ld,,,,\"%s\"\n", Record->Header.Type, Values[i], Names[i]);
+  }
+  Print(L"\n");
+}
+
+INTN EFIAPI CompareModules(CONST VOID* Buffer1, CONST VOID* Buffer2)
+{
+  UINT64 Total1 = (*(MODULE_ENTRY**)Buffer1)->Total;
+  UINT64 Total2 = (*(MODULE_ENTRY**)Buffer2)->Total;
+  if (Total1 == Total2) {
+    return 0;
+  }
+  return (Total1 > Total2) ? -1 : 1;
+}
+
+VOID PrintModules()
+{
+  if (mModuleCount == 0) {
+    return;
+  }
+  PerformQuickSort(mModules, mModuleCount, sizeof(MODULE_ENTRY*), CompareModules);
+
+  Print(L"\nModules (sorted by total time):\n");
+  Print(L"  %-36s %15s %15s %15s %15s %15s\n", L"GUID", L"LoadImage", L"Start", L"DB Supported", L"DB Start", L"Total");
+  for (UINTN i = 0; i < mModuleCount; i++) {
+    Print(L"  %g", &mModules[i]->Guid);
+    for (UINTN j = 0; j < ModuleTimeMax; j++) {
+      if (j == ModuleDbStop) {
+        continue;
+      }
+      Print(L" ");
+      PrintMs(mModules[i]->Time[j]);
+    }
+    Print(L" ");
+    PrintMs(mModules[i]->Total);
+    Print(L"\n");
+  }
+}
+
+VOID FreeModules()
+{
+  for (UINTN i = 0; i < mModuleCount; i++) {
+    FreePool(mModules[i]);
+  }
+  if (mModules != NULL) {
+    FreePool(mModules);
+  }
+  if (mOpenEvents != NULL) {
+    FreePool(mOpenEvents);
+  }
+}
+
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"  FpdtInfo [-v] [-b] [-o <file.csv>] [-r <file.bin>]\n");
+  Print(L"    -v             show every paired measurement, not only boot phases\n");
+  Print(L"    -b             enable page break mode\n");
+  Print(L"    -o <file.csv>  export all the records as CSV\n");
+  Print(L"    -r <file.bin>  save raw FBPT table\n");
+}
+
+INTN EFIAPI ShellAppMain(IN UINTN Argc, IN CHAR16 **Argv)
+{
+  CHAR16* CsvFileName = NULL;
+  CHAR16* RawFileName = NULL;
+  for (UINTN i = 1; i < Argc; i++) {
+    if (!StrCmp(Argv[i], L"-v")) {
+      mVerbose = TRUE;
+    } else if (!StrCmp(Argv[i], L"-b")) {
+      ShellSetPageBreakMode(TRUE);
+    } else if (!StrCmp(Argv[i], L"-o") && ((i + 1) < Argc)) {
+      CsvFileName = Argv[++i];
+    } else if (!StrCmp(Argv[i], L"-r") && ((i + 1) < Argc)) {
+      RawFileName = Argv[++i];
+    } else {
+      Usage();
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  EFI_ACPI_DESCRIPTION_HEADER* Fpdt = (EFI_ACPI_DESCRIPTION_HEADER*)AcpiTableIndexFind(EFI_ACPI_5_0_FIRMWARE_PERFORMANCE_DATA_TABLE_SIGNATURE, 0);
+  if (Fpdt == NULL) {
+    Print(L"Error! FPDT table is not found\n");
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // FPDT contains only the pointer records, the actual data is in the FBPT
+  //
+  EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER* Fbpt = NULL;
+  UINT8* Ptr = (UINT8*)Fpdt + sizeof(EFI_ACPI_DESCRIPTION_HEADER);
+  UINT8* End = (UINT8*)Fpdt + Fpdt->Length;
+  while (Ptr + sizeof(EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER) <= End) {
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER* Header = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER*)Ptr;
+    if ((Header->Length == 0) || (Ptr + Header->Length > End)) {
+      break;
+    }
+    if ((Header->Type == EFI_ACPI_5_0_FPDT_RECORD_TYPE_FIRMWARE_BASIC_BOOT_POINTER) &&
+        (Header->Length >= sizeof(EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_POINTER_RECORD))) {
+      Fbpt = (EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER*)(UINTN)
+             ((EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_POINTER_RECORD*)Header)->BootPerformanceTablePointer;
+    } else if ((Header->Type == EFI_ACPI_5_0_FPDT_RECORD_TYPE_S3_PERFORMANCE_TABLE_POINTER) &&
+               (Header->Length >= sizeof(EFI_ACPI_5_0_FPDT_S3_PERFORMANCE_TABLE_POINTER_RECORD))) {
+      Print(L"S3 performance table is placed at 0x%lx\n",
+            ((EFI_ACPI_5_0_FPDT_S3_PERFORMANCE_TABLE_POINTER_RECORD*)Header)->S3PerformanceTablePointer);
+    }
+    Ptr += Header->Length;
+  }
+
+  if ((Fbpt == NULL) ||
+      (Fbpt->Signature != EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_SIGNATURE) ||
+      (Fbpt->Length < sizeof(EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER))) {
+    Print(L"Error! Firmware basic boot performance table is not found\n");
+    return EFI_NOT_FOUND;
+  }
+  Print(L"FBPT is placed at %p with length 0x%x\n\n", Fbpt, Fbpt->Length);
+
+  EFI_STATUS Status = EFI_SUCCESS;
+  if (RawFileName != NULL) {
+    UINTN Size = Fbpt->Length;
+    Status = SaveFile(RawFileName, Fbpt, &Size);
+  }
+
+  CSV_OUTPUT Csv;
+  ZeroMem(&Csv, sizeof(Csv));
+  if (CsvFileName != NULL) {
+    Csv.Capacity = SIZE_64KB;
+    Csv.Buffer = AllocatePool(Csv.Capacity);
+    if (Csv.Buffer == NULL) {
+      Print(L"Error! Can't allocate CSV buffer\n");
+      return EFI_OUT_OF_RESOURCES;
+    }
+    CsvAppend(&Csv, "Type,ProgressID,ApicID,Timestamp,Guid,Guid2,Qword,String\n");
+  }
+
+  //
+  // Single pass over the records: the basic boot record and the extended records
+  // are printed as they come, start/end pairs are matched on the fly
+  //
+  UINTN RecordCount = 0;
+  UINTN UnknownCount = 0;
+  BOOLEAN PhasesHeader = FALSE;
+  Ptr = (UINT8*)(Fbpt + 1);
+  End = (UINT8*)Fbpt + Fbpt->Length;
+  while (Ptr + sizeof(EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER) <= End) {
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER* Header = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER*)Ptr;
+    if ((Header->Length == 0) || (Ptr + Header->Length > End)) {
+      Print(L"Error! Invalid record at offset 0x%lx\n", (UINTN)(Ptr - (UINT8*)Fbpt));
+      break;
+    }
+    RecordCount++;
+
+    PERF_EVENT Event;
+    if ((Header->Type == EFI_ACPI_5_0_FPDT_RUNTIME_RECORD_TYPE_FIRMWARE_BASIC_BOOT) &&
+        (Header->Length >= sizeof(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD))) {
+      PrintBasicBootRecord((EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD*)Header, &Csv);
+    } else if (DecodeEvent(Header, &Event)) {
+      if (!PhasesHeader) {
+        Print(L"%s:\n  %15s  %15s  Name\n", mVerbose ? L"Measurements" : L"Boot phases", L"Start", L"Duration");
+        PhasesHeader = TRUE;
+      }
+      ProcessEvent(&Event);
+      CsvAppendEvent(&Csv, &Event);
+    } else {
+      UnknownCount++;
+    }
+    Ptr += Header->Length;
+  }
+
+  PrintModules();
+  Print(L"\nRecords: %d (unknown %d), unpaired end records: %d, unclosed start records: %d\n",
+        RecordCount,
+        UnknownCount,
+        mUnpairedCount,
+        mOpenCount);
+
+  if (CsvFileName != NULL) {
+    if (Csv.Error) {
+      Print(L"Error! Not enough memory for the CSV output\n");
+      Status = EFI_OUT_OF_RESOURCES;
+    } else {
+      Status = SaveFile(CsvFileName, Csv.Buffer, &Csv.Size);
+    }
+    FreePool(Csv.Buffer);
+  }
+
+  FreeModules();
+  return Status;
+}
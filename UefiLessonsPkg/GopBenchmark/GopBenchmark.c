@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BenchmarkLib.h>
+#include <Library/GopDrawLib.h>
+
+#define DEFAULT_FRAMES  100
+#define BOX_SIZE        64
+#define BOX_STEP        8
+
+//
+// Per-pixel Blt is too slow to draw many frames, so it is measured only for this time
+// and the frame rate is calculated from the part of the frame that was drawn
+//
+#define PER_PIXEL_TIME_LIMIT_NS  1000000000ULL
+
+typedef enum {
+  PathPerPixelBlt,
+  PathFullFrameBlt,
+  PathFrameBuffer,
+  PathDirtyRect,
+  PathMax
+} DRAW_PATH;
+
+typedef struct {
+  UINT32   Mode;
+  UINT32   Width;
+  UINT32   Height;
+  BOOLEAN  Supported[PathMax];
+  UINT64   Fps100[PathMax];     // Frames per second * 100
+} MODE_RESULT;
+
+STATIC CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL mBoxColor = { 0xFF, 0xFF, 0xFF, 0x00 };
+
+STATIC
+EFI_GRAPHICS_OUTPUT_BLT_PIXEL
+BackgroundColor (
+  IN UINTN  Frame
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL Color;
+  Color.Blue = (UINT8)Frame;
+  Color.Green = (UINT8)(Frame >> 1);
+  Color.Red = 0;
+  Color.Reserved = 0;
+  return Color;
+}
+
+//
+// Box moves diagonally and bounces off the screen edges
+//
+STATIC
+VOID
+BoxPosition (
+  IN  GOP_DRAW_CONTEXT  *Context,
+  IN  UINTN             Frame,
+  OUT UINTN             *X,
+  OUT UINTN             *Y
+  )
+{
+  UINTN RangeX = (Context->Width > BOX_SIZE) ? (Context->Width - BOX_SIZE) : 1;
+  UINTN RangeY = (Context->Height > BOX_SIZE) ? (Context->Height - BOX_SIZE) : 1;
+  UINTN PosX = (Frame * BOX_STEP) % (2 * RangeX);
+  UINTN PosY = (Frame * BOX_STEP) % (2 * RangeY);
+  *X = (PosX < RangeX) ? PosX : (2 * RangeX - PosX);
+  *Y = (PosY < RangeY) ? PosY : (2 * RangeY - PosY);
+}
+
+STATIC
+VOID
+DrawFrame (
+  IN GOP_DRAW_CONTEXT  *Context,
+  IN UINTN             Frame
+  )
+{
+  UINTN X;
+  UINTN Y;
+  GopDrawFillRect(Context, 0, 0, Context->Width, Context->Height, BackgroundColor(Frame));
+  BoxPosition(Context, Frame, &X, &Y);
+  GopDrawFillRect(Context, X, Y, BOX_SIZE, BOX_SIZE, mBoxColor);
+}
+
+STATIC
+UINT64
+Fps100 (
+  IN UINT64  Frames,
+  IN UINT64  Ticks
+  )
+{
+  UINT64 Ns = BenchmarkTicksToNs(Ticks);
+  if (Ns == 0) {
+    Ns = 1;
+  }
+  return DivU64x64Remainder(MultU64x64(Frames, 100000000000ULL), Ns, NULL);
+}
+
+STATIC
+EFI_STATUS
+BenchmarkPerPixelBlt (
+  IN  GOP_DRAW_CONTEXT  *Context,
+  OUT UINT64            *Result
+  )
+{
+  DrawFrame(Context, 0);
+  UINT64 Limit = DivU64x64Remainder(MultU64x64(BenchmarkGetFrequency(), PER_PIXEL_TIME_LIMIT_NS), 1000000000ULL, NULL);
+  UINTN Pixels = 0;
+  UINT64 Start = BenchmarkGetTicks();
+  UINT64 Ticks = 0;
+  for (UINTN y = 0; (y < Context->Height) && (Ticks < Limit); y++) {
+    for (UINTN x = 0; x < Context->Width; x++) {
+      EFI_STATUS Status = Context->Gop->Blt(
+        Context->Gop,
+        Context->BackBuffer,
+        EfiBltBufferToVideo,
+        x,
+        y,
+        x,
+        y,
+        1,
+        1,
+        Context->Width * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+      );
+      if (EFI_ERROR(Status)) {
+        return Status;
+      }
+    }
+    Pixels += Context->Width;
+    Ticks = BenchmarkGetTicks() - Start;
+  }
+  // Fraction of the frame that was drawn
+  *Result = DivU64x64Remainder(Fps100(Pixels, Ticks), Context->Width * Context->Height, NULL);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+BenchmarkFullFrame (
+  IN  GOP_DRAW_CONTEXT  *Context,
+  IN  BOOLEAN           FrameBuffer,
+  IN  UINTN             Frames,
+  OUT UINT64            *Result
+  )
+{
+  UINT64 Start = BenchmarkGetTicks();
+  for (UINTN Frame = 0; Frame < Frames; Frame++) {
+    DrawFrame(Context, Frame);
+    EFI_STATUS Status = FrameBuffer ? GopDrawFlushFrameBuffer(Context) : GopDrawFlush(Context);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  *Result = Fps100(Frames, BenchmarkGetTicks() - Start);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+BenchmarkDirtyRect (
+  IN  GOP_DRAW_CONTEXT  *Context,
+  IN  UINTN             Frames,
+  OUT UINT64            *Result
+  )
+{
+  DrawFrame(Context, 0);
+  EFI_STATUS Status = GopDrawFlush(Context);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  // Only the box moves, so only the union of its old and new positions is transferred
+  UINT64 Start = BenchmarkGetTicks();
+  for (UINTN Frame = 1; Frame <= Frames; Frame++) {
+    UINTN X;
+    UINTN Y;
+    BoxPosition(Context, Frame - 1, &X, &Y);
+    GopDrawFillRect(Context, X, Y, BOX_SIZE, BOX_SIZE, BackgroundColor(0));
+    BoxPosition(Context, Frame, &X, &Y);
+    GopDrawFillRect(Context, X, Y, BOX_SIZE, BOX_SIZE, mBoxColor);
+    Status = GopDrawFlushDirty(Context);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  *Result = Fps100(Frames, BenchmarkGetTicks() - Start);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+BenchmarkMode (
+  IN  EFI_GRAPHICS_OUTPUT_PROTOCOL  *Gop,
+  IN  UINTN                         Frames,
+  OUT MODE_RESULT                   *Result
+  )
+{
+  GOP_DRAW_CONTEXT Context;
+  EFI_STATUS Status = GopDrawInit(Gop, &Context);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  Result->Mode = Gop->Mode->Mode;
+  Result->Width = (UINT32)Context.Width;
+  Result->Height = (UINT32)Context.Height;
+
+  Status = BenchmarkPerPixelBlt(&Context, &Result->Fps100[PathPerPixelBlt]);
+  Result->Supported[PathPerPixelBlt] = !EFI_ERROR(Status);
+  Status = BenchmarkFullFrame(&Context, FALSE, Frames, &Result->Fps100[PathFullFrameBlt]);
+  Result->Supported[PathFullFrameBlt] = !EFI_ERROR(Status);
+  if (GopDrawHasFrameBuffer(&Context)) {
+    Status = BenchmarkFullFrame(&Context, TRUE, Frames, &Result->Fps100[PathFrameBuffer]);
+    Result->Supported[PathFrameBuffer] = !EFI_ERROR(Status);
+  }
+  Status = BenchmarkDirtyRect(&Context, Frames, &Result->Fps100[PathDirtyRect]);
+  Result->Supported[PathDirtyRect] = !EFI_ERROR(Status);
+
+  GopDrawFree(&Context);
+  return EFI_SUCCESS;
+}
+
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"  GopBenchmark [-a | -m <mode>] [-f <frames>]\n");
+  Print(L"    -a           benchmark all video modes (default is the current mode)\n");
+  Print(L"    -m <mode>    benchmark only this video mode\n");
+  Print(L"    -f <frames>  frames to draw for every test (default %d)\n", DEFAULT_FRAMES);
+}
+
+INTN EFIAPI ShellAppMain(IN UINTN Argc, IN CHAR16 **Argv)
+{
+  BOOLEAN AllModes = FALSE;
+  BOOLEAN OneMode = FALSE;
+  UINT32 RequestedMode = 0;
+  UINTN Frames = DEFAULT_FRAMES;
+  for (UINTN i = 1; i < Argc; i++) {
+    if (!StrCmp(Argv[i], L"-a")) {
+      AllModes = TRUE;
+    } else if (!StrCmp(Argv[i], L"-m") && ((i + 1) < Argc)) {
+      OneMode = TRUE;
+      RequestedMode = (UINT32)StrDecimalToUintn(Argv[++i]);
+    } else if (!StrCmp(Argv[i], L"-f") && ((i + 1) < Argc)) {
+      Frames = StrDecimalToUintn(Argv[++i]);
+    } else {
+      Usage();
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+  if ((AllModes && OneMode) || (Frames == 0)) {
+    Usage();
+    return EFI_INVALID_PARAMETER;
+  }
+
+  EFI_GRAPHICS_OUTPUT_PROTOCOL* Gop;
+  EFI_STATUS Status = gBS->LocateProtocol(
+    &gEfiGraphicsOutputProtocolGuid,
+    NULL,
+    (VOID **)&Gop
+  );
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't locate GOP: %r\n", Status);
+    return Status;
+  }
+
+  UINT32 OriginalMode = Gop->Mode->Mode;
+  UINT32 FirstMode = OriginalMode;
+  UINT32 LastMode = OriginalMode;
+  if (AllModes) {
+    FirstMode = 0;
+    LastMode = Gop->Mode->MaxMode - 1;
+  } else if (OneMode) {
+    if (RequestedMode >= Gop->Mode->MaxMode) {
+      Print(L"Error! Mode %d is not supported, max mode is %d\n", RequestedMode, Gop->Mode->MaxMode - 1);
+      return EFI_INVALID_PARAMETER;
+    }
+    FirstMode = RequestedMode;
+    LastMode = RequestedMode;
+  }
+
+  MODE_RESULT* Results = AllocateZeroPool((LastMode - FirstMode + 1) * sizeof(MODE_RESULT));
+  if (Results == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  // Nothing is printed during the benchmark, the console would draw over the test frames
+  UINTN ResultCount = 0;
+  for (UINT32 Mode = FirstMode; Mode <= LastMode; Mode++) {
+    if (Mode != Gop->Mode->Mode) {
+      Status = Gop->SetMode(Gop, Mode);
+      if (EFI_ERROR(Status)) {
+        continue;
+      }
+    }
+    Status = BenchmarkMode(Gop, Frames, &Results[ResultCount]);
+    if (!EFI_ERROR(Status)) {
+      ResultCount++;
+    }
+  }
+
+  if (Gop->Mode->Mode != OriginalMode) {
+    Gop->SetMode(Gop, OriginalMode);
+  }
+  gST->ConOut->ClearScreen(gST->ConOut);
+
+  CONST CHAR16* PathNames[] = {
+    L"Per-pixel Blt",
+    L"Full-frame Blt",
+    L"Framebuffer",
+    L"Dirty rect"
+  };
+  Print(L"Frames/s, %d frames per test, %dx%d box in the dirty rect test\n\n", Frames, BOX_SIZE, BOX_SIZE);
+  Print(L"Mode  Resolution");
+  for (UINTN Path = 0; Path < PathMax; Path++) {
+    Print(L"  %14s", PathNames[Path]);
+  }
+  Print(L"\n");
+  for (UINTN i = 0; i < ResultCount; i++) {
+    Print(L"%4d  %4dx%-4d ", Results[i].Mode, Results[i].Width, Results[i].Height);
+    for (UINTN Path = 0; Path < PathMax; Path++) {
+      if (Results[i].Supported[Path]) {
+        Print(L"  %11ld.%02ld", DivU64x32(Results[i].Fps100[Path], 100), ModU64x32(Results[i].Fps100[Path], 100));
+      } else {
+        Print(L"  %14s", L"-");
+      }
+    }
+    Print(L"\n");
+  }
+
+  FreePool(Results);
+  return EFI_SUCCESS;
+}
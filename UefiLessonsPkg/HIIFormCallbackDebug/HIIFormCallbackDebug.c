@@ -14,6 +14,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PrintLib.h>
 #include <Library/DebugLib.h>
+#include <Library/CallbackTraceLib.h>
 #include <Protocol/HiiConfigAccess.h>
 #include <Protocol/HiiPopup.h>
 #include "Data.h"
@@ -355,6 +356,9 @@ Callback (
   OUT    EFI_BROWSER_ACTION_REQUEST             *ActionRequest
   )
 {
+  // Read the trace with CallbackTraceDump.efi
+  CallbackTraceRecord(Action, QuestionId, Type, Value);
+
   //DEBUG ((EFI_D_INFO, "Callback: Action=%s, QuestionId=0x%04x, Type=%s, Value=", ActionToStr(Action), QuestionId, TypeToStr(Type)));
   //DebugCallbackValue(Type, Value);
 
@@ -374,6 +378,8 @@ HIIFormCallbackDebugUnload (
   if (mHiiHandle != NULL)
     HiiRemovePackages(mHiiHandle);
 
+  CallbackTraceUninstall(mDriverHandle);
+
   EFI_STATUS Status = gBS->UninstallMultipleProtocolInterfaces(
                              mDriverHandle,
                              &gEfiDevicePathProtocolGuid,
@@ -433,5 +439,11 @@ HIIFormCallbackDebugEntryPoint (
     Print(L"Error! Can't set default configuration #%d\n", DefaultId);
   }
 
+  EFI_GUID FormSetGuid = FORMSET_GUID;
+  Status = CallbackTraceInstall(mDriverHandle, &FormSetGuid);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't install callback trace protocol: %r\n", Status);
+  }
+
   return EFI_SUCCESS;
 }
@@ -14,8 +14,11 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PrintLib.h>
 #include <Library/DebugLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BenchmarkLib.h>
 #include <Protocol/HiiConfigAccess.h>
 #include <Protocol/HiiPopup.h>
+#include <Protocol/ShellParameters.h>
 #include "Data.h"
 
 extern UINT8 FormBin[];
@@ -210,106 +213,195 @@ EFI_STRING TypeToStr(UINT8 Type)
   }
 }
 
-VOID CallbackValueToStr(UINT8 Type, EFI_IFR_TYPE_VALUE *Value, EFI_STRING* ValueStr, UINTN ValueStrSize)
+//
+// The callback path doesn't allocate memory: question prompts are resolved once at load,
+// all strings are formatted into the fixed buffers below.
+// Every cached question has its own popup message string with the last text, so the
+// string package is updated only when the text of this question changes, even if the
+// browser sends the callbacks for several questions in turn.
+//
+#define MAX_CACHED_QUESTIONS  16
+#define PROMPT_SIZE           64
+#define VALUE_STRING_SIZE     100
+#define POPUP_STRING_SIZE     300
+
+typedef struct {
+  EFI_QUESTION_ID QuestionId;
+  CHAR16          Prompt[PROMPT_SIZE];
+  EFI_STRING_ID   PopupMessage;                 // 0 until the first callback of the question
+  CHAR16          PopupStr[POPUP_STRING_SIZE];  // Current PopupMessage text
+} QUESTION_CACHE;
+
+QUESTION_CACHE mQuestions[MAX_CACHED_QUESTIONS];
+UINTN mQuestionCount = 0;
+
+// Questions that are not cached share POPUP_MESSAGE
+QUESTION_CACHE mUnknownQuestion = { 0, L"Unknown", STRING_TOKEN(POPUP_MESSAGE), L"" };
+
+UINTN mPopupStrUpdates = 0;
+
+EFI_HII_POPUP_PROTOCOL* mHiiPopup = NULL;
+
+VOID GetStringToBuffer(EFI_STRING_ID StringId, CHAR16* Buffer, UINTN BufferSize)
 {
-  switch (Type) {
-    case EFI_IFR_TYPE_NUM_SIZE_8:
-      UnicodeSPrint(*ValueStr, ValueStrSize, L"%d", Value->u8);
-      break;
-    case EFI_IFR_TYPE_NUM_SIZE_16:
-      UnicodeSPrint(*ValueStr, ValueStrSize, L"%d", Value->u16);
-      break;
-    case EFI_IFR_TYPE_NUM_SIZE_32:
-      UnicodeSPrint(*ValueStr, ValueStrSize, L"%d", Value->u32);
-      break;
-    case EFI_IFR_TYPE_NUM_SIZE_64:
-      UnicodeSPrint(*ValueStr, ValueStrSize, L"%ld", Value->u64);
-      break;
-    case EFI_IFR_TYPE_BOOLEAN:
-      UnicodeSPrint(*ValueStr, ValueStrSize, L"%d", Value->b);
-      break;
-    case EFI_IFR_TYPE_TIME:
-      UnicodeSPrint(*ValueStr, ValueStrSize, L"%02d:%02d:%02d", Value->time.Hour, Value->time.Minute, Value->time.Second);
-      break;
-    case EFI_IFR_TYPE_DATE:
-      UnicodeSPrint(*ValueStr, ValueStrSize, L"%04d/%02d/%02d", Value->date.Year, Value->date.Month, Value->date.Day);
-      break;
-    case EFI_IFR_TYPE_STRING:
-      if (Value->string)
-        UnicodeSPrint(*ValueStr, ValueStrSize, L"%s", HiiGetString(mHiiHandle, Value->string, "en-US"));
-      else
-        UnicodeSPrint(*ValueStr, ValueStrSize, L"NO STRING!");
-      break;
-    default:
-      UnicodeSPrint(*ValueStr, ValueStrSize, L"Unknown");
+  UINTN Size = BufferSize;
+  EFI_STATUS Status = gHiiString->GetString(gHiiString, "en-US", mHiiHandle, StringId, Buffer, &Size, NULL);
+  if (EFI_ERROR(Status)) {
+    UnicodeSPrint(Buffer, BufferSize, L"<%r>", Status);
+  }
+}
+
+VOID CacheQuestionPrompts()
+{
+  // FormBin is the UINT32 length followed by the forms package
+  UINT32 Length = ReadUnaligned32((UINT32*)FormBin);
+  UINT8* Ptr = FormBin + sizeof(UINT32) + sizeof(EFI_HII_PACKAGE_HEADER);
+  while ((Ptr + sizeof(EFI_IFR_OP_HEADER)) <= (FormBin + Length)) {
+    EFI_IFR_OP_HEADER* OpHeader = (EFI_IFR_OP_HEADER*)Ptr;
+    if (OpHeader->Length == 0) {
       break;
+    }
+    switch (OpHeader->OpCode) {
+      case EFI_IFR_CHECKBOX_OP:
+      case EFI_IFR_NUMERIC_OP:
+      case EFI_IFR_STRING_OP:
+      case EFI_IFR_PASSWORD_OP:
+      case EFI_IFR_DATE_OP:
+      case EFI_IFR_TIME_OP:
+      case EFI_IFR_ONE_OF_OP:
+      case EFI_IFR_ORDERED_LIST_OP:
+      case EFI_IFR_ACTION_OP:
+      case EFI_IFR_REF_OP:
+        if ((mQuestionCount < MAX_CACHED_QUESTIONS) &&
+            (OpHeader->Length >= sizeof(EFI_IFR_OP_HEADER) + sizeof(EFI_IFR_QUESTION_HEADER))) {
+          EFI_IFR_QUESTION_HEADER* Question = (EFI_IFR_QUESTION_HEADER*)(OpHeader + 1);
+          mQuestions[mQuestionCount].QuestionId = Question->QuestionId;
+          GetStringToBuffer(Question->Header.Prompt,
+                            mQuestions[mQuestionCount].Prompt,
+                            sizeof(mQuestions[mQuestionCount].Prompt));
+          mQuestionCount++;
+        }
+        break;
+    }
+    Ptr += OpHeader->Length;
   }
 }
 
-VOID DebugCallbackValue(UINT8 Type, EFI_IFR_TYPE_VALUE *Value)
+QUESTION_CACHE* FindQuestion(EFI_QUESTION_ID QuestionId)
+{
+  for (UINTN i = 0; i < mQuestionCount; i++) {
+    if (mQuestions[i].QuestionId == QuestionId) {
+      return &mQuestions[i];
+    }
+  }
+  return &mUnknownQuestion;
+}
+
+VOID CallbackValueToStr(UINT8 Type, EFI_IFR_TYPE_VALUE *Value, EFI_STRING ValueStr, UINTN ValueStrSize)
 {
   switch (Type) {
     case EFI_IFR_TYPE_NUM_SIZE_8:
-      DEBUG ((EFI_D_INFO, "%d\n", Value->u8));
+      UnicodeSPrint(ValueStr, ValueStrSize, L"%d", Value->u8);
       break;
     case EFI_IFR_TYPE_NUM_SIZE_16:
-      DEBUG ((EFI_D_INFO, "%d\n", Value->u16));
+      UnicodeSPrint(ValueStr, ValueStrSize, L"%d", Value->u16);
       break;
     case EFI_IFR_TYPE_NUM_SIZE_32:
-      DEBUG ((EFI_D_INFO, "%d\n", Value->u32));
+      UnicodeSPrint(ValueStr, ValueStrSize, L"%d", Value->u32);
       break;
     case EFI_IFR_TYPE_NUM_SIZE_64:
-      DEBUG ((EFI_D_INFO, "%ld\n", Value->u64));
+      UnicodeSPrint(ValueStr, ValueStrSize, L"%ld", Value->u64);
       break;
     case EFI_IFR_TYPE_BOOLEAN:
-      DEBUG ((EFI_D_INFO, "%d\n", Value->b));
+      UnicodeSPrint(ValueStr, ValueStrSize, L"%d", Value->b);
       break;
     case EFI_IFR_TYPE_TIME:
-      DEBUG ((EFI_D_INFO, "%02d:%02d:%02d\n", Value->time.Hour, Value->time.Minute, Value->time.Second));
+      UnicodeSPrint(ValueStr, ValueStrSize, L"%02d:%02d:%02d", Value->time.Hour, Value->time.Minute, Value->time.Second);
       break;
     case EFI_IFR_TYPE_DATE:
-      DEBUG ((EFI_D_INFO, "%04d/%02d/%02d\n", Value->date.Year, Value->date.Month, Value->date.Day));
+      UnicodeSPrint(ValueStr, ValueStrSize, L"%04d/%02d/%02d", Value->date.Year, Value->date.Month, Value->date.Day);
       break;
     case EFI_IFR_TYPE_STRING:
       if (Value->string)
-        DEBUG ((EFI_D_INFO, "%s\n", HiiGetString(mHiiHandle, Value->string, "en-US") ));
+        GetStringToBuffer(Value->string, ValueStr, ValueStrSize);
       else
-        DEBUG ((EFI_D_INFO, "NO STRING!\n" ));
+        UnicodeSPrint(ValueStr, ValueStrSize, L"NO STRING!");
       break;
     default:
-      DEBUG ((EFI_D_INFO, "Unknown\n" ));
+      UnicodeSPrint(ValueStr, ValueStrSize, L"Unknown");
       break;
   }
 }
 
+VOID DebugCallbackValue(UINT8 Type, EFI_IFR_TYPE_VALUE *Value)
+{
+  CHAR16 ValueStr[VALUE_STRING_SIZE];
+  CallbackValueToStr(Type, Value, ValueStr, sizeof(ValueStr));
+  DEBUG ((EFI_D_INFO, "%s\n", ValueStr));
+}
+
+//
+// Format the callback info to the popup message of the question, the string package is updated
+// only if the text of the question changes.
+// Returns the popup message string ID or 0 on error.
+//
+EFI_STRING_ID UpdatePopupMessage(EFI_BROWSER_ACTION Action, EFI_QUESTION_ID QuestionId, UINT8 Type, EFI_IFR_TYPE_VALUE* Value)
+{
+  CHAR16 ValueStr[VALUE_STRING_SIZE];
+  CallbackValueToStr(Type, Value, ValueStr, sizeof(ValueStr));
+
+  QUESTION_CACHE* Question = FindQuestion(QuestionId);
+  CHAR16 NewStr[POPUP_STRING_SIZE];
+  UnicodeSPrint(NewStr,
+                sizeof(NewStr),
+                L"Callback:\nAction=%s\nQuestion=%s (0x%04x)\nType=%s\nValue=%s",
+                ActionToStr(Action),
+                Question->Prompt,
+                QuestionId,
+                TypeToStr(Type),
+                ValueStr);
+  if ((Question->PopupMessage != 0) && !StrCmp(NewStr, Question->PopupStr)) {
+    return Question->PopupMessage;
+  }
+
+  // String ID 0 adds a new string on the first callback of the question
+  EFI_STRING_ID PopupMessage = HiiSetString(mHiiHandle, Question->PopupMessage, NewStr, NULL);
+  if (PopupMessage == 0) {
+    DEBUG ((EFI_D_ERROR, "Error! Can't update popup message\n"));
+    return 0;
+  }
+  Question->PopupMessage = PopupMessage;
+  StrCpyS(Question->PopupStr, POPUP_STRING_SIZE, NewStr);
+  mPopupStrUpdates++;
+  return PopupMessage;
+}
+
 VOID HIIPopupCallbackInfo(EFI_BROWSER_ACTION Action, EFI_QUESTION_ID QuestionId, UINT8 Type, EFI_IFR_TYPE_VALUE* Value)
 {
   EFI_STATUS Status;
-  EFI_HII_POPUP_PROTOCOL* HiiPopup;
   EFI_HII_POPUP_SELECTION UserSelection;
-  Status = gBS->LocateProtocol(&gEfiHiiPopupProtocolGuid,
-                               NULL,
-                               (VOID **)&HiiPopup);
-  if (EFI_ERROR(Status)) {
-    DEBUG ((EFI_D_ERROR, "Error! Can't find EFI_HII_POPUP_PROTOCOL\n"));
-    return;
+  if (mHiiPopup == NULL) {
+    Status = gBS->LocateProtocol(&gEfiHiiPopupProtocolGuid,
+                                 NULL,
+                                 (VOID **)&mHiiPopup);
+    if (EFI_ERROR(Status)) {
+      DEBUG ((EFI_D_ERROR, "Error! Can't find EFI_HII_POPUP_PROTOCOL\n"));
+      mHiiPopup = NULL;
+      return;
+    }
   }
 
-  UINTN Size = 300;
-  EFI_STRING ValueStr = AllocateZeroPool(Size);
-  CallbackValueToStr(Type, Value, &ValueStr, Size);
-  EFI_STRING PopupStr = AllocateZeroPool(Size);
-  UnicodeSPrint(PopupStr, Size, L"Callback:\nAction=%s\nQuestionId=0x%04x\nType=%s\nValue=%s", ActionToStr(Action), QuestionId, TypeToStr(Type), ValueStr);
-  FreePool(ValueStr);
-  HiiSetString(mHiiHandle, STRING_TOKEN(POPUP_MESSAGE), PopupStr, NULL);
-  Status = HiiPopup->CreatePopup(HiiPopup,
-                                 EfiHiiPopupStyleInfo,
-                                 EfiHiiPopupTypeOk,
-                                 mHiiHandle,
-                                 STRING_TOKEN(POPUP_MESSAGE),
-                                 &UserSelection
-                                );
-  FreePool(PopupStr);
+  EFI_STRING_ID PopupMessage = UpdatePopupMessage(Action, QuestionId, Type, Value);
+  if (PopupMessage == 0) {
+    return;
+  }
+  Status = mHiiPopup->CreatePopup(mHiiPopup,
+                                  EfiHiiPopupStyleInfo,
+                                  EfiHiiPopupTypeOk,
+                                  mHiiHandle,
+                                  PopupMessage,
+                                  &UserSelection
+                                 );
   if (EFI_ERROR(Status)) {
     DEBUG ((EFI_D_ERROR, "Error! Can't create popup, %r\n", Status));
     return;
@@ -320,27 +412,64 @@ VOID PopupCallbackInfo(EFI_BROWSER_ACTION Action, EFI_QUESTION_ID QuestionId, UI
 {
   EFI_INPUT_KEY Key;  
 
-  UINTN Size = 100;
-  EFI_STRING ActionStr = AllocateZeroPool(Size);
-  EFI_STRING QuestionIdStr = AllocateZeroPool(Size);
-  EFI_STRING TypeStr = AllocateZeroPool(Size);
-  EFI_STRING ValueStr = AllocateZeroPool(Size);
-  EFI_STRING ValStr = AllocateZeroPool(Size);
-  CallbackValueToStr(Type, Value, &ValStr, Size);
-  UnicodeSPrint(ActionStr, Size, L"Action=%s", ActionToStr(Action));
-  UnicodeSPrint(QuestionIdStr, Size, L"QuestionId=0x%04x", QuestionId);
-  UnicodeSPrint(TypeStr, Size, L"Type=%s", TypeToStr(Type));
-  UnicodeSPrint(ValueStr, Size, L"Value=%s", ValStr);
+  CHAR16 ActionStr[VALUE_STRING_SIZE];
+  CHAR16 QuestionIdStr[VALUE_STRING_SIZE];
+  CHAR16 TypeStr[VALUE_STRING_SIZE];
+  CHAR16 ValueStr[VALUE_STRING_SIZE];
+  CHAR16 ValStr[VALUE_STRING_SIZE];
+  CallbackValueToStr(Type, Value, ValStr, sizeof(ValStr));
+  UnicodeSPrint(ActionStr, sizeof(ActionStr), L"Action=%s", ActionToStr(Action));
+  UnicodeSPrint(QuestionIdStr, sizeof(QuestionIdStr), L"QuestionId=0x%04x", QuestionId);
+  UnicodeSPrint(TypeStr, sizeof(TypeStr), L"Type=%s", TypeToStr(Type));
+  UnicodeSPrint(ValueStr, sizeof(ValueStr), L"Value=%s", ValStr);
   do {
     //CreatePopUp(EFI_TEXT_ATTR(EFI_LIGHTGRAY, EFI_BLUE), &Key, L"Callback:", ActionStr, QuestionIdStr, TypeStr, ValueStr, NULL);
     CreatePopUp(EFI_TEXT_ATTR(EFI_RED, EFI_BLACK), &Key, L"Callback:", ActionStr, QuestionIdStr, TypeStr, ValueStr, NULL);
   } while (Key.UnicodeChar != CHAR_CARRIAGE_RETURN);
+}
+
+//
+// Measure the callback message path for the EFI_BROWSER_ACTION_RETRIEVE storm,
+// the browser sends it for every question on every form refresh
+//
+#define BENCHMARK_CALLBACKS  10000
 
-  FreePool(ActionStr);
-  FreePool(QuestionIdStr);
-  FreePool(TypeStr);
-  FreePool(ValueStr);
-  FreePool(ValStr);
+VOID BenchmarkCallbacks()
+{
+  EFI_IFR_TYPE_VALUE Value;
+  ZeroMem(&Value, sizeof(Value));
+
+  // First refresh, the texts of the same values pass are set here
+  Value.u16 = 7;
+  UpdatePopupMessage(EFI_BROWSER_ACTION_RETRIEVE, NUMERIC_QUESTION_ID, EFI_IFR_TYPE_NUM_SIZE_16, &Value);
+  Value.b = TRUE;
+  UpdatePopupMessage(EFI_BROWSER_ACTION_RETRIEVE, CHECKBOX_QUESTION_ID, EFI_IFR_TYPE_BOOLEAN, &Value);
+
+  for (UINTN Pass = 0; Pass < 2; Pass++) {
+    UINTN Updates = mPopupStrUpdates;
+    UINT64 Start = BenchmarkGetTicks();
+    for (UINTN i = 0; i < BENCHMARK_CALLBACKS; i++) {
+      // Pass 0: the same values on every refresh, pass 1: the value changes every time
+      Value.u16 = (Pass == 0) ? 7 : (UINT16)i;
+      UpdatePopupMessage(EFI_BROWSER_ACTION_RETRIEVE, NUMERIC_QUESTION_ID, EFI_IFR_TYPE_NUM_SIZE_16, &Value);
+      Value.b = (Pass == 0) ? TRUE : (BOOLEAN)(i & 1);
+      UpdatePopupMessage(EFI_BROWSER_ACTION_RETRIEVE, CHECKBOX_QUESTION_ID, EFI_IFR_TYPE_BOOLEAN, &Value);
+    }
+    UINT64 Ns = BenchmarkTicksToNs(BenchmarkGetTicks() - Start);
+    Print(L"RETRIEVE storm, %s values: %d callbacks, %ld ns/callback, %ld callbacks/s, %d string updates\n",
+          (Pass == 0) ? L"same" : L"changing",
+          BENCHMARK_CALLBACKS * 2,
+          DivU64x64Remainder(Ns, BENCHMARK_CALLBACKS * 2, NULL),
+          DivU64x64Remainder(BENCHMARK_CALLBACKS * 2 * 1000000000ULL, MAX(Ns, 1), NULL),
+          mPopupStrUpdates - Updates);
+
+    // Same values need no updates, changing values update both questions on every callback
+    UINTN ExpectedUpdates = (Pass == 0) ? 0 : BENCHMARK_CALLBACKS * 2;
+    if ((mPopupStrUpdates - Updates) != ExpectedUpdates) {
+      Print(L"Error! %d string updates were expected\n", ExpectedUpdates);
+    }
+    ASSERT ((mPopupStrUpdates - Updates) == ExpectedUpdates);
+  }
 }
 
 STATIC
@@ -439,6 +568,21 @@ HIIFormCallbackDebug2EntryPoint (
   if (!HiiSetToDefaults(ConfigStr, DefaultId)) {
     Print(L"Error! Can't set default configuration #%d\n", DefaultId);
   }
+  if (ConfigStr != NULL) {
+    FreePool(ConfigStr);
+  }
+
+  CacheQuestionPrompts();
+
+  // 'HIIFormCallbackDebug2.efi -t' from the shell measures the callback message path
+  EFI_SHELL_PARAMETERS_PROTOCOL* ShellParameters;
+  if (!EFI_ERROR(gBS->HandleProtocol(ImageHandle, &gEfiShellParametersProtocolGuid, (VOID **) &ShellParameters))) {
+    for (UINTN i = 1; i < ShellParameters->Argc; i++) {
+      if (!StrCmp(ShellParameters->Argv[i], L"-t")) {
+        BenchmarkCallbacks();
+      }
+    }
+  }
 
   return EFI_SUCCESS;
 }
@@ -6,4 +6,7 @@
 #define LABEL_START 0x1111
 #define LABEL_END   0x2222
 
+#define LABEL_PORTS_START 0x3333
+#define LABEL_PORTS_END   0x3334
+
 #endif
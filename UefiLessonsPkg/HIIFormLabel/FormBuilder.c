@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/HiiLib.h>
+#include <Guid/MdeModuleHii.h>
+
+#include "FormBuilder.h"
+
+//
+// The opcodes are created directly in the builder buffer and are passed to HiiLib with
+// a single HiiCreateRawOpCodes() call. HiiCreate*OpCode() functions grow the opcode handle
+// buffer by a fixed step, so thousands of entries would be copied over and over again.
+//
+STATIC
+UINTN
+AppendLabel (
+  IN UINT8   *Buffer,
+  IN UINT16  Number
+  )
+{
+  EFI_IFR_GUID_LABEL* Label = (EFI_IFR_GUID_LABEL*)Buffer;
+  Label->Header.OpCode = EFI_IFR_GUID_OP;
+  Label->Header.Length = sizeof(EFI_IFR_GUID_LABEL);
+  Label->Header.Scope = 0;
+  CopyGuid(&Label->Guid, &gEfiIfrTianoGuid);
+  Label->ExtendOpCode = EFI_IFR_EXTEND_OP_LABEL;
+  Label->Number = Number;
+  return sizeof(EFI_IFR_GUID_LABEL);
+}
+
+STATIC
+UINTN
+AppendText (
+  IN UINT8          *Buffer,
+  IN EFI_STRING_ID  Prompt,
+  IN EFI_STRING_ID  Help,
+  IN EFI_STRING_ID  TextTwo
+  )
+{
+  EFI_IFR_TEXT* Text = (EFI_IFR_TEXT*)Buffer;
+  Text->Header.OpCode = EFI_IFR_TEXT_OP;
+  Text->Header.Length = sizeof(EFI_IFR_TEXT);
+  Text->Header.Scope = 0;
+  Text->Statement.Prompt = Prompt;
+  Text->Statement.Help = Help;
+  Text->TextTwo = TextTwo;
+  return sizeof(EFI_IFR_TEXT);
+}
+
+STATIC
+UINTN
+ChunkCount (
+  IN UINTN  EntryCount
+  )
+{
+  return (EntryCount + FORM_BUILDER_CHUNK_SIZE - 1) / FORM_BUILDER_CHUNK_SIZE;
+}
+
+STATIC
+VOID*
+CreateLabelOpCodeHandle (
+  IN UINT16  Number
+  )
+{
+  VOID* OpCodeHandle = HiiAllocateOpCodeHandle();
+  if (OpCodeHandle == NULL) {
+    return NULL;
+  }
+  UINT8 Label[sizeof(EFI_IFR_GUID_LABEL)];
+  AppendLabel(Label, Number);
+  if (HiiCreateRawOpCodes(OpCodeHandle, Label, sizeof(Label)) == NULL) {
+    HiiFreeOpCodeHandle(OpCodeHandle);
+    return NULL;
+  }
+  return OpCodeHandle;
+}
+
+STATIC
+EFI_STATUS
+UpdateRange (
+  IN FORM_BUILDER  *Builder,
+  IN UINTN         Size,
+  IN VOID          *EndOpCodeHandle
+  )
+{
+  VOID* StartOpCodeHandle = HiiAllocateOpCodeHandle();
+  if (StartOpCodeHandle == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  EFI_STATUS Status = EFI_OUT_OF_RESOURCES;
+  if (HiiCreateRawOpCodes(StartOpCodeHandle, Builder->OpCodes, Size) != NULL) {
+    Status = HiiUpdateForm(Builder->HiiHandle,
+                           &Builder->FormSetGuid,
+                           Builder->FormId,
+                           StartOpCodeHandle,
+                           EndOpCodeHandle);
+  }
+  HiiFreeOpCodeHandle(StartOpCodeHandle);
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+ReserveOpCodes (
+  IN FORM_BUILDER  *Builder,
+  IN UINTN         Size
+  )
+{
+  if (Size <= Builder->OpCodesSize) {
+    return EFI_SUCCESS;
+  }
+  UINT8* OpCodes = ReallocatePool(Builder->OpCodesSize, Size, Builder->OpCodes);
+  if (OpCodes == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Builder->OpCodes = OpCodes;
+  Builder->OpCodesSize = Size;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+ReserveEntries (
+  IN FORM_BUILDER  *Builder,
+  IN UINTN         Count
+  )
+{
+  if (Count > Builder->EntryCapacity) {
+    UINTN Capacity = MAX(Count, Builder->EntryCapacity * 2);
+    UINT8* Status = ReallocatePool(Builder->EntryCapacity * sizeof(UINT8), Capacity * sizeof(UINT8), Builder->Status);
+    if (Status == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Builder->Status = Status;
+    EFI_STRING_ID* Prompts = ReallocatePool(Builder->EntryCapacity * sizeof(EFI_STRING_ID), Capacity * sizeof(EFI_STRING_ID), Builder->Prompts);
+    if (Prompts == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Builder->Prompts = Prompts;
+    Builder->EntryCapacity = Capacity;
+  }
+
+  UINTN Chunks = ChunkCount(Count);
+  if (Chunks > Builder->ChunkCapacity) {
+    UINTN Capacity = MAX(Chunks, Builder->ChunkCapacity * 2);
+    BOOLEAN* DirtyChunks = ReallocatePool(Builder->ChunkCapacity * sizeof(BOOLEAN), Capacity * sizeof(BOOLEAN), Builder->DirtyChunks);
+    if (DirtyChunks == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Builder->DirtyChunks = DirtyChunks;
+    VOID** Handles = ReallocatePool(Builder->ChunkCapacity * sizeof(VOID*), Capacity * sizeof(VOID*), Builder->ChunkEndOpCodeHandles);
+    if (Handles == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    ZeroMem(&Handles[Builder->ChunkCapacity], (Capacity - Builder->ChunkCapacity) * sizeof(VOID*));
+    Builder->ChunkEndOpCodeHandles = Handles;
+    Builder->ChunkCapacity = Capacity;
+  }
+
+  // Prompts of the entries that were never shown before
+  for (; Builder->PromptCount < Count; Builder->PromptCount++) {
+    CHAR16 Prompt[32];
+    UnicodeSPrint(Prompt, sizeof(Prompt), L"Port %d", Builder->PromptCount);
+    Builder->Prompts[Builder->PromptCount] = HiiSetString(Builder->HiiHandle, 0, Prompt, NULL);
+    if (Builder->Prompts[Builder->PromptCount] == 0) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  return ReserveOpCodes(Builder,
+                        sizeof(EFI_IFR_GUID_LABEL) * (Chunks + 2) +
+                        sizeof(EFI_IFR_TEXT) * Count);
+}
+
+STATIC
+UINTN
+AppendChunk (
+  IN FORM_BUILDER  *Builder,
+  IN UINTN         Chunk,
+  IN UINT8         *Buffer
+  )
+{
+  UINTN Size = AppendLabel(Buffer, (UINT16)(FORM_BUILDER_CHUNK_LABEL + Chunk));
+  UINTN Last = MIN((Chunk + 1) * FORM_BUILDER_CHUNK_SIZE, Builder->EntryCount);
+  for (UINTN i = Chunk * FORM_BUILDER_CHUNK_SIZE; i < Last; i++) {
+    Size += AppendText(&Buffer[Size], Builder->Prompts[i], Builder->Help, Builder->StatusStrings[Builder->Status[i]]);
+  }
+  return Size;
+}
+
+EFI_STATUS
+FormBuilderInit (
+  OUT FORM_BUILDER    *Builder,
+  IN  EFI_HII_HANDLE  HiiHandle,
+  IN  EFI_GUID        *FormSetGuid,
+  IN  EFI_FORM_ID     FormId,
+  IN  UINT16          LabelStart,
+  IN  UINT16          LabelEnd
+  )
+{
+  ZeroMem(Builder, sizeof(*Builder));
+  Builder->HiiHandle = HiiHandle;
+  CopyGuid(&Builder->FormSetGuid, FormSetGuid);
+  Builder->FormId = FormId;
+  Builder->LabelStart = LabelStart;
+  Builder->LabelEnd = LabelEnd;
+
+  STATIC CONST CHAR16* StatusText[FormBuilderStatusMax] = { L"Link up", L"Link down", L"Disabled" };
+  for (UINTN i = 0; i < FormBuilderStatusMax; i++) {
+    Builder->StatusStrings[i] = HiiSetString(HiiHandle, 0, (EFI_STRING)StatusText[i], NULL);
+  }
+  Builder->Help = HiiSetString(HiiHandle, 0, L"Generated entry", NULL);
+  Builder->EndOpCodeHandle = CreateLabelOpCodeHandle(LabelEnd);
+  if ((Builder->EndOpCodeHandle == NULL) || (Builder->Help == 0)) {
+    FormBuilderFree(Builder);
+    return EFI_OUT_OF_RESOURCES;
+  }
+  return EFI_SUCCESS;
+}
+
+VOID
+FormBuilderFree (
+  IN FORM_BUILDER  *Builder
+  )
+{
+  if (Builder->EndOpCodeHandle != NULL) {
+    HiiFreeOpCodeHandle(Builder->EndOpCodeHandle);
+  }
+  for (UINTN i = 0; i < Builder->ChunkCapacity; i++) {
+    if (Builder->ChunkEndOpCodeHandles[i] != NULL) {
+      HiiFreeOpCodeHandle(Builder->ChunkEndOpCodeHandles[i]);
+    }
+  }
+  if (Builder->ChunkEndOpCodeHandles != NULL) {
+    FreePool(Builder->ChunkEndOpCodeHandles);
+  }
+  if (Builder->DirtyChunks != NULL) {
+    FreePool(Builder->DirtyChunks);
+  }
+  if (Builder->Status != NULL) {
+    FreePool(Builder->Status);
+  }
+  if (Builder->Prompts != NULL) {
+    FreePool(Builder->Prompts);
+  }
+  if (Builder->OpCodes != NULL) {
+    FreePool(Builder->OpCodes);
+  }
+  ZeroMem(Builder, sizeof(*Builder));
+}
+
+EFI_STATUS
+FormBuilderSetEntryCount (
+  IN FORM_BUILDER  *Builder,
+  IN UINTN         Count
+  )
+{
+  if (ChunkCount(Count) >= (MAX_UINT16 - FORM_BUILDER_CHUNK_LABEL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+  EFI_STATUS Status = ReserveEntries(Builder, Count);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  Builder->EntryCount = Count;
+  SetMem(Builder->Status, Count, FormBuilderLinkUp);
+  UINTN Chunks = ChunkCount(Count);
+  ZeroMem(Builder->DirtyChunks, Chunks * sizeof(BOOLEAN));
+
+  //
+  // LabelStart, chunks with their labels, the label that closes the last chunk
+  //
+  UINTN Size = AppendLabel(Builder->OpCodes, Builder->LabelStart);
+  for (UINTN i = 0; i < Chunks; i++) {
+    Size += AppendChunk(Builder, i, &Builder->OpCodes[Size]);
+  }
+  Size += AppendLabel(&Builder->OpCodes[Size], (UINT16)(FORM_BUILDER_CHUNK_LABEL + Chunks));
+
+  return UpdateRange(Builder, Size, Builder->EndOpCodeHandle);
+}
+
+VOID
+FormBuilderSetStatus (
+  IN FORM_BUILDER         *Builder,
+  IN UINTN                Index,
+  IN FORM_BUILDER_STATUS  Status
+  )
+{
+  if ((Index >= Builder->EntryCount) || (Status >= FormBuilderStatusMax) || (Builder->Status[Index] == Status)) {
+    return;
+  }
+  Builder->Status[Index] = (UINT8)Status;
+  Builder->DirtyChunks[Index / FORM_BUILDER_CHUNK_SIZE] = TRUE;
+}
+
+EFI_STATUS
+FormBuilderRefresh (
+  IN  FORM_BUILDER  *Builder,
+  OUT UINTN         *UpdatedChunks OPTIONAL
+  )
+{
+  UINTN Updated = 0;
+  EFI_STATUS Status = EFI_SUCCESS;
+  for (UINTN i = 0; (i < ChunkCount(Builder->EntryCount)) && !EFI_ERROR(Status); i++) {
+    if (!Builder->DirtyChunks[i]) {
+      continue;
+    }
+    if (Builder->ChunkEndOpCodeHandles[i] == NULL) {
+      Builder->ChunkEndOpCodeHandles[i] = CreateLabelOpCodeHandle((UINT16)(FORM_BUILDER_CHUNK_LABEL + i + 1));
+      if (Builder->ChunkEndOpCodeHandles[i] == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+    }
+    UINTN Size = AppendChunk(Builder, i, Builder->OpCodes);
+    Status = UpdateRange(Builder, Size, Builder->ChunkEndOpCodeHandles[i]);
+    Builder->DirtyChunks[i] = FALSE;
+    Updated++;
+  }
+
+  if (UpdatedChunks != NULL) {
+    *UpdatedChunks = Updated;
+  }
+  return Status;
+}
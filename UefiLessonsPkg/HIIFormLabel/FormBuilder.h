@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __FORM_BUILDER_H__
+#define __FORM_BUILDER_H__
+
+#include <Uefi.h>
+
+//
+// Dynamic form with a large number of generated entries (e.g. per-port settings).
+//
+// Entries are placed between two labels of the form and are split into chunks of
+// FORM_BUILDER_CHUNK_SIZE entries. Every chunk is surrounded by its own generated labels,
+// so a change of one entry updates only its chunk with HiiUpdateForm().
+// Prompt strings are created once for every entry index and reused by later builds,
+// status strings are shared by all entries.
+//
+#define FORM_BUILDER_CHUNK_SIZE   64
+#define FORM_BUILDER_CHUNK_LABEL  0x4000    // Chunk labels are FORM_BUILDER_CHUNK_LABEL + chunk index
+
+typedef enum {
+  FormBuilderLinkUp,
+  FormBuilderLinkDown,
+  FormBuilderDisabled,
+  FormBuilderStatusMax
+} FORM_BUILDER_STATUS;
+
+typedef struct {
+  EFI_HII_HANDLE  HiiHandle;
+  EFI_GUID        FormSetGuid;
+  EFI_FORM_ID     FormId;
+  UINT16          LabelStart;
+  UINT16          LabelEnd;
+  VOID            *EndOpCodeHandle;          // LabelEnd label, built once
+  VOID            **ChunkEndOpCodeHandles;   // Next chunk label for every chunk, built on the first use
+  UINTN           ChunkCapacity;
+  UINTN           EntryCount;
+  UINT8           *Status;                   // FORM_BUILDER_STATUS of every entry
+  BOOLEAN         *DirtyChunks;
+  EFI_STRING_ID   *Prompts;
+  UINTN           PromptCount;
+  UINTN           EntryCapacity;
+  EFI_STRING_ID   StatusStrings[FormBuilderStatusMax];
+  EFI_STRING_ID   Help;
+  UINT8           *OpCodes;                  // Raw opcode buffer, grows only for the larger forms
+  UINTN           OpCodesSize;
+} FORM_BUILDER;
+
+EFI_STATUS
+FormBuilderInit (
+  OUT FORM_BUILDER    *Builder,
+  IN  EFI_HII_HANDLE  HiiHandle,
+  IN  EFI_GUID        *FormSetGuid,
+  IN  EFI_FORM_ID     FormId,
+  IN  UINT16          LabelStart,
+  IN  UINT16          LabelEnd
+  );
+
+VOID
+FormBuilderFree (
+  IN FORM_BUILDER  *Builder
+  );
+
+/**
+  Set the number of entries and rebuild the whole label range. All entries get the
+  FormBuilderLinkUp status.
+**/
+EFI_STATUS
+FormBuilderSetEntryCount (
+  IN FORM_BUILDER  *Builder,
+  IN UINTN         Count
+  );
+
+/**
+  Change the entry status. The form is not updated until FormBuilderRefresh().
+**/
+VOID
+FormBuilderSetStatus (
+  IN FORM_BUILDER         *Builder,
+  IN UINTN                Index,
+  IN FORM_BUILDER_STATUS  Status
+  );
+
+/**
+  Update the chunks with the changed entries.
+
+  @param[out] UpdatedChunks  Number of the updated chunks, optional
+**/
+EFI_STATUS
+FormBuilderRefresh (
+  IN  FORM_BUILDER  *Builder,
+  OUT UINTN         *UpdatedChunks OPTIONAL
+  );
+
+#endif
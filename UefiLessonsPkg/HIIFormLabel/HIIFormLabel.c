@@ -7,12 +7,74 @@
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
 #include <Library/HiiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BenchmarkLib.h>
 #include <Guid/MdeModuleHii.h>
+#include <Protocol/ShellParameters.h>
 #include "Data.h"
+#include "FormBuilder.h"
 
 extern UINT8 FormBin[];
 
 EFI_HII_HANDLE  mHiiHandle = NULL;
+FORM_BUILDER    mBuilder;
+
+#define DEFAULT_PORT_COUNT  16
+
+UINT64 ElapsedUs(UINT64 Start)
+{
+  return BenchmarkTicksToNs(BenchmarkGetTicks() - Start) / 1000;
+}
+
+EFI_STATUS BenchmarkFormBuilder()
+{
+  STATIC CONST UINTN Counts[] = { 100, 1000, 10000 };
+
+  Print(L"Entries   Build(us)   Rebuild(us)   Refresh 1(us)   Refresh all(us)\n");
+  for (UINTN i = 0; i < ARRAY_SIZE(Counts); i++) {
+    // The first build also creates the prompt strings for the new entries
+    UINT64 Start = BenchmarkGetTicks();
+    EFI_STATUS Status = FormBuilderSetEntryCount(&mBuilder, Counts[i]);
+    UINT64 Build = ElapsedUs(Start);
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! Can't build form with %d entries: %r\n", Counts[i], Status);
+      return Status;
+    }
+
+    Start = BenchmarkGetTicks();
+    Status = FormBuilderSetEntryCount(&mBuilder, Counts[i]);
+    UINT64 Rebuild = ElapsedUs(Start);
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! Can't rebuild form with %d entries: %r\n", Counts[i], Status);
+      return Status;
+    }
+
+    UINTN Updated;
+    Start = BenchmarkGetTicks();
+    FormBuilderSetStatus(&mBuilder, Counts[i] / 2, FormBuilderLinkDown);
+    Status = FormBuilderRefresh(&mBuilder, &Updated);
+    UINT64 RefreshOne = ElapsedUs(Start);
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! Can't refresh form: %r\n", Status);
+      return Status;
+    }
+
+    // Change one entry in every chunk
+    Start = BenchmarkGetTicks();
+    for (UINTN j = 0; j < Counts[i]; j += FORM_BUILDER_CHUNK_SIZE) {
+      FormBuilderSetStatus(&mBuilder, j, FormBuilderDisabled);
+    }
+    Status = FormBuilderRefresh(&mBuilder, &Updated);
+    UINT64 RefreshAll = ElapsedUs(Start);
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! Can't refresh form: %r\n", Status);
+      return Status;
+    }
+
+    Print(L"%7d   %9ld   %11ld   %13ld   %15ld (%d chunks)\n", Counts[i], Build, Rebuild, RefreshOne, RefreshAll, Updated);
+  }
+  return EFI_SUCCESS;
+}
 
 
 EFI_STATUS
@@ -21,6 +83,8 @@ HIIFormLabelUnload (
   EFI_HANDLE ImageHandle
   )
 {
+  FormBuilderFree(&mBuilder);
+
   if (mHiiHandle != NULL)
     HiiRemovePackages(mHiiHandle);
 
@@ -136,5 +200,45 @@ HIIFormLabelEntryPoint (
 
   HiiFreeOpCodeHandle(StartOpCodeHandle);
   HiiFreeOpCodeHandle(EndOpCodeHandle);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  //
+  // Generated port entries: 'HIIFormLabel.efi [<count>] [-t]' when started from the shell
+  //
+  UINTN PortCount = DEFAULT_PORT_COUNT;
+  BOOLEAN Benchmark = FALSE;
+  EFI_SHELL_PARAMETERS_PROTOCOL* ShellParameters;
+  if (!EFI_ERROR(gBS->HandleProtocol(ImageHandle, &gEfiShellParametersProtocolGuid, (VOID **) &ShellParameters))) {
+    for (UINTN i = 1; i < ShellParameters->Argc; i++) {
+      if (!StrCmp(ShellParameters->Argv[i], L"-t")) {
+        Benchmark = TRUE;
+      } else {
+        PortCount = StrDecimalToUintn(ShellParameters->Argv[i]);
+      }
+    }
+  }
+
+  Status = FormBuilderInit(&mBuilder, mHiiHandle, &formsetGuid, 0x1, LABEL_PORTS_START, LABEL_PORTS_END);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't initialize form builder: %r\n", Status);
+    HiiRemovePackages(mHiiHandle);
+    return Status;
+  }
+
+  if (Benchmark) {
+    Status = BenchmarkFormBuilder();
+  }
+  if (!EFI_ERROR(Status)) {
+    Status = FormBuilderSetEntryCount(&mBuilder, PortCount);
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! Can't create %d port entries: %r\n", PortCount, Status);
+    }
+  }
+  if (EFI_ERROR(Status)) {
+    FormBuilderFree(&mBuilder);
+    HiiRemovePackages(mHiiHandle);
+  }
   return Status;
 }
@@ -13,6 +13,7 @@
 #include <Library/UefiHiiServicesLib.h>
 #include <Library/UefiLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/VarstoreCacheLib.h>
 #include <Protocol/HiiConfigAccess.h>
 #include "Data.h"
 
@@ -53,7 +54,10 @@ EFI_HII_CONFIG_ACCESS_PROTOCOL mConfigAccess;
 EFI_GUID StorageGuid = STORAGE_GUID;
 EFI_STRING StorageName = L"FormData";
 
-VARIABLE_STRUCTURE FormStorage;
+EFI_GUID EfiStorageGuid = STORAGE_EFI_GUID;
+EFI_STRING EfiStorageName = L"FormEfiData";
+
+VARSTORE_CACHE mFormCache;
 
 STATIC
 EFI_STATUS
@@ -65,42 +69,7 @@ ExtractConfig (
   OUT       EFI_STRING                      *Results
 )
 {
-  BOOLEAN AllocatedRequest = FALSE;
-
-  if (Progress == NULL || Results == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  if ((Request != NULL) && !HiiIsConfigHdrMatch(Request, &StorageGuid, StorageName)) {
-    return EFI_NOT_FOUND;
-  }
-
-  EFI_STRING ConfigRequest = Request;
-  if ((Request == NULL) || (StrStr (Request, L"OFFSET") == NULL)) {
-    EFI_STRING ConfigRequestHdr = HiiConstructConfigHdr(&StorageGuid, StorageName, mDriverHandle);
-    UINTN Size = (StrLen(ConfigRequestHdr) + StrLen(L"&OFFSET=0&WIDTH=") + sizeof(UINTN)*2 + 1) * sizeof(CHAR16);
-    ConfigRequest = AllocateZeroPool(Size);
-    AllocatedRequest = TRUE;
-    UnicodeSPrint(ConfigRequest, Size, L"%s&OFFSET=0&WIDTH=%016LX", ConfigRequestHdr, sizeof(VARIABLE_STRUCTURE));
-    FreePool(ConfigRequestHdr);
-  }
-  EFI_STATUS Status = gHiiConfigRouting->BlockToConfig(gHiiConfigRouting,
-                                                       ConfigRequest,
-                                                       (UINT8*)&FormStorage,
-                                                       sizeof(VARIABLE_STRUCTURE),
-                                                       Results,
-                                                       Progress);
-
-  if (AllocatedRequest) {
-    FreePool(ConfigRequest);
-    if (Request == NULL) {
-      *Progress = NULL;
-    } else if (StrStr(Request, L"OFFSET") == NULL) {
-      *Progress = Request + StrLen(Request);
-    }
-  }
-
-  return Status;
+  return VarstoreCacheExtractConfig(&mFormCache, mDriverHandle, Request, Progress, Results);
 }
 
 STATIC
@@ -112,18 +81,7 @@ RouteConfig (
   OUT       EFI_STRING                      *Progress
 )
 {
-  if (Configuration == NULL || Progress == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  UINTN BlockSize = sizeof(VARIABLE_STRUCTURE);
-  EFI_STATUS Status = gHiiConfigRouting->ConfigToBlock(gHiiConfigRouting,
-                                                       Configuration,
-                                                       (UINT8*)&FormStorage,
-                                                       &BlockSize,
-                                                       Progress);
-
-  return Status;
+  return VarstoreCacheRouteConfig(&mFormCache, Configuration, Progress);
 }
 
 STATIC
@@ -159,20 +117,22 @@ HiddenSettingsUnload (
                              &mConfigAccess,
                              NULL);
 
+  VarstoreCachePrintStats(&mFormCache);
+  VarstoreCacheFree(&mFormCache);
+
   UINTN BufferSize;
   VARIABLE_STRUCTURE EfiVarstore;
   BufferSize = sizeof(VARIABLE_STRUCTURE);
-  EFI_GUID EfiVarGuid = STORAGE_EFI_GUID;
   Status = gRT->GetVariable(
-                L"FormEfiData",
-                &EfiVarGuid,
+                EfiStorageName,
+                &EfiStorageGuid,
                 NULL,
                 &BufferSize,
                 &EfiVarstore);
   if (!EFI_ERROR(Status)) {
     Status = gRT->SetVariable(
-                  L"FormEfiData",
-                  &EfiVarGuid,
+                  EfiStorageName,
+                  &EfiStorageGuid,
                   0,
                   0,
                   NULL);
@@ -191,11 +151,24 @@ HiddenSettingsEntryPoint (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
+  //
+  // The buffer varstore lives only in memory, so the cache is created without variable
+  // attributes: ExtractConfig/RouteConfig work on its buffer and never touch the NVRAM
+  //
+  EFI_STATUS Status;
+  Status = VarstoreCacheInit(&mFormCache,
+                             StorageName,
+                             &StorageGuid,
+                             0,
+                             sizeof(VARIABLE_STRUCTURE));
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
   mConfigAccess.ExtractConfig = &ExtractConfig;
   mConfigAccess.RouteConfig   = &RouteConfig;
   mConfigAccess.Callback      = &Callback;
 
-  EFI_STATUS Status;
   Status = gBS->InstallMultipleProtocolInterfaces(
                   &mDriverHandle,
                   &gEfiDevicePathProtocolGuid,
@@ -205,6 +178,7 @@ HiddenSettingsEntryPoint (
                   NULL
                   );
   if (EFI_ERROR (Status)) {
+    VarstoreCacheFree(&mFormCache);
     return Status;
   }
 
@@ -223,6 +197,7 @@ HiddenSettingsEntryPoint (
            &gEfiHiiConfigAccessProtocolGuid,
            &mConfigAccess,
            NULL);
+    VarstoreCacheFree(&mFormCache);
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -232,18 +207,17 @@ HiddenSettingsEntryPoint (
   UINTN BufferSize;
   VARIABLE_STRUCTURE EfiVarstore;
   BufferSize = sizeof(VARIABLE_STRUCTURE);
-  EFI_GUID EfiVarGuid = STORAGE_EFI_GUID;
   Status = gRT->GetVariable (
-                L"FormEfiData",
-                &EfiVarGuid,
+                EfiStorageName,
+                &EfiStorageGuid,
                 NULL,
                 &BufferSize,
                 &EfiVarstore);
   if (EFI_ERROR(Status)) {
     ZeroMem(&EfiVarstore, sizeof(EfiVarstore));
     Status = gRT->SetVariable(
-                  L"FormEfiData",
-                  &EfiVarGuid,
+                  EfiStorageName,
+                  &EfiStorageGuid,
                   EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
                   sizeof(EfiVarstore),
                   &EfiVarstore);
@@ -251,14 +225,13 @@ HiddenSettingsEntryPoint (
       Print(L"Error! Can't create variable! %r\n", Status);
     }
 
-    ConfigStr = HiiConstructConfigHdr(&EfiVarGuid, L"FormEfiData", mDriverHandle);
-    UINT16 DefaultId = 0;
+    ConfigStr = HiiConstructConfigHdr(&EfiStorageGuid, EfiStorageName, mDriverHandle);
     if (!HiiSetToDefaults(ConfigStr, DefaultId)) {
       Print(L"Error! Can't set default configuration #%d\n", DefaultId);
     }
   }
 
-  ConfigStr = HiiConstructConfigHdr(&StorageGuid, L"FormData", mDriverHandle);
+  ConfigStr = HiiConstructConfigHdr(&StorageGuid, StorageName, mDriverHandle);
   if (!HiiSetToDefaults(ConfigStr, DefaultId)) {
     Print(L"Error! Can't set default configuration #%d\n", DefaultId);
   }
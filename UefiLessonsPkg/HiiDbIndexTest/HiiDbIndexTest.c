@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/HiiLib.h>
+#include <Library/HiiDbIndexLib.h>
+
+//
+// Check that HiiDbIndexLib follows the database changes: add and remove a package list
+// and compare the index generation and the GUID lookup before and after.
+//
+
+STATIC UINTN mFailed = 0;
+
+STATIC
+VOID
+Check (
+  IN BOOLEAN  Condition,
+  IN CHAR16   *Description
+  )
+{
+  Print(L"%s: %s\n", Condition ? L"PASS" : L"FAIL", Description);
+  if (!Condition) {
+    mFailed++;
+  }
+}
+
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS Status = HiiDbIndexInit();
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't build HII database index: %r\n", Status);
+    return Status;
+  }
+
+  UINTN Generation = HiiDbIndexGetGeneration();
+  UINTN Count = HiiDbIndexCountByGuid(&gEfiCallerIdGuid);
+  Check(HiiDbIndexGetGeneration() == Generation, L"generation doesn't change without database changes");
+
+  EFI_HII_HANDLE Handle = HiiAddPackages(&gEfiCallerIdGuid,
+                                         NULL,
+                                         HiiDbIndexTestStrings,
+                                         NULL);
+  if (Handle == NULL) {
+    Print(L"Error! Can't perform HiiAddPackages\n");
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  UINTN AddGeneration = HiiDbIndexGetGeneration();
+  Check(AddGeneration != Generation, L"generation changes after the package list is added");
+  Check(HiiDbIndexCountByGuid(&gEfiCallerIdGuid) == Count + 1, L"added package list is found by GUID");
+  CONST HII_DB_PACKAGE_LIST* List = HiiDbIndexFindByGuid(&gEfiCallerIdGuid, Count);
+  Check((List != NULL) && (List->Handle == Handle), L"added package list has its HII handle");
+
+  HiiRemovePackages(Handle);
+
+  UINTN RemoveGeneration = HiiDbIndexGetGeneration();
+  Check(RemoveGeneration != AddGeneration, L"generation changes after the package list is removed");
+  Check(HiiDbIndexCountByGuid(&gEfiCallerIdGuid) == Count, L"removed package list is not found by GUID");
+
+  for (UINTN i = 0; i < HiiDbIndexGetListCount(); i++) {
+    if (HiiDbIndexGetList(i)->Handle == NULL) {
+      Check(FALSE, L"all package lists have HII handles");
+      break;
+    }
+  }
+
+  Print(L"%d check(s) failed\n", mFailed);
+  return (mFailed == 0) ? EFI_SUCCESS : EFI_ABORTED;
+}
@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Protocol/Shell.h>
+
+#include "BindingConfig.h"
+
+#define KEY_NAME_SIZE  40
+
+typedef struct {
+  CONST CHAR8  *Name;
+  UINT16       ScanCode;
+  CHAR16       UnicodeChar;
+} KEY_NAME;
+
+typedef struct {
+  CONST CHAR8  *Name;
+  UINT32       ShiftState;
+} MODIFIER_NAME;
+
+STATIC CONST KEY_NAME mKeyNames[] = {
+  { "esc",   SCAN_ESC,       CHAR_NULL },
+  { "up",    SCAN_UP,        CHAR_NULL },
+  { "down",  SCAN_DOWN,      CHAR_NULL },
+  { "left",  SCAN_LEFT,      CHAR_NULL },
+  { "right", SCAN_RIGHT,     CHAR_NULL },
+  { "home",  SCAN_HOME,      CHAR_NULL },
+  { "end",   SCAN_END,       CHAR_NULL },
+  { "ins",   SCAN_INSERT,    CHAR_NULL },
+  { "del",   SCAN_DELETE,    CHAR_NULL },
+  { "pgup",  SCAN_PAGE_UP,   CHAR_NULL },
+  { "pgdn",  SCAN_PAGE_DOWN, CHAR_NULL },
+  { "f1",    SCAN_F1,        CHAR_NULL },
+  { "f2",    SCAN_F2,        CHAR_NULL },
+  { "f3",    SCAN_F3,        CHAR_NULL },
+  { "f4",    SCAN_F4,        CHAR_NULL },
+  { "f5",    SCAN_F5,        CHAR_NULL },
+  { "f6",    SCAN_F6,        CHAR_NULL },
+  { "f7",    SCAN_F7,        CHAR_NULL },
+  { "f8",    SCAN_F8,        CHAR_NULL },
+  { "f9",    SCAN_F9,        CHAR_NULL },
+  { "f10",   SCAN_F10,       CHAR_NULL },
+  { "f11",   SCAN_F11,       CHAR_NULL },
+  { "f12",   SCAN_F12,       CHAR_NULL },
+  // Characters that can't be written in the table as is
+  { "space", SCAN_NULL,      L' ' },
+  { "tab",   SCAN_NULL,      CHAR_TAB },
+  { "enter", SCAN_NULL,      CHAR_CARRIAGE_RETURN },
+  { "bs",    SCAN_NULL,      CHAR_BACKSPACE },
+};
+
+STATIC CONST MODIFIER_NAME mModifiers[] = {
+  { "ctrl",   EFI_LEFT_CONTROL_PRESSED },
+  { "alt",    EFI_LEFT_ALT_PRESSED },
+  { "shift",  EFI_LEFT_SHIFT_PRESSED },
+  { "rctrl",  EFI_RIGHT_CONTROL_PRESSED },
+  { "ralt",   EFI_RIGHT_ALT_PRESSED },
+  { "rshift", EFI_RIGHT_SHIFT_PRESSED },
+  { "logo",   EFI_LEFT_LOGO_PRESSED },
+};
+
+// Used when there is no file and no variable, the same keys as HotKeyDriver has
+STATIC CONST CHAR8 mDefaultBindings[] =
+  "ctrl+alt+z print Hot Key 1 is pressed\n"
+  "ctrl+alt+s stats\n";
+
+// Texts of the 'print' bindings
+STATIC CHAR16* mTexts[HOTKEY_SERVICE_MAX_BINDINGS];
+STATIC UINTN mTextCount = 0;
+
+STATIC
+VOID
+KeyName (
+  IN  CONST EFI_KEY_DATA  *Key,
+  OUT CHAR16              *Name
+  )
+{
+  UINTN Length = 0;
+  Name[0] = L'\0';
+  for (UINTN i = 0; i < ARRAY_SIZE(mModifiers); i++) {
+    if (Key->KeyState.KeyShiftState & mModifiers[i].ShiftState) {
+      Length += UnicodeSPrint(Name + Length, (KEY_NAME_SIZE - Length) * sizeof(CHAR16), L"%a+", mModifiers[i].Name);
+    }
+  }
+  for (UINTN i = 0; i < ARRAY_SIZE(mKeyNames); i++) {
+    if ((Key->Key.ScanCode == mKeyNames[i].ScanCode) && (Key->Key.UnicodeChar == mKeyNames[i].UnicodeChar)) {
+      UnicodeSPrint(Name + Length, (KEY_NAME_SIZE - Length) * sizeof(CHAR16), L"%a", mKeyNames[i].Name);
+      return;
+    }
+  }
+  UnicodeSPrint(Name + Length, (KEY_NAME_SIZE - Length) * sizeof(CHAR16), L"%c", Key->Key.UnicodeChar);
+}
+
+STATIC
+VOID
+EFIAPI
+PrintAction (
+  IN EFI_KEY_DATA  *KeyData,
+  IN VOID          *Context
+  )
+{
+  Print(L"\n%s\n", (CHAR16*)Context);
+}
+
+STATIC
+VOID
+EFIAPI
+StatsAction (
+  IN EFI_KEY_DATA  *KeyData,
+  IN VOID          *Context
+  )
+{
+  HOTKEY_SERVICE_PROTOCOL* Service = (HOTKEY_SERVICE_PROTOCOL*)Context;
+  HOTKEY_SERVICE_STATS Stats;
+  CHAR16 Name[KEY_NAME_SIZE];
+
+  Print(L"\n%-20s %8s %8s %10s %10s %10s %11s\n", L"Key", L"Count", L"Dropped", L"Min ns", L"Avg ns", L"Max ns", L"Handler ns");
+  for (UINTN i = 0; !EFI_ERROR(Service->GetStats(Service, i, &Stats)); i++) {
+    UINT64 AvgLatency = 0;
+    UINT64 AvgHandler = 0;
+    if (Stats.Count != 0) {
+      AvgLatency = DivU64x64Remainder(Stats.TotalLatencyNs, Stats.Count, NULL);
+      AvgHandler = DivU64x64Remainder(Stats.TotalHandlerNs, Stats.Count, NULL);
+    }
+    KeyName(&Stats.Key, Name);
+    Print(L"%-20s %8ld %8ld %10ld %10ld %10ld %11ld\n",
+          Name,
+          Stats.Count,
+          Stats.Dropped,
+          Stats.MinLatencyNs,
+          AvgLatency,
+          Stats.MaxLatencyNs,
+          AvgHandler);
+  }
+}
+
+STATIC
+VOID
+EFIAPI
+ResetAction (
+  IN EFI_KEY_DATA  *KeyData,
+  IN VOID          *Context
+  )
+{
+  gRT->ResetSystem(EfiResetCold, EFI_SUCCESS, 0, NULL);
+}
+
+STATIC
+BOOLEAN
+IsSpace (
+  IN CHAR8  Char
+  )
+{
+  return (Char == ' ') || (Char == '\t');
+}
+
+//
+// Cut the first word from the text, Text is moved to the next word
+//
+STATIC
+CHAR8*
+NextWord (
+  IN OUT CHAR8  **Text
+  )
+{
+  CHAR8* Word = *Text;
+  while (IsSpace(*Word)) {
+    Word++;
+  }
+  CHAR8* End = Word;
+  while ((*End != '\0') && !IsSpace(*End)) {
+    End++;
+  }
+  if (*End != '\0') {
+    *End++ = '\0';
+  }
+  while (IsSpace(*End)) {
+    End++;
+  }
+  *Text = End;
+  return Word;
+}
+
+STATIC
+BOOLEAN
+ParseKey (
+  IN  CHAR8         *Text,
+  OUT EFI_KEY_DATA  *Key
+  )
+{
+  ZeroMem(Key, sizeof(EFI_KEY_DATA));
+
+  // '+' as the first character is the key itself, e.g. 'ctrl++'
+  UINT32 ShiftState = 0;
+  CHAR8* Plus;
+  while ((Text[0] != '\0') && ((Plus = AsciiStrStr(Text + 1, "+")) != NULL)) {
+    *Plus = '\0';
+    UINTN i = 0;
+    while ((i < ARRAY_SIZE(mModifiers)) && AsciiStriCmp(Text, mModifiers[i].Name)) {
+      i++;
+    }
+    if (i == ARRAY_SIZE(mModifiers)) {
+      return FALSE;
+    }
+    ShiftState |= mModifiers[i].ShiftState;
+    Text = Plus + 1;
+  }
+  if (ShiftState != 0) {
+    Key->KeyState.KeyShiftState = ShiftState | EFI_SHIFT_STATE_VALID;
+  }
+
+  if (AsciiStrLen(Text) == 1) {
+    Key->Key.UnicodeChar = (CHAR16)Text[0];
+    return TRUE;
+  }
+  for (UINTN i = 0; i < ARRAY_SIZE(mKeyNames); i++) {
+    if (!AsciiStriCmp(Text, mKeyNames[i].Name)) {
+      Key->Key.ScanCode = mKeyNames[i].ScanCode;
+      Key->Key.UnicodeChar = mKeyNames[i].UnicodeChar;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+STATIC
+EFI_STATUS
+AddLineBinding (
+  IN HOTKEY_SERVICE_PROTOCOL  *Service,
+  IN CHAR8                    *Line,
+  IN UINTN                    LineNumber
+  )
+{
+  CHAR8* KeyText = NextWord(&Line);
+  CHAR8* Action = NextWord(&Line);
+  // Rest of the line is the argument, trailing spaces are dropped
+  CHAR8* Argument = Line;
+  UINTN Length = AsciiStrLen(Argument);
+  while ((Length > 0) && IsSpace(Argument[Length - 1])) {
+    Argument[--Length] = '\0';
+  }
+
+  EFI_KEY_DATA Key;
+  if (!ParseKey(KeyText, &Key)) {
+    Print(L"Error! Line %d: unknown key '%a'\n", LineNumber, KeyText);
+    return EFI_INVALID_PARAMETER;
+  }
+
+  HOTKEY_SERVICE_HANDLER Handler;
+  VOID* Context;
+  CHAR16* Text = NULL;
+  if (!AsciiStriCmp(Action, "print")) {
+    if (mTextCount == ARRAY_SIZE(mTexts)) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Text = AllocatePool((Length + 1) * sizeof(CHAR16));
+    if (Text == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    AsciiStrToUnicodeStrS(Argument, Text, Length + 1);
+    Handler = PrintAction;
+    Context = Text;
+  } else if (!AsciiStriCmp(Action, "stats")) {
+    Handler = StatsAction;
+    Context = Service;
+  } else if (!AsciiStriCmp(Action, "reset")) {
+    Handler = ResetAction;
+    Context = NULL;
+  } else {
+    Print(L"Error! Line %d: unknown action '%a'\n", LineNumber, Action);
+    return EFI_INVALID_PARAMETER;
+  }
+
+  EFI_STATUS Status = Service->AddBinding(Service, &Key, Handler, Context, NULL);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Line %d: can't bind key '%a': %r\n", LineNumber, KeyText, Status);
+    if (Text != NULL) {
+      FreePool(Text);
+    }
+    return Status;
+  }
+  if (Text != NULL) {
+    mTexts[mTextCount++] = Text;
+  }
+  return EFI_SUCCESS;
+}
+
+//
+// Text must be null-terminated, it is split to the lines in place
+//
+STATIC
+UINTN
+AddBindings (
+  IN HOTKEY_SERVICE_PROTOCOL  *Service,
+  IN CHAR8                    *Text
+  )
+{
+  UINTN Count = 0;
+  UINTN LineNumber = 1;
+  CHAR8* Line = Text;
+  while (*Line != '\0') {
+    CHAR8* End = Line;
+    while ((*End != '\0') && (*End != '\n') && (*End != '\r') && (*End != ';')) {
+      End++;
+    }
+    CHAR8 Separator = *End;
+    *End = '\0';
+
+    CHAR8* Start = Line;
+    while (IsSpace(*Start)) {
+      Start++;
+    }
+    if ((*Start != '\0') && (*Start != '#')) {
+      if (!EFI_ERROR(AddLineBinding(Service, Start, LineNumber))) {
+        Count++;
+      }
+    }
+
+    if (Separator == '\n') {
+      LineNumber++;
+    }
+    Line = (Separator == '\0') ? End : (End + 1);
+  }
+  return Count;
+}
+
+//
+// The driver doesn't link ShellLib, its constructor fails when the driver is loaded without
+// the shell. The file is read with EFI_SHELL_PROTOCOL if it is present.
+//
+// @retval EFI_UNSUPPORTED  There is no EFI_SHELL_PROTOCOL
+//
+STATIC
+EFI_STATUS
+ReadConfigFile (
+  IN  CHAR16  *FileName,
+  OUT CHAR8   **Text
+  )
+{
+  EFI_SHELL_PROTOCOL* ShellProtocol;
+  EFI_STATUS Status = gBS->LocateProtocol(&gEfiShellProtocolGuid, NULL, (VOID **)&ShellProtocol);
+  if (EFI_ERROR(Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  SHELL_FILE_HANDLE FileHandle;
+  Status = ShellProtocol->OpenFileByName(FileName, &FileHandle, EFI_FILE_MODE_READ);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't open file %s: %r\n", FileName, Status);
+    return Status;
+  }
+
+  UINT64 FileSize;
+  Status = ShellProtocol->GetFileSize(FileHandle, &FileSize);
+  if (EFI_ERROR(Status)) {
+    ShellProtocol->CloseFile(FileHandle);
+    return Status;
+  }
+
+  // Zeroed buffer is null-terminated after the read
+  UINTN Size = (UINTN)FileSize;
+  *Text = AllocateZeroPool(Size + 1);
+  if (*Text == NULL) {
+    ShellProtocol->CloseFile(FileHandle);
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Status = ShellProtocol->ReadFile(FileHandle, &Size, *Text);
+  ShellProtocol->CloseFile(FileHandle);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't read file %s: %r\n", FileName, Status);
+    FreePool(*Text);
+    *Text = NULL;
+  }
+  return Status;
+}
+
+EFI_STATUS
+LoadBindingConfig (
+  IN HOTKEY_SERVICE_PROTOCOL  *Service,
+  IN CHAR16                   *FileName OPTIONAL
+  )
+{
+  CHAR8* Text = NULL;
+  CONST CHAR16* Source = FileName;
+  if (FileName != NULL) {
+    EFI_STATUS Status = ReadConfigFile(FileName, &Text);
+    if (Status == EFI_UNSUPPORTED) {
+      Print(L"HotKeyService: no EFI_SHELL_PROTOCOL, %s is ignored\n", FileName);
+    } else if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  if (Text == NULL) {
+    VOID* Data;
+    UINTN Size;
+    if (!EFI_ERROR(GetVariable2(HOTKEY_BINDINGS_VARIABLE_NAME, &gHotKeyServiceProtocolGuid, &Data, &Size))) {
+      // Variable is not null-terminated
+      Text = AllocateZeroPool(Size + 1);
+      if (Text != NULL) {
+        CopyMem(Text, Data, Size);
+      }
+      FreePool(Data);
+      Source = HOTKEY_BINDINGS_VARIABLE_NAME;
+    } else {
+      Text = AllocateCopyPool(sizeof(mDefaultBindings), mDefaultBindings);
+      Source = L"built-in table";
+    }
+    if (Text == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  UINTN Count = AddBindings(Service, Text);
+  FreePool(Text);
+  Print(L"HotKeyService: %d bindings from %s\n", Count, Source);
+  return EFI_SUCCESS;
+}
+
+VOID
+FreeBindingConfig (
+  VOID
+  )
+{
+  for (UINTN i = 0; i < mTextCount; i++) {
+    FreePool(mTexts[i]);
+  }
+  mTextCount = 0;
+}
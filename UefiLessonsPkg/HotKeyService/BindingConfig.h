@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __BINDING_CONFIG_H__
+#define __BINDING_CONFIG_H__
+
+#include <Uefi.h>
+#include <Protocol/HotKeyService.h>
+
+//
+// Binding table is an ASCII text, one binding per line (';' also ends the binding):
+//   <key> <action> [<argument>]
+// Key is a character or a key name (f1-f12, esc, up, down, left, right, home, end, ins, del,
+// pgup, pgdn, space, tab, enter, bs) with optional modifiers: ctrl+, alt+, shift+, rctrl+, ralt+, rshift+, logo+.
+// Key without modifiers matches any shift state. Actions:
+//   print <text>  print the text
+//   stats         print the latency statistics of all bindings
+//   reset         cold reset
+// Lines that start with '#' are comments. See HotKeyBindings.txt for the example.
+//
+// The table is read from the file, or from the HotKeyBindings variable (gHotKeyServiceProtocolGuid)
+// if the file is not set or there is no EFI_SHELL_PROTOCOL to read it. Built-in bindings are
+// used if there is no variable.
+//
+#define HOTKEY_BINDINGS_VARIABLE_NAME  L"HotKeyBindings"
+
+/**
+  Read the binding table and add all its bindings to the service.
+  Wrong bindings are reported and skipped.
+
+  @param[in] FileName  Binding table file, optional
+**/
+EFI_STATUS
+LoadBindingConfig (
+  IN HOTKEY_SERVICE_PROTOCOL  *Service,
+  IN CHAR16                   *FileName OPTIONAL
+  );
+
+/**
+  Free the action data of the bindings. The bindings must be removed from the service before.
+**/
+VOID
+FreeBindingConfig (
+  VOID
+  );
+
+#endif
@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BenchmarkLib.h>
+
+#include <Protocol/ShellParameters.h>
+#include <Protocol/HotKeyService.h>
+
+#include "BindingConfig.h"
+
+//
+// Dispatch table is an open addressing hash index of the binding slots, it is never
+// more than half full, so every lookup ends on the empty entry quickly
+//
+#define INDEX_SIZE   128
+#define INDEX_EMPTY  0xFF
+
+#define QUEUE_SIZE   16
+
+#define SHIFT_STATE(State)  (((State) & EFI_SHIFT_STATE_VALID) ? (State) : 0)
+
+typedef struct {
+  BOOLEAN                 Used;
+  UINT64                  Key;            // See BindingKey()
+  EFI_KEY_DATA            KeyData;
+  HOTKEY_SERVICE_HANDLER  Handler;
+  VOID                    *Context;
+  VOID                    *NotifyHandle;
+  // Statistics in ticks
+  UINT64                  Count;
+  UINT64                  Dropped;
+  UINT64                  MinLatency;
+  UINT64                  MaxLatency;
+  UINT64                  TotalLatency;
+  UINT64                  TotalHandler;
+} BINDING;
+
+typedef struct {
+  BINDING       *Binding;       // NULL if the binding was removed after the key press
+  EFI_KEY_DATA  KeyData;
+  UINT64        Timestamp;
+} PENDING_KEY;
+
+EFI_HANDLE mHotKeyServiceHandle = NULL;
+
+STATIC EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL* mInputEx = NULL;
+STATIC EFI_EVENT mDispatchEvent = NULL;
+
+STATIC BINDING mBindings[HOTKEY_SERVICE_MAX_BINDINGS];
+STATIC UINT8 mIndex[INDEX_SIZE];
+
+// Queue is filled by the key notification and drained by DispatchKeys(), both at raised TPL
+STATIC PENDING_KEY mQueue[QUEUE_SIZE];
+STATIC UINTN mQueueHead = 0;
+STATIC UINTN mQueueTail = 0;
+
+// Key press that matches both the exact and the any shift state bindings is notified twice
+STATIC UINT64 mSuppressKey = 0;
+STATIC UINTN mSuppressCount = 0;
+
+STATIC
+UINT64
+BindingKey (
+  IN CONST EFI_KEY_DATA  *KeyData
+  )
+{
+  return LShiftU64(KeyData->Key.ScanCode, 48) |
+         LShiftU64(KeyData->Key.UnicodeChar, 32) |
+         SHIFT_STATE(KeyData->KeyState.KeyShiftState);
+}
+
+STATIC
+UINTN
+IndexSlot (
+  IN UINT64  Key
+  )
+{
+  // Fibonacci hashing, the top bits of the product are the best mixed ones
+  return (UINTN)RShiftU64(MultU64x64(Key, 0x9E3779B97F4A7C15ULL), 57) & (INDEX_SIZE - 1);
+}
+
+STATIC
+BINDING*
+FindBinding (
+  IN UINT64  Key
+  )
+{
+  for (UINTN i = IndexSlot(Key); mIndex[i] != INDEX_EMPTY; i = (i + 1) & (INDEX_SIZE - 1)) {
+    if (mBindings[mIndex[i]].Key == Key) {
+      return &mBindings[mIndex[i]];
+    }
+  }
+  return NULL;
+}
+
+STATIC
+VOID
+IndexBinding (
+  IN UINTN  Slot
+  )
+{
+  UINTN i = IndexSlot(mBindings[Slot].Key);
+  while (mIndex[i] != INDEX_EMPTY) {
+    i = (i + 1) & (INDEX_SIZE - 1);
+  }
+  mIndex[i] = (UINT8)Slot;
+}
+
+//
+// Open addressing can't just clear the entry, so the index is built again after the removal
+//
+STATIC
+VOID
+RebuildIndex (
+  VOID
+  )
+{
+  SetMem(mIndex, sizeof(mIndex), INDEX_EMPTY);
+  for (UINTN Slot = 0; Slot < HOTKEY_SERVICE_MAX_BINDINGS; Slot++) {
+    if (mBindings[Slot].Used) {
+      IndexBinding(Slot);
+    }
+  }
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HotKeyNotify (
+  IN EFI_KEY_DATA  *KeyData
+  )
+{
+  UINT64 Timestamp = BenchmarkGetTicks();
+  UINT64 Key = BindingKey(KeyData);
+  if ((mSuppressCount > 0) && (Key == mSuppressKey)) {
+    mSuppressCount--;
+    return EFI_SUCCESS;
+  }
+
+  BINDING* Exact = FindBinding(Key);
+  BINDING* AnyShift = (SHIFT_STATE(KeyData->KeyState.KeyShiftState) != 0) ? FindBinding(Key & ~(UINT64)MAX_UINT32) : NULL;
+  BINDING* Binding = (Exact != NULL) ? Exact : AnyShift;
+  if (Binding == NULL) {
+    return EFI_SUCCESS;
+  }
+  mSuppressKey = Key;
+  mSuppressCount = ((Exact != NULL) && (AnyShift != NULL)) ? 1 : 0;
+
+  if (mQueueTail - mQueueHead >= QUEUE_SIZE) {
+    Binding->Dropped++;
+    return EFI_SUCCESS;
+  }
+  PENDING_KEY* Pending = &mQueue[mQueueTail % QUEUE_SIZE];
+  Pending->Binding = Binding;
+  CopyMem(&Pending->KeyData, KeyData, sizeof(EFI_KEY_DATA));
+  Pending->Timestamp = Timestamp;
+  mQueueTail++;
+
+  gBS->SignalEvent(mDispatchEvent);
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+EFIAPI
+DispatchKeys (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  while (TRUE) {
+    EFI_TPL OldTpl = gBS->RaiseTPL(TPL_NOTIFY);
+    if (mQueueHead == mQueueTail) {
+      gBS->RestoreTPL(OldTpl);
+      break;
+    }
+    PENDING_KEY Pending = mQueue[mQueueHead % QUEUE_SIZE];
+    mQueueHead++;
+    gBS->RestoreTPL(OldTpl);
+
+    BINDING* Binding = Pending.Binding;
+    if (Binding == NULL) {
+      continue;
+    }
+    UINT64 Start = BenchmarkGetTicks();
+    Binding->Handler(&Pending.KeyData, Binding->Context);
+    UINT64 End = BenchmarkGetTicks();
+
+    // Handler could remove its own binding
+    if (!Binding->Used) {
+      continue;
+    }
+    UINT64 Latency = Start - Pending.Timestamp;
+    if ((Binding->Count == 0) || (Latency < Binding->MinLatency)) {
+      Binding->MinLatency = Latency;
+    }
+    if (Latency > Binding->MaxLatency) {
+      Binding->MaxLatency = Latency;
+    }
+    Binding->TotalLatency += Latency;
+    Binding->TotalHandler += End - Start;
+    Binding->Count++;
+  }
+}
+
+EFI_STATUS
+EFIAPI
+HotKeyServiceAddBinding (
+  IN  HOTKEY_SERVICE_PROTOCOL  *This,
+  IN  CONST EFI_KEY_DATA       *Key,
+  IN  HOTKEY_SERVICE_HANDLER   Handler,
+  IN  VOID                     *Context OPTIONAL,
+  OUT VOID                     **Binding OPTIONAL
+  )
+{
+  if ((Key == NULL) || (Handler == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (FindBinding(BindingKey(Key)) != NULL) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  UINTN Slot = 0;
+  while ((Slot < HOTKEY_SERVICE_MAX_BINDINGS) && mBindings[Slot].Used) {
+    Slot++;
+  }
+  if (Slot == HOTKEY_SERVICE_MAX_BINDINGS) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  BINDING* NewBinding = &mBindings[Slot];
+  ZeroMem(NewBinding, sizeof(BINDING));
+  CopyMem(&NewBinding->KeyData, Key, sizeof(EFI_KEY_DATA));
+  NewBinding->KeyData.KeyState.KeyShiftState = SHIFT_STATE(Key->KeyState.KeyShiftState);
+  NewBinding->KeyData.KeyState.KeyToggleState = 0;
+  NewBinding->Key = BindingKey(&NewBinding->KeyData);
+  NewBinding->Handler = Handler;
+  NewBinding->Context = Context;
+
+  // Key presses before the binding gets to the index are just ignored by the notification
+  EFI_STATUS Status = mInputEx->RegisterKeyNotify(
+                                  mInputEx,
+                                  &NewBinding->KeyData,
+                                  HotKeyNotify,
+                                  &NewBinding->NotifyHandle
+                                  );
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  EFI_TPL OldTpl = gBS->RaiseTPL(TPL_NOTIFY);
+  NewBinding->Used = TRUE;
+  IndexBinding(Slot);
+  gBS->RestoreTPL(OldTpl);
+
+  if (Binding != NULL) {
+    *Binding = NewBinding;
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HotKeyServiceRemoveBinding (
+  IN HOTKEY_SERVICE_PROTOCOL  *This,
+  IN VOID                     *Binding
+  )
+{
+  BINDING* OldBinding = (BINDING*)Binding;
+  if ((OldBinding < mBindings) || (OldBinding >= mBindings + HOTKEY_SERVICE_MAX_BINDINGS) || !OldBinding->Used) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  EFI_TPL OldTpl = gBS->RaiseTPL(TPL_NOTIFY);
+  OldBinding->Used = FALSE;
+  RebuildIndex();
+  for (UINTN i = mQueueHead; i != mQueueTail; i++) {
+    if (mQueue[i % QUEUE_SIZE].Binding == OldBinding) {
+      mQueue[i % QUEUE_SIZE].Binding = NULL;
+    }
+  }
+  gBS->RestoreTPL(OldTpl);
+
+  return mInputEx->UnregisterKeyNotify(mInputEx, OldBinding->NotifyHandle);
+}
+
+EFI_STATUS
+EFIAPI
+HotKeyServiceGetStats (
+  IN  HOTKEY_SERVICE_PROTOCOL  *This,
+  IN  UINTN                    Index,
+  OUT HOTKEY_SERVICE_STATS     *Stats
+  )
+{
+  if (Stats == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (UINTN Slot = 0; Slot < HOTKEY_SERVICE_MAX_BINDINGS; Slot++) {
+    if (!mBindings[Slot].Used) {
+      continue;
+    }
+    if (Index > 0) {
+      Index--;
+      continue;
+    }
+    BINDING* Binding = &mBindings[Slot];
+    CopyMem(&Stats->Key, &Binding->KeyData, sizeof(EFI_KEY_DATA));
+    Stats->Count = Binding->Count;
+    Stats->Dropped = Binding->Dropped;
+    Stats->MinLatencyNs = BenchmarkTicksToNs(Binding->MinLatency);
+    Stats->MaxLatencyNs = BenchmarkTicksToNs(Binding->MaxLatency);
+    Stats->TotalLatencyNs = BenchmarkTicksToNs(Binding->TotalLatency);
+    Stats->TotalHandlerNs = BenchmarkTicksToNs(Binding->TotalHandler);
+    return EFI_SUCCESS;
+  }
+  return EFI_NOT_FOUND;
+}
+
+HOTKEY_SERVICE_PROTOCOL mHotKeyService = {
+  HotKeyServiceAddBinding,
+  HotKeyServiceRemoveBinding,
+  HotKeyServiceGetStats
+};
+
+STATIC
+VOID
+RemoveAllBindings (
+  VOID
+  )
+{
+  for (UINTN Slot = 0; Slot < HOTKEY_SERVICE_MAX_BINDINGS; Slot++) {
+    if (mBindings[Slot].Used) {
+      HotKeyServiceRemoveBinding(&mHotKeyService, &mBindings[Slot]);
+    }
+  }
+}
+
+EFI_STATUS
+EFIAPI
+HotKeyServiceUnload (
+  IN EFI_HANDLE        ImageHandle
+  )
+{
+  EFI_STATUS Status = gBS->UninstallMultipleProtocolInterfaces(
+                             mHotKeyServiceHandle,
+                             &gHotKeyServiceProtocolGuid,
+                             &mHotKeyService,
+                             NULL
+                             );
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't uninstall HOTKEY_SERVICE_PROTOCOL: %r\n", Status);
+    return Status;
+  }
+
+  RemoveAllBindings();
+  gBS->CloseEvent(mDispatchEvent);
+  FreeBindingConfig();
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+HotKeyServiceEntryPoint (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  // ConIn handle has the console splitter protocol, so the keys of all keyboards are received
+  EFI_STATUS Status = gBS->HandleProtocol(
+                             gST->ConsoleInHandle,
+                             &gEfiSimpleTextInputExProtocolGuid,
+                             (VOID**)&mInputEx
+                             );
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't get EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL: %r\n", Status);
+    return Status;
+  }
+
+  CHAR16* FileName = NULL;
+  EFI_SHELL_PARAMETERS_PROTOCOL* ShellParameters;
+  if (!EFI_ERROR(gBS->HandleProtocol(ImageHandle, &gEfiShellParametersProtocolGuid, (VOID **) &ShellParameters))) {
+    for (UINTN i = 1; i < ShellParameters->Argc; i++) {
+      if (!StrCmp(ShellParameters->Argv[i], L"-f") && ((i + 1) < ShellParameters->Argc)) {
+        FileName = ShellParameters->Argv[++i];
+      } else {
+        Print(L"Usage:\n");
+        Print(L"  HotKeyService [-f <file>]\n");
+        Print(L"    -f <file>  read bindings from the file instead of the HotKeyBindings variable\n");
+        return EFI_INVALID_PARAMETER;
+      }
+    }
+  }
+
+  SetMem(mIndex, sizeof(mIndex), INDEX_EMPTY);
+  Status = gBS->CreateEvent(
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  DispatchKeys,
+                  NULL,
+                  &mDispatchEvent
+                  );
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't create dispatch event: %r\n", Status);
+    return Status;
+  }
+
+  Status = gBS->InstallMultipleProtocolInterfaces(
+                  &mHotKeyServiceHandle,
+                  &gHotKeyServiceProtocolGuid,
+                  &mHotKeyService,
+                  NULL
+                  );
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't install HOTKEY_SERVICE_PROTOCOL: %r\n", Status);
+    gBS->CloseEvent(mDispatchEvent);
+    return Status;
+  }
+
+  Status = LoadBindingConfig(&mHotKeyService, FileName);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't load bindings: %r\n", Status);
+    gBS->UninstallMultipleProtocolInterfaces(
+           mHotKeyServiceHandle,
+           &gHotKeyServiceProtocolGuid,
+           &mHotKeyService,
+           NULL
+           );
+    RemoveAllBindings();
+    gBS->CloseEvent(mDispatchEvent);
+    FreeBindingConfig();
+    return Status;
+  }
+
+  return EFI_SUCCESS;
+}
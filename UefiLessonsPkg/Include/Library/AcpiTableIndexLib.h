@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __ACPI_TABLE_INDEX_LIB_H__
+#define __ACPI_TABLE_INDEX_LIB_H__
+
+#include <Uefi.h>
+#include <Protocol/AcpiSystemDescriptionTable.h>
+
+//
+// Index of the installed ACPI tables by signature.
+//
+// Tables are enumerated with EFI_ACPI_SDT_PROTOCOL once on the first use. Tables installed
+// later are added to the index through the EFI_ACPI_SDT_PROTOCOL.RegisterNotify() callback.
+// The callback is unregistered in the library destructor.
+//
+// The protocol has no notification about the uninstalled tables, so the index keeps the
+// table key of every table, and a lookup checks the keys of the tables with the requested
+// signature with EFI_ACPI_SDT_PROTOCOL.OpenSdt(). If some table is not installed anymore,
+// the tables are enumerated again.
+//
+// Returned pointers point to the installed tables, they are valid only while the table
+// stays installed. Don't keep them across the code that can uninstall or replace ACPI tables,
+// look the table up again instead.
+//
+
+/**
+  Enumerate the installed ACPI tables. It is called implicitly by the lookup functions,
+  so it is needed only to get the error status.
+
+  @retval EFI_SUCCESS    Index is ready
+  @retval EFI_NOT_FOUND  EFI_ACPI_SDT_PROTOCOL is not present in the system
+**/
+EFI_STATUS
+AcpiTableIndexInit (
+  VOID
+  );
+
+/**
+  Get the table with the signature. Instance is the index among the tables with
+  the same signature in the order of the installation (e.g. for SSDT tables).
+
+  @return Pointer to the installed table or NULL if there is no such table
+**/
+EFI_ACPI_SDT_HEADER*
+AcpiTableIndexFind (
+  IN UINT32  Signature,
+  IN UINTN   Instance
+  );
+
+/**
+  Get the count of the tables with the signature.
+**/
+UINTN
+AcpiTableIndexCount (
+  IN UINT32  Signature
+  );
+
+#endif
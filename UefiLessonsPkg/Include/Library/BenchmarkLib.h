@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __BENCHMARK_LIB_H__
+#define __BENCHMARK_LIB_H__
+
+#include <Uefi.h>
+
+//
+// Simple TSC-based time measurement.
+// TSC frequency is calibrated against gBS->Stall() on the first conversion.
+//
+
+/**
+  Get the current timestamp in ticks.
+**/
+UINT64
+BenchmarkGetTicks (
+  VOID
+  );
+
+/**
+  Get the tick frequency in Hz.
+**/
+UINT64
+BenchmarkGetFrequency (
+  VOID
+  );
+
+/**
+  Convert the difference of two timestamps to nanoseconds.
+**/
+UINT64
+BenchmarkTicksToNs (
+  IN UINT64  Ticks
+  );
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __CALLBACK_TRACE_LIB_H__
+#define __CALLBACK_TRACE_LIB_H__
+
+#include <Uefi.h>
+#include <Uefi/UefiInternalFormRepresentation.h>
+#include <Protocol/CallbackTrace.h>
+
+//
+// Fixed-size trace ring for the form callbacks.
+//
+// CallbackTraceRecord() doesn't allocate memory, doesn't print and doesn't take locks,
+// a slot is reserved with an atomic increment, so the callback timing stays close to the
+// untraced one. When the ring is full the oldest entries are overwritten.
+// The ring is exposed with CALLBACK_TRACE_PROTOCOL for CallbackTraceDump.efi.
+//
+#define CALLBACK_TRACE_SIZE  1024
+
+/**
+  Install CALLBACK_TRACE_PROTOCOL on the driver handle.
+**/
+EFI_STATUS
+CallbackTraceInstall (
+  IN EFI_HANDLE  Handle,
+  IN EFI_GUID    *FormSetGuid
+  );
+
+EFI_STATUS
+CallbackTraceUninstall (
+  IN EFI_HANDLE  Handle
+  );
+
+/**
+  Append the callback to the trace, call it at the start of the Callback() function.
+**/
+VOID
+CallbackTraceRecord (
+  IN EFI_BROWSER_ACTION  Action,
+  IN EFI_QUESTION_ID     QuestionId,
+  IN UINT8               Type,
+  IN EFI_IFR_TYPE_VALUE  *Value
+  );
+
+#endif
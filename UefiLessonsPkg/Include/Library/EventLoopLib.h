@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __EVENT_LOOP_LIB_H__
+#define __EVENT_LOOP_LIB_H__
+
+#include <Uefi.h>
+
+//
+// Cooperative event loop for the interactive applications.
+//
+// Key presses, periodic timers, protocol installations and arbitrary wait events are
+// multiplexed in a single WaitForEvent() call, so the application can refresh its status
+// while it waits for the input and doesn't need to poll.
+// After WaitForEvent() returns, the loop checks all other sources with CheckEvent(), so a
+// busy source (e.g. a fast timer) can't starve the sources that follow it in the array.
+// Handlers are called from the loop at the application TPL, so they can use the console
+// and call EventLoopStop() to leave EventLoopRun().
+//
+#define EVENT_LOOP_MAX_SOURCES  16
+
+typedef struct _EVENT_LOOP  EVENT_LOOP;
+
+typedef
+VOID
+(EFIAPI* EVENT_LOOP_HANDLER)(
+  IN EVENT_LOOP  *Loop,
+  IN VOID        *Context
+  );
+
+typedef
+VOID
+(EFIAPI* EVENT_LOOP_KEY_HANDLER)(
+  IN EVENT_LOOP     *Loop,
+  IN EFI_INPUT_KEY  *Key,
+  IN VOID           *Context
+  );
+
+typedef
+VOID
+(EFIAPI* EVENT_LOOP_PROTOCOL_HANDLER)(
+  IN EVENT_LOOP  *Loop,
+  IN EFI_HANDLE  Handle,
+  IN VOID        *Context
+  );
+
+typedef enum {
+  EventLoopSourceEvent,
+  EventLoopSourceKey,
+  EventLoopSourceTimer,
+  EventLoopSourceProtocol
+} EVENT_LOOP_SOURCE_TYPE;
+
+typedef struct {
+  EVENT_LOOP_SOURCE_TYPE       Type;
+  EVENT_LOOP_HANDLER           Handler;
+  EVENT_LOOP_KEY_HANDLER       KeyHandler;
+  EVENT_LOOP_PROTOCOL_HANDLER  ProtocolHandler;
+  VOID                         *Context;
+  VOID                         *Registration;   // RegisterProtocolNotify() registration
+} EVENT_LOOP_SOURCE;
+
+struct _EVENT_LOOP {
+  // Events[] is passed to WaitForEvent() as is, Sources[] has the same indexes
+  EFI_EVENT          Events[EVENT_LOOP_MAX_SOURCES];
+  EVENT_LOOP_SOURCE  Sources[EVENT_LOOP_MAX_SOURCES];
+  UINTN              Count;
+  BOOLEAN            Running;
+};
+
+VOID
+EventLoopInit (
+  OUT EVENT_LOOP  *Loop
+  );
+
+/**
+  Close the events created by the loop. Events added with EventLoopAddEvent()
+  belong to the caller and are not closed.
+**/
+VOID
+EventLoopFree (
+  IN EVENT_LOOP  *Loop
+  );
+
+/**
+  Call the handler when the event is signaled. The event must not be EVT_NOTIFY_SIGNAL.
+
+  @retval EFI_OUT_OF_RESOURCES  All EVENT_LOOP_MAX_SOURCES sources are used
+**/
+EFI_STATUS
+EventLoopAddEvent (
+  IN EVENT_LOOP          *Loop,
+  IN EFI_EVENT           Event,
+  IN EVENT_LOOP_HANDLER  Handler,
+  IN VOID                *Context OPTIONAL
+  );
+
+/**
+  Call the handler for every key stroke from gST->ConIn.
+**/
+EFI_STATUS
+EventLoopAddKey (
+  IN EVENT_LOOP              *Loop,
+  IN EVENT_LOOP_KEY_HANDLER  Handler,
+  IN VOID                    *Context OPTIONAL
+  );
+
+/**
+  Call the handler periodically. Ticks that are missed while the loop is busy are merged.
+
+  @param[in] PeriodMs  Timer period in milliseconds
+**/
+EFI_STATUS
+EventLoopAddTimer (
+  IN EVENT_LOOP          *Loop,
+  IN UINTN               PeriodMs,
+  IN EVENT_LOOP_HANDLER  Handler,
+  IN VOID                *Context OPTIONAL
+  );
+
+/**
+  Call the handler for every handle with the protocol installed after this call.
+**/
+EFI_STATUS
+EventLoopAddProtocolNotify (
+  IN EVENT_LOOP                   *Loop,
+  IN EFI_GUID                     *Protocol,
+  IN EVENT_LOOP_PROTOCOL_HANDLER  Handler,
+  IN VOID                         *Context OPTIONAL
+  );
+
+/**
+  Wait for the sources and call their handlers until EventLoopStop() is called.
+**/
+EFI_STATUS
+EventLoopRun (
+  IN EVENT_LOOP  *Loop
+  );
+
+VOID
+EventLoopStop (
+  IN EVENT_LOOP  *Loop
+  );
+
+#endif
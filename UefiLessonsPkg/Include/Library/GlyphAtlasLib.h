@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __GLYPH_ATLAS_LIB_H__
+#define __GLYPH_ATLAS_LIB_H__
+
+#include <Uefi.h>
+#include <Uefi/UefiInternalFormRepresentation.h>
+#include <Protocol/GraphicsOutput.h>
+#include <Library/GopDrawLib.h>
+
+//
+// Text rendering from the glyphs of the simple font packages (EFI_HII_SIMPLE_FONT_PACKAGE_HDR).
+//
+// Every glyph is rasterized once into the atlas as a ready EFI_GRAPHICS_OUTPUT_BLT_PIXEL
+// cell (EFI_GLYPH_WIDTH or 2 * EFI_GLYPH_WIDTH pixels wide, EFI_GLYPH_HEIGHT pixels high)
+// with the atlas colors, so drawing a string is just a copy of the glyph rows.
+// Glyph lookup is a direct table indexed by the character code.
+// Characters without a glyph are drawn as the empty narrow cell.
+//
+#define GLYPH_ATLAS_NONE      MAX_UINT32  // Glyphs[] value for the character without a glyph
+#define GLYPH_ATLAS_WIDE      BIT31       // Glyphs[] flag of the wide glyph, other bits are the offset in Pixels
+
+typedef struct {
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Foreground;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Background;
+  UINT32                         *Glyphs;          // Pixel offset of every CHAR16 glyph or GLYPH_ATLAS_NONE
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Pixels;          // Glyph cells, the first one is the empty narrow cell
+  UINTN                          PixelCount;
+  UINTN                          PixelCapacity;
+  UINTN                          GlyphCount;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *LineBuffer;      // String image for GlyphAtlasBltString
+  UINTN                          LineBufferWidth;
+} GLYPH_ATLAS;
+
+/**
+  Create the empty atlas for the colors.
+**/
+EFI_STATUS
+GlyphAtlasInit (
+  OUT GLYPH_ATLAS                    *Atlas,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Foreground,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Background
+  );
+
+VOID
+GlyphAtlasFree (
+  IN GLYPH_ATLAS  *Atlas
+  );
+
+/**
+  Rasterize the glyphs of the simple font package. Characters that are already in the atlas
+  keep their glyphs, the same way the first registered glyph wins in the HII database.
+  Non-spacing glyphs are skipped, they can't be drawn as a separate cell.
+**/
+EFI_STATUS
+GlyphAtlasAddSimpleFontPackage (
+  IN GLYPH_ATLAS                            *Atlas,
+  IN CONST EFI_HII_SIMPLE_FONT_PACKAGE_HDR  *Package
+  );
+
+/**
+  Rasterize the glyphs of all simple font packages in the HII database.
+**/
+EFI_STATUS
+GlyphAtlasAddRegisteredFonts (
+  IN GLYPH_ATLAS  *Atlas
+  );
+
+/**
+  Get the width of the string in pixels.
+**/
+UINTN
+GlyphAtlasStringWidth (
+  IN GLYPH_ATLAS   *Atlas,
+  IN CONST CHAR16  *String
+  );
+
+/**
+  Draw the string to the GopDrawLib off-screen buffer and add it to the dirty rectangle.
+  The string is clipped to the screen.
+
+  @return Width of the drawn string in pixels
+**/
+UINTN
+GlyphAtlasDrawString (
+  IN GLYPH_ATLAS       *Atlas,
+  IN GOP_DRAW_CONTEXT  *Context,
+  IN UINTN             X,
+  IN UINTN             Y,
+  IN CONST CHAR16      *String
+  );
+
+/**
+  Draw the string directly to the screen with a single Blt call.
+  The string is clipped to the screen.
+**/
+EFI_STATUS
+GlyphAtlasBltString (
+  IN GLYPH_ATLAS                   *Atlas,
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL  *Gop,
+  IN UINTN                         X,
+  IN UINTN                         Y,
+  IN CONST CHAR16                  *String
+  );
+
+#endif
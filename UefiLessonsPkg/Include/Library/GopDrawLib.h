@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __GOP_DRAW_LIB_H__
+#define __GOP_DRAW_LIB_H__
+
+#include <Uefi.h>
+#include <Protocol/GraphicsOutput.h>
+
+//
+// Double-buffered drawing on top of EFI_GRAPHICS_OUTPUT_PROTOCOL.
+//
+// All drawing goes to the off-screen buffer, the screen is updated only on flush.
+// The library keeps the bounding rectangle of everything that was drawn since
+// the last flush, so GopDrawFlushDirty() transfers only the changed area.
+//
+
+typedef struct {
+  EFI_GRAPHICS_OUTPUT_PROTOCOL   *Gop;
+  UINTN                          Width;
+  UINTN                          Height;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *BackBuffer;
+  // Dirty rectangle, Right/Bottom are exclusive, the rectangle is empty if Right == 0
+  UINTN                          DirtyLeft;
+  UINTN                          DirtyTop;
+  UINTN                          DirtyRight;
+  UINTN                          DirtyBottom;
+} GOP_DRAW_CONTEXT;
+
+/**
+  Allocate the off-screen buffer for the current GOP mode.
+  Must be called again after the mode change.
+**/
+EFI_STATUS
+GopDrawInit (
+  IN  EFI_GRAPHICS_OUTPUT_PROTOCOL  *Gop,
+  OUT GOP_DRAW_CONTEXT              *Context
+  );
+
+/**
+  Free the off-screen buffer.
+**/
+VOID
+GopDrawFree (
+  IN GOP_DRAW_CONTEXT  *Context
+  );
+
+/**
+  Fill the rectangle in the off-screen buffer. The rectangle is clipped to the screen.
+**/
+VOID
+GopDrawFillRect (
+  IN GOP_DRAW_CONTEXT               *Context,
+  IN UINTN                          X,
+  IN UINTN                          Y,
+  IN UINTN                          Width,
+  IN UINTN                          Height,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Color
+  );
+
+/**
+  Add the rectangle to the dirty area after drawing directly to BackBuffer.
+  The rectangle is clipped to the screen.
+**/
+VOID
+GopDrawMarkDirty (
+  IN GOP_DRAW_CONTEXT  *Context,
+  IN UINTN             X,
+  IN UINTN             Y,
+  IN UINTN             Width,
+  IN UINTN             Height
+  );
+
+/**
+  Transfer the whole off-screen buffer to the screen with a single Blt call.
+**/
+EFI_STATUS
+GopDrawFlush (
+  IN GOP_DRAW_CONTEXT  *Context
+  );
+
+/**
+  Transfer only the dirty rectangle to the screen with a single Blt call.
+**/
+EFI_STATUS
+GopDrawFlushDirty (
+  IN GOP_DRAW_CONTEXT  *Context
+  );
+
+/**
+  Copy the whole off-screen buffer directly to the framebuffer.
+
+  @retval EFI_UNSUPPORTED  Mode has no linear framebuffer (PixelBltOnly) or uses PixelBitMask format
+**/
+EFI_STATUS
+GopDrawFlushFrameBuffer (
+  IN GOP_DRAW_CONTEXT  *Context
+  );
+
+/**
+  Check if GopDrawFlushFrameBuffer() is supported in the current mode.
+**/
+BOOLEAN
+GopDrawHasFrameBuffer (
+  IN GOP_DRAW_CONTEXT  *Context
+  );
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __HII_DB_INDEX_LIB_H__
+#define __HII_DB_INDEX_LIB_H__
+
+#include <Uefi.h>
+#include <Protocol/HiiDatabase.h>
+
+//
+// Index of the HII database package lists by GUID and of the packages by type.
+//
+// The whole database is exported with a single ExportPackageLists() call on the first use,
+// after that lookups don't call the protocol at all. Package changes are tracked with the
+// EFI_HII_DATABASE_PROTOCOL.RegisterPackageNotify() callbacks (NEW_PACK, ADD_PACK and
+// REMOVE_PACK for every standard package type), they only remember the handles of the
+// changed package lists. On the next lookup only these package lists are exported again
+// and the lists that are not in the database anymore are dropped. The whole database is
+// exported again only if there are too many changes or they don't match the listed handles.
+// The callbacks are unregistered in the library destructor.
+//
+// Pointers returned by the library point into the exported copy of the database, they
+// stay valid until the next lookup after the database change (see HiiDbIndexGetGeneration).
+//
+
+typedef struct {
+  EFI_HII_HANDLE               Handle;
+  EFI_HII_PACKAGE_LIST_HEADER  *PackageList;
+} HII_DB_PACKAGE_LIST;
+
+typedef struct {
+  EFI_HII_PACKAGE_HEADER  *Package;
+  UINTN                   ListIndex;           // Index of the package list that contains the package
+} HII_DB_PACKAGE;
+
+/**
+  Export the database and build the index if it is not built yet or the database
+  has changed. It is called implicitly by the lookup functions, so it is needed only
+  to get the error status.
+
+  @retval EFI_SUCCESS    Index is ready
+  @retval EFI_NOT_FOUND  EFI_HII_DATABASE_PROTOCOL is not present in the system
+  @retval EFI_ABORTED    Database kept changing during the export, handles can't be matched to the package lists
+**/
+EFI_STATUS
+HiiDbIndexInit (
+  VOID
+  );
+
+/**
+  Get the index generation. It is incremented every time the index is updated after
+  the database change, so the users can detect that their cached pointers are not valid anymore.
+**/
+UINTN
+HiiDbIndexGetGeneration (
+  VOID
+  );
+
+/**
+  Get the exported database, e.g. to save it as a whole.
+**/
+EFI_STATUS
+HiiDbIndexGetDatabase (
+  OUT EFI_HII_PACKAGE_LIST_HEADER  **Database,
+  OUT UINTN                        *Size
+  );
+
+/**
+  Get the count of the package lists in the database.
+**/
+UINTN
+HiiDbIndexGetListCount (
+  VOID
+  );
+
+/**
+  Get the package list by its index in the database order.
+
+  @return Package list or NULL if Index is out of range
+**/
+CONST HII_DB_PACKAGE_LIST*
+HiiDbIndexGetList (
+  IN UINTN  Index
+  );
+
+/**
+  Get the count of the package lists with the GUID.
+**/
+UINTN
+HiiDbIndexCountByGuid (
+  IN CONST EFI_GUID  *Guid
+  );
+
+/**
+  Get the package list with the GUID. Instance is the index among the package lists
+  with the same GUID in the database order.
+
+  @return Package list or NULL if there is no such package list
+**/
+CONST HII_DB_PACKAGE_LIST*
+HiiDbIndexFindByGuid (
+  IN CONST EFI_GUID  *Guid,
+  IN UINTN           Instance
+  );
+
+/**
+  Get the count of the packages of the type in all package lists.
+**/
+UINTN
+HiiDbIndexCountByType (
+  IN UINT8  Type
+  );
+
+/**
+  Get the package of the type. Instance is the index among all the packages
+  of the type in the database order.
+
+  @return Package or NULL if there is no such package
+**/
+CONST HII_DB_PACKAGE*
+HiiDbIndexFindByType (
+  IN UINT8  Type,
+  IN UINTN  Instance
+  );
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __HII_STRING_DECODER_LIB_H__
+#define __HII_STRING_DECODER_LIB_H__
+
+#include <Uefi.h>
+#include <Uefi/UefiInternalFormRepresentation.h>
+
+//
+// Random access to the strings of a STRINGS package.
+//
+// All the SIBT blocks of the package are walked once in HiiStringDecoderInit(), and the
+// offset of every string text is saved to a table indexed by the string ID. After that
+// string lookups don't walk the blocks and don't allocate memory.
+// The decoder points into the package, so the package must stay valid while it is used.
+//
+
+typedef struct {
+  CONST EFI_HII_STRING_PACKAGE_HDR  *Package;
+  CONST CHAR8                       *Language;
+  UINTN                             StringCount;     // String IDs are 1..StringCount - 1
+  UINT32                            *Offsets;        // HII_STRING_OFFSET_* encoded text offsets, 0 if there is no string
+} HII_STRING_DECODER;
+
+//
+// Offsets[] element: offset of the string text from the package start and its encoding
+//
+#define HII_STRING_OFFSET_SCSU  BIT31
+#define HII_STRING_OFFSET_MASK  (BIT31 - 1)
+
+/**
+  Walk the SIBT blocks of the STRINGS package and build the string ID table.
+
+  @retval EFI_SUCCESS            Decoder is ready
+  @retval EFI_INVALID_PARAMETER  Package is not a STRINGS package
+  @retval EFI_VOLUME_CORRUPTED   Package has a broken block
+**/
+EFI_STATUS
+HiiStringDecoderInit (
+  OUT HII_STRING_DECODER                *Decoder,
+  IN  CONST EFI_HII_STRING_PACKAGE_HDR  *Package
+  );
+
+/**
+  Create decoders for all the STRINGS packages of the package list, one per language.
+  Free them with HiiStringDecoderFreeArray().
+**/
+EFI_STATUS
+HiiStringDecoderInitPackageList (
+  IN  CONST EFI_HII_PACKAGE_LIST_HEADER  *PackageList,
+  OUT HII_STRING_DECODER                 **Decoders,
+  OUT UINTN                              *DecoderCount
+  );
+
+VOID
+HiiStringDecoderFree (
+  IN HII_STRING_DECODER  *Decoder
+  );
+
+VOID
+HiiStringDecoderFreeArray (
+  IN HII_STRING_DECODER  *Decoders,
+  IN UINTN               DecoderCount
+  );
+
+/**
+  Check if the string with the ID is present in the package.
+**/
+BOOLEAN
+HiiStringDecoderHasString (
+  IN CONST HII_STRING_DECODER  *Decoder,
+  IN EFI_STRING_ID             StringId
+  );
+
+/**
+  Copy the string to the buffer. SCSU strings are expanded to UCS2 the same way the
+  HII database does it, i.e. every byte is a character.
+
+  @param[in]      Decoder     Decoder
+  @param[in]      StringId    String ID
+  @param[out]     Buffer      Output buffer, can be NULL if *BufferSize is 0
+  @param[in, out] BufferSize  On input the size of Buffer in bytes, on output the size
+                              of the string including the terminating null
+
+  @retval EFI_SUCCESS           String is copied
+  @retval EFI_NOT_FOUND         There is no string with the ID
+  @retval EFI_BUFFER_TOO_SMALL  Buffer is too small, *BufferSize is updated
+**/
+EFI_STATUS
+HiiStringDecoderGetString (
+  IN     CONST HII_STRING_DECODER  *Decoder,
+  IN     EFI_STRING_ID             StringId,
+  OUT    CHAR16                    *Buffer OPTIONAL,
+  IN OUT UINTN                     *BufferSize
+  );
+
+#endif
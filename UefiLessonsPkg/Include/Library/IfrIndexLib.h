@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __IFR_INDEX_LIB_H__
+#define __IFR_INDEX_LIB_H__
+
+#include <Uefi.h>
+#include <Uefi/UefiInternalFormRepresentation.h>
+
+//
+// Index of the questions from all the FORMS packages of the HII database.
+//
+// The IFR opcode stream of every FORMS package from HiiDbIndexLib is parsed once, the index
+// is rebuilt only when the HII database changes. Varstores with the same GUID and name are
+// merged, so questions from different formsets that use the same storage are found together.
+//
+
+#define IFR_INDEX_NOT_FOUND     MAX_UINTN
+#define IFR_MAX_DEFAULTS        4
+#define IFR_VARSTORE_NAME_SIZE  64
+
+//
+// IFR_QUESTION.Flags
+//
+#define IFR_QUESTION_BIT_FIELD  BIT0      // Question is placed in a bit varstore, see BitOffset/BitWidth
+
+typedef struct {
+  EFI_GUID       Guid;
+  EFI_STRING_ID  Title;
+  UINTN          PackageList;           // Index of the package list in HiiDbIndexLib
+  UINTN          FirstQuestion;         // Questions of the formset are FirstQuestion..FirstQuestion + QuestionCount - 1
+  UINTN          QuestionCount;
+} IFR_FORMSET;
+
+typedef struct {
+  EFI_GUID  Guid;
+  CHAR8     Name[IFR_VARSTORE_NAME_SIZE];   // Empty for name/value varstores
+  UINT8     OpCode;                         // EFI_IFR_VARSTORE_OP, EFI_IFR_VARSTORE_EFI_OP or EFI_IFR_VARSTORE_NAME_VALUE_OP
+  UINT32    Attributes;                     // Only for EFI_IFR_VARSTORE_EFI_OP
+  UINT16    Size;
+  UINTN     QuestionCount;
+} IFR_VARSTORE;
+
+typedef struct {
+  UINT16  DefaultId;          // EFI_HII_DEFAULT_CLASS_STANDARD, EFI_HII_DEFAULT_CLASS_MANUFACTURING, ...
+  UINT64  Value;
+} IFR_DEFAULT;
+
+typedef struct {
+  EFI_QUESTION_ID  QuestionId;
+  EFI_STRING_ID    Prompt;
+  EFI_STRING_ID    Help;
+  UINT8            OpCode;            // EFI_IFR_CHECKBOX_OP, EFI_IFR_ONE_OF_OP, EFI_IFR_NUMERIC_OP, ...
+  UINT8            Flags;             // IFR_QUESTION_*
+  EFI_FORM_ID      FormId;
+  UINTN            FormSet;
+  UINTN            VarStore;          // IFR_INDEX_NOT_FOUND if the question has no storage
+  UINT16           Offset;            // Byte offset in the buffer varstore or the name string ID in the name/value varstore
+  UINT16           Width;             // Storage width in bytes
+  UINT16           BitOffset;         // Only for IFR_QUESTION_BIT_FIELD
+  UINT8            BitWidth;          // Only for IFR_QUESTION_BIT_FIELD
+  UINTN            DefaultCount;
+  IFR_DEFAULT      Defaults[IFR_MAX_DEFAULTS];
+} IFR_QUESTION;
+
+/**
+  Parse the FORMS packages and build the index if it is not built yet or the HII database
+  has changed. It is called implicitly by the lookup functions, so it is needed only to get
+  the error status.
+**/
+EFI_STATUS
+IfrIndexInit (
+  VOID
+  );
+
+UINTN
+IfrIndexGetFormSetCount (
+  VOID
+  );
+
+CONST IFR_FORMSET*
+IfrIndexGetFormSet (
+  IN UINTN  Index
+  );
+
+/**
+  Get the count of the formsets in the package list.
+
+  @param[in] PackageList  Index of the package list in HiiDbIndexLib
+**/
+UINTN
+IfrIndexCountFormSetsInList (
+  IN UINTN  PackageList
+  );
+
+/**
+  Get the formset of the package list. Instance is the index among the formsets
+  of the package list in the database order.
+
+  @return Formset or NULL if there is no such formset
+**/
+CONST IFR_FORMSET*
+IfrIndexFindFormSetInList (
+  IN UINTN  PackageList,
+  IN UINTN  Instance
+  );
+
+UINTN
+IfrIndexGetVarStoreCount (
+  VOID
+  );
+
+CONST IFR_VARSTORE*
+IfrIndexGetVarStore (
+  IN UINTN  Index
+  );
+
+UINTN
+IfrIndexGetQuestionCount (
+  VOID
+  );
+
+CONST IFR_QUESTION*
+IfrIndexGetQuestion (
+  IN UINTN  Index
+  );
+
+/**
+  Find the varstore by GUID and name. Guid can be NULL to match any GUID.
+
+  @return Varstore index or IFR_INDEX_NOT_FOUND
+**/
+UINTN
+IfrIndexFindVarStore (
+  IN CONST EFI_GUID  *Guid OPTIONAL,
+  IN CONST CHAR8     *Name
+  );
+
+/**
+  Find the question by its ID in the formset.
+**/
+CONST IFR_QUESTION*
+IfrIndexFindQuestion (
+  IN UINTN            FormSet,
+  IN EFI_QUESTION_ID  QuestionId
+  );
+
+/**
+  Find the questions that own the byte at Offset of the buffer varstore. Several questions
+  can share the same storage (e.g. bit fields or the same setting on different forms),
+  Instance selects one of them in the offset order.
+
+  @return Question or NULL if there are no more owners
+**/
+CONST IFR_QUESTION*
+IfrIndexFindOwner (
+  IN UINTN  VarStore,
+  IN UINTN  Offset,
+  IN UINTN  Instance
+  );
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __SAVE_FILE_LIB_H__
+#define __SAVE_FILE_LIB_H__
+
+#include <Uefi.h>
+
+//
+// Save a buffer as a file with the ShellLib file functions, for the shell applications
+// that export their data (tables, dumps, CSV reports).
+//
+
+/**
+  Create or overwrite the file and write the data to it. Progress and errors are printed.
+
+  @param[in]      FileName  File name, relative to the current shell directory or absolute
+  @param[in]      Data      Data to write
+  @param[in, out] Size      On input the size of Data, on output the count of written bytes
+
+  @retval EFI_SUCCESS        All data was written
+  @retval EFI_DEVICE_ERROR   Not all data was written
+  @retval Others             Error of the file open/write/close
+**/
+EFI_STATUS
+SaveFile (
+  IN     CHAR16  *FileName,
+  IN     VOID    *Data,
+  IN OUT UINTN   *Size
+  );
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __VARSTORE_CACHE_LIB_H__
+#define __VARSTORE_CACHE_LIB_H__
+
+#include <Uefi.h>
+
+//
+// Hits and WritesAvoided count only the variable services calls that the cache really saved,
+// so they stay 0 for the in-memory buffer storage (Attributes == 0).
+//
+typedef struct {
+  UINTN Hits;           // Reads and ExtractConfig requests served from memory instead of gRT->GetVariable
+  UINTN Misses;         // gRT->GetVariable calls
+  UINTN Updates;        // Writes/RouteConfig requests that changed the data
+  UINTN WritesAvoided;  // Writes/RouteConfig requests with byte-identical data that skipped gRT->SetVariable
+  UINTN NvWrites;       // gRT->SetVariable calls (writes and deletes)
+} VARSTORE_CACHE_STATS;
+
+//
+// Write-back cache for a HII varstore.
+//
+// The varstore content is kept in memory. If the cache is backed by a UEFI variable
+// (Attributes != 0) the variable is read once at init and written only on flush when
+// some range of the data has really changed.
+//
+typedef struct {
+  EFI_STRING            Name;
+  EFI_GUID              Guid;
+  UINT32                Attributes;   // 0 - in-memory buffer storage without UEFI variable
+  UINTN                 Size;
+  UINT8*                Buffer;       // Cached varstore data
+  UINT8*                Scratch;      // Temporary buffer for the incoming configuration
+  BOOLEAN               Present;      // UEFI variable exists in the NVRAM
+  UINTN                 DirtyStart;
+  UINTN                 DirtyEnd;     // DirtyStart == DirtyEnd - no unflushed changes
+  VARSTORE_CACHE_STATS  Stats;
+} VARSTORE_CACHE;
+
+/**
+  Initialize the cache and load the UEFI variable content into it.
+
+  @retval EFI_SUCCESS      Cache is ready, variable content is loaded (if the cache is backed by a variable)
+  @retval EFI_NOT_FOUND    Cache is ready, but the UEFI variable doesn't exist. Buffer is zeroed.
+**/
+EFI_STATUS
+VarstoreCacheInit (
+  OUT VARSTORE_CACHE  *Cache,
+  IN  EFI_STRING      Name,
+  IN  EFI_GUID        *Guid,
+  IN  UINT32          Attributes,
+  IN  UINTN           Size
+  );
+
+VOID
+VarstoreCacheFree (
+  IN VARSTORE_CACHE  *Cache
+  );
+
+/**
+  Drop the cached data and read the UEFI variable again.
+  Use it when the variable could be changed bypassing the cache (for example by HiiSetToDefaults).
+**/
+EFI_STATUS
+VarstoreCacheReload (
+  IN VARSTORE_CACHE  *Cache
+  );
+
+EFI_STATUS
+VarstoreCacheRead (
+  IN  VARSTORE_CACHE  *Cache,
+  IN  UINTN           Offset,
+  IN  UINTN           Width,
+  OUT VOID            *Data
+  );
+
+/**
+  Update the cached data. Nothing is written to the NVRAM until VarstoreCacheFlush.
+**/
+EFI_STATUS
+VarstoreCacheWrite (
+  IN VARSTORE_CACHE  *Cache,
+  IN UINTN           Offset,
+  IN UINTN           Width,
+  IN CONST VOID      *Data
+  );
+
+/**
+  Write the cached data to the UEFI variable if there are unflushed changes
+  or if the variable doesn't exist yet.
+**/
+EFI_STATUS
+VarstoreCacheFlush (
+  IN VARSTORE_CACHE  *Cache
+  );
+
+/**
+  Delete the UEFI variable behind the cache.
+**/
+EFI_STATUS
+VarstoreCacheDelete (
+  IN VARSTORE_CACHE  *Cache
+  );
+
+/**
+  EFI_HII_CONFIG_ACCESS_PROTOCOL.ExtractConfig() implementation served from the cache.
+**/
+EFI_STATUS
+VarstoreCacheExtractConfig (
+  IN  VARSTORE_CACHE    *Cache,
+  IN  EFI_HANDLE        DriverHandle,
+  IN  CONST EFI_STRING  Request,
+  OUT EFI_STRING        *Progress,
+  OUT EFI_STRING        *Results
+  );
+
+/**
+  EFI_HII_CONFIG_ACCESS_PROTOCOL.RouteConfig() implementation.
+  Byte-identical configuration doesn't touch the NVRAM, otherwise the changed range is flushed.
+**/
+EFI_STATUS
+VarstoreCacheRouteConfig (
+  IN  VARSTORE_CACHE    *Cache,
+  IN  CONST EFI_STRING  Configuration,
+  OUT EFI_STRING        *Progress
+  );
+
+VOID
+VarstoreCachePrintStats (
+  IN VARSTORE_CACHE  *Cache
+  );
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __CALLBACK_TRACE_PROTOCOL_H__
+#define __CALLBACK_TRACE_PROTOCOL_H__
+
+//
+// Trace of the EFI_HII_CONFIG_ACCESS_PROTOCOL.Callback() calls of a form driver.
+// Installed by CallbackTraceLib on the driver handle, drained by CallbackTraceDump.efi.
+//
+
+typedef struct _CALLBACK_TRACE_PROTOCOL  CALLBACK_TRACE_PROTOCOL;
+
+typedef struct {
+  UINT64 Timestamp;     // Ticks of the callback start, see CALLBACK_TRACE_PROTOCOL.Frequency
+  UINT64 Value;         // First 8 bytes of EFI_IFR_TYPE_VALUE: number, boolean, date, time or string ID
+  UINT32 Sequence;      // Number of the callback since the driver start
+  UINT32 Action;        // EFI_BROWSER_ACTION
+  UINT16 QuestionId;
+  UINT8  Type;          // EFI_IFR_TYPE_*
+  UINT8  Reserved[5];
+} CALLBACK_TRACE_ENTRY;
+
+/**
+  Copy the oldest unread entries and remove them from the trace.
+
+  @param[out]    Entries  Buffer for the entries
+  @param[in,out] Count    Buffer size in entries on input, number of the copied entries on output
+  @param[out]    Dropped  Number of the entries that were overwritten before they were read, optional
+**/
+typedef
+EFI_STATUS
+(EFIAPI* CALLBACK_TRACE_READ)(
+  IN     CALLBACK_TRACE_PROTOCOL  *This,
+  OUT    CALLBACK_TRACE_ENTRY     *Entries,
+  IN OUT UINTN                    *Count,
+  OUT    UINT64                   *Dropped OPTIONAL
+  );
+
+struct _CALLBACK_TRACE_PROTOCOL {
+  EFI_GUID            FormSetGuid;
+  UINT64              Frequency;       // Timestamp ticks per second
+  UINT32              Capacity;        // Entries that the trace keeps before the oldest are overwritten
+  CALLBACK_TRACE_READ Read;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __HOTKEY_SERVICE_PROTOCOL_H__
+#define __HOTKEY_SERVICE_PROTOCOL_H__
+
+#include <Protocol/SimpleTextInEx.h>
+
+//
+// Hotkey dispatch service installed by HotKeyService.efi.
+//
+// Every binding is registered with EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL.RegisterKeyNotify().
+// The key notification only looks up the binding and queues the key press, handlers are
+// called later from a TPL_CALLBACK event, so they can use the console.
+//
+// Binding key is ScanCode, UnicodeChar and KeyShiftState of EFI_KEY_DATA. KeyShiftState 0
+// matches the key with any shift state, the same way RegisterKeyNotify() does it, and the
+// binding with the exact shift state wins over such a binding. KeyToggleState is ignored.
+//
+
+#define HOTKEY_SERVICE_MAX_BINDINGS  64
+
+typedef struct _HOTKEY_SERVICE_PROTOCOL  HOTKEY_SERVICE_PROTOCOL;
+
+typedef
+VOID
+(EFIAPI* HOTKEY_SERVICE_HANDLER)(
+  IN EFI_KEY_DATA  *KeyData,
+  IN VOID          *Context
+  );
+
+typedef struct {
+  EFI_KEY_DATA  Key;
+  UINT64        Count;            // Handled key presses
+  UINT64        Dropped;          // Key presses lost because the dispatch queue was full
+  UINT64        MinLatencyNs;     // Time from the key notification to the handler call
+  UINT64        MaxLatencyNs;
+  UINT64        TotalLatencyNs;
+  UINT64        TotalHandlerNs;   // Time spent in the handler
+} HOTKEY_SERVICE_STATS;
+
+/**
+  Add the binding and register its key with RegisterKeyNotify().
+
+  @param[out] Binding  Binding handle for RemoveBinding(), optional
+
+  @retval EFI_ALREADY_STARTED   Key is already bound
+  @retval EFI_OUT_OF_RESOURCES  All HOTKEY_SERVICE_MAX_BINDINGS bindings are used
+**/
+typedef
+EFI_STATUS
+(EFIAPI* HOTKEY_SERVICE_ADD_BINDING)(
+  IN  HOTKEY_SERVICE_PROTOCOL  *This,
+  IN  CONST EFI_KEY_DATA       *Key,
+  IN  HOTKEY_SERVICE_HANDLER   Handler,
+  IN  VOID                     *Context OPTIONAL,
+  OUT VOID                     **Binding OPTIONAL
+  );
+
+/**
+  Unregister the key notification and remove the binding.
+  Key presses that are queued but not handled yet are dropped.
+**/
+typedef
+EFI_STATUS
+(EFIAPI* HOTKEY_SERVICE_REMOVE_BINDING)(
+  IN HOTKEY_SERVICE_PROTOCOL  *This,
+  IN VOID                     *Binding
+  );
+
+/**
+  Get the statistics of the binding. Bindings are enumerated with Index 0, 1, ...
+
+  @retval EFI_NOT_FOUND  Index is bigger than the number of bindings
+**/
+typedef
+EFI_STATUS
+(EFIAPI* HOTKEY_SERVICE_GET_STATS)(
+  IN  HOTKEY_SERVICE_PROTOCOL  *This,
+  IN  UINTN                    Index,
+  OUT HOTKEY_SERVICE_STATS     *Stats
+  );
+
+struct _HOTKEY_SERVICE_PROTOCOL {
+  HOTKEY_SERVICE_ADD_BINDING     AddBinding;
+  HOTKEY_SERVICE_REMOVE_BINDING  RemoveBinding;
+  HOTKEY_SERVICE_GET_STATS       GetStats;
+};
+
+#endif
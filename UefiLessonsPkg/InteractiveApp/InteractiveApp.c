@@ -6,6 +6,64 @@
 
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
+#include <Library/EventLoopLib.h>
+
+#define STATUS_WIDTH  28
+
+typedef struct {
+  UINTN  Attempts;
+  UINTN  Seconds;
+} GAME_STATE;
+
+VOID
+EFIAPI
+KeyHandler (
+  IN EVENT_LOOP     *Loop,
+  IN EFI_INPUT_KEY  *Key,
+  IN VOID           *Context
+  )
+{
+  GAME_STATE *State = (GAME_STATE*)Context;
+
+  Print(L"ScanCode = %04x, UnicodeChar = %04x (%c)\n", Key->ScanCode, Key->UnicodeChar, Key->UnicodeChar);
+
+  if (Key->UnicodeChar == 'k') {
+    Print(L"Correct!\n");
+    EventLoopStop(Loop);
+  } else if (Key->UnicodeChar == 'q') {
+    Print(L"Bye!\n");
+    EventLoopStop(Loop);
+  } else {
+    Print(L"Wrong!\n");
+    State->Attempts++;
+  }
+}
+
+VOID
+EFIAPI
+StatusHandler (
+  IN EVENT_LOOP  *Loop,
+  IN VOID        *Context
+  )
+{
+  GAME_STATE *State = (GAME_STATE*)Context;
+  UINTN Columns;
+  UINTN Rows;
+  INT32 CursorColumn;
+  INT32 CursorRow;
+
+  State->Seconds++;
+
+  // Draw the status in the top right corner and return the cursor back
+  if (EFI_ERROR(gST->ConOut->QueryMode(gST->ConOut, gST->ConOut->Mode->Mode, &Columns, &Rows)) || (Columns <= STATUS_WIDTH)) {
+    return;
+  }
+  CursorColumn = gST->ConOut->Mode->CursorColumn;
+  CursorRow = gST->ConOut->Mode->CursorRow;
+  gST->ConOut->SetCursorPosition(gST->ConOut, Columns - STATUS_WIDTH, 0);
+  Print(L"Time: %4ds, wrong: %4d", State->Seconds, State->Attempts);
+  gST->ConOut->SetCursorPosition(gST->ConOut, CursorColumn, CursorRow);
+}
 
 EFI_STATUS
 EFIAPI
@@ -14,27 +72,27 @@ UefiMain (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
-  UINTN Index;
-  EFI_INPUT_KEY Key;
+  EFI_STATUS Status;
+  EVENT_LOOP Loop;
+  GAME_STATE State = {0, 0};
 
   Print(L"Try to guess the secret symbol!\n");
   Print(L"To quit press 'q'\n");
 
-  while(TRUE) {
-    gBS->WaitForEvent(1, &(gST->ConIn->WaitForKey), &Index);
-    gST->ConIn->ReadKeyStroke(gST->ConIn, &Key);
-    Print(L"ScanCode = %04x, UnicodeChar = %04x (%c)\n", Key.ScanCode, Key.UnicodeChar, Key.UnicodeChar);
-
-    if (Key.UnicodeChar == 'k') {
-      Print(L"Correct!\n");
-      break;
-    } else if (Key.UnicodeChar == 'q') {
-      Print(L"Bye!\n");
-      break;
-    } else {
-      Print(L"Wrong!\n");
-    }
+  // Keys and the status timer are waited in a single WaitForEvent() call
+  EventLoopInit(&Loop);
+  Status = EventLoopAddKey(&Loop, KeyHandler, &State);
+  if (!EFI_ERROR(Status)) {
+    Status = EventLoopAddTimer(&Loop, 1000, StatusHandler, &State);
+  }
+  if (!EFI_ERROR(Status)) {
+    Status = EventLoopRun(&Loop);
   }
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Event loop failed: %r\n", Status);
+  }
+  EventLoopFree(&Loop);
+
   gST->ConIn->Reset(gST->ConIn, FALSE);
   return EFI_SUCCESS;
 }
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#define BUCKETS_COUNT  64    // Must be a power of 2
+
+typedef struct {
+  EFI_ACPI_SDT_HEADER  *Table;
+  UINTN                TableKey;
+} TABLE_ENTRY;
+
+typedef struct _SIGNATURE_ENTRY SIGNATURE_ENTRY;
+struct _SIGNATURE_ENTRY {
+  SIGNATURE_ENTRY      *Next;
+  UINT32               Signature;
+  UINTN                Count;
+  UINTN                Capacity;
+  TABLE_ENTRY          *Tables;
+};
+
+STATIC EFI_ACPI_SDT_PROTOCOL* mAcpiSdt = NULL;
+STATIC SIGNATURE_ENTRY* mBuckets[BUCKETS_COUNT];
+STATIC BOOLEAN mNotifyRegistered = FALSE;
+
+STATIC
+UINTN
+SignatureHash (
+  IN UINT32  Signature
+  )
+{
+  // Fibonacci hashing, take the upper bits
+  return (UINTN)(((UINT32)(Signature * 0x9E3779B9U)) >> 26) & (BUCKETS_COUNT - 1);
+}
+
+STATIC
+SIGNATURE_ENTRY*
+FindEntry (
+  IN UINT32  Signature
+  )
+{
+  SIGNATURE_ENTRY* Entry = mBuckets[SignatureHash(Signature)];
+  while ((Entry != NULL) && (Entry->Signature != Signature)) {
+    Entry = Entry->Next;
+  }
+  return Entry;
+}
+
+STATIC
+EFI_STATUS
+AddTable (
+  IN EFI_ACPI_SDT_HEADER  *Table,
+  IN UINTN                TableKey
+  )
+{
+  SIGNATURE_ENTRY* Entry = FindEntry(Table->Signature);
+  if (Entry == NULL) {
+    Entry = AllocateZeroPool(sizeof(SIGNATURE_ENTRY));
+    if (Entry == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    UINTN Bucket = SignatureHash(Table->Signature);
+    Entry->Signature = Table->Signature;
+    Entry->Next = mBuckets[Bucket];
+    mBuckets[Bucket] = Entry;
+  }
+
+  for (UINTN i = 0; i < Entry->Count; i++) {
+    if (Entry->Tables[i].TableKey == TableKey) {
+      Entry->Tables[i].Table = Table;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (Entry->Count == Entry->Capacity) {
+    UINTN NewCapacity = (Entry->Capacity == 0) ? 1 : Entry->Capacity * 2;
+    TABLE_ENTRY* NewTables = ReallocatePool(Entry->Capacity * sizeof(TABLE_ENTRY),
+                                            NewCapacity * sizeof(TABLE_ENTRY),
+                                            Entry->Tables);
+    if (NewTables == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Entry->Tables = NewTables;
+    Entry->Capacity = NewCapacity;
+  }
+  Entry->Tables[Entry->Count].Table = Table;
+  Entry->Tables[Entry->Count].TableKey = TableKey;
+  Entry->Count++;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+AcpiTableInstalled (
+  IN EFI_ACPI_SDT_HEADER     *Table,
+  IN EFI_ACPI_TABLE_VERSION  Version,
+  IN UINTN                   TableKey
+  )
+{
+  DEBUG ((EFI_D_INFO, "AcpiTableIndex: table 0x%08x is installed\n", Table->Signature));
+  return AddTable(Table, TableKey);
+}
+
+STATIC
+VOID
+FreeIndex (
+  VOID
+  )
+{
+  for (UINTN i = 0; i < BUCKETS_COUNT; i++) {
+    while (mBuckets[i] != NULL) {
+      SIGNATURE_ENTRY* Entry = mBuckets[i];
+      mBuckets[i] = Entry->Next;
+      if (Entry->Tables != NULL) {
+        FreePool(Entry->Tables);
+      }
+      FreePool(Entry);
+    }
+  }
+}
+
+STATIC
+EFI_STATUS
+EnumerateTables (
+  IN EFI_ACPI_SDT_PROTOCOL  *AcpiSdt
+  )
+{
+  UINTN Index = 0;
+  EFI_ACPI_SDT_HEADER* Table;
+  EFI_ACPI_TABLE_VERSION Version;
+  UINTN TableKey;
+  while (!EFI_ERROR(AcpiSdt->GetAcpiTable(Index, &Table, &Version, &TableKey))) {
+    EFI_STATUS Status = AddTable(Table, TableKey);
+    if (EFI_ERROR(Status)) {
+      FreeIndex();
+      return Status;
+    }
+    Index++;
+  }
+  return EFI_SUCCESS;
+}
+
+//
+// There is no notification about the uninstalled tables, so the keys of the tables with
+// the signature are checked before they are returned. If some table is not installed anymore,
+// the index is built again.
+//
+STATIC
+SIGNATURE_ENTRY*
+FindValidEntry (
+  IN UINT32  Signature
+  )
+{
+  SIGNATURE_ENTRY* Entry = FindEntry(Signature);
+  if (Entry == NULL) {
+    return NULL;
+  }
+
+  for (UINTN i = 0; i < Entry->Count; i++) {
+    EFI_ACPI_HANDLE Handle;
+    if (EFI_ERROR(mAcpiSdt->OpenSdt(Entry->Tables[i].TableKey, &Handle))) {
+      DEBUG ((EFI_D_INFO, "AcpiTableIndex: table 0x%08x is not installed anymore\n", Signature));
+      FreeIndex();
+      if (EFI_ERROR(EnumerateTables(mAcpiSdt))) {
+        return NULL;
+      }
+      return FindEntry(Signature);
+    }
+    mAcpiSdt->Close(Handle);
+  }
+  return Entry;
+}
+
+EFI_STATUS
+AcpiTableIndexInit (
+  VOID
+  )
+{
+  if (mAcpiSdt != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  EFI_ACPI_SDT_PROTOCOL* AcpiSdt;
+  EFI_STATUS Status = gBS->LocateProtocol(&gEfiAcpiSdtProtocolGuid,
+                                          NULL,
+                                          (VOID**)&AcpiSdt);
+  if (EFI_ERROR(Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = EnumerateTables(AcpiSdt);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  Status = AcpiSdt->RegisterNotify(TRUE, AcpiTableInstalled);
+  mNotifyRegistered = !EFI_ERROR(Status);
+  if (!mNotifyRegistered) {
+    DEBUG ((EFI_D_ERROR, "AcpiTableIndex: can't register notify function: %r\n", Status));
+  }
+
+  mAcpiSdt = AcpiSdt;
+  return EFI_SUCCESS;
+}
+
+EFI_ACPI_SDT_HEADER*
+AcpiTableIndexFind (
+  IN UINT32  Signature,
+  IN UINTN   Instance
+  )
+{
+  if (EFI_ERROR(AcpiTableIndexInit())) {
+    return NULL;
+  }
+
+  SIGNATURE_ENTRY* Entry = FindValidEntry(Signature);
+  if ((Entry == NULL) || (Instance >= Entry->Count)) {
+    return NULL;
+  }
+  return Entry->Tables[Instance].Table;
+}
+
+UINTN
+AcpiTableIndexCount (
+  IN UINT32  Signature
+  )
+{
+  if (EFI_ERROR(AcpiTableIndexInit())) {
+    return 0;
+  }
+
+  SIGNATURE_ENTRY* Entry = FindValidEntry(Signature);
+  return (Entry != NULL) ? Entry->Count : 0;
+}
+
+EFI_STATUS
+EFIAPI
+AcpiTableIndexLibDestructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  //
+  // The notify function is a part of this image, it must not stay registered after unload
+  //
+  if (mNotifyRegistered) {
+    mAcpiSdt->RegisterNotify(FALSE, AcpiTableInstalled);
+    mNotifyRegistered = FALSE;
+  }
+  FreeIndex();
+  mAcpiSdt = NULL;
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/BaseLib.h>
+#include <Library/BenchmarkLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#define CALIBRATION_TIME_US  10000
+
+STATIC UINT64 mTscFrequency = 0;
+
+UINT64
+BenchmarkGetTicks (
+  VOID
+  )
+{
+  return AsmReadTsc();
+}
+
+UINT64
+BenchmarkGetFrequency (
+  VOID
+  )
+{
+  if (mTscFrequency == 0) {
+    UINT64 Start = AsmReadTsc();
+    gBS->Stall(CALIBRATION_TIME_US);
+    UINT64 End = AsmReadTsc();
+    mTscFrequency = MultU64x32(End - Start, 1000000 / CALIBRATION_TIME_US);
+    if (mTscFrequency == 0) {
+      mTscFrequency = 1;
+    }
+  }
+  return mTscFrequency;
+}
+
+UINT64
+BenchmarkTicksToNs (
+  IN UINT64  Ticks
+  )
+{
+  UINT64 Frequency = BenchmarkGetFrequency();
+  UINT64 Remainder;
+  UINT64 Seconds = DivU64x64Remainder(Ticks, Frequency, &Remainder);
+  // Remainder < Frequency, so the multiplication doesn't overflow for any real TSC frequency
+  return MultU64x32(Seconds, 1000000000) + DivU64x64Remainder(MultU64x32(Remainder, 1000000000), Frequency, NULL);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BenchmarkLib.h>
+#include <Library/CallbackTraceLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+//
+// mTraceHead counts the reserved slots, mTraceTail counts the read ones. Entry of the slot is
+// valid when its Sequence matches the expected number, the writer sets INVALID_SEQUENCE first
+// and the real number after the entry is filled. The reader copies the entry and checks the
+// number again, so an entry overwritten during the copy is dropped, not returned torn.
+// Only one reader is supported.
+//
+#define INVALID_SEQUENCE  MAX_UINT32
+
+STATIC CALLBACK_TRACE_ENTRY     mTraceRing[CALLBACK_TRACE_SIZE];
+STATIC volatile UINT32          mTraceHead = 0;
+STATIC UINT32                   mTraceTail = 0;
+STATIC CALLBACK_TRACE_PROTOCOL  mCallbackTrace;
+
+VOID
+CallbackTraceRecord (
+  IN EFI_BROWSER_ACTION  Action,
+  IN EFI_QUESTION_ID     QuestionId,
+  IN UINT8               Type,
+  IN EFI_IFR_TYPE_VALUE  *Value
+  )
+{
+  UINT64 Timestamp = BenchmarkGetTicks();
+  UINT32 Sequence = InterlockedIncrement(&mTraceHead) - 1;
+  CALLBACK_TRACE_ENTRY* Entry = &mTraceRing[Sequence % CALLBACK_TRACE_SIZE];
+
+  Entry->Sequence = INVALID_SEQUENCE;
+  MemoryFence();
+  Entry->Timestamp = Timestamp;
+  Entry->Action = (UINT32)Action;
+  Entry->QuestionId = QuestionId;
+  Entry->Type = Type;
+  Entry->Value = 0;
+  if (Value != NULL) {
+    // Only the bytes of the value type, the rest of the union can be garbage
+    switch (Type) {
+      case EFI_IFR_TYPE_NUM_SIZE_8:
+        Entry->Value = Value->u8;
+        break;
+      case EFI_IFR_TYPE_BOOLEAN:
+        Entry->Value = Value->b;
+        break;
+      case EFI_IFR_TYPE_NUM_SIZE_16:
+        Entry->Value = Value->u16;
+        break;
+      case EFI_IFR_TYPE_STRING:
+        Entry->Value = Value->string;
+        break;
+      case EFI_IFR_TYPE_NUM_SIZE_32:
+        Entry->Value = Value->u32;
+        break;
+      case EFI_IFR_TYPE_NUM_SIZE_64:
+        Entry->Value = Value->u64;
+        break;
+      case EFI_IFR_TYPE_DATE:
+        CopyMem(&Entry->Value, &Value->date, sizeof(EFI_HII_DATE));
+        break;
+      case EFI_IFR_TYPE_TIME:
+        CopyMem(&Entry->Value, &Value->time, sizeof(EFI_HII_TIME));
+        break;
+    }
+  }
+  MemoryFence();
+  Entry->Sequence = Sequence;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+CallbackTraceRead (
+  IN     CALLBACK_TRACE_PROTOCOL  *This,
+  OUT    CALLBACK_TRACE_ENTRY     *Entries,
+  IN OUT UINTN                    *Count,
+  OUT    UINT64                   *Dropped OPTIONAL
+  )
+{
+  if ((Count == NULL) || ((Entries == NULL) && (*Count != 0))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UINT64 Lost = 0;
+  UINTN Copied = 0;
+  while (Copied < *Count) {
+    UINT32 Head = mTraceHead;
+    if (Head == mTraceTail) {
+      break;
+    }
+    if ((UINT32)(Head - mTraceTail) > CALLBACK_TRACE_SIZE) {
+      Lost += (UINT32)(Head - mTraceTail) - CALLBACK_TRACE_SIZE;
+      mTraceTail = Head - CALLBACK_TRACE_SIZE;
+    }
+
+    CALLBACK_TRACE_ENTRY* Slot = &mTraceRing[mTraceTail % CALLBACK_TRACE_SIZE];
+    UINT32 Sequence = Slot->Sequence;
+    if ((Sequence == INVALID_SEQUENCE) || ((INT32)(Sequence - mTraceTail) < 0)) {
+      // The entry is not written yet
+      break;
+    }
+    if (Sequence != mTraceTail) {
+      // Overwritten by the newer entry, skip to the oldest entry that is still in the ring
+      continue;
+    }
+    CopyMem(&Entries[Copied], Slot, sizeof(CALLBACK_TRACE_ENTRY));
+    MemoryFence();
+    if (Slot->Sequence != mTraceTail) {
+      continue;
+    }
+    Copied++;
+    mTraceTail++;
+  }
+
+  *Count = Copied;
+  if (Dropped != NULL) {
+    *Dropped = Lost;
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+CallbackTraceInstall (
+  IN EFI_HANDLE  Handle,
+  IN EFI_GUID    *FormSetGuid
+  )
+{
+  CopyGuid(&mCallbackTrace.FormSetGuid, FormSetGuid);
+  mCallbackTrace.Frequency = BenchmarkGetFrequency();
+  mCallbackTrace.Capacity = CALLBACK_TRACE_SIZE;
+  mCallbackTrace.Read = CallbackTraceRead;
+  return gBS->InstallMultipleProtocolInterfaces(&Handle,
+                                                &gCallbackTraceProtocolGuid,
+                                                &mCallbackTrace,
+                                                NULL);
+}
+
+EFI_STATUS
+CallbackTraceUninstall (
+  IN EFI_HANDLE  Handle
+  )
+{
+  return gBS->UninstallMultipleProtocolInterfaces(Handle,
+                                                  &gCallbackTraceProtocolGuid,
+                                                  &mCallbackTrace,
+                                                  NULL);
+}
+
+EFI_STATUS
+EFIAPI
+CallbackTraceLibConstructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  for (UINTN i = 0; i < CALLBACK_TRACE_SIZE; i++) {
+    mTraceRing[i].Sequence = INVALID_SEQUENCE;
+  }
+  return EFI_SUCCESS;
+}
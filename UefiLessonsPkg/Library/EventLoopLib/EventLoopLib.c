@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/EventLoopLib.h>
+
+STATIC
+EFI_STATUS
+AddSource (
+  IN  EVENT_LOOP              *Loop,
+  IN  EFI_EVENT               Event,
+  IN  EVENT_LOOP_SOURCE_TYPE  Type,
+  IN  VOID                    *Context,
+  OUT EVENT_LOOP_SOURCE       **Source
+  )
+{
+  if (Loop->Count == EVENT_LOOP_MAX_SOURCES) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Loop->Events[Loop->Count] = Event;
+  *Source = &Loop->Sources[Loop->Count];
+  ZeroMem(*Source, sizeof(EVENT_LOOP_SOURCE));
+  (*Source)->Type = Type;
+  (*Source)->Context = Context;
+  Loop->Count++;
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+Dispatch (
+  IN EVENT_LOOP  *Loop,
+  IN UINTN       Index
+  )
+{
+  EVENT_LOOP_SOURCE  *Source;
+  EFI_INPUT_KEY      Key;
+  EFI_HANDLE         Handle;
+  UINTN              BufferSize;
+
+  Source = &Loop->Sources[Index];
+  switch (Source->Type) {
+  case EventLoopSourceEvent:
+  case EventLoopSourceTimer:
+    Source->Handler(Loop, Source->Context);
+    break;
+  case EventLoopSourceKey:
+    // Drain all buffered keys, WaitForKey is signaled only once for them
+    while (Loop->Running && (gST->ConIn->ReadKeyStroke(gST->ConIn, &Key) == EFI_SUCCESS)) {
+      Source->KeyHandler(Loop, &Key, Source->Context);
+    }
+    break;
+  case EventLoopSourceProtocol:
+    // ByRegisterNotify returns one new handle per call
+    while (TRUE) {
+      BufferSize = sizeof(Handle);
+      if (EFI_ERROR(gBS->LocateHandle(ByRegisterNotify, NULL, Source->Registration, &BufferSize, &Handle))) {
+        break;
+      }
+      Source->ProtocolHandler(Loop, Handle, Source->Context);
+    }
+    break;
+  }
+}
+
+VOID
+EventLoopInit (
+  OUT EVENT_LOOP  *Loop
+  )
+{
+  ZeroMem(Loop, sizeof(EVENT_LOOP));
+}
+
+VOID
+EventLoopFree (
+  IN EVENT_LOOP  *Loop
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Loop->Count; Index++) {
+    if (Loop->Sources[Index].Type == EventLoopSourceTimer) {
+      gBS->SetTimer(Loop->Events[Index], TimerCancel, 0);
+      gBS->CloseEvent(Loop->Events[Index]);
+    } else if (Loop->Sources[Index].Type == EventLoopSourceProtocol) {
+      // Closing the event also unregisters the protocol notification
+      gBS->CloseEvent(Loop->Events[Index]);
+    }
+  }
+  EventLoopInit(Loop);
+}
+
+EFI_STATUS
+EventLoopAddEvent (
+  IN EVENT_LOOP          *Loop,
+  IN EFI_EVENT           Event,
+  IN EVENT_LOOP_HANDLER  Handler,
+  IN VOID                *Context OPTIONAL
+  )
+{
+  EFI_STATUS         Status;
+  EVENT_LOOP_SOURCE  *Source;
+
+  Status = AddSource(Loop, Event, EventLoopSourceEvent, Context, &Source);
+  if (!EFI_ERROR(Status)) {
+    Source->Handler = Handler;
+  }
+  return Status;
+}
+
+EFI_STATUS
+EventLoopAddKey (
+  IN EVENT_LOOP              *Loop,
+  IN EVENT_LOOP_KEY_HANDLER  Handler,
+  IN VOID                    *Context OPTIONAL
+  )
+{
+  EFI_STATUS         Status;
+  EVENT_LOOP_SOURCE  *Source;
+
+  Status = AddSource(Loop, gST->ConIn->WaitForKey, EventLoopSourceKey, Context, &Source);
+  if (!EFI_ERROR(Status)) {
+    Source->KeyHandler = Handler;
+  }
+  return Status;
+}
+
+EFI_STATUS
+EventLoopAddTimer (
+  IN EVENT_LOOP          *Loop,
+  IN UINTN               PeriodMs,
+  IN EVENT_LOOP_HANDLER  Handler,
+  IN VOID                *Context OPTIONAL
+  )
+{
+  EFI_STATUS         Status;
+  EFI_EVENT          Event;
+  EVENT_LOOP_SOURCE  *Source;
+
+  if (PeriodMs == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (Loop->Count == EVENT_LOOP_MAX_SOURCES) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  // Timer without the notify function, its signal state is consumed by WaitForEvent()/CheckEvent()
+  Status = gBS->CreateEvent(EVT_TIMER, TPL_CALLBACK, NULL, NULL, &Event);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+  // SetTimer() period is in 100ns units
+  Status = gBS->SetTimer(Event, TimerPeriodic, MultU64x32(PeriodMs, 10000));
+  if (EFI_ERROR(Status)) {
+    gBS->CloseEvent(Event);
+    return Status;
+  }
+
+  AddSource(Loop, Event, EventLoopSourceTimer, Context, &Source);
+  Source->Handler = Handler;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EventLoopAddProtocolNotify (
+  IN EVENT_LOOP                   *Loop,
+  IN EFI_GUID                     *Protocol,
+  IN EVENT_LOOP_PROTOCOL_HANDLER  Handler,
+  IN VOID                         *Context OPTIONAL
+  )
+{
+  EFI_STATUS         Status;
+  EFI_EVENT          Event;
+  VOID               *Registration;
+  EVENT_LOOP_SOURCE  *Source;
+
+  if (Loop->Count == EVENT_LOOP_MAX_SOURCES) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  // Plain event, RegisterProtocolNotify() only signals it, the handles are read in Dispatch()
+  Status = gBS->CreateEvent(0, TPL_CALLBACK, NULL, NULL, &Event);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+  Status = gBS->RegisterProtocolNotify(Protocol, Event, &Registration);
+  if (EFI_ERROR(Status)) {
+    gBS->CloseEvent(Event);
+    return Status;
+  }
+
+  AddSource(Loop, Event, EventLoopSourceProtocol, Context, &Source);
+  Source->ProtocolHandler = Handler;
+  Source->Registration = Registration;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EventLoopRun (
+  IN EVENT_LOOP  *Loop
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINTN       Signaled;
+
+  if (Loop->Count == 0) {
+    return EFI_NOT_READY;
+  }
+
+  Loop->Running = TRUE;
+  while (Loop->Running) {
+    Status = gBS->WaitForEvent(Loop->Count, Loop->Events, &Signaled);
+    if (EFI_ERROR(Status)) {
+      Loop->Running = FALSE;
+      return Status;
+    }
+    Dispatch(Loop, Signaled);
+
+    // WaitForEvent() returns only the first signaled event, check the rest in the same pass
+    for (Index = 0; (Index < Loop->Count) && Loop->Running; Index++) {
+      if ((Index != Signaled) && (gBS->CheckEvent(Loop->Events[Index]) == EFI_SUCCESS)) {
+        Dispatch(Loop, Index);
+      }
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+VOID
+EventLoopStop (
+  IN EVENT_LOOP  *Loop
+  )
+{
+  Loop->Running = FALSE;
+}
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/HiiDbIndexLib.h>
+#include <Library/GlyphAtlasLib.h>
+
+#define CHAR_COUNT         0x10000
+#define NARROW_CELL_SIZE   (EFI_GLYPH_WIDTH * EFI_GLYPH_HEIGHT)
+
+#define GLYPH_OFFSET(Glyph)  ((Glyph) & ~GLYPH_ATLAS_WIDE)
+#define GLYPH_WIDTH(Glyph)   (((Glyph) & GLYPH_ATLAS_WIDE) ? (2 * EFI_GLYPH_WIDTH) : EFI_GLYPH_WIDTH)
+
+STATIC
+EFI_STATUS
+ReservePixels (
+  IN GLYPH_ATLAS  *Atlas,
+  IN UINTN        Count
+  )
+{
+  if (Atlas->PixelCount + Count <= Atlas->PixelCapacity) {
+    return EFI_SUCCESS;
+  }
+
+  UINTN NewCapacity = Atlas->PixelCapacity * 2;
+  while (NewCapacity < Atlas->PixelCount + Count) {
+    NewCapacity *= 2;
+  }
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* NewPixels = ReallocatePool(
+    Atlas->PixelCapacity * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL),
+    NewCapacity * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL),
+    Atlas->Pixels
+  );
+  if (NewPixels == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Atlas->Pixels = NewPixels;
+  Atlas->PixelCapacity = NewCapacity;
+  return EFI_SUCCESS;
+}
+
+//
+// Glyph bitmap row is one byte, the most significant bit is the leftmost pixel
+//
+STATIC
+VOID
+RasterizeRow (
+  IN GLYPH_ATLAS                    *Atlas,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Dst,
+  IN UINT8                          Bits
+  )
+{
+  for (UINTN x = 0; x < EFI_GLYPH_WIDTH; x++) {
+    Dst[x] = (Bits & (0x80 >> x)) ? Atlas->Foreground : Atlas->Background;
+  }
+}
+
+//
+// Col2 is NULL for the narrow glyph, for the wide glyph Col1 is its left half
+//
+STATIC
+EFI_STATUS
+AddGlyph (
+  IN GLYPH_ATLAS  *Atlas,
+  IN CHAR16       Char,
+  IN CONST UINT8  *Col1,
+  IN CONST UINT8  *Col2 OPTIONAL
+  )
+{
+  if (Atlas->Glyphs[Char] != GLYPH_ATLAS_NONE) {
+    return EFI_SUCCESS;
+  }
+
+  UINTN Width = (Col2 == NULL) ? EFI_GLYPH_WIDTH : (2 * EFI_GLYPH_WIDTH);
+  EFI_STATUS Status = ReservePixels(Atlas, Width * EFI_GLYPH_HEIGHT);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Dst = Atlas->Pixels + Atlas->PixelCount;
+  for (UINTN y = 0; y < EFI_GLYPH_HEIGHT; y++) {
+    RasterizeRow(Atlas, Dst, Col1[y]);
+    if (Col2 != NULL) {
+      RasterizeRow(Atlas, Dst + EFI_GLYPH_WIDTH, Col2[y]);
+    }
+    Dst += Width;
+  }
+
+  Atlas->Glyphs[Char] = (UINT32)Atlas->PixelCount | ((Col2 != NULL) ? GLYPH_ATLAS_WIDE : 0);
+  Atlas->PixelCount += Width * EFI_GLYPH_HEIGHT;
+  Atlas->GlyphCount++;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+GlyphAtlasInit (
+  OUT GLYPH_ATLAS                    *Atlas,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Foreground,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Background
+  )
+{
+  ZeroMem(Atlas, sizeof(GLYPH_ATLAS));
+  Atlas->Foreground = Foreground;
+  Atlas->Background = Background;
+
+  Atlas->Glyphs = AllocatePool(CHAR_COUNT * sizeof(UINT32));
+  if (Atlas->Glyphs == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  SetMem32(Atlas->Glyphs, CHAR_COUNT * sizeof(UINT32), GLYPH_ATLAS_NONE);
+
+  // Space for the ASCII range of the usual system font, the atlas grows if needed
+  Atlas->PixelCapacity = 128 * NARROW_CELL_SIZE;
+  Atlas->Pixels = AllocatePool(Atlas->PixelCapacity * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+  if (Atlas->Pixels == NULL) {
+    GlyphAtlasFree(Atlas);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  // Empty cell for the characters without a glyph
+  for (UINTN i = 0; i < NARROW_CELL_SIZE; i++) {
+    Atlas->Pixels[i] = Background;
+  }
+  Atlas->PixelCount = NARROW_CELL_SIZE;
+  return EFI_SUCCESS;
+}
+
+VOID
+GlyphAtlasFree (
+  IN GLYPH_ATLAS  *Atlas
+  )
+{
+  if (Atlas->Glyphs != NULL) {
+    FreePool(Atlas->Glyphs);
+    Atlas->Glyphs = NULL;
+  }
+  if (Atlas->Pixels != NULL) {
+    FreePool(Atlas->Pixels);
+    Atlas->Pixels = NULL;
+  }
+  if (Atlas->LineBuffer != NULL) {
+    FreePool(Atlas->LineBuffer);
+    Atlas->LineBuffer = NULL;
+  }
+  Atlas->PixelCount = 0;
+  Atlas->PixelCapacity = 0;
+  Atlas->GlyphCount = 0;
+  Atlas->LineBufferWidth = 0;
+}
+
+EFI_STATUS
+GlyphAtlasAddSimpleFontPackage (
+  IN GLYPH_ATLAS                            *Atlas,
+  IN CONST EFI_HII_SIMPLE_FONT_PACKAGE_HDR  *Package
+  )
+{
+  // Narrow glyphs follow the header, wide glyphs follow the narrow ones
+  UINTN Size = sizeof(EFI_HII_SIMPLE_FONT_PACKAGE_HDR) +
+               Package->NumberOfNarrowGlyphs * sizeof(EFI_NARROW_GLYPH) +
+               Package->NumberOfWideGlyphs * sizeof(EFI_WIDE_GLYPH);
+  if ((Package->Header.Type != EFI_HII_PACKAGE_SIMPLE_FONTS) || (Package->Header.Length < Size)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  CONST EFI_NARROW_GLYPH* Narrow = (CONST EFI_NARROW_GLYPH*)(Package + 1);
+  for (UINTN i = 0; i < Package->NumberOfNarrowGlyphs; i++) {
+    if (Narrow[i].Attributes & EFI_GLYPH_NON_SPACING) {
+      continue;
+    }
+    EFI_STATUS Status = AddGlyph(Atlas, Narrow[i].UnicodeWeight, Narrow[i].GlyphCol1, NULL);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+
+  CONST EFI_WIDE_GLYPH* Wide = (CONST EFI_WIDE_GLYPH*)(Narrow + Package->NumberOfNarrowGlyphs);
+  for (UINTN i = 0; i < Package->NumberOfWideGlyphs; i++) {
+    if (Wide[i].Attributes & EFI_GLYPH_NON_SPACING) {
+      continue;
+    }
+    EFI_STATUS Status = AddGlyph(Atlas, Wide[i].UnicodeWeight, Wide[i].GlyphCol1, Wide[i].GlyphCol2);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+GlyphAtlasAddRegisteredFonts (
+  IN GLYPH_ATLAS  *Atlas
+  )
+{
+  EFI_STATUS Status = HiiDbIndexInit();
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  for (UINTN i = 0; ; i++) {
+    CONST HII_DB_PACKAGE* Package = HiiDbIndexFindByType(EFI_HII_PACKAGE_SIMPLE_FONTS, i);
+    if (Package == NULL) {
+      break;
+    }
+    Status = GlyphAtlasAddSimpleFontPackage(Atlas, (CONST EFI_HII_SIMPLE_FONT_PACKAGE_HDR*)Package->Package);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC
+UINT32
+FindGlyph (
+  IN GLYPH_ATLAS  *Atlas,
+  IN CHAR16       Char
+  )
+{
+  UINT32 Glyph = Atlas->Glyphs[Char];
+  // Offset 0 is the empty cell
+  return (Glyph == GLYPH_ATLAS_NONE) ? 0 : Glyph;
+}
+
+UINTN
+GlyphAtlasStringWidth (
+  IN GLYPH_ATLAS   *Atlas,
+  IN CONST CHAR16  *String
+  )
+{
+  UINTN Width = 0;
+  for (; *String != L'\0'; String++) {
+    Width += GLYPH_WIDTH(FindGlyph(Atlas, *String));
+  }
+  return Width;
+}
+
+//
+// Copy the glyph rows of the string to the buffer, Stride is the buffer width in pixels.
+// Returns the width of the rendered part of the string.
+//
+STATIC
+UINTN
+RenderString (
+  IN  GLYPH_ATLAS                    *Atlas,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Dst,
+  IN  UINTN                          Stride,
+  IN  UINTN                          MaxWidth,
+  IN  UINTN                          Rows,
+  IN  CONST CHAR16                   *String
+  )
+{
+  UINTN X = 0;
+  for (; (*String != L'\0') && (X < MaxWidth); String++) {
+    UINT32 Glyph = FindGlyph(Atlas, *String);
+    UINTN Width = GLYPH_WIDTH(Glyph);
+    UINTN CopyWidth = MIN(Width, MaxWidth - X);
+    CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Src = Atlas->Pixels + GLYPH_OFFSET(Glyph);
+    EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Row = Dst + X;
+    for (UINTN y = 0; y < Rows; y++) {
+      CopyMem(Row, Src, CopyWidth * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+      Row += Stride;
+      Src += Width;
+    }
+    X += CopyWidth;
+  }
+  return X;
+}
+
+UINTN
+GlyphAtlasDrawString (
+  IN GLYPH_ATLAS       *Atlas,
+  IN GOP_DRAW_CONTEXT  *Context,
+  IN UINTN             X,
+  IN UINTN             Y,
+  IN CONST CHAR16      *String
+  )
+{
+  if ((X >= Context->Width) || (Y >= Context->Height)) {
+    return 0;
+  }
+
+  UINTN Rows = MIN(EFI_GLYPH_HEIGHT, Context->Height - Y);
+  UINTN Width = RenderString(
+    Atlas,
+    Context->BackBuffer + Y * Context->Width + X,
+    Context->Width,
+    Context->Width - X,
+    Rows,
+    String
+  );
+  GopDrawMarkDirty(Context, X, Y, Width, Rows);
+  return Width;
+}
+
+EFI_STATUS
+GlyphAtlasBltString (
+  IN GLYPH_ATLAS                   *Atlas,
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL  *Gop,
+  IN UINTN                         X,
+  IN UINTN                         Y,
+  IN CONST CHAR16                  *String
+  )
+{
+  UINTN ScreenWidth = Gop->Mode->Info->HorizontalResolution;
+  UINTN ScreenHeight = Gop->Mode->Info->VerticalResolution;
+  if ((X >= ScreenWidth) || (Y >= ScreenHeight)) {
+    return EFI_SUCCESS;
+  }
+
+  UINTN Width = MIN(GlyphAtlasStringWidth(Atlas, String), ScreenWidth - X);
+  if (Width == 0) {
+    return EFI_SUCCESS;
+  }
+
+  // The line buffer is kept between the calls and grows only for the longer strings
+  if (Width > Atlas->LineBufferWidth) {
+    if (Atlas->LineBuffer != NULL) {
+      FreePool(Atlas->LineBuffer);
+    }
+    Atlas->LineBuffer = AllocatePool(Width * EFI_GLYPH_HEIGHT * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    if (Atlas->LineBuffer == NULL) {
+      Atlas->LineBufferWidth = 0;
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Atlas->LineBufferWidth = Width;
+  }
+
+  UINTN Rows = MIN(EFI_GLYPH_HEIGHT, ScreenHeight - Y);
+  RenderString(Atlas, Atlas->LineBuffer, Width, Width, Rows, String);
+  return Gop->Blt(
+    Gop,
+    Atlas->LineBuffer,
+    EfiBltBufferToVideo,
+    0,
+    0,
+    X,
+    Y,
+    Width,
+    Rows,
+    0
+  );
+}
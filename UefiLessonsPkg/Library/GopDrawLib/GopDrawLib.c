@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/GopDrawLib.h>
+
+STATIC
+VOID
+ResetDirty (
+  IN GOP_DRAW_CONTEXT  *Context
+  )
+{
+  Context->DirtyLeft = 0;
+  Context->DirtyTop = 0;
+  Context->DirtyRight = 0;
+  Context->DirtyBottom = 0;
+}
+
+EFI_STATUS
+GopDrawInit (
+  IN  EFI_GRAPHICS_OUTPUT_PROTOCOL  *Gop,
+  OUT GOP_DRAW_CONTEXT              *Context
+  )
+{
+  Context->Gop = Gop;
+  Context->Width = Gop->Mode->Info->HorizontalResolution;
+  Context->Height = Gop->Mode->Info->VerticalResolution;
+  Context->BackBuffer = AllocateZeroPool(Context->Width * Context->Height * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+  if (Context->BackBuffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  ResetDirty(Context);
+  return EFI_SUCCESS;
+}
+
+VOID
+GopDrawFree (
+  IN GOP_DRAW_CONTEXT  *Context
+  )
+{
+  if (Context->BackBuffer != NULL) {
+    FreePool(Context->BackBuffer);
+    Context->BackBuffer = NULL;
+  }
+}
+
+VOID
+GopDrawFillRect (
+  IN GOP_DRAW_CONTEXT               *Context,
+  IN UINTN                          X,
+  IN UINTN                          Y,
+  IN UINTN                          Width,
+  IN UINTN                          Height,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Color
+  )
+{
+  if ((X >= Context->Width) || (Y >= Context->Height)) {
+    return;
+  }
+  Width = MIN(Width, Context->Width - X);
+  Height = MIN(Height, Context->Height - Y);
+  if ((Width == 0) || (Height == 0)) {
+    return;
+  }
+
+  // BLT pixel is 4 bytes, so every row is filled with a single SetMem32
+  UINT32 Value;
+  CopyMem(&Value, &Color, sizeof(Value));
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Row = Context->BackBuffer + Y * Context->Width + X;
+  for (UINTN i = 0; i < Height; i++) {
+    SetMem32(Row, Width * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL), Value);
+    Row += Context->Width;
+  }
+
+  GopDrawMarkDirty(Context, X, Y, Width, Height);
+}
+
+VOID
+GopDrawMarkDirty (
+  IN GOP_DRAW_CONTEXT  *Context,
+  IN UINTN             X,
+  IN UINTN             Y,
+  IN UINTN             Width,
+  IN UINTN             Height
+  )
+{
+  if ((X >= Context->Width) || (Y >= Context->Height)) {
+    return;
+  }
+  Width = MIN(Width, Context->Width - X);
+  Height = MIN(Height, Context->Height - Y);
+  if ((Width == 0) || (Height == 0)) {
+    return;
+  }
+
+  if (Context->DirtyRight == 0) {
+    Context->DirtyLeft = X;
+    Context->DirtyTop = Y;
+    Context->DirtyRight = X + Width;
+    Context->DirtyBottom = Y + Height;
+  } else {
+    Context->DirtyLeft = MIN(Context->DirtyLeft, X);
+    Context->DirtyTop = MIN(Context->DirtyTop, Y);
+    Context->DirtyRight = MAX(Context->DirtyRight, X + Width);
+    Context->DirtyBottom = MAX(Context->DirtyBottom, Y + Height);
+  }
+}
+
+EFI_STATUS
+GopDrawFlush (
+  IN GOP_DRAW_CONTEXT  *Context
+  )
+{
+  ResetDirty(Context);
+  return Context->Gop->Blt(
+    Context->Gop,
+    Context->BackBuffer,
+    EfiBltBufferToVideo,
+    0,
+    0,
+    0,
+    0,
+    Context->Width,
+    Context->Height,
+    0
+  );
+}
+
+EFI_STATUS
+GopDrawFlushDirty (
+  IN GOP_DRAW_CONTEXT  *Context
+  )
+{
+  if (Context->DirtyRight == 0) {
+    return EFI_SUCCESS;
+  }
+
+  // Delta is required since the rectangle is smaller than the buffer
+  EFI_STATUS Status = Context->Gop->Blt(
+    Context->Gop,
+    Context->BackBuffer,
+    EfiBltBufferToVideo,
+    Context->DirtyLeft,
+    Context->DirtyTop,
+    Context->DirtyLeft,
+    Context->DirtyTop,
+    Context->DirtyRight - Context->DirtyLeft,
+    Context->DirtyBottom - Context->DirtyTop,
+    Context->Width * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+  );
+  ResetDirty(Context);
+  return Status;
+}
+
+BOOLEAN
+GopDrawHasFrameBuffer (
+  IN GOP_DRAW_CONTEXT  *Context
+  )
+{
+  EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE* Mode = Context->Gop->Mode;
+  if (Mode->FrameBufferBase == 0) {
+    return FALSE;
+  }
+  return (Mode->Info->PixelFormat == PixelBlueGreenRedReserved8BitPerColor) ||
+         (Mode->Info->PixelFormat == PixelRedGreenBlueReserved8BitPerColor);
+}
+
+EFI_STATUS
+GopDrawFlushFrameBuffer (
+  IN GOP_DRAW_CONTEXT  *Context
+  )
+{
+  if (!GopDrawHasFrameBuffer(Context)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE* Mode = Context->Gop->Mode;
+  UINT32* Dst = (UINT32*)(UINTN)Mode->FrameBufferBase;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Src = Context->BackBuffer;
+  for (UINTN y = 0; y < Context->Height; y++) {
+    if (Mode->Info->PixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
+      // Same layout as the BLT pixel
+      CopyMem(Dst, Src, Context->Width * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    } else {
+      for (UINTN x = 0; x < Context->Width; x++) {
+        Dst[x] = Src[x].Red | ((UINT32)Src[x].Green << 8) | ((UINT32)Src[x].Blue << 16);
+      }
+    }
+    Src += Context->Width;
+    Dst += Mode->Info->PixelsPerScanLine;
+  }
+  ResetDirty(Context);
+  return EFI_SUCCESS;
+}
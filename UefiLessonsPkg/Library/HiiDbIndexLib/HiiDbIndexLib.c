@@ -0,0 +1,717 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/HiiDbIndexLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#define TYPES_COUNT       256
+#define MIN_BUCKET_COUNT  16      // Must be a power of 2
+#define NO_ENTRY          MAX_UINT32
+
+//
+// The database can change between the ExportPackageLists() and ListPackageLists() calls,
+// in this case the export is repeated
+//
+#define EXPORT_ATTEMPTS   3
+
+//
+// Package lists changed since the index was built are remembered by the notify function
+// and only they are exported again. If there are more changes, the whole database is exported.
+//
+#define MAX_CHANGES       32
+
+typedef struct {
+  EFI_GUID  Guid;
+  UINT32    Next;         // Next entry in the same bucket
+  UINT32    First;        // Package lists with this GUID are mGuidOrder[First]..mGuidOrder[First + Count - 1]
+  UINT32    Count;
+} GUID_ENTRY;
+
+typedef struct {
+  EFI_HII_HANDLE  Handle;
+  BOOLEAN         Removed;      // REMOVE_PACK was received for the handle
+} CHANGE_ENTRY;
+
+//
+// HII database calls the notify function only if the registered NotifyType is equal to
+// the type of the change, so every notify type is registered separately.
+//
+STATIC CONST EFI_HII_DATABASE_NOTIFY_TYPE mNotifyTypes[] = {
+  EFI_HII_DATABASE_NOTIFY_NEW_PACK,
+  EFI_HII_DATABASE_NOTIFY_REMOVE_PACK,
+  EFI_HII_DATABASE_NOTIFY_ADD_PACK,
+};
+
+//
+// Notifications are registered per package type, EFI_HII_PACKAGE_TYPE_ALL is not accepted
+//
+STATIC CONST UINT8 mNotifyPackageTypes[] = {
+  EFI_HII_PACKAGE_FORMS,
+  EFI_HII_PACKAGE_STRINGS,
+  EFI_HII_PACKAGE_FONTS,
+  EFI_HII_PACKAGE_IMAGES,
+  EFI_HII_PACKAGE_SIMPLE_FONTS,
+  EFI_HII_PACKAGE_DEVICE_PATH,
+  EFI_HII_PACKAGE_KEYBOARD_LAYOUT,
+  EFI_HII_PACKAGE_ANIMATIONS,
+};
+
+STATIC EFI_HII_DATABASE_PROTOCOL* mHiiDatabase = NULL;
+STATIC EFI_HANDLE mNotifyHandles[ARRAY_SIZE(mNotifyTypes)][ARRAY_SIZE(mNotifyPackageTypes)];
+STATIC BOOLEAN mStale = TRUE;
+STATIC CHANGE_ENTRY mChanges[MAX_CHANGES];
+STATIC UINTN mChangeCount = 0;
+STATIC UINTN mGeneration = 0;
+
+STATIC EFI_HII_PACKAGE_LIST_HEADER* mDatabase = NULL;
+STATIC UINTN mDatabaseSize = 0;
+STATIC HII_DB_PACKAGE_LIST* mLists = NULL;
+STATIC UINTN mListCount = 0;
+STATIC GUID_ENTRY* mGuidEntries = NULL;
+STATIC UINT32* mGuidOrder = NULL;
+STATIC UINT32* mBuckets = NULL;
+STATIC UINTN mBucketCount = 0;
+STATIC HII_DB_PACKAGE* mPackages = NULL;
+STATIC UINTN mTypeFirst[TYPES_COUNT + 1];    // Packages of the type T are mPackages[mTypeFirst[T]]..mPackages[mTypeFirst[T + 1] - 1]
+
+STATIC
+UINTN
+GuidHash (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINT32 Value = Guid->Data1 ^ ((UINT32)Guid->Data2 << 16) ^ Guid->Data3 ^
+                 ReadUnaligned32((UINT32*)&Guid->Data4[0]) ^ ReadUnaligned32((UINT32*)&Guid->Data4[4]);
+  // Fibonacci hashing, the bucket count is a power of 2
+  return (UINTN)(UINT32)(Value * 0x9E3779B9U) & (mBucketCount - 1);
+}
+
+STATIC
+GUID_ENTRY*
+FindGuidEntry (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  if (mBucketCount == 0) {
+    return NULL;
+  }
+  UINT32 Index = mBuckets[GuidHash(Guid)];
+  while (Index != NO_ENTRY) {
+    if (CompareGuid(&mGuidEntries[Index].Guid, Guid)) {
+      return &mGuidEntries[Index];
+    }
+    Index = mGuidEntries[Index].Next;
+  }
+  return NULL;
+}
+
+STATIC
+VOID
+FreeIndex (
+  VOID
+  )
+{
+  if (mDatabase != NULL) {
+    FreePool(mDatabase);
+    mDatabase = NULL;
+  }
+  if (mLists != NULL) {
+    FreePool(mLists);
+    mLists = NULL;
+  }
+  if (mGuidEntries != NULL) {
+    FreePool(mGuidEntries);
+    mGuidEntries = NULL;
+  }
+  if (mGuidOrder != NULL) {
+    FreePool(mGuidOrder);
+    mGuidOrder = NULL;
+  }
+  if (mBuckets != NULL) {
+    FreePool(mBuckets);
+    mBuckets = NULL;
+  }
+  if (mPackages != NULL) {
+    FreePool(mPackages);
+    mPackages = NULL;
+  }
+  mDatabaseSize = 0;
+  mListCount = 0;
+  mBucketCount = 0;
+  ZeroMem(mTypeFirst, sizeof(mTypeFirst));
+}
+
+STATIC
+EFI_STATUS
+ListHandles (
+  OUT EFI_HII_HANDLE  **Handles,
+  OUT UINTN           *HandleCount
+  )
+{
+  UINTN Size = 0;
+  EFI_STATUS Status = mHiiDatabase->ListPackageLists(mHiiDatabase, EFI_HII_PACKAGE_TYPE_ALL, NULL, &Size, NULL);
+  if (Status == EFI_NOT_FOUND) {
+    return EFI_SUCCESS;
+  }
+  if (Status != EFI_BUFFER_TOO_SMALL) {
+    return Status;
+  }
+  *Handles = AllocatePool(Size);
+  if (*Handles == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Status = mHiiDatabase->ListPackageLists(mHiiDatabase, EFI_HII_PACKAGE_TYPE_ALL, NULL, &Size, *Handles);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+  *HandleCount = Size / sizeof(EFI_HII_HANDLE);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+ExportDatabase (
+  OUT EFI_HII_HANDLE  **Handles,
+  OUT UINTN           *HandleCount
+  )
+{
+  UINTN Size = 0;
+  EFI_STATUS Status = mHiiDatabase->ExportPackageLists(mHiiDatabase, NULL, &Size, NULL);
+  if (Status != EFI_BUFFER_TOO_SMALL) {
+    return Status;
+  }
+  mDatabase = AllocatePool(Size);
+  if (mDatabase == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Status = mHiiDatabase->ExportPackageLists(mHiiDatabase, NULL, &Size, mDatabase);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+  mDatabaseSize = Size;
+
+  //
+  // Package lists are exported in the same order as their handles are listed
+  //
+  return ListHandles(Handles, HandleCount);
+}
+
+//
+// Build the index of the package lists in mDatabase, Handles are the handles of the lists in the same order
+//
+STATIC
+EFI_STATUS
+IndexDatabase (
+  IN EFI_HII_HANDLE  *Handles,
+  IN UINTN           HandleCount
+  )
+{
+  //
+  // First pass: count package lists and packages of every type
+  //
+  UINTN TypeCount[TYPES_COUNT];
+  ZeroMem(TypeCount, sizeof(TypeCount));
+  UINTN PackageCount = 0;
+  UINTN ListCount = 0;
+  UINT8* DatabaseEnd = (UINT8*)mDatabase + mDatabaseSize;
+  EFI_HII_PACKAGE_LIST_HEADER* List = mDatabase;
+  while ((UINT8*)List + sizeof(EFI_HII_PACKAGE_LIST_HEADER) <= DatabaseEnd) {
+    if ((List->PackageLength < sizeof(EFI_HII_PACKAGE_LIST_HEADER)) ||
+        (List->PackageLength > (UINTN)(DatabaseEnd - (UINT8*)List))) {
+      break;
+    }
+    UINT8* ListEnd = (UINT8*)List + List->PackageLength;
+    EFI_HII_PACKAGE_HEADER* Package = (EFI_HII_PACKAGE_HEADER*)(List + 1);
+    while ((UINT8*)Package + sizeof(EFI_HII_PACKAGE_HEADER) <= ListEnd) {
+      if ((Package->Length < sizeof(EFI_HII_PACKAGE_HEADER)) || (Package->Length > (UINTN)(ListEnd - (UINT8*)Package))) {
+        break;
+      }
+      TypeCount[Package->Type]++;
+      PackageCount++;
+      Package = (EFI_HII_PACKAGE_HEADER*)((UINT8*)Package + Package->Length);
+    }
+    ListCount++;
+    List = (EFI_HII_PACKAGE_LIST_HEADER*)ListEnd;
+  }
+
+  //
+  // Handles can be matched to the package lists only by the order, so the lists are
+  // never indexed without their handles
+  //
+  if (ListCount != HandleCount) {
+    DEBUG ((EFI_D_INFO, "HiiDbIndex: %d package lists were exported, but %d handles were listed\n", ListCount, HandleCount));
+    return EFI_ABORTED;
+  }
+
+  mBucketCount = MIN_BUCKET_COUNT;
+  while (mBucketCount < ListCount * 2) {
+    mBucketCount *= 2;
+  }
+  mLists = AllocatePool(MAX(ListCount, 1) * sizeof(HII_DB_PACKAGE_LIST));
+  mGuidEntries = AllocatePool(MAX(ListCount, 1) * sizeof(GUID_ENTRY));
+  mGuidOrder = AllocatePool(MAX(ListCount, 1) * sizeof(UINT32));
+  mBuckets = AllocatePool(mBucketCount * sizeof(UINT32));
+  mPackages = AllocatePool(MAX(PackageCount, 1) * sizeof(HII_DB_PACKAGE));
+  if ((mLists == NULL) || (mGuidEntries == NULL) || (mGuidOrder == NULL) || (mBuckets == NULL) || (mPackages == NULL)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  SetMem32(mBuckets, mBucketCount * sizeof(UINT32), NO_ENTRY);
+
+  // Packages are grouped by type
+  UINTN TypeNext[TYPES_COUNT];
+  mTypeFirst[0] = 0;
+  for (UINTN Type = 0; Type < TYPES_COUNT; Type++) {
+    mTypeFirst[Type + 1] = mTypeFirst[Type] + TypeCount[Type];
+    TypeNext[Type] = mTypeFirst[Type];
+  }
+
+  //
+  // Second pass: fill the package lists, GUID entries and packages
+  //
+  UINTN EntryCount = 0;
+  List = mDatabase;
+  for (UINTN i = 0; i < ListCount; i++) {
+    mLists[i].PackageList = List;
+    mLists[i].Handle = Handles[i];
+
+    GUID_ENTRY* Entry = FindGuidEntry(&List->PackageListGuid);
+    if (Entry == NULL) {
+      Entry = &mGuidEntries[EntryCount];
+      CopyGuid(&Entry->Guid, &List->PackageListGuid);
+      Entry->Count = 0;
+      UINTN Bucket = GuidHash(&List->PackageListGuid);
+      Entry->Next = mBuckets[Bucket];
+      mBuckets[Bucket] = (UINT32)EntryCount;
+      EntryCount++;
+    }
+    Entry->Count++;
+
+    UINT8* ListEnd = (UINT8*)List + List->PackageLength;
+    EFI_HII_PACKAGE_HEADER* Package = (EFI_HII_PACKAGE_HEADER*)(List + 1);
+    while ((UINT8*)Package + sizeof(EFI_HII_PACKAGE_HEADER) <= ListEnd) {
+      if ((Package->Length < sizeof(EFI_HII_PACKAGE_HEADER)) || (Package->Length > (UINTN)(ListEnd - (UINT8*)Package))) {
+        break;
+      }
+      HII_DB_PACKAGE* Indexed = &mPackages[TypeNext[Package->Type]++];
+      Indexed->Package = Package;
+      Indexed->ListIndex = i;
+      Package = (EFI_HII_PACKAGE_HEADER*)((UINT8*)Package + Package->Length);
+    }
+    List = (EFI_HII_PACKAGE_LIST_HEADER*)ListEnd;
+  }
+
+  // Package lists with the same GUID are grouped in mGuidOrder in the database order
+  UINT32 First = 0;
+  for (UINTN i = 0; i < EntryCount; i++) {
+    mGuidEntries[i].First = First;
+    First += mGuidEntries[i].Count;
+    mGuidEntries[i].Count = 0;
+  }
+  for (UINTN i = 0; i < ListCount; i++) {
+    GUID_ENTRY* Entry = FindGuidEntry(&mLists[i].PackageList->PackageListGuid);
+    mGuidOrder[Entry->First + Entry->Count++] = (UINT32)i;
+  }
+
+  mListCount = ListCount;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+BuildIndex (
+  VOID
+  )
+{
+  EFI_HII_HANDLE* Handles = NULL;
+  UINTN HandleCount = 0;
+  EFI_STATUS Status = ExportDatabase(&Handles, &HandleCount);
+  if (!EFI_ERROR(Status)) {
+    Status = IndexDatabase(Handles, HandleCount);
+  }
+  if (Handles != NULL) {
+    FreePool(Handles);
+  }
+  return Status;
+}
+
+STATIC
+CHANGE_ENTRY*
+FindChange (
+  IN CHANGE_ENTRY    *Changes,
+  IN UINTN           ChangeCount,
+  IN EFI_HII_HANDLE  Handle
+  )
+{
+  for (UINTN i = 0; i < ChangeCount; i++) {
+    if (Changes[i].Handle == Handle) {
+      return &Changes[i];
+    }
+  }
+  return NULL;
+}
+
+STATIC
+HII_DB_PACKAGE_LIST*
+FindListByHandle (
+  IN EFI_HII_HANDLE  Handle
+  )
+{
+  for (UINTN i = 0; i < mListCount; i++) {
+    if (mLists[i].Handle == Handle) {
+      return &mLists[i];
+    }
+  }
+  return NULL;
+}
+
+//
+// Update the index after the changes reported by the notify function. Only the changed package
+// lists are exported, the unchanged ones are copied from the current index, the lists that are not
+// listed anymore are dropped. The GUID and type buckets are refilled from the new copy in memory.
+//
+// EFI_ABORTED means that the changes can't be matched to the listed handles, in this case the
+// current index stays untouched and the whole database must be exported.
+//
+STATIC
+EFI_STATUS
+UpdateIndex (
+  IN CHANGE_ENTRY  *Changes,
+  IN UINTN         ChangeCount
+  )
+{
+  EFI_HII_HANDLE* Handles = NULL;
+  UINTN HandleCount = 0;
+  UINTN* Sizes = NULL;
+  EFI_HII_PACKAGE_LIST_HEADER* Database = NULL;
+  EFI_STATUS Status = ListHandles(&Handles, &HandleCount);
+  if (EFI_ERROR(Status)) {
+    goto Exit;
+  }
+
+  //
+  // A handle that is gone must have been removed, a handle that has appeared must have been added
+  //
+  for (UINTN i = 0; i < ChangeCount; i++) {
+    BOOLEAN Listed = FALSE;
+    for (UINTN j = 0; j < HandleCount; j++) {
+      if (Handles[j] == Changes[i].Handle) {
+        Listed = TRUE;
+        break;
+      }
+    }
+    if (!Listed && !Changes[i].Removed) {
+      Status = EFI_ABORTED;
+      goto Exit;
+    }
+  }
+  for (UINTN i = 0; i < mListCount; i++) {
+    BOOLEAN Listed = FALSE;
+    for (UINTN j = 0; j < HandleCount; j++) {
+      if (Handles[j] == mLists[i].Handle) {
+        Listed = TRUE;
+        break;
+      }
+    }
+    if (!Listed && (FindChange(Changes, ChangeCount, mLists[i].Handle) == NULL)) {
+      Status = EFI_ABORTED;
+      goto Exit;
+    }
+  }
+
+  Sizes = AllocatePool(MAX(HandleCount, 1) * sizeof(UINTN));
+  if (Sizes == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+  UINTN DatabaseSize = 0;
+  for (UINTN i = 0; i < HandleCount; i++) {
+    HII_DB_PACKAGE_LIST* List = FindListByHandle(Handles[i]);
+    if (FindChange(Changes, ChangeCount, Handles[i]) == NULL) {
+      if (List == NULL) {
+        // Package list was added without a notification
+        Status = EFI_ABORTED;
+        goto Exit;
+      }
+      Sizes[i] = List->PackageList->PackageLength;
+    } else {
+      Sizes[i] = 0;
+      Status = mHiiDatabase->ExportPackageLists(mHiiDatabase, Handles[i], &Sizes[i], NULL);
+      if (Status != EFI_BUFFER_TOO_SMALL) {
+        Status = EFI_ABORTED;
+        goto Exit;
+      }
+    }
+    DatabaseSize += Sizes[i];
+  }
+
+  Database = AllocatePool(MAX(DatabaseSize, 1));
+  if (Database == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+  UINT8* Ptr = (UINT8*)Database;
+  for (UINTN i = 0; i < HandleCount; i++) {
+    HII_DB_PACKAGE_LIST* List = FindListByHandle(Handles[i]);
+    if ((List != NULL) && (FindChange(Changes, ChangeCount, Handles[i]) == NULL)) {
+      CopyMem(Ptr, List->PackageList, Sizes[i]);
+    } else {
+      UINTN Size = Sizes[i];
+      Status = mHiiDatabase->ExportPackageLists(mHiiDatabase, Handles[i], &Size, (EFI_HII_PACKAGE_LIST_HEADER*)Ptr);
+      if (EFI_ERROR(Status) || (Size != Sizes[i])) {
+        Status = EFI_ABORTED;
+        goto Exit;
+      }
+    }
+    Ptr += Sizes[i];
+  }
+
+  FreeIndex();
+  mDatabase = Database;
+  mDatabaseSize = DatabaseSize;
+  Database = NULL;
+  Status = IndexDatabase(Handles, HandleCount);
+
+Exit:
+  if (Database != NULL) {
+    FreePool(Database);
+  }
+  if (Sizes != NULL) {
+    FreePool(Sizes);
+  }
+  if (Handles != NULL) {
+    FreePool(Handles);
+  }
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+PackageNotify (
+  IN UINT8                         PackageType,
+  IN CONST EFI_GUID                *PackageGuid,
+  IN CONST EFI_HII_PACKAGE_HEADER  *Package,
+  IN EFI_HII_HANDLE                Handle,
+  IN EFI_HII_DATABASE_NOTIFY_TYPE  NotifyType
+  )
+{
+  //
+  // Notifications come in the middle of the database update, so only remember the changed
+  // package list, it is exported again on the next lookup
+  //
+  if (mStale) {
+    return EFI_SUCCESS;
+  }
+  CHANGE_ENTRY* Change = FindChange(mChanges, mChangeCount, Handle);
+  if (Change == NULL) {
+    if (mChangeCount == MAX_CHANGES) {
+      mStale = TRUE;
+      mChangeCount = 0;
+      return EFI_SUCCESS;
+    }
+    Change = &mChanges[mChangeCount++];
+    Change->Handle = Handle;
+    Change->Removed = FALSE;
+  }
+  if (NotifyType == EFI_HII_DATABASE_NOTIFY_REMOVE_PACK) {
+    Change->Removed = TRUE;
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+HiiDbIndexInit (
+  VOID
+  )
+{
+  if (mHiiDatabase == NULL) {
+    EFI_STATUS Status = gBS->LocateProtocol(&gEfiHiiDatabaseProtocolGuid,
+                                            NULL,
+                                            (VOID**)&mHiiDatabase);
+    if (EFI_ERROR(Status)) {
+      mHiiDatabase = NULL;
+      return EFI_NOT_FOUND;
+    }
+
+    for (UINTN n = 0; n < ARRAY_SIZE(mNotifyTypes); n++) {
+      for (UINTN i = 0; i < ARRAY_SIZE(mNotifyPackageTypes); i++) {
+        Status = mHiiDatabase->RegisterPackageNotify(mHiiDatabase,
+                                                     mNotifyPackageTypes[i],
+                                                     NULL,
+                                                     PackageNotify,
+                                                     mNotifyTypes[n],
+                                                     &mNotifyHandles[n][i]);
+        if (EFI_ERROR(Status)) {
+          DEBUG ((EFI_D_ERROR, "HiiDbIndex: can't register notify function 0x%x for the package type 0x%x: %r\n", mNotifyTypes[n], mNotifyPackageTypes[i], Status));
+          mNotifyHandles[n][i] = NULL;
+        }
+      }
+    }
+  }
+
+  if (!mStale && (mChangeCount == 0)) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Changes reported while the index is updated are collected for the next update
+  //
+  CHANGE_ENTRY Changes[MAX_CHANGES];
+  UINTN ChangeCount = mChangeCount;
+  CopyMem(Changes, mChanges, ChangeCount * sizeof(CHANGE_ENTRY));
+  mChangeCount = 0;
+
+  EFI_STATUS Status = EFI_ABORTED;
+  if (!mStale) {
+    Status = UpdateIndex(Changes, ChangeCount);
+    if (EFI_ERROR(Status)) {
+      DEBUG ((EFI_D_INFO, "HiiDbIndex: can't update the index with %d changed package lists: %r, export the whole database\n", ChangeCount, Status));
+      Status = EFI_ABORTED;
+    }
+  }
+  mStale = FALSE;
+  for (UINTN Attempt = 0; (Attempt < EXPORT_ATTEMPTS) && (Status == EFI_ABORTED); Attempt++) {
+    FreeIndex();
+    mChangeCount = 0;
+    Status = BuildIndex();
+  }
+  if (EFI_ERROR(Status)) {
+    DEBUG ((EFI_D_ERROR, "HiiDbIndex: can't export HII database: %r\n", Status));
+    FreeIndex();
+    mStale = TRUE;
+    return Status;
+  }
+  mGeneration++;
+  return EFI_SUCCESS;
+}
+
+UINTN
+HiiDbIndexGetGeneration (
+  VOID
+  )
+{
+  HiiDbIndexInit();
+  return mGeneration;
+}
+
+EFI_STATUS
+HiiDbIndexGetDatabase (
+  OUT EFI_HII_PACKAGE_LIST_HEADER  **Database,
+  OUT UINTN                        *Size
+  )
+{
+  EFI_STATUS Status = HiiDbIndexInit();
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+  *Database = mDatabase;
+  *Size = mDatabaseSize;
+  return EFI_SUCCESS;
+}
+
+UINTN
+HiiDbIndexGetListCount (
+  VOID
+  )
+{
+  if (EFI_ERROR(HiiDbIndexInit())) {
+    return 0;
+  }
+  return mListCount;
+}
+
+CONST HII_DB_PACKAGE_LIST*
+HiiDbIndexGetList (
+  IN UINTN  Index
+  )
+{
+  if (EFI_ERROR(HiiDbIndexInit()) || (Index >= mListCount)) {
+    return NULL;
+  }
+  return &mLists[Index];
+}
+
+UINTN
+HiiDbIndexCountByGuid (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  if (EFI_ERROR(HiiDbIndexInit())) {
+    return 0;
+  }
+  GUID_ENTRY* Entry = FindGuidEntry(Guid);
+  return (Entry != NULL) ? Entry->Count : 0;
+}
+
+CONST HII_DB_PACKAGE_LIST*
+HiiDbIndexFindByGuid (
+  IN CONST EFI_GUID  *Guid,
+  IN UINTN           Instance
+  )
+{
+  if (EFI_ERROR(HiiDbIndexInit())) {
+    return NULL;
+  }
+  GUID_ENTRY* Entry = FindGuidEntry(Guid);
+  if ((Entry == NULL) || (Instance >= Entry->Count)) {
+    return NULL;
+  }
+  return &mLists[mGuidOrder[Entry->First + Instance]];
+}
+
+UINTN
+HiiDbIndexCountByType (
+  IN UINT8  Type
+  )
+{
+  if (EFI_ERROR(HiiDbIndexInit())) {
+    return 0;
+  }
+  return mTypeFirst[Type + 1] - mTypeFirst[Type];
+}
+
+CONST HII_DB_PACKAGE*
+HiiDbIndexFindByType (
+  IN UINT8  Type,
+  IN UINTN  Instance
+  )
+{
+  if (EFI_ERROR(HiiDbIndexInit()) || (Instance >= mTypeFirst[Type + 1] - mTypeFirst[Type])) {
+    return NULL;
+  }
+  return &mPackages[mTypeFirst[Type] + Instance];
+}
+
+EFI_STATUS
+EFIAPI
+HiiDbIndexLibDestructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  //
+  // The notify function is a part of this image, it must not stay registered after unload
+  //
+  if (mHiiDatabase != NULL) {
+    for (UINTN n = 0; n < ARRAY_SIZE(mNotifyTypes); n++) {
+      for (UINTN i = 0; i < ARRAY_SIZE(mNotifyPackageTypes); i++) {
+        if (mNotifyHandles[n][i] != NULL) {
+          mHiiDatabase->UnregisterPackageNotify(mHiiDatabase, mNotifyHandles[n][i]);
+          mNotifyHandles[n][i] = NULL;
+        }
+      }
+    }
+  }
+  FreeIndex();
+  mHiiDatabase = NULL;
+  mStale = TRUE;
+  mChangeCount = 0;
+  return EFI_SUCCESS;
+}
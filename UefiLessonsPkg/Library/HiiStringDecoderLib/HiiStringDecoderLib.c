@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/HiiStringDecoderLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#define MAX_STRING_ID  0xFFFF
+
+typedef struct {
+  CONST UINT8  *Base;
+  UINTN        Length;
+  UINTN        Capacity;
+  UINTN        CurrentId;
+} WALK_STATE;
+
+//
+// Get the offset after the null-terminated string or 0 if it is not terminated inside the package
+//
+STATIC
+UINTN
+SkipString (
+  IN CONST WALK_STATE  *State,
+  IN UINTN             Offset,
+  IN BOOLEAN           Scsu
+  )
+{
+  if (Scsu) {
+    while (Offset < State->Length) {
+      if (State->Base[Offset++] == 0) {
+        return Offset;
+      }
+    }
+  } else {
+    // UCS2 text in the blocks is not aligned
+    while (Offset + sizeof(CHAR16) <= State->Length) {
+      BOOLEAN Null = (State->Base[Offset] == 0) && (State->Base[Offset + 1] == 0);
+      Offset += sizeof(CHAR16);
+      if (Null) {
+        return Offset;
+      }
+    }
+  }
+  return 0;
+}
+
+STATIC
+EFI_STATUS
+AddString (
+  IN OUT HII_STRING_DECODER  *Decoder,
+  IN OUT WALK_STATE          *State,
+  IN     UINT32              Offset
+  )
+{
+  if (State->CurrentId > MAX_STRING_ID) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+  if (State->CurrentId >= State->Capacity) {
+    UINTN NewCapacity = MAX(State->Capacity * 2, State->CurrentId + 1);
+    NewCapacity = MAX(NewCapacity, 64);
+    UINT32* NewOffsets = ReallocatePool(State->Capacity * sizeof(UINT32), NewCapacity * sizeof(UINT32), Decoder->Offsets);
+    if (NewOffsets == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    // IDs that are skipped have no strings
+    ZeroMem(&NewOffsets[State->Capacity], (NewCapacity - State->Capacity) * sizeof(UINT32));
+    Decoder->Offsets = NewOffsets;
+    State->Capacity = NewCapacity;
+  }
+  Decoder->Offsets[State->CurrentId] = Offset;
+  State->CurrentId++;
+  Decoder->StringCount = State->CurrentId;
+  return EFI_SUCCESS;
+}
+
+//
+// Add Count strings starting at Offset, return the offset after the last one or 0 on error
+//
+STATIC
+UINTN
+AddStrings (
+  IN OUT HII_STRING_DECODER  *Decoder,
+  IN OUT WALK_STATE          *State,
+  IN     UINTN               Offset,
+  IN     UINTN               Count,
+  IN     BOOLEAN             Scsu
+  )
+{
+  for (UINTN i = 0; i < Count; i++) {
+    UINTN Next = SkipString(State, Offset, Scsu);
+    if (Next == 0) {
+      return 0;
+    }
+    if (EFI_ERROR(AddString(Decoder, State, (UINT32)Offset | (Scsu ? HII_STRING_OFFSET_SCSU : 0)))) {
+      return 0;
+    }
+    Offset = Next;
+  }
+  return Offset;
+}
+
+EFI_STATUS
+HiiStringDecoderInit (
+  OUT HII_STRING_DECODER                *Decoder,
+  IN  CONST EFI_HII_STRING_PACKAGE_HDR  *Package
+  )
+{
+  ZeroMem(Decoder, sizeof(*Decoder));
+  if ((Package->Header.Type != EFI_HII_PACKAGE_STRINGS) ||
+      (Package->Header.Length > HII_STRING_OFFSET_MASK) ||
+      (Package->StringInfoOffset > Package->Header.Length) ||
+      (Package->HdrSize < sizeof(EFI_HII_STRING_PACKAGE_HDR))) {
+    return EFI_INVALID_PARAMETER;
+  }
+  Decoder->Package = Package;
+  Decoder->Language = Package->Language;
+
+  WALK_STATE State;
+  State.Base = (CONST UINT8*)Package;
+  State.Length = Package->Header.Length;
+  State.Capacity = 0;
+  State.CurrentId = 1;
+
+  UINTN Offset = Package->StringInfoOffset;
+  CONST UINT8* Ptr = State.Base;
+  EFI_STATUS Status = EFI_SUCCESS;
+  while (Offset < State.Length) {
+    UINT8 BlockType = Ptr[Offset];
+    UINTN Remaining = State.Length - Offset;
+    UINTN Next = 0;
+
+    switch (BlockType) {
+      case EFI_HII_SIBT_END:
+        goto Done;
+      case EFI_HII_SIBT_STRING_SCSU:
+        Next = AddStrings(Decoder, &State, Offset + 1, 1, TRUE);
+        break;
+      case EFI_HII_SIBT_STRING_SCSU_FONT:
+        Next = AddStrings(Decoder, &State, Offset + 2, 1, TRUE);
+        break;
+      case EFI_HII_SIBT_STRINGS_SCSU:
+        if (Remaining >= 3) {
+          Next = AddStrings(Decoder, &State, Offset + 3, ReadUnaligned16((UINT16*)&Ptr[Offset + 1]), TRUE);
+        }
+        break;
+      case EFI_HII_SIBT_STRINGS_SCSU_FONT:
+        if (Remaining >= 4) {
+          Next = AddStrings(Decoder, &State, Offset + 4, ReadUnaligned16((UINT16*)&Ptr[Offset + 2]), TRUE);
+        }
+        break;
+      case EFI_HII_SIBT_STRING_UCS2:
+        Next = AddStrings(Decoder, &State, Offset + 1, 1, FALSE);
+        break;
+      case EFI_HII_SIBT_STRING_UCS2_FONT:
+        Next = AddStrings(Decoder, &State, Offset + 2, 1, FALSE);
+        break;
+      case EFI_HII_SIBT_STRINGS_UCS2:
+        if (Remaining >= 3) {
+          Next = AddStrings(Decoder, &State, Offset + 3, ReadUnaligned16((UINT16*)&Ptr[Offset + 1]), FALSE);
+        }
+        break;
+      case EFI_HII_SIBT_STRINGS_UCS2_FONT:
+        if (Remaining >= 4) {
+          Next = AddStrings(Decoder, &State, Offset + 4, ReadUnaligned16((UINT16*)&Ptr[Offset + 2]), FALSE);
+        }
+        break;
+      case EFI_HII_SIBT_DUPLICATE:
+        if (Remaining >= sizeof(EFI_HII_SIBT_DUPLICATE_BLOCK)) {
+          // Only the strings that are already defined can be duplicated
+          UINTN StringId = ReadUnaligned16((UINT16*)&Ptr[Offset + 1]);
+          UINT32 Duplicate = (StringId < Decoder->StringCount) ? Decoder->Offsets[StringId] : 0;
+          if (!EFI_ERROR(AddString(Decoder, &State, Duplicate))) {
+            Next = Offset + sizeof(EFI_HII_SIBT_DUPLICATE_BLOCK);
+          }
+        }
+        break;
+      case EFI_HII_SIBT_SKIP2:
+        if (Remaining >= sizeof(EFI_HII_SIBT_SKIP2_BLOCK)) {
+          State.CurrentId += ReadUnaligned16((UINT16*)&Ptr[Offset + 1]);
+          Next = Offset + sizeof(EFI_HII_SIBT_SKIP2_BLOCK);
+        }
+        break;
+      case EFI_HII_SIBT_SKIP1:
+        if (Remaining >= sizeof(EFI_HII_SIBT_SKIP1_BLOCK)) {
+          State.CurrentId += Ptr[Offset + 1];
+          Next = Offset + sizeof(EFI_HII_SIBT_SKIP1_BLOCK);
+        }
+        break;
+      case EFI_HII_SIBT_EXT1:
+        // Extended blocks (e.g. EFI_HII_SIBT_FONT) don't define strings, only skip them
+        if (Remaining >= sizeof(EFI_HII_SIBT_EXT1_BLOCK)) {
+          Next = Offset + Ptr[Offset + 2];
+        }
+        break;
+      case EFI_HII_SIBT_EXT2:
+        if (Remaining >= sizeof(EFI_HII_SIBT_EXT2_BLOCK)) {
+          Next = Offset + ReadUnaligned16((UINT16*)&Ptr[Offset + 2]);
+        }
+        break;
+      case EFI_HII_SIBT_EXT4:
+        if (Remaining >= sizeof(EFI_HII_SIBT_EXT4_BLOCK)) {
+          Next = Offset + ReadUnaligned32((UINT32*)&Ptr[Offset + 2]);
+        }
+        break;
+    }
+
+    if (Next <= Offset) {
+      DEBUG ((EFI_D_ERROR, "HiiStringDecoder: broken block 0x%02x at offset 0x%x\n", BlockType, Offset));
+      Status = EFI_VOLUME_CORRUPTED;
+      break;
+    }
+    Offset = Next;
+  }
+
+Done:
+  if (EFI_ERROR(Status)) {
+    HiiStringDecoderFree(Decoder);
+  }
+  return Status;
+}
+
+EFI_STATUS
+HiiStringDecoderInitPackageList (
+  IN  CONST EFI_HII_PACKAGE_LIST_HEADER  *PackageList,
+  OUT HII_STRING_DECODER                 **Decoders,
+  OUT UINTN                              *DecoderCount
+  )
+{
+  *Decoders = NULL;
+  *DecoderCount = 0;
+
+  CONST UINT8* Ptr = (CONST UINT8*)(PackageList + 1);
+  CONST UINT8* End = (CONST UINT8*)PackageList + PackageList->PackageLength;
+  UINTN Count = 0;
+  while (Ptr + sizeof(EFI_HII_PACKAGE_HEADER) <= End) {
+    CONST EFI_HII_PACKAGE_HEADER* Package = (CONST EFI_HII_PACKAGE_HEADER*)Ptr;
+    if ((Package->Length < sizeof(EFI_HII_PACKAGE_HEADER)) || (Package->Length > (UINTN)(End - Ptr))) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+    if (Package->Type == EFI_HII_PACKAGE_STRINGS) {
+      Count++;
+    }
+    Ptr += Package->Length;
+  }
+  if (Count == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  HII_STRING_DECODER* Array = AllocateZeroPool(Count * sizeof(HII_STRING_DECODER));
+  if (Array == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Ptr = (CONST UINT8*)(PackageList + 1);
+  for (UINTN i = 0; i < Count; Ptr += ((CONST EFI_HII_PACKAGE_HEADER*)Ptr)->Length) {
+    if (((CONST EFI_HII_PACKAGE_HEADER*)Ptr)->Type != EFI_HII_PACKAGE_STRINGS) {
+      continue;
+    }
+    EFI_STATUS Status = HiiStringDecoderInit(&Array[i], (CONST EFI_HII_STRING_PACKAGE_HDR*)Ptr);
+    if (EFI_ERROR(Status)) {
+      HiiStringDecoderFreeArray(Array, i);
+      return Status;
+    }
+    i++;
+  }
+
+  *Decoders = Array;
+  *DecoderCount = Count;
+  return EFI_SUCCESS;
+}
+
+VOID
+HiiStringDecoderFree (
+  IN HII_STRING_DECODER  *Decoder
+  )
+{
+  if (Decoder->Offsets != NULL) {
+    FreePool(Decoder->Offsets);
+  }
+  Decoder->Offsets = NULL;
+  Decoder->StringCount = 0;
+}
+
+VOID
+HiiStringDecoderFreeArray (
+  IN HII_STRING_DECODER  *Decoders,
+  IN UINTN               DecoderCount
+  )
+{
+  for (UINTN i = 0; i < DecoderCount; i++) {
+    HiiStringDecoderFree(&Decoders[i]);
+  }
+  FreePool(Decoders);
+}
+
+BOOLEAN
+HiiStringDecoderHasString (
+  IN CONST HII_STRING_DECODER  *Decoder,
+  IN EFI_STRING_ID             StringId
+  )
+{
+  return (StringId < Decoder->StringCount) && (Decoder->Offsets[StringId] != 0);
+}
+
+EFI_STATUS
+HiiStringDecoderGetString (
+  IN     CONST HII_STRING_DECODER  *Decoder,
+  IN     EFI_STRING_ID             StringId,
+  OUT    CHAR16                    *Buffer OPTIONAL,
+  IN OUT UINTN                     *BufferSize
+  )
+{
+  if (!HiiStringDecoderHasString(Decoder, StringId)) {
+    return EFI_NOT_FOUND;
+  }
+
+  UINT32 Entry = Decoder->Offsets[StringId];
+  CONST UINT8* Text = (CONST UINT8*)Decoder->Package + (Entry & HII_STRING_OFFSET_MASK);
+  UINTN Length = 0;
+  if (Entry & HII_STRING_OFFSET_SCSU) {
+    while (Text[Length] != 0) {
+      Length++;
+    }
+  } else {
+    while ((Text[Length * 2] != 0) || (Text[Length * 2 + 1] != 0)) {
+      Length++;
+    }
+  }
+
+  UINTN Size = (Length + 1) * sizeof(CHAR16);
+  if (*BufferSize < Size) {
+    *BufferSize = Size;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+  *BufferSize = Size;
+
+  if (Entry & HII_STRING_OFFSET_SCSU) {
+    for (UINTN i = 0; i <= Length; i++) {
+      Buffer[i] = Text[i];
+    }
+  } else {
+    CopyMem(Buffer, Text, Size);
+  }
+  return EFI_SUCCESS;
+}
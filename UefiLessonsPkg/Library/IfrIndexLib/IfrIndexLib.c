@@ -0,0 +1,819 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/IfrIndexLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HiiDbIndexLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/SortLib.h>
+#include <Guid/MdeModuleHii.h>
+
+#define MAX_FORMSET_VARSTORES  128
+
+typedef struct {
+  VOID   *Data;
+  UINTN  Count;
+  UINTN  Capacity;
+} ARRAY;
+
+//
+// Questions of the varstore in the offset order are mOffsetOrder[First]..mOffsetOrder[First + Count - 1]
+//
+typedef struct {
+  UINTN   First;
+  UINTN   Count;
+  UINT16  MaxWidth;
+} VARSTORE_ORDER;
+
+//
+// VarStoreId is local to the formset
+//
+typedef struct {
+  EFI_VARSTORE_ID  VarStoreId;
+  UINTN            VarStore;
+} LOCAL_VARSTORE;
+
+STATIC ARRAY mFormSets = { NULL, 0, 0 };
+STATIC ARRAY mVarStores = { NULL, 0, 0 };
+STATIC ARRAY mQuestions = { NULL, 0, 0 };
+STATIC UINTN* mOffsetOrder = NULL;
+STATIC UINTN* mIdOrder = NULL;
+STATIC VARSTORE_ORDER* mVarStoreOrder = NULL;
+//
+// Formsets of the package list are mListOrder[mListFirst[List]]..mListOrder[mListFirst[List + 1] - 1]
+//
+STATIC UINTN* mListOrder = NULL;
+STATIC UINTN* mListFirst = NULL;
+STATIC UINTN mListCount = 0;
+STATIC BOOLEAN mBuilt = FALSE;
+STATIC UINTN mHiiGeneration = 0;
+
+STATIC
+VOID*
+ArrayAppend (
+  IN ARRAY  *Array,
+  IN UINTN  ElementSize
+  )
+{
+  if (Array->Count == Array->Capacity) {
+    UINTN NewCapacity = (Array->Capacity == 0) ? 16 : Array->Capacity * 2;
+    VOID* NewData = ReallocatePool(Array->Capacity * ElementSize, NewCapacity * ElementSize, Array->Data);
+    if (NewData == NULL) {
+      return NULL;
+    }
+    Array->Data = NewData;
+    Array->Capacity = NewCapacity;
+  }
+  VOID* Element = (UINT8*)Array->Data + Array->Count * ElementSize;
+  ZeroMem(Element, ElementSize);
+  Array->Count++;
+  return Element;
+}
+
+STATIC
+VOID
+ArrayFree (
+  IN ARRAY  *Array
+  )
+{
+  if (Array->Data != NULL) {
+    FreePool(Array->Data);
+  }
+  Array->Data = NULL;
+  Array->Count = 0;
+  Array->Capacity = 0;
+}
+
+#define FORMSETS   ((IFR_FORMSET*)mFormSets.Data)
+#define VARSTORES  ((IFR_VARSTORE*)mVarStores.Data)
+#define QUESTIONS  ((IFR_QUESTION*)mQuestions.Data)
+
+STATIC
+VOID
+FreeIndex (
+  VOID
+  )
+{
+  ArrayFree(&mFormSets);
+  ArrayFree(&mVarStores);
+  ArrayFree(&mQuestions);
+  if (mOffsetOrder != NULL) {
+    FreePool(mOffsetOrder);
+    mOffsetOrder = NULL;
+  }
+  if (mIdOrder != NULL) {
+    FreePool(mIdOrder);
+    mIdOrder = NULL;
+  }
+  if (mVarStoreOrder != NULL) {
+    FreePool(mVarStoreOrder);
+    mVarStoreOrder = NULL;
+  }
+  if (mListOrder != NULL) {
+    FreePool(mListOrder);
+    mListOrder = NULL;
+  }
+  if (mListFirst != NULL) {
+    FreePool(mListFirst);
+    mListFirst = NULL;
+  }
+  mListCount = 0;
+  mBuilt = FALSE;
+}
+
+STATIC
+UINTN
+AddVarStore (
+  IN EFI_IFR_OP_HEADER  *OpHeader
+  )
+{
+  IFR_VARSTORE VarStore;
+  ZeroMem(&VarStore, sizeof(VarStore));
+  VarStore.OpCode = OpHeader->OpCode;
+
+  CONST UINT8* Name = NULL;
+  UINTN NameSize = 0;
+  if (OpHeader->OpCode == EFI_IFR_VARSTORE_OP) {
+    EFI_IFR_VARSTORE* Op = (EFI_IFR_VARSTORE*)OpHeader;
+    CopyGuid(&VarStore.Guid, &Op->Guid);
+    VarStore.Size = Op->Size;
+    Name = Op->Name;
+    NameSize = OpHeader->Length - OFFSET_OF(EFI_IFR_VARSTORE, Name);
+  } else if (OpHeader->OpCode == EFI_IFR_VARSTORE_EFI_OP) {
+    EFI_IFR_VARSTORE_EFI* Op = (EFI_IFR_VARSTORE_EFI*)OpHeader;
+    CopyGuid(&VarStore.Guid, &Op->Guid);
+    VarStore.Attributes = Op->Attributes;
+    // UEFI 2.1 EFI varstores have no Size and Name fields
+    if (OpHeader->Length > OFFSET_OF(EFI_IFR_VARSTORE_EFI, Name)) {
+      VarStore.Size = Op->Size;
+      Name = Op->Name;
+      NameSize = OpHeader->Length - OFFSET_OF(EFI_IFR_VARSTORE_EFI, Name);
+    }
+  } else {
+    EFI_IFR_VARSTORE_NAME_VALUE* Op = (EFI_IFR_VARSTORE_NAME_VALUE*)OpHeader;
+    CopyGuid(&VarStore.Guid, &Op->Guid);
+  }
+  for (UINTN i = 0; (i < NameSize) && (i < IFR_VARSTORE_NAME_SIZE - 1) && (Name[i] != 0); i++) {
+    VarStore.Name[i] = (CHAR8)Name[i];
+  }
+
+  // The same storage declared in several formsets is a single varstore
+  for (UINTN i = 0; i < mVarStores.Count; i++) {
+    if ((VARSTORES[i].OpCode == VarStore.OpCode) &&
+        CompareGuid(&VARSTORES[i].Guid, &VarStore.Guid) &&
+        (AsciiStrCmp(VARSTORES[i].Name, VarStore.Name) == 0)) {
+      return i;
+    }
+  }
+
+  IFR_VARSTORE* New = ArrayAppend(&mVarStores, sizeof(IFR_VARSTORE));
+  if (New == NULL) {
+    return IFR_INDEX_NOT_FOUND;
+  }
+  CopyMem(New, &VarStore, sizeof(VarStore));
+  return mVarStores.Count - 1;
+}
+
+STATIC
+UINT16
+NumericWidth (
+  IN UINT8  Flags
+  )
+{
+  return (UINT16)(1 << (Flags & EFI_IFR_NUMERIC_SIZE));
+}
+
+STATIC
+UINT16
+ValueWidth (
+  IN UINT8  Type
+  )
+{
+  switch (Type) {
+    case EFI_IFR_TYPE_NUM_SIZE_8:
+    case EFI_IFR_TYPE_BOOLEAN:
+      return 1;
+    case EFI_IFR_TYPE_NUM_SIZE_16:
+    case EFI_IFR_TYPE_STRING:
+      return 2;
+    case EFI_IFR_TYPE_NUM_SIZE_32:
+      return 4;
+    case EFI_IFR_TYPE_NUM_SIZE_64:
+      return 8;
+    case EFI_IFR_TYPE_TIME:
+      return sizeof(EFI_HII_TIME);
+    case EFI_IFR_TYPE_DATE:
+      return sizeof(EFI_HII_DATE);
+  }
+  return 0;
+}
+
+STATIC
+VOID
+AddDefault (
+  IN IFR_QUESTION  *Question,
+  IN UINT16        DefaultId,
+  IN UINT8         Type,
+  IN UINT8         *Value,
+  IN UINTN         ValueSize
+  )
+{
+  UINTN Width = ValueWidth(Type);
+  if ((Width == 0) || (Width > ValueSize) || (Question->DefaultCount == IFR_MAX_DEFAULTS)) {
+    return;
+  }
+  for (UINTN i = 0; i < Question->DefaultCount; i++) {
+    if (Question->Defaults[i].DefaultId == DefaultId) {
+      return;
+    }
+  }
+  IFR_DEFAULT* Default = &Question->Defaults[Question->DefaultCount++];
+  Default->DefaultId = DefaultId;
+  Default->Value = 0;
+  CopyMem(&Default->Value, Value, Width);
+}
+
+STATIC
+IFR_QUESTION*
+AddQuestion (
+  IN EFI_IFR_OP_HEADER  *OpHeader,
+  IN UINTN              FormSet,
+  IN EFI_FORM_ID        FormId,
+  IN LOCAL_VARSTORE     *LocalVarStores,
+  IN UINTN              LocalVarStoreCount,
+  IN BOOLEAN            BitVarStore
+  )
+{
+  IFR_QUESTION* Question = ArrayAppend(&mQuestions, sizeof(IFR_QUESTION));
+  if (Question == NULL) {
+    return NULL;
+  }
+
+  EFI_IFR_QUESTION_HEADER* Header = (EFI_IFR_QUESTION_HEADER*)(OpHeader + 1);
+  Question->QuestionId = Header->QuestionId;
+  Question->Prompt = Header->Header.Prompt;
+  Question->Help = Header->Header.Help;
+  Question->OpCode = OpHeader->OpCode;
+  Question->FormId = FormId;
+  Question->FormSet = FormSet;
+  Question->Offset = Header->VarStoreInfo.VarOffset;
+  Question->VarStore = IFR_INDEX_NOT_FOUND;
+  for (UINTN i = 0; (Header->VarStoreId != 0) && (i < LocalVarStoreCount); i++) {
+    if (LocalVarStores[i].VarStoreId == Header->VarStoreId) {
+      Question->VarStore = LocalVarStores[i].VarStore;
+      break;
+    }
+  }
+
+  UINT8 BitWidth = 0;
+  switch (OpHeader->OpCode) {
+    case EFI_IFR_CHECKBOX_OP: {
+      EFI_IFR_CHECKBOX* Op = (EFI_IFR_CHECKBOX*)OpHeader;
+      Question->Width = 1;
+      BitWidth = 1;
+      UINT8 True = 1;
+      if (Op->Flags & EFI_IFR_CHECKBOX_DEFAULT) {
+        AddDefault(Question, EFI_HII_DEFAULT_CLASS_STANDARD, EFI_IFR_TYPE_BOOLEAN, &True, sizeof(True));
+      }
+      if (Op->Flags & EFI_IFR_CHECKBOX_DEFAULT_MFG) {
+        AddDefault(Question, EFI_HII_DEFAULT_CLASS_MANUFACTURING, EFI_IFR_TYPE_BOOLEAN, &True, sizeof(True));
+      }
+      break;
+    }
+    case EFI_IFR_ONE_OF_OP:
+    case EFI_IFR_NUMERIC_OP: {
+      // EFI_IFR_NUMERIC has the same layout
+      EFI_IFR_ONE_OF* Op = (EFI_IFR_ONE_OF*)OpHeader;
+      Question->Width = NumericWidth(Op->Flags);
+      BitWidth = Op->Flags & EDKII_IFR_NUMERIC_SIZE_BIT;
+      break;
+    }
+    case EFI_IFR_STRING_OP: {
+      EFI_IFR_STRING* Op = (EFI_IFR_STRING*)OpHeader;
+      Question->Width = Op->MaxSize * sizeof(CHAR16);
+      break;
+    }
+    case EFI_IFR_PASSWORD_OP: {
+      EFI_IFR_PASSWORD* Op = (EFI_IFR_PASSWORD*)OpHeader;
+      Question->Width = Op->MaxSize * sizeof(CHAR16);
+      break;
+    }
+    case EFI_IFR_ORDERED_LIST_OP: {
+      // Element size is known only from the options, it is updated later
+      EFI_IFR_ORDERED_LIST* Op = (EFI_IFR_ORDERED_LIST*)OpHeader;
+      Question->Width = Op->MaxContainers;
+      break;
+    }
+    case EFI_IFR_DATE_OP:
+      Question->Width = sizeof(EFI_HII_DATE);
+      break;
+    case EFI_IFR_TIME_OP:
+      Question->Width = sizeof(EFI_HII_TIME);
+      break;
+  }
+
+  //
+  // In the bit varstores VarOffset is a bit offset and the numeric size flags are bit widths
+  //
+  if (BitVarStore && (Question->VarStore != IFR_INDEX_NOT_FOUND) && (BitWidth != 0)) {
+    Question->Flags |= IFR_QUESTION_BIT_FIELD;
+    Question->BitOffset = Header->VarStoreInfo.VarOffset;
+    Question->BitWidth = BitWidth;
+    Question->Offset = Question->BitOffset / 8;
+    Question->Width = (UINT16)((Question->BitOffset % 8 + BitWidth + 7) / 8);
+  }
+
+  if (Question->VarStore == IFR_INDEX_NOT_FOUND) {
+    Question->Width = 0;
+  } else {
+    VARSTORES[Question->VarStore].QuestionCount++;
+  }
+  return Question;
+}
+
+STATIC
+EFI_STATUS
+ParseFormsPackage (
+  IN EFI_HII_PACKAGE_HEADER  *Package,
+  IN UINTN                   PackageList
+  )
+{
+  LOCAL_VARSTORE LocalVarStores[MAX_FORMSET_VARSTORES];
+  UINTN LocalVarStoreCount = 0;
+  UINTN FormSet = IFR_INDEX_NOT_FOUND;
+  EFI_FORM_ID FormId = 0;
+  UINTN Depth = 0;
+  UINTN Question = IFR_INDEX_NOT_FOUND;     // Question that has the current scope
+  UINTN QuestionDepth = 0;
+  BOOLEAN OptionWidthSet = FALSE;
+  BOOLEAN BitVarStore = FALSE;
+  UINTN BitVarStoreDepth = 0;
+
+  UINT8* Ptr = (UINT8*)(Package + 1);
+  UINT8* End = (UINT8*)Package + Package->Length;
+  while (Ptr + sizeof(EFI_IFR_OP_HEADER) <= End) {
+    EFI_IFR_OP_HEADER* OpHeader = (EFI_IFR_OP_HEADER*)Ptr;
+    if ((OpHeader->Length < sizeof(EFI_IFR_OP_HEADER)) || (OpHeader->Length > (UINTN)(End - Ptr))) {
+      DEBUG ((EFI_D_ERROR, "IfrIndex: wrong opcode 0x%02x length at offset 0x%x\n", OpHeader->OpCode, Ptr - (UINT8*)Package));
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    switch (OpHeader->OpCode) {
+      case EFI_IFR_FORM_SET_OP: {
+        if (OpHeader->Length < OFFSET_OF(EFI_IFR_FORM_SET, Flags)) {
+          break;
+        }
+        EFI_IFR_FORM_SET* Op = (EFI_IFR_FORM_SET*)OpHeader;
+        IFR_FORMSET* New = ArrayAppend(&mFormSets, sizeof(IFR_FORMSET));
+        if (New == NULL) {
+          return EFI_OUT_OF_RESOURCES;
+        }
+        CopyGuid(&New->Guid, &Op->Guid);
+        New->Title = Op->FormSetTitle;
+        New->PackageList = PackageList;
+        New->FirstQuestion = mQuestions.Count;
+        FormSet = mFormSets.Count - 1;
+        LocalVarStoreCount = 0;
+        break;
+      }
+      case EFI_IFR_FORM_OP:
+      case EFI_IFR_FORM_MAP_OP:
+        // EFI_IFR_FORM_MAP starts with the FormId too
+        FormId = ((EFI_IFR_FORM*)OpHeader)->FormId;
+        break;
+      case EFI_IFR_VARSTORE_OP:
+      case EFI_IFR_VARSTORE_EFI_OP:
+      case EFI_IFR_VARSTORE_NAME_VALUE_OP: {
+        if (OpHeader->Length < sizeof(EFI_IFR_VARSTORE_NAME_VALUE)) {
+          break;
+        }
+        if (LocalVarStoreCount == MAX_FORMSET_VARSTORES) {
+          DEBUG ((EFI_D_ERROR, "IfrIndex: too many varstores in the formset\n"));
+          break;
+        }
+        UINTN VarStore = AddVarStore(OpHeader);
+        if (VarStore == IFR_INDEX_NOT_FOUND) {
+          return EFI_OUT_OF_RESOURCES;
+        }
+        // EFI_IFR_VARSTORE has VarStoreId after the GUID, other varstores before it
+        LocalVarStores[LocalVarStoreCount].VarStoreId = (OpHeader->OpCode == EFI_IFR_VARSTORE_OP) ?
+                                                        ((EFI_IFR_VARSTORE*)OpHeader)->VarStoreId :
+                                                        ((EFI_IFR_VARSTORE_EFI*)OpHeader)->VarStoreId;
+        LocalVarStores[LocalVarStoreCount].VarStore = VarStore;
+        LocalVarStoreCount++;
+        break;
+      }
+      case EFI_IFR_CHECKBOX_OP:
+      case EFI_IFR_ONE_OF_OP:
+      case EFI_IFR_NUMERIC_OP:
+      case EFI_IFR_STRING_OP:
+      case EFI_IFR_PASSWORD_OP:
+      case EFI_IFR_ORDERED_LIST_OP:
+      case EFI_IFR_DATE_OP:
+      case EFI_IFR_TIME_OP:
+      case EFI_IFR_ACTION_OP:
+      case EFI_IFR_REF_OP: {
+        if ((FormSet == IFR_INDEX_NOT_FOUND) ||
+            (OpHeader->Length < sizeof(EFI_IFR_OP_HEADER) + sizeof(EFI_IFR_QUESTION_HEADER))) {
+          break;
+        }
+        if (AddQuestion(OpHeader, FormSet, FormId, LocalVarStores, LocalVarStoreCount, BitVarStore) == NULL) {
+          return EFI_OUT_OF_RESOURCES;
+        }
+        if (OpHeader->Scope) {
+          Question = mQuestions.Count - 1;
+          QuestionDepth = Depth;
+          OptionWidthSet = FALSE;
+        }
+        break;
+      }
+      case EFI_IFR_ONE_OF_OPTION_OP: {
+        if ((Question == IFR_INDEX_NOT_FOUND) || (OpHeader->Length < OFFSET_OF(EFI_IFR_ONE_OF_OPTION, Value))) {
+          break;
+        }
+        EFI_IFR_ONE_OF_OPTION* Op = (EFI_IFR_ONE_OF_OPTION*)OpHeader;
+        IFR_QUESTION* Current = &QUESTIONS[Question];
+        if ((Current->OpCode == EFI_IFR_ORDERED_LIST_OP) && !OptionWidthSet) {
+          // MaxContainers elements of the option type
+          Current->Width = (UINT16)(Current->Width * MAX(ValueWidth(Op->Type), 1));
+          OptionWidthSet = TRUE;
+        }
+        UINTN ValueSize = OpHeader->Length - OFFSET_OF(EFI_IFR_ONE_OF_OPTION, Value);
+        if (Op->Flags & EFI_IFR_OPTION_DEFAULT) {
+          AddDefault(Current, EFI_HII_DEFAULT_CLASS_STANDARD, Op->Type, (UINT8*)&Op->Value, ValueSize);
+        }
+        if (Op->Flags & EFI_IFR_OPTION_DEFAULT_MFG) {
+          AddDefault(Current, EFI_HII_DEFAULT_CLASS_MANUFACTURING, Op->Type, (UINT8*)&Op->Value, ValueSize);
+        }
+        break;
+      }
+      case EFI_IFR_DEFAULT_OP: {
+        if ((Question == IFR_INDEX_NOT_FOUND) || (OpHeader->Length < OFFSET_OF(EFI_IFR_DEFAULT, Value))) {
+          break;
+        }
+        // Defaults calculated by expressions (EFI_IFR_TYPE_OTHER) are not supported
+        EFI_IFR_DEFAULT* Op = (EFI_IFR_DEFAULT*)OpHeader;
+        AddDefault(&QUESTIONS[Question],
+                   Op->DefaultId,
+                   Op->Type,
+                   (UINT8*)&Op->Value,
+                   OpHeader->Length - OFFSET_OF(EFI_IFR_DEFAULT, Value));
+        break;
+      }
+      case EFI_IFR_GUID_OP: {
+        if (OpHeader->Length < sizeof(EFI_IFR_GUID)) {
+          break;
+        }
+        if (OpHeader->Scope && CompareGuid(&((EFI_IFR_GUID*)OpHeader)->Guid, &gEdkiiIfrBitVarstoreGuid)) {
+          BitVarStore = TRUE;
+          BitVarStoreDepth = Depth;
+        }
+        break;
+      }
+      case EFI_IFR_END_OP: {
+        if (Depth == 0) {
+          DEBUG ((EFI_D_ERROR, "IfrIndex: unbalanced EFI_IFR_END_OP\n"));
+          return EFI_VOLUME_CORRUPTED;
+        }
+        Depth--;
+        if ((Question != IFR_INDEX_NOT_FOUND) && (Depth == QuestionDepth)) {
+          Question = IFR_INDEX_NOT_FOUND;
+        }
+        if (BitVarStore && (Depth == BitVarStoreDepth)) {
+          BitVarStore = FALSE;
+        }
+        if ((Depth == 0) && (FormSet != IFR_INDEX_NOT_FOUND)) {
+          FORMSETS[FormSet].QuestionCount = mQuestions.Count - FORMSETS[FormSet].FirstQuestion;
+          FormSet = IFR_INDEX_NOT_FOUND;
+        }
+        break;
+      }
+    }
+
+    if (OpHeader->Scope) {
+      Depth++;
+    }
+    Ptr += OpHeader->Length;
+  }
+
+  // Formset without the closing EFI_IFR_END_OP
+  if (FormSet != IFR_INDEX_NOT_FOUND) {
+    FORMSETS[FormSet].QuestionCount = mQuestions.Count - FORMSETS[FormSet].FirstQuestion;
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC
+INTN
+EFIAPI
+CompareByOffset (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  CONST IFR_QUESTION* Question1 = &QUESTIONS[*(CONST UINTN*)Buffer1];
+  CONST IFR_QUESTION* Question2 = &QUESTIONS[*(CONST UINTN*)Buffer2];
+  if (Question1->VarStore != Question2->VarStore) {
+    return (Question1->VarStore < Question2->VarStore) ? -1 : 1;
+  }
+  if (Question1->Offset != Question2->Offset) {
+    return (Question1->Offset < Question2->Offset) ? -1 : 1;
+  }
+  // Keep the database order for the same offset
+  return (*(CONST UINTN*)Buffer1 < *(CONST UINTN*)Buffer2) ? -1 : 1;
+}
+
+STATIC
+INTN
+EFIAPI
+CompareById (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  CONST IFR_QUESTION* Question1 = &QUESTIONS[*(CONST UINTN*)Buffer1];
+  CONST IFR_QUESTION* Question2 = &QUESTIONS[*(CONST UINTN*)Buffer2];
+  if (Question1->FormSet != Question2->FormSet) {
+    return (Question1->FormSet < Question2->FormSet) ? -1 : 1;
+  }
+  if (Question1->QuestionId != Question2->QuestionId) {
+    return (Question1->QuestionId < Question2->QuestionId) ? -1 : 1;
+  }
+  return (*(CONST UINTN*)Buffer1 < *(CONST UINTN*)Buffer2) ? -1 : 1;
+}
+
+STATIC
+EFI_STATUS
+BuildIndex (
+  VOID
+  )
+{
+  UINTN PackageCount = HiiDbIndexCountByType(EFI_HII_PACKAGE_FORMS);
+  for (UINTN i = 0; i < PackageCount; i++) {
+    CONST HII_DB_PACKAGE* Package = HiiDbIndexFindByType(EFI_HII_PACKAGE_FORMS, i);
+    EFI_STATUS Status = ParseFormsPackage(Package->Package, Package->ListIndex);
+    if (Status == EFI_OUT_OF_RESOURCES) {
+      return Status;
+    }
+    // Broken package doesn't prevent the others from being indexed
+  }
+
+  UINTN QuestionCount = mQuestions.Count;
+  mOffsetOrder = AllocatePool(MAX(QuestionCount, 1) * sizeof(UINTN));
+  mIdOrder = AllocatePool(MAX(QuestionCount, 1) * sizeof(UINTN));
+  mVarStoreOrder = AllocateZeroPool(MAX(mVarStores.Count, 1) * sizeof(VARSTORE_ORDER));
+  if ((mOffsetOrder == NULL) || (mIdOrder == NULL) || (mVarStoreOrder == NULL)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  for (UINTN i = 0; i < QuestionCount; i++) {
+    mOffsetOrder[i] = i;
+    mIdOrder[i] = i;
+  }
+  if (QuestionCount > 1) {
+    PerformQuickSort(mOffsetOrder, QuestionCount, sizeof(UINTN), CompareByOffset);
+    PerformQuickSort(mIdOrder, QuestionCount, sizeof(UINTN), CompareById);
+  }
+
+  // Questions without storage are sorted to the end (IFR_INDEX_NOT_FOUND is the largest index)
+  for (UINTN i = 0; i < QuestionCount; i++) {
+    IFR_QUESTION* Question = &QUESTIONS[mOffsetOrder[i]];
+    if (Question->VarStore == IFR_INDEX_NOT_FOUND) {
+      break;
+    }
+    VARSTORE_ORDER* Order = &mVarStoreOrder[Question->VarStore];
+    if (Order->Count == 0) {
+      Order->First = i;
+    }
+    Order->Count++;
+    Order->MaxWidth = MAX(Order->MaxWidth, Question->Width);
+  }
+
+  //
+  // Group the formsets by the package list with a counting sort, the database order
+  // is kept inside every package list
+  //
+  mListCount = HiiDbIndexGetListCount();
+  mListOrder = AllocatePool(MAX(mFormSets.Count, 1) * sizeof(UINTN));
+  mListFirst = AllocateZeroPool((mListCount + 1) * sizeof(UINTN));
+  if ((mListOrder == NULL) || (mListFirst == NULL)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  for (UINTN i = 0; i < mFormSets.Count; i++) {
+    mListFirst[FORMSETS[i].PackageList + 1]++;
+  }
+  for (UINTN i = 0; i < mListCount; i++) {
+    mListFirst[i + 1] += mListFirst[i];
+  }
+  for (UINTN i = 0; i < mFormSets.Count; i++) {
+    // mListFirst[List] is used as the insert position and is restored by the shift below
+    mListOrder[mListFirst[FORMSETS[i].PackageList]++] = i;
+  }
+  for (UINTN i = mListCount; i > 0; i--) {
+    mListFirst[i] = mListFirst[i - 1];
+  }
+  mListFirst[0] = 0;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+IfrIndexInit (
+  VOID
+  )
+{
+  EFI_STATUS Status = HiiDbIndexInit();
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  UINTN Generation = HiiDbIndexGetGeneration();
+  if (mBuilt && (Generation == mHiiGeneration)) {
+    return EFI_SUCCESS;
+  }
+
+  FreeIndex();
+  Status = BuildIndex();
+  if (EFI_ERROR(Status)) {
+    FreeIndex();
+    return Status;
+  }
+  mBuilt = TRUE;
+  mHiiGeneration = Generation;
+  return EFI_SUCCESS;
+}
+
+UINTN
+IfrIndexGetFormSetCount (
+  VOID
+  )
+{
+  return EFI_ERROR(IfrIndexInit()) ? 0 : mFormSets.Count;
+}
+
+CONST IFR_FORMSET*
+IfrIndexGetFormSet (
+  IN UINTN  Index
+  )
+{
+  if (EFI_ERROR(IfrIndexInit()) || (Index >= mFormSets.Count)) {
+    return NULL;
+  }
+  return &FORMSETS[Index];
+}
+
+UINTN
+IfrIndexCountFormSetsInList (
+  IN UINTN  PackageList
+  )
+{
+  if (EFI_ERROR(IfrIndexInit()) || (PackageList >= mListCount)) {
+    return 0;
+  }
+  return mListFirst[PackageList + 1] - mListFirst[PackageList];
+}
+
+CONST IFR_FORMSET*
+IfrIndexFindFormSetInList (
+  IN UINTN  PackageList,
+  IN UINTN  Instance
+  )
+{
+  if (Instance >= IfrIndexCountFormSetsInList(PackageList)) {
+    return NULL;
+  }
+  return &FORMSETS[mListOrder[mListFirst[PackageList] + Instance]];
+}
+
+UINTN
+IfrIndexGetVarStoreCount (
+  VOID
+  )
+{
+  return EFI_ERROR(IfrIndexInit()) ? 0 : mVarStores.Count;
+}
+
+CONST IFR_VARSTORE*
+IfrIndexGetVarStore (
+  IN UINTN  Index
+  )
+{
+  if (EFI_ERROR(IfrIndexInit()) || (Index >= mVarStores.Count)) {
+    return NULL;
+  }
+  return &VARSTORES[Index];
+}
+
+UINTN
+IfrIndexGetQuestionCount (
+  VOID
+  )
+{
+  return EFI_ERROR(IfrIndexInit()) ? 0 : mQuestions.Count;
+}
+
+CONST IFR_QUESTION*
+IfrIndexGetQuestion (
+  IN UINTN  Index
+  )
+{
+  if (EFI_ERROR(IfrIndexInit()) || (Index >= mQuestions.Count)) {
+    return NULL;
+  }
+  return &QUESTIONS[Index];
+}
+
+UINTN
+IfrIndexFindVarStore (
+  IN CONST EFI_GUID  *Guid OPTIONAL,
+  IN CONST CHAR8     *Name
+  )
+{
+  if (EFI_ERROR(IfrIndexInit())) {
+    return IFR_INDEX_NOT_FOUND;
+  }
+  for (UINTN i = 0; i < mVarStores.Count; i++) {
+    if (((Guid == NULL) || CompareGuid(&VARSTORES[i].Guid, Guid)) &&
+        (AsciiStrCmp(VARSTORES[i].Name, Name) == 0)) {
+      return i;
+    }
+  }
+  return IFR_INDEX_NOT_FOUND;
+}
+
+CONST IFR_QUESTION*
+IfrIndexFindQuestion (
+  IN UINTN            FormSet,
+  IN EFI_QUESTION_ID  QuestionId
+  )
+{
+  if (EFI_ERROR(IfrIndexInit())) {
+    return NULL;
+  }
+
+  // Binary search for the first question with the FormSet/QuestionId pair
+  UINTN Low = 0;
+  UINTN High = mQuestions.Count;
+  while (Low < High) {
+    UINTN Middle = Low + (High - Low) / 2;
+    IFR_QUESTION* Question = &QUESTIONS[mIdOrder[Middle]];
+    if ((Question->FormSet < FormSet) || ((Question->FormSet == FormSet) && (Question->QuestionId < QuestionId))) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+  if (Low < mQuestions.Count) {
+    IFR_QUESTION* Question = &QUESTIONS[mIdOrder[Low]];
+    if ((Question->FormSet == FormSet) && (Question->QuestionId == QuestionId)) {
+      return Question;
+    }
+  }
+  return NULL;
+}
+
+CONST IFR_QUESTION*
+IfrIndexFindOwner (
+  IN UINTN  VarStore,
+  IN UINTN  Offset,
+  IN UINTN  Instance
+  )
+{
+  if (EFI_ERROR(IfrIndexInit()) || (VarStore >= mVarStores.Count)) {
+    return NULL;
+  }
+
+  //
+  // Binary search for the first question that starts after Offset, the owners are before it,
+  // but not further than the widest question of the varstore
+  //
+  VARSTORE_ORDER* Order = &mVarStoreOrder[VarStore];
+  UINTN Low = 0;
+  UINTN High = Order->Count;
+  while (Low < High) {
+    UINTN Middle = Low + (High - Low) / 2;
+    if (QUESTIONS[mOffsetOrder[Order->First + Middle]].Offset <= Offset) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  UINTN Start = Low;
+  while ((Start > 0) && (QUESTIONS[mOffsetOrder[Order->First + Start - 1]].Offset + Order->MaxWidth > Offset)) {
+    Start--;
+  }
+  for (UINTN i = Start; i < Low; i++) {
+    IFR_QUESTION* Question = &QUESTIONS[mOffsetOrder[Order->First + i]];
+    if (Offset < (UINTN)Question->Offset + Question->Width) {
+      if (Instance == 0) {
+        return Question;
+      }
+      Instance--;
+    }
+  }
+  return NULL;
+}
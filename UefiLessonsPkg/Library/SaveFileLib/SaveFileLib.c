@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/SaveFileLib.h>
+#include <Library/ShellLib.h>
+#include <Library/UefiLib.h>
+
+EFI_STATUS
+SaveFile (
+  IN     CHAR16  *FileName,
+  IN     VOID    *Data,
+  IN OUT UINTN   *Size
+  )
+{
+  SHELL_FILE_HANDLE FileHandle;
+  EFI_STATUS Status = ShellOpenFileByName(
+    FileName,
+    &FileHandle,
+    EFI_FILE_MODE_CREATE | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_READ,
+    0
+  );
+  if (EFI_ERROR(Status)) {
+    Print(L"Can't open file: %r\n", Status);
+    return Status;
+  }
+
+  Print(L"Save file as %s\n", FileName);
+  UINTN ToWrite = *Size;
+  Status = ShellWriteFile(
+    FileHandle,
+    Size,
+    Data
+  );
+  if (EFI_ERROR(Status)) {
+    Print(L"Can't write file: %r\n", Status);
+  } else if (*Size != ToWrite) {
+    Print(L"Error! Not all data was written\n");
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  // Write error is not overwritten by the close status
+  EFI_STATUS CloseStatus = ShellCloseFile(
+    &FileHandle
+  );
+  if (EFI_ERROR(CloseStatus)) {
+    Print(L"Can't close file: %r\n", CloseStatus);
+    if (!EFI_ERROR(Status)) {
+      Status = CloseStatus;
+    }
+  }
+  return Status;
+}
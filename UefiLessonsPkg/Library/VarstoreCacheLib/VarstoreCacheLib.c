@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HiiLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UefiHiiServicesLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/VarstoreCacheLib.h>
+
+EFI_STATUS
+VarstoreCacheReload (
+  IN VARSTORE_CACHE  *Cache
+  )
+{
+  Cache->DirtyStart = 0;
+  Cache->DirtyEnd = 0;
+  Cache->Present = FALSE;
+
+  if (Cache->Attributes == 0) {
+    return EFI_SUCCESS;
+  }
+
+  UINTN BufferSize = Cache->Size;
+  Cache->Stats.Misses++;
+  EFI_STATUS Status = gRT->GetVariable(Cache->Name,
+                                       &Cache->Guid,
+                                       NULL,
+                                       &BufferSize,
+                                       Cache->Buffer);
+  if (EFI_ERROR(Status) || (BufferSize != Cache->Size)) {
+    ZeroMem(Cache->Buffer, Cache->Size);
+    return EFI_NOT_FOUND;
+  }
+
+  Cache->Present = TRUE;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+VarstoreCacheInit (
+  OUT VARSTORE_CACHE  *Cache,
+  IN  EFI_STRING      Name,
+  IN  EFI_GUID        *Guid,
+  IN  UINT32          Attributes,
+  IN  UINTN           Size
+  )
+{
+  if ((Cache == NULL) || (Name == NULL) || (Guid == NULL) || (Size == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem(Cache, sizeof(VARSTORE_CACHE));
+  Cache->Name = Name;
+  CopyGuid(&Cache->Guid, Guid);
+  Cache->Attributes = Attributes;
+  Cache->Size = Size;
+  Cache->Buffer = AllocateZeroPool(Size);
+  Cache->Scratch = AllocateZeroPool(Size);
+  if ((Cache->Buffer == NULL) || (Cache->Scratch == NULL)) {
+    VarstoreCacheFree(Cache);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  return VarstoreCacheReload(Cache);
+}
+
+VOID
+VarstoreCacheFree (
+  IN VARSTORE_CACHE  *Cache
+  )
+{
+  if (Cache->Buffer != NULL) {
+    FreePool(Cache->Buffer);
+    Cache->Buffer = NULL;
+  }
+  if (Cache->Scratch != NULL) {
+    FreePool(Cache->Scratch);
+    Cache->Scratch = NULL;
+  }
+}
+
+//
+// Only the caches backed by a UEFI variable save variable services calls
+//
+STATIC
+VOID
+CountHit (
+  IN VARSTORE_CACHE  *Cache
+  )
+{
+  if (Cache->Attributes != 0) {
+    Cache->Stats.Hits++;
+  }
+}
+
+STATIC
+VOID
+CountWriteAvoided (
+  IN VARSTORE_CACHE  *Cache
+  )
+{
+  if (Cache->Attributes != 0) {
+    Cache->Stats.WritesAvoided++;
+  }
+}
+
+EFI_STATUS
+VarstoreCacheRead (
+  IN  VARSTORE_CACHE  *Cache,
+  IN  UINTN           Offset,
+  IN  UINTN           Width,
+  OUT VOID            *Data
+  )
+{
+  if ((Data == NULL) || (Offset > Cache->Size) || (Width > Cache->Size - Offset)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  CopyMem(Data, Cache->Buffer + Offset, Width);
+  CountHit(Cache);
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+MarkDirty (
+  IN VARSTORE_CACHE  *Cache,
+  IN UINTN           Start,
+  IN UINTN           End
+  )
+{
+  if (Cache->DirtyStart == Cache->DirtyEnd) {
+    Cache->DirtyStart = Start;
+    Cache->DirtyEnd = End;
+  } else {
+    Cache->DirtyStart = MIN(Cache->DirtyStart, Start);
+    Cache->DirtyEnd = MAX(Cache->DirtyEnd, End);
+  }
+}
+
+EFI_STATUS
+VarstoreCacheWrite (
+  IN VARSTORE_CACHE  *Cache,
+  IN UINTN           Offset,
+  IN UINTN           Width,
+  IN CONST VOID      *Data
+  )
+{
+  if ((Data == NULL) || (Offset > Cache->Size) || (Width > Cache->Size - Offset)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (CompareMem(Cache->Buffer + Offset, Data, Width) == 0) {
+    CountWriteAvoided(Cache);
+    return EFI_SUCCESS;
+  }
+
+  CopyMem(Cache->Buffer + Offset, Data, Width);
+  MarkDirty(Cache, Offset, Offset + Width);
+  Cache->Stats.Updates++;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+VarstoreCacheFlush (
+  IN VARSTORE_CACHE  *Cache
+  )
+{
+  if (Cache->Attributes == 0) {
+    Cache->DirtyStart = 0;
+    Cache->DirtyEnd = 0;
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Variable that is not present in the NVRAM yet is always written
+  //
+  if ((Cache->DirtyStart == Cache->DirtyEnd) && Cache->Present) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((EFI_D_INFO, "VarstoreCache: flush %s, dirty range [0x%x, 0x%x)\n", Cache->Name, Cache->DirtyStart, Cache->DirtyEnd));
+
+  //
+  // UEFI variable services can't update only a part of the variable data,
+  // so the whole buffer is written, but only if some range of it is dirty.
+  //
+  Cache->Stats.NvWrites++;
+  EFI_STATUS Status = gRT->SetVariable(Cache->Name,
+                                       &Cache->Guid,
+                                       Cache->Attributes,
+                                       Cache->Size,
+                                       Cache->Buffer);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  Cache->Present = TRUE;
+  Cache->DirtyStart = 0;
+  Cache->DirtyEnd = 0;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+VarstoreCacheDelete (
+  IN VARSTORE_CACHE  *Cache
+  )
+{
+  Cache->DirtyStart = 0;
+  Cache->DirtyEnd = 0;
+
+  if ((Cache->Attributes == 0) || !Cache->Present) {
+    return EFI_SUCCESS;
+  }
+
+  Cache->Stats.NvWrites++;
+  EFI_STATUS Status = gRT->SetVariable(Cache->Name,
+                                       &Cache->Guid,
+                                       0,
+                                       0,
+                                       NULL);
+  if (!EFI_ERROR(Status) || (Status == EFI_NOT_FOUND)) {
+    Cache->Present = FALSE;
+    return EFI_SUCCESS;
+  }
+  return Status;
+}
+
+EFI_STATUS
+VarstoreCacheExtractConfig (
+  IN  VARSTORE_CACHE    *Cache,
+  IN  EFI_HANDLE        DriverHandle,
+  IN  CONST EFI_STRING  Request,
+  OUT EFI_STRING        *Progress,
+  OUT EFI_STRING        *Results
+  )
+{
+  BOOLEAN AllocatedRequest = FALSE;
+
+  if (Progress == NULL || Results == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((Request != NULL) && !HiiIsConfigHdrMatch(Request, &Cache->Guid, Cache->Name)) {
+    return EFI_NOT_FOUND;
+  }
+
+  EFI_STRING ConfigRequest = Request;
+  if ((Request == NULL) || (StrStr (Request, L"OFFSET") == NULL)) {
+    EFI_STRING ConfigRequestHdr = HiiConstructConfigHdr(&Cache->Guid, Cache->Name, DriverHandle);
+    if (ConfigRequestHdr == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    UINTN Size = (StrLen(ConfigRequestHdr) + StrLen(L"&OFFSET=0&WIDTH=") + sizeof(UINTN)*2 + 1) * sizeof(CHAR16);
+    ConfigRequest = AllocateZeroPool(Size);
+    if (ConfigRequest == NULL) {
+      FreePool(ConfigRequestHdr);
+      return EFI_OUT_OF_RESOURCES;
+    }
+    AllocatedRequest = TRUE;
+    UnicodeSPrint(ConfigRequest, Size, L"%s&OFFSET=0&WIDTH=%016LX", ConfigRequestHdr, (UINT64)Cache->Size);
+    FreePool(ConfigRequestHdr);
+  }
+
+  CountHit(Cache);
+  EFI_STATUS Status = gHiiConfigRouting->BlockToConfig(gHiiConfigRouting,
+                                                       ConfigRequest,
+                                                       Cache->Buffer,
+                                                       Cache->Size,
+                                                       Results,
+                                                       Progress);
+
+  if (AllocatedRequest) {
+    FreePool(ConfigRequest);
+    if (Request == NULL) {
+      *Progress = NULL;
+    } else if (StrStr(Request, L"OFFSET") == NULL) {
+      *Progress = Request + StrLen(Request);
+    }
+  }
+
+  return Status;
+}
+
+EFI_STATUS
+VarstoreCacheRouteConfig (
+  IN  VARSTORE_CACHE    *Cache,
+  IN  CONST EFI_STRING  Configuration,
+  OUT EFI_STRING        *Progress
+  )
+{
+  if (Configuration == NULL || Progress == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!HiiIsConfigHdrMatch(Configuration, &Cache->Guid, Cache->Name)) {
+    *Progress = Configuration;
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Decode the configuration on top of the current data and find the changed range
+  //
+  CopyMem(Cache->Scratch, Cache->Buffer, Cache->Size);
+  UINTN BlockSize = Cache->Size;
+  EFI_STATUS Status = gHiiConfigRouting->ConfigToBlock(gHiiConfigRouting,
+                                                       Configuration,
+                                                       Cache->Scratch,
+                                                       &BlockSize,
+                                                       Progress);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  UINTN Start = 0;
+  while ((Start < Cache->Size) && (Cache->Scratch[Start] == Cache->Buffer[Start])) {
+    Start++;
+  }
+  if (Start == Cache->Size) {
+    if (!Cache->Present) {
+      // Variable that doesn't exist yet is created even with the unchanged data
+      return VarstoreCacheFlush(Cache);
+    }
+    CountWriteAvoided(Cache);
+    return EFI_SUCCESS;
+  }
+  UINTN End = Cache->Size;
+  while (Cache->Scratch[End - 1] == Cache->Buffer[End - 1]) {
+    End--;
+  }
+
+  CopyMem(Cache->Buffer + Start, Cache->Scratch + Start, End - Start);
+  MarkDirty(Cache, Start, End);
+  Cache->Stats.Updates++;
+
+  return VarstoreCacheFlush(Cache);
+}
+
+VOID
+VarstoreCachePrintStats (
+  IN VARSTORE_CACHE  *Cache
+  )
+{
+  UINTN Requests = Cache->Stats.Hits + Cache->Stats.Misses;
+  Print(L"%s: hits=%d, misses=%d (hit rate %d%%), updates=%d, NV writes=%d, NV writes avoided=%d\n",
+        Cache->Name,
+        Cache->Stats.Hits,
+        Cache->Stats.Misses,
+        (Requests != 0) ? (Cache->Stats.Hits * 100 / Requests) : 0,
+        Cache->Stats.Updates,
+        Cache->Stats.NvWrites,
+        Cache->Stats.WritesAvoided);
+}
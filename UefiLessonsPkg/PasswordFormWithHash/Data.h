@@ -8,12 +8,26 @@
 #define PASSWORD_MIN_LEN       6
 #define PASSWORD_MAX_LEN       8
 #define HASHED_PASSWORD_SIZE   64
+#define SALT_SIZE              16
+
+#define KDF_LEGACY_SHA512       0   // Single unsalted SHA-512, hashes from the older driver versions
+#define KDF_PBKDF2_SHA256       1
+#define KDF_PBKDF2_SHA512       2
+
+#define KDF_MIN_ITERATIONS      1000
+#define KDF_MAX_ITERATIONS      10000000
+#define KDF_DEFAULT_ITERATIONS  10000
 
 #define KEY_PASSWORD 0x1234
 
 #pragma pack(1)
 typedef struct {
-  UINT8 Password[HASHED_PASSWORD_SIZE];
+  UINT8  Password[HASHED_PASSWORD_SIZE];
+  UINT8  KdfAlgorithm;                  // KDF for the next password change
+  UINT32 KdfIterations;
+  UINT8  HashAlgorithm;                 // KDF of the current Password hash
+  UINT32 HashIterations;
+  UINT8  Salt[SALT_SIZE];
 } VARIABLE_STRUCTURE;
 #pragma pack()
 
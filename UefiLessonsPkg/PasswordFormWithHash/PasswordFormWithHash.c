@@ -4,7 +4,10 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/BenchmarkLib.h>
+#include <Library/DebugLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/HiiLib.h>
 #include <Library/MemoryAllocationLib.h>
@@ -15,7 +18,9 @@
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Protocol/HiiConfigAccess.h>
 #include <Protocol/Hash2.h>
+#include <Protocol/Rng.h>
 #include <Protocol/ServiceBinding.h>
+#include <Protocol/ShellParameters.h>
 #include "Data.h"
 
 extern UINT8 FormBin[];
@@ -135,19 +140,199 @@ RouteConfig (
 
 BOOLEAN OldPasswordVerified = FALSE;
 
-EFI_STATUS ComputeStringHash(EFI_STRING Password, UINT8* HashedPassword)
+typedef struct {
+  EFI_GUID HashGuid;
+  UINTN    DigestSize;
+  UINTN    BlockSize;
+} KDF_HASH;
+
+#define KDF_MAX_DIGEST_SIZE  64
+#define KDF_MAX_BLOCK_SIZE   128
+
+STATIC CONST KDF_HASH mKdfHash[] = {
+  [KDF_LEGACY_SHA512] = { EFI_HASH_ALGORITHM_SHA512_GUID, 64, 128 },
+  [KDF_PBKDF2_SHA256] = { EFI_HASH_ALGORITHM_SHA256_GUID, 32, 64  },
+  [KDF_PBKDF2_SHA512] = { EFI_HASH_ALGORITHM_SHA512_GUID, 64, 128 },
+};
+
+typedef struct {
+  CONST KDF_HASH* Hash;
+  UINT8 InnerPad[KDF_MAX_BLOCK_SIZE];
+  UINT8 OuterPad[KDF_MAX_BLOCK_SIZE];
+} HMAC_CONTEXT;
+
+EFI_STATUS HashData(CONST KDF_HASH* Hash, CONST UINT8* Data1, UINTN Size1, CONST UINT8* Data2, UINTN Size2, UINT8* Digest)
 {
-  EFI_GUID HashGuid = EFI_HASH_ALGORITHM_SHA512_GUID;
-  EFI_HASH2_OUTPUT Hash;
-  EFI_STATUS Status = hash2Protocol->Hash(hash2Protocol,
-                                          &HashGuid,
-                                          (UINT8*)Password,
-                                          StrLen(Password)*sizeof(CHAR16),
-                                          &Hash);
+  EFI_HASH2_OUTPUT Output;
+  EFI_STATUS Status = hash2Protocol->HashInit(hash2Protocol, &Hash->HashGuid);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+  Status = hash2Protocol->HashUpdate(hash2Protocol, Data1, Size1);
+  if (!EFI_ERROR(Status) && (Size2 != 0)) {
+    Status = hash2Protocol->HashUpdate(hash2Protocol, Data2, Size2);
+  }
+  // HashFinal() ends the sequence even after an error, otherwise the next HashInit() would fail
+  EFI_STATUS FinalStatus = hash2Protocol->HashFinal(hash2Protocol, &Output);
   if (EFI_ERROR(Status)) {
     return Status;
   }
-  CopyMem(HashedPassword, Hash.Sha512Hash, HASHED_PASSWORD_SIZE);
+  if (EFI_ERROR(FinalStatus)) {
+    return FinalStatus;
+  }
+  CopyMem(Digest, &Output, Hash->DigestSize);
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS HmacInit(HMAC_CONTEXT* Context, CONST KDF_HASH* Hash, CONST UINT8* Key, UINTN KeySize)
+{
+  Context->Hash = Hash;
+  ZeroMem(Context->InnerPad, sizeof(Context->InnerPad));
+  if (KeySize > Hash->BlockSize) {
+    EFI_STATUS Status = HashData(Hash, Key, KeySize, NULL, 0, Context->InnerPad);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  } else {
+    CopyMem(Context->InnerPad, Key, KeySize);
+  }
+  for (UINTN i = 0; i < Hash->BlockSize; i++) {
+    Context->OuterPad[i] = Context->InnerPad[i] ^ 0x5c;
+    Context->InnerPad[i] ^= 0x36;
+  }
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS Hmac(HMAC_CONTEXT* Context, CONST UINT8* Data, UINTN Size, UINT8* Digest)
+{
+  UINT8 Inner[KDF_MAX_DIGEST_SIZE];
+  EFI_STATUS Status = HashData(Context->Hash, Context->InnerPad, Context->Hash->BlockSize, Data, Size, Inner);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+  return HashData(Context->Hash, Context->OuterPad, Context->Hash->BlockSize, Inner, Context->Hash->DigestSize, Digest);
+}
+
+//
+// PBKDF2 from RFC 8018 with HMAC-SHA256/HMAC-SHA512 as PRF
+//
+EFI_STATUS Pbkdf2(CONST KDF_HASH* Hash, CONST UINT8* Password, UINTN PasswordSize, CONST UINT8* Salt, UINT32 Iterations, UINT8* Output, UINTN OutputSize)
+{
+  HMAC_CONTEXT Context;
+  EFI_STATUS Status = HmacInit(&Context, Hash, Password, PasswordSize);
+  UINT8 U[KDF_MAX_DIGEST_SIZE];
+  UINT8 T[KDF_MAX_DIGEST_SIZE];
+  for (UINT32 Block = 1; !EFI_ERROR(Status) && (OutputSize != 0); Block++) {
+    // U1 = PRF(Password, Salt || INT_32_BE(Block))
+    UINT8 SaltBlock[SALT_SIZE + sizeof(UINT32)];
+    CopyMem(SaltBlock, Salt, SALT_SIZE);
+    WriteUnaligned32((UINT32*)&SaltBlock[SALT_SIZE], SwapBytes32(Block));
+    Status = Hmac(&Context, SaltBlock, sizeof(SaltBlock), U);
+    CopyMem(T, U, Hash->DigestSize);
+    for (UINT32 i = 1; (i < Iterations) && !EFI_ERROR(Status); i++) {
+      Status = Hmac(&Context, U, Hash->DigestSize, U);
+      for (UINTN j = 0; j < Hash->DigestSize; j++) {
+        T[j] ^= U[j];
+      }
+    }
+    UINTN Size = MIN(OutputSize, Hash->DigestSize);
+    CopyMem(Output, T, Size);
+    Output += Size;
+    OutputSize -= Size;
+  }
+  ZeroMem(&Context, sizeof(Context));
+  ZeroMem(U, sizeof(U));
+  ZeroMem(T, sizeof(T));
+  return Status;
+}
+
+EFI_STATUS ComputeStringHash(EFI_STRING Password, UINT8 Algorithm, UINT32 Iterations, CONST UINT8* Salt, UINT8* HashedPassword)
+{
+  if (Algorithm >= ARRAY_SIZE(mKdfHash)) {
+    return EFI_UNSUPPORTED;
+  }
+  if (Algorithm == KDF_LEGACY_SHA512) {
+    return HashData(&mKdfHash[Algorithm], (UINT8*)Password, StrLen(Password)*sizeof(CHAR16), NULL, 0, HashedPassword);
+  }
+  if (Iterations == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+  return Pbkdf2(&mKdfHash[Algorithm],
+                (UINT8*)Password,
+                StrLen(Password)*sizeof(CHAR16),
+                Salt,
+                Iterations,
+                HashedPassword,
+                HASHED_PASSWORD_SIZE);
+}
+
+//
+// Salt only has to be unique for every password. Without EFI_RNG_PROTOCOL it is the start of
+// the SHA-512 digest of the current time, the monotonic count and the timer ticks: this is
+// unique, but predictable, the form shows which source is used.
+//
+typedef struct {
+  EFI_TIME  Time;
+  UINT64    MonotonicCount;
+  UINT64    Ticks;
+} SALT_SEED;
+
+EFI_STATUS GenerateSalt(UINT8* Salt)
+{
+  EFI_RNG_PROTOCOL* Rng;
+  EFI_STATUS Status = gBS->LocateProtocol(&gEfiRngProtocolGuid, NULL, (VOID**)&Rng);
+  if (!EFI_ERROR(Status)) {
+    Status = Rng->GetRNG(Rng, NULL, SALT_SIZE, Salt);
+    if (!EFI_ERROR(Status)) {
+      return EFI_SUCCESS;
+    }
+    DEBUG((EFI_D_ERROR, "Can't get random salt: %r, time based salt is used\n", Status));
+  }
+
+  SALT_SEED Seed;
+  ZeroMem(&Seed, sizeof(Seed));
+  gRT->GetTime(&Seed.Time, NULL);
+  gBS->GetNextMonotonicCount(&Seed.MonotonicCount);
+  Seed.Ticks = BenchmarkGetTicks();
+  UINT8 Digest[KDF_MAX_DIGEST_SIZE];
+  Status = HashData(&mKdfHash[KDF_PBKDF2_SHA512], (UINT8*)&Seed, sizeof(Seed), NULL, 0, Digest);
+  if (EFI_ERROR(Status)) {
+    DEBUG((EFI_D_ERROR, "Can't generate password salt: %r\n", Status));
+    return Status;
+  }
+  CopyMem(Salt, Digest, SALT_SIZE);
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS SetPassword(EFI_STRING Password)
+{
+  // Take the KDF settings from the browser, they can be changed on the form and not saved yet
+  VARIABLE_STRUCTURE BrowserData;
+  if (!HiiGetBrowserData(&StorageGuid, StorageName, sizeof(BrowserData), (UINT8*)&BrowserData)) {
+    CopyMem(&BrowserData, &FormStorage, sizeof(BrowserData));
+  }
+
+  // The storage can come from a configuration that was never set on the form
+  BrowserData.KdfIterations = MIN(MAX(BrowserData.KdfIterations, KDF_MIN_ITERATIONS), KDF_MAX_ITERATIONS);
+
+  UINT8 Salt[SALT_SIZE];
+  ZeroMem(Salt, sizeof(Salt));
+  if (BrowserData.KdfAlgorithm != KDF_LEGACY_SHA512) {
+    EFI_STATUS Status = GenerateSalt(Salt);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+
+  UINT8 Hash[HASHED_PASSWORD_SIZE];
+  EFI_STATUS Status = ComputeStringHash(Password, BrowserData.KdfAlgorithm, BrowserData.KdfIterations, Salt, Hash);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+  CopyMem(FormStorage.Password, Hash, HASHED_PASSWORD_SIZE);
+  CopyMem(FormStorage.Salt, Salt, SALT_SIZE);
+  FormStorage.HashAlgorithm = BrowserData.KdfAlgorithm;
+  FormStorage.HashIterations = BrowserData.KdfIterations;
   return EFI_SUCCESS;
 }
 
@@ -168,17 +353,20 @@ EFI_STATUS HandlePasswordInput(EFI_STRING Password)
 
     if (FormStorage.Password[0] == 0) {
       // Set initial password
-      ComputeStringHash(Password, FormStorage.Password);
-      if (EFI_ERROR(Status)) {
-        return Status;
-      }
-      return EFI_SUCCESS;
+      return SetPassword(Password);
     }
 
     if (!OldPasswordVerified) {
-      // Check old password
+      // Check old password with the parameters of the stored hash
       UINT8 TempHash[HASHED_PASSWORD_SIZE];
-      ComputeStringHash(Password, TempHash);
+      Status = ComputeStringHash(Password,
+                                 FormStorage.HashAlgorithm,
+                                 FormStorage.HashIterations,
+                                 FormStorage.Salt,
+                                 TempHash);
+      if (EFI_ERROR(Status)) {
+        return Status;
+      }
       if (CompareMem(TempHash, FormStorage.Password, HASHED_PASSWORD_SIZE))
         return EFI_NOT_READY;
 
@@ -187,7 +375,7 @@ EFI_STATUS HandlePasswordInput(EFI_STRING Password)
     }
 
     // Update password
-    Status = ComputeStringHash(Password, FormStorage.Password);
+    Status = SetPassword(Password);
     if (EFI_ERROR(Status)) {
       return Status;
     }
@@ -196,6 +384,48 @@ EFI_STATUS HandlePasswordInput(EFI_STRING Password)
   }
 }
 
+//
+// Measure the KDF speed to choose the iteration count for the password check time budget
+//
+#define BENCHMARK_ITERATIONS  1000
+
+VOID BenchmarkKdf(UINT64 BudgetMs)
+{
+  STATIC CONST UINT8 Algorithms[] = { KDF_PBKDF2_SHA256, KDF_PBKDF2_SHA512 };
+  STATIC CONST CHAR16* Names[] = { L"PBKDF2-HMAC-SHA256", L"PBKDF2-HMAC-SHA512" };
+  UINT8 Salt[SALT_SIZE];
+  UINT8 Hash[HASHED_PASSWORD_SIZE];
+  SetMem(Salt, sizeof(Salt), 0xA5);
+
+  UINT64 Start = BenchmarkGetTicks();
+  for (UINTN i = 0; i < BENCHMARK_ITERATIONS; i++) {
+    ComputeStringHash(L"Password", KDF_LEGACY_SHA512, 0, Salt, Hash);
+  }
+  UINT64 Ns = MAX(BenchmarkTicksToNs(BenchmarkGetTicks() - Start), 1);
+  Print(L"SHA-512 (legacy): %ld hashes/s\n", DivU64x64Remainder(BENCHMARK_ITERATIONS * 1000000000ULL, Ns, NULL));
+
+  Print(L"Algorithm            Hashes/s   Iterations/s   Iterations for %ld ms\n", BudgetMs);
+  for (UINTN i = 0; i < ARRAY_SIZE(Algorithms); i++) {
+    Start = BenchmarkGetTicks();
+    EFI_STATUS Status = ComputeStringHash(L"Password", Algorithms[i], BENCHMARK_ITERATIONS, Salt, Hash);
+    Ns = MAX(BenchmarkTicksToNs(BenchmarkGetTicks() - Start), 1);
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! %s failed: %r\n", Names[i], Status);
+      continue;
+    }
+    // Every iteration is one HMAC (two hashes) for every digest block of the output
+    CONST KDF_HASH* KdfHash = &mKdfHash[Algorithms[i]];
+    UINT64 Hashes = BENCHMARK_ITERATIONS * 2 * ((HASHED_PASSWORD_SIZE + KdfHash->DigestSize - 1) / KdfHash->DigestSize);
+    UINT64 IterationsPerSecond = DivU64x64Remainder(BENCHMARK_ITERATIONS * 1000000000ULL, Ns, NULL);
+    UINT64 Iterations = DivU64x64Remainder(MultU64x64(BudgetMs * 1000000ULL, BENCHMARK_ITERATIONS), Ns, NULL);
+    Print(L"%-18s %10ld   %12ld   %ld\n",
+          Names[i],
+          DivU64x64Remainder(MultU64x64(Hashes, 1000000000ULL), Ns, NULL),
+          IterationsPerSecond,
+          MIN(MAX(Iterations, KDF_MIN_ITERATIONS), KDF_MAX_ITERATIONS));
+  }
+}
+
 STATIC
 EFI_STATUS
 EFIAPI
@@ -279,6 +509,24 @@ PasswordFormWithHashEntryPoint (
     return Status;
   }
 
+  // 'PasswordFormWithHash.efi -t [<ms>]' from the shell measures the KDF speed
+  EFI_SHELL_PARAMETERS_PROTOCOL* ShellParameters;
+  if (!EFI_ERROR(gBS->HandleProtocol(ImageHandle, &gEfiShellParametersProtocolGuid, (VOID **) &ShellParameters))) {
+    for (UINTN i = 1; i < ShellParameters->Argc; i++) {
+      if (!StrCmp(ShellParameters->Argv[i], L"-t")) {
+        UINT64 BudgetMs = 250;
+        if ((i + 1) < ShellParameters->Argc) {
+          BudgetMs = StrDecimalToUintn(ShellParameters->Argv[++i]);
+        }
+        BenchmarkKdf(BudgetMs);
+      }
+    }
+  }
+
+  // Same values as the form defaults
+  FormStorage.KdfAlgorithm = KDF_PBKDF2_SHA512;
+  FormStorage.KdfIterations = KDF_DEFAULT_ITERATIONS;
+
   mConfigAccess.ExtractConfig = &ExtractConfig;
   mConfigAccess.RouteConfig   = &RouteConfig;
   mConfigAccess.Callback      = &Callback;
@@ -319,5 +567,15 @@ PasswordFormWithHashEntryPoint (
     Print(L"Error! Can't set default configuration #%d\n", DefaultId);
   }
 
+  // Without EFI_RNG_PROTOCOL the password salt is predictable, show it on the form
+  VOID* Rng;
+  if (EFI_ERROR(gBS->LocateProtocol(&gEfiRngProtocolGuid, NULL, &Rng))) {
+    EFI_STRING SaltSource = HiiGetString(mHiiHandle, STRING_TOKEN(SALT_SOURCE_TIME), NULL);
+    if (SaltSource != NULL) {
+      HiiSetString(mHiiHandle, STRING_TOKEN(SALT_SOURCE), SaltSource, NULL);
+      FreePool(SaltSource);
+    }
+  }
+
   return EFI_SUCCESS;
 }
@@ -0,0 +1,543 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BenchmarkLib.h>
+
+#include <Protocol/SimpleClass.h>
+
+#define DEFAULT_CALLS   1000000
+#define DEFAULT_ROUNDS  10
+
+//
+// Private GUID for the install test, so the protocol notifications of
+// gSimpleClassProtocolGuid (e.g. ProtocolEventDriver) don't fire in the loop
+//
+STATIC EFI_GUID mBenchmarkProtocolGuid = { 0x5b0d2b7e, 0x8f43, 0x4d6a, { 0x91, 0x2c, 0x3e, 0x76, 0xa0, 0x1f, 0xd4, 0x58 } };
+
+typedef enum {
+  TestEmptyLoop,
+  TestCachedGetNumber,
+  TestCachedSetNumber,
+  TestLocateProtocol,
+  TestHandleProtocol,
+  TestOpenProtocol,
+  TestInstallProtocol,
+  TestMax
+} BENCHMARK_TEST;
+
+STATIC CONST CHAR16* mTestNames[TestMax] = {
+  L"Empty loop",
+  L"Cached GetNumber",
+  L"Cached SetNumber",
+  L"LocateProtocol+Get",
+  L"HandleProtocol+Get",
+  L"OpenProtocol+Get",
+  L"Install+Uninstall"
+};
+
+typedef struct {
+  UINT64  MinNs100;     // ns per call * 100
+  UINT64  MaxNs100;
+  UINT64  TotalNs;
+} TEST_RESULT;
+
+//
+// Local SimpleClass instance, used when the SimpleClassProtocol driver is not loaded
+//
+STATIC UINTN mLocalNumber = 0;
+
+STATIC
+EFI_STATUS
+EFIAPI
+LocalGetNumber (
+  UINTN* Number
+  )
+{
+  if (Number == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  *Number = mLocalNumber;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+LocalSetNumber (
+  UINTN Number
+  )
+{
+  mLocalNumber = Number;
+  return EFI_SUCCESS;
+}
+
+STATIC SIMPLE_CLASS_PROTOCOL mLocalSimpleClass = {
+  LocalGetNumber,
+  LocalSetNumber
+};
+
+//
+// Every test has its own loop, so the test selection is not a part of the measured time
+//
+STATIC
+EFI_STATUS
+RunRound (
+  IN  BENCHMARK_TEST         Test,
+  IN  EFI_HANDLE             Handle,
+  IN  SIMPLE_CLASS_PROTOCOL  *Cached,
+  IN  UINTN                  Calls,
+  OUT UINT64                 *Ticks
+  )
+{
+  EFI_STATUS             Status = EFI_SUCCESS;
+  SIMPLE_CLASS_PROTOCOL  *SimpleClass;
+  EFI_HANDLE             NewHandle;
+  UINTN                  Number;
+  volatile UINTN         Counter = 0;
+  UINTN                  i;
+
+  UINT64 Start = BenchmarkGetTicks();
+  switch (Test) {
+  case TestEmptyLoop:
+    for (i = 0; i < Calls; i++) {
+      Counter++;
+    }
+    break;
+  case TestCachedGetNumber:
+    for (i = 0; (i < Calls) && !EFI_ERROR(Status); i++) {
+      Status = Cached->GetNumber(&Number);
+    }
+    break;
+  case TestCachedSetNumber:
+    for (i = 0; (i < Calls) && !EFI_ERROR(Status); i++) {
+      Status = Cached->SetNumber(i);
+    }
+    break;
+  case TestLocateProtocol:
+    for (i = 0; (i < Calls) && !EFI_ERROR(Status); i++) {
+      Status = gBS->LocateProtocol(&gSimpleClassProtocolGuid, NULL, (VOID**)&SimpleClass);
+      if (!EFI_ERROR(Status)) {
+        Status = SimpleClass->GetNumber(&Number);
+      }
+    }
+    break;
+  case TestHandleProtocol:
+    for (i = 0; (i < Calls) && !EFI_ERROR(Status); i++) {
+      Status = gBS->HandleProtocol(Handle, &gSimpleClassProtocolGuid, (VOID**)&SimpleClass);
+      if (!EFI_ERROR(Status)) {
+        Status = SimpleClass->GetNumber(&Number);
+      }
+    }
+    break;
+  case TestOpenProtocol:
+    // Repeated GET_PROTOCOL opens with the same agent reuse one open entry, so the list doesn't grow
+    for (i = 0; (i < Calls) && !EFI_ERROR(Status); i++) {
+      Status = gBS->OpenProtocol(
+        Handle,
+        &gSimpleClassProtocolGuid,
+        (VOID**)&SimpleClass,
+        gImageHandle,
+        NULL,
+        EFI_OPEN_PROTOCOL_GET_PROTOCOL
+      );
+      if (!EFI_ERROR(Status)) {
+        Status = SimpleClass->GetNumber(&Number);
+      }
+    }
+    break;
+  case TestInstallProtocol:
+    for (i = 0; (i < Calls) && !EFI_ERROR(Status); i++) {
+      NewHandle = NULL;
+      Status = gBS->InstallMultipleProtocolInterfaces(
+        &NewHandle,
+        &mBenchmarkProtocolGuid,
+        &mLocalSimpleClass,
+        NULL
+      );
+      if (!EFI_ERROR(Status)) {
+        Status = gBS->UninstallMultipleProtocolInterfaces(
+          NewHandle,
+          &mBenchmarkProtocolGuid,
+          &mLocalSimpleClass,
+          NULL
+        );
+      }
+    }
+    break;
+  default:
+    Status = EFI_UNSUPPORTED;
+    break;
+  }
+  *Ticks = BenchmarkGetTicks() - Start;
+  return Status;
+}
+
+//
+// The calls are split in rounds, min/max are taken over the per-call time of the rounds.
+// Min is the most stable value, max shows the rounds that were hit by the timer interrupt.
+//
+STATIC
+EFI_STATUS
+RunTest (
+  IN  BENCHMARK_TEST         Test,
+  IN  EFI_HANDLE             Handle,
+  IN  SIMPLE_CLASS_PROTOCOL  *Cached,
+  IN  UINTN                  Calls,
+  IN  UINTN                  Rounds,
+  OUT TEST_RESULT            *Result
+  )
+{
+  UINTN CallsPerRound = Calls / Rounds;
+  UINT64 Ticks;
+
+  Result->MinNs100 = MAX_UINT64;
+  Result->MaxNs100 = 0;
+  Result->TotalNs = 0;
+
+  // The cached instance can belong to the real driver, SetNumber() test must not change its number
+  UINTN SavedNumber = 0;
+  EFI_STATUS Status = EFI_SUCCESS;
+  if (Test == TestCachedSetNumber) {
+    Status = Cached->GetNumber(&SavedNumber);
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+
+  for (UINTN Round = 0; Round < Rounds; Round++) {
+    Status = RunRound(Test, Handle, Cached, CallsPerRound, &Ticks);
+    if (EFI_ERROR(Status)) {
+      break;
+    }
+    UINT64 Ns = BenchmarkTicksToNs(Ticks);
+    UINT64 Ns100 = DivU64x64Remainder(MultU64x32(Ns, 100), CallsPerRound, NULL);
+    Result->MinNs100 = MIN(Result->MinNs100, Ns100);
+    Result->MaxNs100 = MAX(Result->MaxNs100, Ns100);
+    Result->TotalNs += Ns;
+  }
+
+  if (Test == TestCachedSetNumber) {
+    EFI_STATUS RestoreStatus = Cached->SetNumber(SavedNumber);
+    if (!EFI_ERROR(Status)) {
+      Status = RestoreStatus;
+    }
+  }
+  return Status;
+}
+
+//
+// Notify mode: install a burst of SimpleClass instances and measure the time from the
+// install call to the moment ProtocolEventDriver handles the instance.
+// The protocol functions don't get the instance pointer, so the instances share one
+// interface and SetNumber() timestamps the calls in order. ProtocolEventDriver handles
+// the new handles in the install order, so the n-th SetNumber() call is the n-th instance.
+//
+STATIC UINT64 *mHandledTicks = NULL;
+STATIC UINTN  mHandledCount = 0;
+STATIC UINTN  mHandledMax = 0;
+
+STATIC
+EFI_STATUS
+EFIAPI
+NotifyGetNumber (
+  UINTN* Number
+  )
+{
+  if (Number == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+  *Number = 0;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+NotifySetNumber (
+  UINTN Number
+  )
+{
+  if (mHandledCount < mHandledMax) {
+    mHandledTicks[mHandledCount++] = BenchmarkGetTicks();
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC SIMPLE_CLASS_PROTOCOL mNotifySimpleClass = {
+  NotifyGetNumber,
+  NotifySetNumber
+};
+
+typedef struct {
+  UINTN   Installed;
+  UINTN   Handled;
+  UINT64  TotalNs;
+  UINT64  MinNs;
+  UINT64  MaxNs;
+  UINT64  AvgNs;
+} NOTIFY_RESULT;
+
+//
+// One by one: every install returns to TPL_APPLICATION, so the TPL_NOTIFY notification
+// runs inside each install call and gets a single new handle.
+// Burst: all instances are installed at TPL_NOTIFY, so the notification is signaled
+// once and runs on RestoreTPL() with all the handles pending.
+//
+STATIC
+EFI_STATUS
+RunNotifyBurst (
+  IN  BOOLEAN        Burst,
+  IN  UINTN          Instances,
+  IN  EFI_HANDLE     *Handles,
+  IN  UINT64         *InstallTicks,
+  OUT NOTIFY_RESULT  *Result
+  )
+{
+  EFI_STATUS Status = EFI_SUCCESS;
+  EFI_TPL OldTpl = TPL_APPLICATION;
+  UINTN i;
+
+  mHandledCount = 0;
+  mHandledMax = Instances;
+
+  UINT64 Start = BenchmarkGetTicks();
+  if (Burst) {
+    OldTpl = gBS->RaiseTPL(TPL_NOTIFY);
+  }
+  for (i = 0; i < Instances; i++) {
+    Handles[i] = NULL;
+    InstallTicks[i] = BenchmarkGetTicks();
+    Status = gBS->InstallMultipleProtocolInterfaces(
+      &Handles[i],
+      &gSimpleClassProtocolGuid,
+      &mNotifySimpleClass,
+      NULL
+    );
+    if (EFI_ERROR(Status)) {
+      break;
+    }
+  }
+  if (Burst) {
+    gBS->RestoreTPL(OldTpl);
+  }
+  UINT64 End = BenchmarkGetTicks();
+
+  Result->Installed = i;
+  Result->Handled = mHandledCount;
+  Result->TotalNs = BenchmarkTicksToNs(End - Start);
+  Result->MinNs = 0;
+  Result->MaxNs = 0;
+  Result->AvgNs = 0;
+
+  UINT64 TotalTicks = 0;
+  UINT64 MinTicks = MAX_UINT64;
+  UINT64 MaxTicks = 0;
+  UINTN Count = MIN(Result->Installed, Result->Handled);
+  for (i = 0; i < Count; i++) {
+    UINT64 Ticks = mHandledTicks[i] - InstallTicks[i];
+    MinTicks = MIN(MinTicks, Ticks);
+    MaxTicks = MAX(MaxTicks, Ticks);
+    TotalTicks += Ticks;
+  }
+  if (Count != 0) {
+    Result->MinNs = BenchmarkTicksToNs(MinTicks);
+    Result->MaxNs = BenchmarkTicksToNs(MaxTicks);
+    Result->AvgNs = DivU64x64Remainder(BenchmarkTicksToNs(TotalTicks), Count, NULL);
+  }
+
+  for (i = 0; i < Result->Installed; i++) {
+    gBS->UninstallMultipleProtocolInterfaces(
+      Handles[i],
+      &gSimpleClassProtocolGuid,
+      &mNotifySimpleClass,
+      NULL
+    );
+  }
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+NotifyBenchmark (
+  IN UINTN  Instances
+  )
+{
+  EFI_STATUS Status = EFI_OUT_OF_RESOURCES;
+  EFI_HANDLE* Handles = AllocatePool(Instances * sizeof(EFI_HANDLE));
+  UINT64* InstallTicks = AllocatePool(Instances * sizeof(UINT64));
+  mHandledTicks = AllocatePool(Instances * sizeof(UINT64));
+  if ((Handles == NULL) || (InstallTicks == NULL) || (mHandledTicks == NULL)) {
+    goto Exit;
+  }
+
+  CONST CHAR16* BurstNames[] = {
+    L"One by one",
+    L"Burst"
+  };
+  NOTIFY_RESULT Results[2];
+  for (UINTN Burst = 0; Burst < 2; Burst++) {
+    Status = RunNotifyBurst((BOOLEAN)Burst, Instances, Handles, InstallTicks, &Results[Burst]);
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! Can't install SimpleClass protocol: %r\n", Status);
+      goto Exit;
+    }
+  }
+
+  Print(L"\nInstall to ProtocolEventDriver notification latency, %d instances\n\n", Instances);
+  Print(L"%-12s %9s %9s %12s %12s %12s %12s\n", L"Install", L"Installed", L"Handled", L"Total ns", L"Min ns", L"Avg ns", L"Max ns");
+  for (UINTN Burst = 0; Burst < 2; Burst++) {
+    Print(L"%-12s %9d %9d %12ld %12ld %12ld %12ld\n",
+          BurstNames[Burst],
+          Results[Burst].Installed,
+          Results[Burst].Handled,
+          Results[Burst].TotalNs,
+          Results[Burst].MinNs,
+          Results[Burst].AvgNs,
+          Results[Burst].MaxNs);
+  }
+  if (Results[0].Handled == 0) {
+    Print(L"No instances were handled, is ProtocolEventDriver loaded?\n");
+  }
+
+Exit:
+  if (Handles != NULL) {
+    FreePool(Handles);
+  }
+  if (InstallTicks != NULL) {
+    FreePool(InstallTicks);
+  }
+  if (mHandledTicks != NULL) {
+    FreePool(mHandledTicks);
+    mHandledTicks = NULL;
+  }
+  return Status;
+}
+
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"  ProtocolBenchmark [-n <calls>] [-r <rounds>]\n");
+  Print(L"  ProtocolBenchmark -p <instances>\n");
+  Print(L"    -n <calls>      calls for every test (default %d)\n", DEFAULT_CALLS);
+  Print(L"    -r <rounds>     rounds the calls are split in (default %d)\n", DEFAULT_ROUNDS);
+  Print(L"    -p <instances>  measure the ProtocolEventDriver notification latency\n");
+  Print(L"                    for a burst of SimpleClass protocol installs\n");
+}
+
+INTN EFIAPI ShellAppMain(IN UINTN Argc, IN CHAR16 **Argv)
+{
+  UINTN Calls = DEFAULT_CALLS;
+  UINTN Rounds = DEFAULT_ROUNDS;
+  UINTN Instances = 0;
+  for (UINTN i = 1; i < Argc; i++) {
+    if (!StrCmp(Argv[i], L"-n") && ((i + 1) < Argc)) {
+      Calls = StrDecimalToUintn(Argv[++i]);
+    } else if (!StrCmp(Argv[i], L"-r") && ((i + 1) < Argc)) {
+      Rounds = StrDecimalToUintn(Argv[++i]);
+    } else if (!StrCmp(Argv[i], L"-p") && ((i + 1) < Argc)) {
+      Instances = StrDecimalToUintn(Argv[++i]);
+      if (Instances == 0) {
+        Usage();
+        return EFI_INVALID_PARAMETER;
+      }
+    } else {
+      Usage();
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+  if ((Rounds == 0) || (Calls < Rounds)) {
+    Usage();
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Instances != 0) {
+    return NotifyBenchmark(Instances);
+  }
+
+  // Use the instance of the SimpleClassProtocol driver, or install the local one
+  EFI_HANDLE LocalHandle = NULL;
+  EFI_HANDLE* HandleBuffer;
+  UINTN HandleCount;
+  EFI_STATUS Status = gBS->LocateHandleBuffer(
+    ByProtocol,
+    &gSimpleClassProtocolGuid,
+    NULL,
+    &HandleCount,
+    &HandleBuffer
+  );
+  if (EFI_ERROR(Status)) {
+    Print(L"SimpleClassProtocol driver is not loaded, using the local instance\n");
+    Status = gBS->InstallMultipleProtocolInterfaces(
+      &LocalHandle,
+      &gSimpleClassProtocolGuid,
+      &mLocalSimpleClass,
+      NULL
+    );
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! Can't install SimpleClass protocol: %r\n", Status);
+      return Status;
+    }
+    Status = gBS->LocateHandleBuffer(ByProtocol, &gSimpleClassProtocolGuid, NULL, &HandleCount, &HandleBuffer);
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! Can't find any handle with gSimpleClassProtocolGuid: %r\n", Status);
+      gBS->UninstallMultipleProtocolInterfaces(LocalHandle, &gSimpleClassProtocolGuid, &mLocalSimpleClass, NULL);
+      return Status;
+    }
+  }
+  EFI_HANDLE Handle = HandleBuffer[0];
+  FreePool(HandleBuffer);
+
+  // The pointer that the drivers would cache
+  SIMPLE_CLASS_PROTOCOL* Cached;
+  Status = gBS->HandleProtocol(Handle, &gSimpleClassProtocolGuid, (VOID**)&Cached);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't get SimpleClass protocol: %r\n", Status);
+  } else {
+    TEST_RESULT Results[TestMax];
+    BOOLEAN Done[TestMax];
+    UINTN CallsDone = (Calls / Rounds) * Rounds;
+    for (UINTN Test = 0; Test < TestMax; Test++) {
+      Status = RunTest((BENCHMARK_TEST)Test, Handle, Cached, Calls, Rounds, &Results[Test]);
+      Done[Test] = !EFI_ERROR(Status);
+      if (EFI_ERROR(Status)) {
+        Print(L"Error! %s test failed: %r\n", mTestNames[Test], Status);
+      }
+    }
+
+    Print(L"ns per call, %d calls in %d rounds, TSC %ld Hz\n\n", CallsDone, Rounds, BenchmarkGetFrequency());
+    Print(L"%-20s %10s %10s %10s %10s\n", L"Test", L"Min", L"Avg", L"Max", L"x cached");
+    // Average is taken over all calls, "x cached" compares it with the cached GetNumber call
+    UINT64 CachedAvg100 = Done[TestCachedGetNumber] ? DivU64x64Remainder(MultU64x32(Results[TestCachedGetNumber].TotalNs, 100), CallsDone, NULL) : 0;
+    for (UINTN Test = 0; Test < TestMax; Test++) {
+      if (!Done[Test]) {
+        Print(L"%-20s %10s %10s %10s %10s\n", mTestNames[Test], L"-", L"-", L"-", L"-");
+        continue;
+      }
+      UINT64 Avg100 = DivU64x64Remainder(MultU64x32(Results[Test].TotalNs, 100), CallsDone, NULL);
+      Print(L"%-20s %7ld.%02ld %7ld.%02ld %7ld.%02ld",
+            mTestNames[Test],
+            DivU64x32(Results[Test].MinNs100, 100), ModU64x32(Results[Test].MinNs100, 100),
+            DivU64x32(Avg100, 100), ModU64x32(Avg100, 100),
+            DivU64x32(Results[Test].MaxNs100, 100), ModU64x32(Results[Test].MaxNs100, 100));
+      if (CachedAvg100 != 0) {
+        UINT64 Ratio100 = DivU64x64Remainder(MultU64x32(Avg100, 100), CachedAvg100, NULL);
+        Print(L" %7ld.%02ld\n", DivU64x32(Ratio100, 100), ModU64x32(Ratio100, 100));
+      } else {
+        Print(L" %10s\n", L"-");
+      }
+    }
+    Status = EFI_SUCCESS;
+  }
+
+  if (LocalHandle != NULL) {
+    gBS->UninstallMultipleProtocolInterfaces(LocalHandle, &gSimpleClassProtocolGuid, &mLocalSimpleClass, NULL);
+  }
+  return Status;
+}
@@ -18,33 +18,49 @@ VOID EFIAPI NotifyFunc(EFI_EVENT Event, VOID* Context)
   if (Context == NULL)
     return;
 
-  Print(L"\nEvent is signaled! Context = %d\n", *(UINTN*)Context);
+  UINTN Signal = *(UINTN*)Context;
   *(UINTN*)Context += 1;
 
-  SIMPLE_CLASS_PROTOCOL* SimpleClass;
-  EFI_STATUS Status;
-  Status = gBS->LocateProtocol(&gSimpleClassProtocolGuid,
-                               // NULL,
-                               mRegistrationTracker,
-                               (VOID**)&SimpleClass);
-  if (EFI_ERROR(Status)) {
-    Print(L"Error! LocateProtocol returned: %r\n", Status);
-    return;
-  }
-
-  UINTN Number;
-  Status = SimpleClass->GetNumber(&Number);
-  if (!EFI_ERROR(Status)) {
-    Print(L"Current number = %d\n", Number);
-  } else {
-    Print(L"Error! Can't get number: %r\n", Status);
-    return;
+  //
+  // The event is signaled only once for all the instances that were installed before the
+  // notification function had a chance to run (e.g. installed at TPL_NOTIFY), so drain
+  // every new handle of the registration. LocateHandle(ByRegisterNotify) returns one
+  // handle per call. Nothing is printed until the batch is handled.
+  //
+  UINTN Handled = 0;
+  UINTN Failed = 0;
+  while (TRUE) {
+    EFI_HANDLE Handle;
+    UINTN BufferSize = sizeof(Handle);
+    EFI_STATUS Status = gBS->LocateHandle(ByRegisterNotify,
+                                          NULL,
+                                          mRegistrationTracker,
+                                          &BufferSize,
+                                          &Handle);
+    if (EFI_ERROR(Status)) {
+      break;
+    }
+
+    SIMPLE_CLASS_PROTOCOL* SimpleClass;
+    UINTN Number;
+    Status = gBS->HandleProtocol(Handle, &gSimpleClassProtocolGuid, (VOID**)&SimpleClass);
+    if (!EFI_ERROR(Status)) {
+      Status = SimpleClass->GetNumber(&Number);
+    }
+    if (!EFI_ERROR(Status)) {
+      Status = SimpleClass->SetNumber(Number+5);
+    }
+    if (EFI_ERROR(Status)) {
+      Failed++;
+    } else {
+      Handled++;
+    }
   }
 
-  Status = SimpleClass->SetNumber(Number+5);
-  if (EFI_ERROR(Status)) {
-    Print(L"Error! Can't set number: %r\n", Status);
-    return;
+  Print(L"\nEvent is signaled! Context = %d\n", Signal);
+  Print(L"Handled %d new instance(s)\n", Handled);
+  if (Failed != 0) {
+    Print(L"Error! Can't update %d instance(s)\n", Failed);
   }
 }
 
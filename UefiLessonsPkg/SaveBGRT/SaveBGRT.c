@@ -7,9 +7,14 @@
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
 
-#include <Protocol/AcpiSystemDescriptionTable.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BenchmarkLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/ShellLib.h>
 #include <IndustryStandard/Bmp.h>
+#include <Protocol/GraphicsOutput.h>
+#include <Protocol/ShellParameters.h>
 
 EFI_STATUS WriteFile(CHAR16* FileName, VOID* Data, UINTN* Size)
 {
@@ -46,6 +51,173 @@ EFI_STATUS WriteFile(CHAR16* FileName, VOID* Data, UINTN* Size)
   return Status;
 }
 
+//
+// Convert one BMP row to the BLT pixels. EFI_GRAPHICS_OUTPUT_BLT_PIXEL has the same
+// Blue/Green/Red/Reserved order as the BMP pixel, so 32bpp rows are plain copies and
+// 24bpp rows are converted with a simple indexed loop that the compiler can vectorize
+//
+STATIC
+VOID
+ConvertRow24 (
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Dst,
+  IN  CONST UINT8                    *Src,
+  IN  UINTN                          Width
+  )
+{
+  for (UINTN x = 0; x < Width; x++) {
+    Dst[x].Blue     = Src[3 * x];
+    Dst[x].Green    = Src[3 * x + 1];
+    Dst[x].Red      = Src[3 * x + 2];
+    Dst[x].Reserved = 0;
+  }
+}
+
+EFI_STATUS
+DecodeBmp (
+  IN  BMP_IMAGE_HEADER               *Bmp,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  **BltBuffer,
+  OUT UINTN                          *Width,
+  OUT UINTN                          *Height
+  )
+{
+  if ((Bmp->CompressionType != 0) || ((Bmp->BitPerPixel != 24) && (Bmp->BitPerPixel != 32))) {
+    Print(L"Error! Only uncompressed 24/32bpp BMP images are supported (%dbpp, compression %d)\n",
+          Bmp->BitPerPixel,
+          Bmp->CompressionType);
+    return EFI_UNSUPPORTED;
+  }
+  if ((Bmp->PixelWidth == 0) || (Bmp->PixelHeight == 0) ||
+      (Bmp->PixelWidth > MAX_UINT16) || (Bmp->PixelHeight > MAX_UINT16)) {
+    Print(L"Error! Wrong BMP image resolution\n");
+    return EFI_UNSUPPORTED;
+  }
+
+  // BMP rows are padded to 4 bytes
+  UINTN RowSize = (((UINTN)Bmp->PixelWidth * Bmp->BitPerPixel + 31) / 32) * 4;
+  if ((Bmp->ImageOffset > Bmp->Size) ||
+      (RowSize * Bmp->PixelHeight > Bmp->Size - Bmp->ImageOffset)) {
+    Print(L"Error! BMP pixel data is out of the image bounds\n");
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Blt = AllocatePool((UINTN)Bmp->PixelWidth * Bmp->PixelHeight * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+  if (Blt == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  // Rows are stored bottom-up
+  UINT8* Src = (UINT8*)Bmp + Bmp->ImageOffset;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Dst = Blt + (UINTN)Bmp->PixelWidth * (Bmp->PixelHeight - 1);
+  for (UINTN y = 0; y < Bmp->PixelHeight; y++) {
+    if (Bmp->BitPerPixel == 32) {
+      CopyMem(Dst, Src, Bmp->PixelWidth * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    } else {
+      ConvertRow24(Dst, Src, Bmp->PixelWidth);
+    }
+    Src += RowSize;
+    Dst -= Bmp->PixelWidth;
+  }
+
+  *BltBuffer = Blt;
+  *Width = Bmp->PixelWidth;
+  *Height = Bmp->PixelHeight;
+  return EFI_SUCCESS;
+}
+
+//
+// Throughput in MPixel/s with one decimal digit
+//
+VOID
+PrintThroughput (
+  IN CONST CHAR16  *Name,
+  IN UINTN         Pixels,
+  IN UINT64        Ticks
+  )
+{
+  UINT64 Ns = BenchmarkTicksToNs(Ticks);
+  if (Ns == 0) {
+    Ns = 1;
+  }
+  UINT64 Rate = DivU64x64Remainder(MultU64x32(Pixels, 10000), Ns, NULL);
+  Print(L"%s: %ld us, %ld.%ld MPixel/s\n", Name, DivU64x32(Ns, 1000), DivU64x32(Rate, 10), ModU64x32(Rate, 10));
+}
+
+EFI_STATUS
+DisplayBmp (
+  IN BMP_IMAGE_HEADER  *Bmp,
+  IN UINTN             X,
+  IN UINTN             Y
+  )
+{
+  EFI_GRAPHICS_OUTPUT_PROTOCOL* Gop;
+  EFI_STATUS Status = gBS->LocateProtocol(
+    &gEfiGraphicsOutputProtocolGuid,
+    NULL,
+    (VOID **)&Gop
+  );
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't locate GOP: %r\n", Status);
+    return Status;
+  }
+
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* BltBuffer;
+  UINTN Width;
+  UINTN Height;
+  UINT64 Start = BenchmarkGetTicks();
+  Status = DecodeBmp(Bmp, &BltBuffer, &Width, &Height);
+  UINT64 DecodeTicks = BenchmarkGetTicks() - Start;
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  // Keep the BGRT position if the image fits, otherwise draw it at the top left corner
+  if ((X + Width > Gop->Mode->Info->HorizontalResolution) ||
+      (Y + Height > Gop->Mode->Info->VerticalResolution)) {
+    X = 0;
+    Y = 0;
+  }
+  if ((Width > Gop->Mode->Info->HorizontalResolution) ||
+      (Height > Gop->Mode->Info->VerticalResolution)) {
+    Print(L"Error! Image doesn't fit in the current %dx%d video mode\n",
+          Gop->Mode->Info->HorizontalResolution,
+          Gop->Mode->Info->VerticalResolution);
+    FreePool(BltBuffer);
+    return EFI_UNSUPPORTED;
+  }
+
+  Start = BenchmarkGetTicks();
+  Status = Gop->Blt(
+    Gop,
+    BltBuffer,
+    EfiBltBufferToVideo,
+    0,
+    0,
+    X,
+    Y,
+    Width,
+    Height,
+    0
+  );
+  UINT64 BltTicks = BenchmarkGetTicks() - Start;
+  FreePool(BltBuffer);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Blt failed: %r\n", Status);
+    return Status;
+  }
+
+  Print(L"Image %dx%d was drawn at (%d,%d)\n", Width, Height, X, Y);
+  PrintThroughput(L"Decode", Width * Height, DecodeTicks);
+  PrintThroughput(L"Blt", Width * Height, BltTicks);
+  return EFI_SUCCESS;
+}
+
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"SaveBGRT.efi      - save BGRT image to the BGRT.bmp file\n");
+  Print(L"SaveBGRT.efi -d   - draw BGRT image on the screen\n");
+}
+
 EFI_STATUS
 EFIAPI
 UefiMain (
@@ -53,40 +225,32 @@ UefiMain (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
-  EFI_ACPI_SDT_PROTOCOL* AcpiSdtProtocol;
-  EFI_STATUS Status = gBS->LocateProtocol (
-                  &gEfiAcpiSdtProtocolGuid,
-                  NULL,
-                  (VOID**)&AcpiSdtProtocol
-                  );
+  BOOLEAN Display = FALSE;
+
+  EFI_SHELL_PARAMETERS_PROTOCOL* ShellParameters;
+  EFI_STATUS Status = gBS->HandleProtocol(
+    ImageHandle,
+    &gEfiShellParametersProtocolGuid,
+    (VOID **) &ShellParameters
+  );
+  if (Status == EFI_SUCCESS) {
+    for (UINTN i = 1; i < ShellParameters->Argc; i++) {
+      if (!StrCmp(ShellParameters->Argv[i], L"-d")) {
+        Display = TRUE;
+      } else {
+        Usage();
+        return EFI_INVALID_PARAMETER;
+      }
+    }
+  }
+
+  Status = AcpiTableIndexInit();
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
-  BOOLEAN BGRT_found = FALSE;
-  UINTN Index = 0;
-  EFI_ACPI_SDT_HEADER* Table;
-  EFI_ACPI_TABLE_VERSION Version;
-  UINTN TableKey;
-  while (TRUE) {
-    Status = AcpiSdtProtocol->GetAcpiTable(Index,
-      &Table,
-      &Version,
-      &TableKey
-    );
-    if (EFI_ERROR(Status)) {
-      break;
-    }
-    if (((CHAR8)((Table->Signature >>  0) & 0xFF) == 'B') &&
-        ((CHAR8)((Table->Signature >>  8) & 0xFF) == 'G') &&
-        ((CHAR8)((Table->Signature >> 16) & 0xFF) == 'R') &&
-        ((CHAR8)((Table->Signature >> 24) & 0xFF) == 'T')) {
-      BGRT_found = TRUE;
-      break;
-    }
-    Index++;
-  }
-  if (!BGRT_found) {
+  EFI_ACPI_SDT_HEADER* Table = AcpiTableIndexFind(EFI_ACPI_6_3_BOOT_GRAPHICS_RESOURCE_TABLE_SIGNATURE, 0);
+  if (Table == NULL) {
     Print(L"BGRT table is not present in the system\n");
     return EFI_UNSUPPORTED;
   }
@@ -100,6 +264,9 @@ UefiMain (
       return EFI_UNSUPPORTED;
     }
     Print(L"BGRT conatins BMP image with %dx%d resolution\n", BMP->PixelWidth, BMP->PixelHeight);
+    if (Display) {
+      return DisplayBmp(BMP, BGRT->ImageOffsetX, BGRT->ImageOffsetY);
+    }
     UINTN Size = BMP->Size;
     Status = WriteFile(L"BGRT.bmp", BMP, &Size);
     if (EFI_ERROR(Status)) {
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Protocol/BlockIo.h>
+#include <Protocol/DevicePath.h>
+#include "BootOptions.h"
+
+#define INITIAL_POOL_SIZE  SIZE_4KB
+
+//
+// Read the variable right into the free space of the model pool. In the common case
+// this is a single GetVariable call, the pool is grown only if the data doesn't fit.
+//
+STATIC
+EFI_STATUS
+ReadVariableToPool (
+  IN  BOOT_OPTION_MODEL  *Model,
+  IN  CHAR16             *Name,
+  OUT UINTN              *Offset,
+  OUT UINTN              *Size
+  )
+{
+  for (;;) {
+    UINTN DataSize = Model->PoolSize - Model->PoolUsed;
+    Model->VariableReads++;
+    EFI_STATUS Status = gRT->GetVariable(Name,
+                                         &gEfiGlobalVariableGuid,
+                                         NULL,
+                                         &DataSize,
+                                         Model->Pool + Model->PoolUsed);
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      UINTN NewSize = ALIGN_VALUE(MAX(Model->PoolSize * 2, Model->PoolUsed + DataSize), sizeof(UINT64));
+      UINT8* NewPool = ReallocatePool(Model->PoolSize, NewSize, Model->Pool);
+      if (NewPool == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+      Model->Pool = NewPool;
+      Model->PoolSize = NewSize;
+      continue;
+    }
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+
+    *Offset = Model->PoolUsed;
+    *Size = DataSize;
+    // Keep every variable aligned inside the pool
+    Model->PoolUsed += ALIGN_VALUE(DataSize, sizeof(UINT64));
+    return EFI_SUCCESS;
+  }
+}
+
+STATIC
+BOOLEAN
+ParseLoadOption (
+  IN  UINT8        *Data,
+  IN  UINTN        Size,
+  OUT BOOT_OPTION  *Option
+  )
+{
+  if (Size < sizeof(EFI_LOAD_OPTION) + sizeof(CHAR16)) {
+    return FALSE;
+  }
+
+  EFI_LOAD_OPTION* LoadOption = (EFI_LOAD_OPTION*)Data;
+  Option->Attributes = LoadOption->Attributes;
+
+  CHAR16* Description = (CHAR16*)(Data + sizeof(EFI_LOAD_OPTION));
+  UINTN MaxLength = (Size - sizeof(EFI_LOAD_OPTION)) / sizeof(CHAR16);
+  UINTN Length = StrnLenS(Description, MaxLength);
+  if (Length == MaxLength) {
+    return FALSE;
+  }
+  Option->Description = Description;
+
+  UINTN Offset = sizeof(EFI_LOAD_OPTION) + (Length + 1) * sizeof(CHAR16);
+  if (LoadOption->FilePathListLength > Size - Offset) {
+    return FALSE;
+  }
+  if (LoadOption->FilePathListLength != 0) {
+    Option->FilePath = (EFI_DEVICE_PATH_PROTOCOL*)(Data + Offset);
+    Option->FilePathSize = LoadOption->FilePathListLength;
+  }
+
+  Offset += LoadOption->FilePathListLength;
+  if (Offset < Size) {
+    Option->OptionalData = Data + Offset;
+    Option->OptionalDataSize = Size - Offset;
+  }
+  return TRUE;
+}
+
+EFI_STATUS
+BootOptionModelLoad (
+  OUT BOOT_OPTION_MODEL  *Model
+  )
+{
+  EFI_STATUS Status;
+
+  ZeroMem(Model, sizeof(BOOT_OPTION_MODEL));
+  Model->Pool = AllocatePool(INITIAL_POOL_SIZE);
+  if (Model->Pool == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Model->PoolSize = INITIAL_POOL_SIZE;
+
+  UINTN Offset;
+  UINTN Size;
+  Status = ReadVariableToPool(Model, L"BootCurrent", &Offset, &Size);
+  if (!EFI_ERROR(Status) && (Size == sizeof(UINT16))) {
+    Model->BootCurrentPresent = TRUE;
+    Model->BootCurrent = *(UINT16*)(Model->Pool + Offset);
+  }
+
+  UINTN BootOrderOffset;
+  Status = ReadVariableToPool(Model, L"BootOrder", &BootOrderOffset, &Size);
+  if (EFI_ERROR(Status)) {
+    BootOptionModelFree(Model);
+    return Status;
+  }
+  Model->Count = Size / sizeof(UINT16);
+
+  Model->Options = AllocateZeroPool(Model->Count * sizeof(BOOT_OPTION));
+  Model->TextCache = AllocateZeroPool(Model->Count * sizeof(DEVICE_PATH_TEXT_ENTRY));
+  UINTN* Offsets = AllocatePool(Model->Count * sizeof(UINTN) * 2);
+  if ((Model->Options == NULL) || (Model->TextCache == NULL) || (Offsets == NULL)) {
+    if (Offsets != NULL) {
+      FreePool(Offsets);
+    }
+    BootOptionModelFree(Model);
+    return EFI_OUT_OF_RESOURCES;
+  }
+  UINTN* Sizes = Offsets + Model->Count;
+
+  //
+  // The pool can move while it grows, so keep offsets until all the variables are read
+  //
+  for (UINTN i = 0; i < Model->Count; i++) {
+    CHAR16 BootOptionStr[sizeof("Boot####")];
+    Model->Options[i].Number = ((UINT16*)(Model->Pool + BootOrderOffset))[i];
+    UnicodeSPrint(BootOptionStr, sizeof(BootOptionStr), L"Boot%04x", Model->Options[i].Number);
+    Status = ReadVariableToPool(Model, BootOptionStr, &Offsets[i], &Sizes[i]);
+    if (Status == EFI_OUT_OF_RESOURCES) {
+      FreePool(Offsets);
+      BootOptionModelFree(Model);
+      return Status;
+    }
+    Model->Options[i].Present = !EFI_ERROR(Status);
+  }
+
+  Model->BootOrder = (UINT16*)(Model->Pool + BootOrderOffset);
+  for (UINTN i = 0; i < Model->Count; i++) {
+    if (Model->Options[i].Present) {
+      if (!ParseLoadOption(Model->Pool + Offsets[i], Sizes[i], &Model->Options[i])) {
+        Model->Options[i].Description = NULL;
+        Model->Options[i].FilePath = NULL;
+        Model->Options[i].FilePathSize = 0;
+        Model->Options[i].OptionalData = NULL;
+        Model->Options[i].OptionalDataSize = 0;
+      }
+    }
+  }
+
+  FreePool(Offsets);
+  return EFI_SUCCESS;
+}
+
+VOID
+BootOptionModelFree (
+  IN BOOT_OPTION_MODEL  *Model
+  )
+{
+  if (Model->TextCache != NULL) {
+    for (UINTN i = 0; i < Model->TextCacheCount; i++) {
+      FreePool(Model->TextCache[i].Text);
+    }
+    FreePool(Model->TextCache);
+  }
+  if (Model->Options != NULL) {
+    FreePool(Model->Options);
+  }
+  if (Model->Pool != NULL) {
+    FreePool(Model->Pool);
+  }
+  ZeroMem(Model, sizeof(BOOT_OPTION_MODEL));
+}
+
+STATIC
+UINT32
+HashBytes (
+  IN CONST UINT8  *Bytes,
+  IN UINTN        Size
+  )
+{
+  // FNV-1a
+  UINT32 Hash = 0x811C9DC5;
+  for (UINTN i = 0; i < Size; i++) {
+    Hash ^= Bytes[i];
+    Hash *= 0x01000193;
+  }
+  return Hash;
+}
+
+CONST CHAR16*
+BootOptionPathText (
+  IN BOOT_OPTION_MODEL  *Model,
+  IN BOOT_OPTION        *Option
+  )
+{
+  if (Option->FilePathText != NULL) {
+    return Option->FilePathText;
+  }
+  if (Option->FilePath == NULL) {
+    return NULL;
+  }
+
+  UINT32 Hash = HashBytes((UINT8*)Option->FilePath, Option->FilePathSize);
+  for (UINTN i = 0; i < Model->TextCacheCount; i++) {
+    DEVICE_PATH_TEXT_ENTRY* Entry = &Model->TextCache[i];
+    if ((Entry->Hash == Hash) &&
+        (Entry->Size == Option->FilePathSize) &&
+        (CompareMem(Entry->Bytes, Option->FilePath, Entry->Size) == 0)) {
+      Option->FilePathText = Entry->Text;
+      return Option->FilePathText;
+    }
+  }
+
+  CHAR16* Text = ConvertDevicePathToText(Option->FilePath, TRUE, FALSE);
+  Model->TextConversions++;
+  if (Text == NULL) {
+    return NULL;
+  }
+
+  // There can't be more unique paths than options, so the table never overflows
+  DEVICE_PATH_TEXT_ENTRY* Entry = &Model->TextCache[Model->TextCacheCount++];
+  Entry->Hash = Hash;
+  Entry->Bytes = (UINT8*)Option->FilePath;
+  Entry->Size = Option->FilePathSize;
+  Entry->Text = Text;
+
+  Option->FilePathText = Text;
+  return Text;
+}
+
+//
+// Short-form hard drive path is expanded by the boot manager, so look for a partition
+// with the same signature among the block devices.
+//
+STATIC
+BOOLEAN
+IsPartitionPresent (
+  IN HARDDRIVE_DEVICE_PATH  *ShortForm
+  )
+{
+  UINTN HandleCount;
+  EFI_HANDLE* Handles;
+  EFI_STATUS Status = gBS->LocateHandleBuffer(ByProtocol,
+                                              &gEfiBlockIoProtocolGuid,
+                                              NULL,
+                                              &HandleCount,
+                                              &Handles);
+  if (EFI_ERROR(Status)) {
+    return FALSE;
+  }
+
+  BOOLEAN Found = FALSE;
+  for (UINTN i = 0; (i < HandleCount) && !Found; i++) {
+    EFI_DEVICE_PATH_PROTOCOL* DevicePath;
+    Status = gBS->HandleProtocol(Handles[i], &gEfiDevicePathProtocolGuid, (VOID**)&DevicePath);
+    if (EFI_ERROR(Status)) {
+      continue;
+    }
+    for (; !IsDevicePathEnd(DevicePath); DevicePath = NextDevicePathNode(DevicePath)) {
+      if ((DevicePathType(DevicePath) == MEDIA_DEVICE_PATH) &&
+          (DevicePathSubType(DevicePath) == MEDIA_HARDDRIVE_DP)) {
+        HARDDRIVE_DEVICE_PATH* Hd = (HARDDRIVE_DEVICE_PATH*)DevicePath;
+        if ((Hd->PartitionNumber == ShortForm->PartitionNumber) &&
+            (Hd->SignatureType == ShortForm->SignatureType) &&
+            (CompareMem(Hd->Signature, ShortForm->Signature, sizeof(Hd->Signature)) == 0)) {
+          Found = TRUE;
+        }
+        break;
+      }
+    }
+  }
+
+  FreePool(Handles);
+  return Found;
+}
+
+BOOT_OPTION_STATE
+BootOptionValidate (
+  IN BOOT_OPTION  *Option
+  )
+{
+  if (!Option->Present) {
+    return BootOptionMissing;
+  }
+  if ((Option->Description == NULL) ||
+      (Option->FilePath == NULL) ||
+      !IsDevicePathValid(Option->FilePath, Option->FilePathSize)) {
+    return BootOptionMalformed;
+  }
+
+  UINT8 Type = DevicePathType(Option->FilePath);
+  UINT8 SubType = DevicePathSubType(Option->FilePath);
+  if ((Type == MEDIA_DEVICE_PATH) && (SubType == MEDIA_HARDDRIVE_DP)) {
+    return IsPartitionPresent((HARDDRIVE_DEVICE_PATH*)Option->FilePath) ? BootOptionOk : BootOptionDangling;
+  }
+  if (((Type == MEDIA_DEVICE_PATH) && (SubType == MEDIA_FILEPATH_DP)) ||
+      ((Type == MESSAGING_DEVICE_PATH) && ((SubType == MSG_USB_CLASS_DP) ||
+                                           (SubType == MSG_USB_WWID_DP) ||
+                                           (SubType == MSG_URI_DP)))) {
+    return BootOptionNotChecked;
+  }
+
+  //
+  // Find the device that is the closest to the path. The path is valid if all the
+  // unmatched nodes describe a file on that device.
+  //
+  EFI_DEVICE_PATH_PROTOCOL* RemainingPath = Option->FilePath;
+  EFI_HANDLE Handle;
+  EFI_STATUS Status = gBS->LocateDevicePath(&gEfiDevicePathProtocolGuid, &RemainingPath, &Handle);
+  if (EFI_ERROR(Status)) {
+    return BootOptionDangling;
+  }
+  if (IsDevicePathEnd(RemainingPath)) {
+    return BootOptionOk;
+  }
+  if ((DevicePathType(RemainingPath) == MEDIA_DEVICE_PATH) &&
+      ((DevicePathSubType(RemainingPath) == MEDIA_FILEPATH_DP) ||
+       (DevicePathSubType(RemainingPath) == MEDIA_PIWG_FW_FILE_DP))) {
+    return BootOptionOk;
+  }
+  return BootOptionDangling;
+}
+
+EFI_STATUS
+BootOptionModelReorder (
+  IN BOOT_OPTION_MODEL  *Model,
+  IN UINT16             *Numbers,
+  IN UINTN              NumbersCount
+  )
+{
+  EFI_STATUS Status = EFI_SUCCESS;
+
+  if (NumbersCount > Model->Count) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UINTN* Index = AllocatePool(Model->Count * sizeof(UINTN));
+  BOOLEAN* Taken = AllocateZeroPool(Model->Count * sizeof(BOOLEAN));
+  UINT16* NewOrder = AllocatePool(Model->Count * sizeof(UINT16));
+  BOOT_OPTION* NewOptions = AllocatePool(Model->Count * sizeof(BOOT_OPTION));
+  if ((Index == NULL) || (Taken == NULL) || (NewOrder == NULL) || (NewOptions == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  UINTN Position = 0;
+  for (UINTN i = 0; i < NumbersCount; i++) {
+    UINTN j;
+    for (j = 0; j < Model->Count; j++) {
+      if (!Taken[j] && (Model->BootOrder[j] == Numbers[i])) {
+        break;
+      }
+    }
+    if (j == Model->Count) {
+      Status = EFI_NOT_FOUND;
+      goto Done;
+    }
+    Taken[j] = TRUE;
+    Index[Position++] = j;
+  }
+  for (UINTN j = 0; j < Model->Count; j++) {
+    if (!Taken[j]) {
+      Index[Position++] = j;
+    }
+  }
+
+  for (UINTN i = 0; i < Model->Count; i++) {
+    NewOrder[i] = Model->BootOrder[Index[i]];
+    NewOptions[i] = Model->Options[Index[i]];
+  }
+
+  if (CompareMem(NewOrder, Model->BootOrder, Model->Count * sizeof(UINT16)) == 0) {
+    goto Done;
+  }
+
+  Status = gRT->SetVariable(L"BootOrder",
+                            &gEfiGlobalVariableGuid,
+                            EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+                            Model->Count * sizeof(UINT16),
+                            NewOrder);
+  if (!EFI_ERROR(Status)) {
+    CopyMem(Model->BootOrder, NewOrder, Model->Count * sizeof(UINT16));
+    CopyMem(Model->Options, NewOptions, Model->Count * sizeof(BOOT_OPTION));
+  }
+
+Done:
+  if (Index != NULL) {
+    FreePool(Index);
+  }
+  if (Taken != NULL) {
+    FreePool(Taken);
+  }
+  if (NewOrder != NULL) {
+    FreePool(NewOrder);
+  }
+  if (NewOptions != NULL) {
+    FreePool(NewOptions);
+  }
+  return Status;
+}
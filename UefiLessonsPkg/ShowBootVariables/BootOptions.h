@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __BOOT_OPTIONS_H__
+#define __BOOT_OPTIONS_H__
+
+#include <Uefi.h>
+
+typedef enum {
+  BootOptionOk,
+  BootOptionMissing,        // Boot#### variable referenced by BootOrder doesn't exist
+  BootOptionMalformed,      // EFI_LOAD_OPTION or its device path is broken
+  BootOptionDangling,       // Device path doesn't lead to any existing device
+  BootOptionNotChecked      // Short-form device path that is not resolved by this tool
+} BOOT_OPTION_STATE;
+
+//
+// Typed view of the EFI_LOAD_OPTION. All pointers point into the model data pool
+// and are valid until BootOptionModelFree.
+//
+typedef struct {
+  UINT16                    Number;
+  BOOLEAN                   Present;
+  UINT32                    Attributes;
+  CHAR16                    *Description;
+  EFI_DEVICE_PATH_PROTOCOL  *FilePath;
+  UINTN                     FilePathSize;
+  UINT8                     *OptionalData;
+  UINTN                     OptionalDataSize;
+  CONST CHAR16              *FilePathText;    // Memoized, shared between options with the same path
+} BOOT_OPTION;
+
+typedef struct {
+  UINT32        Hash;
+  CONST UINT8   *Bytes;
+  UINTN         Size;
+  CHAR16        *Text;
+} DEVICE_PATH_TEXT_ENTRY;
+
+typedef struct {
+  UINT16                  *BootOrder;
+  UINTN                   Count;
+  BOOT_OPTION             *Options;           // Options[i] corresponds to BootOrder[i]
+  BOOLEAN                 BootCurrentPresent;
+  UINT16                  BootCurrent;
+  UINT8                   *Pool;              // Raw data of all variables read in one pass
+  UINTN                   PoolSize;
+  UINTN                   PoolUsed;
+  DEVICE_PATH_TEXT_ENTRY  *TextCache;
+  UINTN                   TextCacheCount;
+  UINTN                   VariableReads;      // gRT->GetVariable calls
+  UINTN                   TextConversions;    // ConvertDevicePathToText calls
+} BOOT_OPTION_MODEL;
+
+/**
+  Read BootCurrent, BootOrder and all Boot#### variables referenced by the BootOrder.
+**/
+EFI_STATUS
+BootOptionModelLoad (
+  OUT BOOT_OPTION_MODEL  *Model
+  );
+
+VOID
+BootOptionModelFree (
+  IN BOOT_OPTION_MODEL  *Model
+  );
+
+/**
+  Get the text representation of the option device path. The conversion is done once
+  for every unique device path.
+**/
+CONST CHAR16*
+BootOptionPathText (
+  IN BOOT_OPTION_MODEL  *Model,
+  IN BOOT_OPTION        *Option
+  );
+
+BOOT_OPTION_STATE
+BootOptionValidate (
+  IN BOOT_OPTION  *Option
+  );
+
+/**
+  Move the options from the Numbers array to the start of the BootOrder in the given
+  sequence. The rest of the options keep their relative order. The BootOrder variable
+  is written only if the order has really changed.
+**/
+EFI_STATUS
+BootOptionModelReorder (
+  IN BOOT_OPTION_MODEL  *Model,
+  IN UINT16             *Numbers,
+  IN UINTN              NumbersCount
+  );
+
+#endif
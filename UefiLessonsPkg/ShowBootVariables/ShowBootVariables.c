@@ -13,87 +13,141 @@
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
 
+#include "BootOptions.h"
 
-EFI_STATUS
-GetNvramVariable( CHAR16   *VariableName,
-                  EFI_GUID *VariableOwnerGuid, 
-                  VOID     **Buffer,
-                  UINTN    *BufferSize)
-{
-    UINTN Size = 0;
-    *BufferSize = 0;
-
-    EFI_STATUS Status = gRT->GetVariable(VariableName, VariableOwnerGuid, NULL, &Size, NULL);
-    if (Status != EFI_BUFFER_TOO_SMALL) {
-        Print(L"Error! 'gRT->GetVariable' call returned %r\n", Status);
-        return Status;
-    }
 
-    *Buffer = AllocateZeroPool(Size);
-    if (!Buffer) {
-        Print(L"Error! 'AllocateZeroPool' call returned %r\n", Status);
-        return EFI_OUT_OF_RESOURCES;
-    }
+VOID PrintBootOption(BOOT_OPTION_MODEL* Model, BOOT_OPTION* Option)
+{
+  if (!Option->Present) {
+    Print(L"Can't get Boot%04x variable\n", Option->Number);
+    return;
+  }
+  if (Option->Description == NULL) {
+    Print(L"Malformed EFI_LOAD_OPTION\n");
+    return;
+  }
 
-    Status = gRT->GetVariable(VariableName, VariableOwnerGuid, NULL, &Size, *Buffer);
-    if (Status == EFI_SUCCESS) {
-        *BufferSize = Size;
-    } else {
-        FreePool( *Buffer );
-        *Buffer = NULL;
-    }
+  Print(L"%s\n", Option->Description);
+  CONST CHAR16* DevPathString = BootOptionPathText(Model, Option);
+  if (DevPathString != NULL) {
+    Print(L"%s\n", DevPathString);
+  }
+}
 
-    return Status;
+VOID ListBootOptions(BOOT_OPTION_MODEL* Model)
+{
+  for (UINTN i=0; i<Model->Count; i++) {
+    BOOT_OPTION* Option = &Model->Options[i];
+    BOOLEAN Current = Model->BootCurrentPresent && (Option->Number == Model->BootCurrent);
+    Print(L"Boot%04x%s\n", Option->Number, Current ? L"*" : L"");
+    PrintBootOption(Model, Option);
+    Print(L"\n");
+  }
 }
 
+CHAR16* BootOptionStateStr(BOOT_OPTION_STATE State)
+{
+  switch (State) {
+    case BootOptionOk:
+      return L"OK";
+    case BootOptionMissing:
+      return L"MISSING";
+    case BootOptionMalformed:
+      return L"MALFORMED";
+    case BootOptionDangling:
+      return L"DANGLING";
+    case BootOptionNotChecked:
+      return L"NOT CHECKED";
+  }
+  return L"UNKNOWN";
+}
 
-VOID PrintBootOption(CHAR16* BootOptionName)
+UINTN ValidateBootOptions(BOOT_OPTION_MODEL* Model)
 {
-  UINTN OptionSize;
-  UINT8* Buffer;
- 
-  EFI_STATUS Status = GetNvramVariable(BootOptionName, &gEfiGlobalVariableGuid, (VOID**)&Buffer, &OptionSize);
-  if (Status == EFI_SUCCESS) {
-      EFI_LOAD_OPTION* LoadOption = (EFI_LOAD_OPTION*) Buffer;
-      CHAR16* Description = (CHAR16*)(Buffer + sizeof (EFI_LOAD_OPTION));
-      UINTN DescriptionSize = StrSize(Description);
-
-      Print(L"%s\n", Description);
-      if (LoadOption->FilePathListLength != 0) {
-        VOID* FilePathList = (UINT8 *)Description + DescriptionSize;
-        CHAR16* DevPathString = ConvertDevicePathToText(FilePathList, TRUE, FALSE);
-        Print(L"%s\n", DevPathString);
-      }
-  } else {
-    Print(L"Can't get %s variable\n", BootOptionName);
+  UINTN Broken = 0;
+  for (UINTN i=0; i<Model->Count; i++) {
+    BOOT_OPTION* Option = &Model->Options[i];
+    BOOT_OPTION_STATE State = BootOptionValidate(Option);
+    if ((State != BootOptionOk) && (State != BootOptionNotChecked)) {
+      Broken++;
+    }
+    Print(L"Boot%04x: %-11s %s\n", Option->Number,
+                                   BootOptionStateStr(State),
+                                   (Option->Description != NULL) ? Option->Description : L"");
+    if ((State == BootOptionDangling) || (State == BootOptionNotChecked)) {
+      CONST CHAR16* DevPathString = BootOptionPathText(Model, Option);
+      Print(L"  %s\n", (DevPathString != NULL) ? DevPathString : L"<no device path>");
+    }
   }
+  Print(L"%d of %d boot options are broken\n", Broken, Model->Count);
+  return Broken;
 }
 
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"ShowBootVariables.efi [list]\n");
+  Print(L"ShowBootVariables.efi validate\n");
+  Print(L"ShowBootVariables.efi order <####> [<####> ...]\n");
+}
 
 INTN EFIAPI ShellAppMain(IN UINTN Argc, IN CHAR16 **Argv)
 {
-  UINTN OptionSize;
   EFI_STATUS Status;
 
-  UINT16* BootCurrent;
-  Status = GetNvramVariable(L"BootCurrent", &gEfiGlobalVariableGuid, (VOID**)&BootCurrent, &OptionSize);
-  if (Status != EFI_SUCCESS) {
+  if ((Argc > 1) && StrCmp(Argv[1], L"list") && StrCmp(Argv[1], L"validate") && StrCmp(Argv[1], L"order")) {
+    Usage();
+    return EFI_INVALID_PARAMETER;
+  }
+
+  BOOT_OPTION_MODEL Model;
+  Status = BootOptionModelLoad(&Model);
+  if (EFI_ERROR(Status)) {
+    Print(L"Can't get BootOrder variable: %r\n", Status);
+    return Status;
+  }
+  if (!Model.BootCurrentPresent) {
     Print(L"Can't get BootCurrent variable\n");
   }
 
-  UINT16* BootOrderArray;
-  Status = GetNvramVariable(L"BootOrder", &gEfiGlobalVariableGuid, (VOID**)&BootOrderArray, &OptionSize);
-  if (Status == EFI_SUCCESS) {
-    for (UINTN i=0; i<(OptionSize/sizeof(UINT16)); i++) {
-      CHAR16 BootOptionStr[sizeof("Boot####")+1];
-      UnicodeSPrint(BootOptionStr, (sizeof("Boot####")+1)*sizeof(CHAR16), L"Boot%04x", BootOrderArray[i]);
-      Print(L"%s%s\n", BootOptionStr, (BootOrderArray[i] == *BootCurrent)? L"*" : L"" );
-      PrintBootOption(BootOptionStr);
-      Print(L"\n");
-    }
+  if ((Argc == 1) || !StrCmp(Argv[1], L"list")) {
+    ListBootOptions(&Model);
+  } else if (!StrCmp(Argv[1], L"validate")) {
+    ValidateBootOptions(&Model);
   } else {
-    Print(L"Can't get BootOrder variable\n");
+    UINTN Count = Argc - 2;
+    if (Count == 0) {
+      Usage();
+      BootOptionModelFree(&Model);
+      return EFI_INVALID_PARAMETER;
+    }
+    UINT16* Numbers = AllocatePool(Count * sizeof(UINT16));
+    if (Numbers == NULL) {
+      BootOptionModelFree(&Model);
+      return EFI_OUT_OF_RESOURCES;
+    }
+    for (UINTN i=0; i<Count; i++) {
+      UINTN Value;
+      CHAR16* EndPointer;
+      Status = StrHexToUintnS(Argv[i + 2], &EndPointer, &Value);
+      if (EFI_ERROR(Status) || (*EndPointer != L'\0') || (Value > MAX_UINT16)) {
+        Print(L"Error! Wrong boot option number %s\n", Argv[i + 2]);
+        FreePool(Numbers);
+        BootOptionModelFree(&Model);
+        return EFI_INVALID_PARAMETER;
+      }
+      Numbers[i] = (UINT16)Value;
+    }
+
+    Status = BootOptionModelReorder(&Model, Numbers, Count);
+    if (EFI_ERROR(Status)) {
+      Print(L"Error! Can't reorder boot options: %r\n", Status);
+    } else {
+      ListBootOptions(&Model);
+    }
+    FreePool(Numbers);
   }
 
-  return EFI_SUCCESS;
+  BootOptionModelFree(&Model);
+  return Status;
 }
@@ -8,7 +8,7 @@
 #include <Library/UefiLib.h>
 
 #include <Protocol/HiiDatabase.h>
-#include <Library/MemoryAllocationLib.h>
+#include <Library/HiiDbIndexLib.h>
 
 
 CHAR16* PackageType(UINTN Type)
@@ -44,29 +44,18 @@ CHAR16* PackageType(UINTN Type)
   return L"UNKNOWN";
 }
 
-VOID ParseHiiPackageLists(EFI_HII_PACKAGE_LIST_HEADER* HiiDatabase, UINTN HiiDatabaseSize)
+VOID ParseHiiPackageList(UINTN Index, EFI_HII_PACKAGE_LIST_HEADER* HiiPackageListHeader)
 {
-  EFI_HII_PACKAGE_LIST_HEADER* HiiPackageListHeader;
-  HiiPackageListHeader = (EFI_HII_PACKAGE_LIST_HEADER*) HiiDatabase;
+  UINTN HiiPackageListSize = HiiPackageListHeader->PackageLength;
+  Print(L"PackageList[%d]: GUID=%g; size=0x%X\n", Index, HiiPackageListHeader->PackageListGuid, HiiPackageListHeader->PackageLength);
 
-  UINTN i=0;
-  while ((UINTN) HiiPackageListHeader < ((UINTN) HiiDatabase + HiiDatabaseSize)) {
-    UINTN HiiPackageListSize = HiiPackageListHeader->PackageLength;
-    if (HiiPackageListSize == 0)
-      break;
-    Print(L"PackageList[%d]: GUID=%g; size=0x%X\n", i++, HiiPackageListHeader->PackageListGuid, HiiPackageListHeader->PackageLength);
+  EFI_HII_PACKAGE_HEADER* HiiPackageHeader = (EFI_HII_PACKAGE_HEADER*)((UINTN) HiiPackageListHeader + sizeof(EFI_HII_PACKAGE_LIST_HEADER));
+  UINTN j=0;
+  while ((UINTN) HiiPackageHeader < ((UINTN) HiiPackageListHeader + HiiPackageListSize)) {
+    Print(L"\tPackage[%d]: type=%s; size=0x%X\n", j++, PackageType(HiiPackageHeader->Type), HiiPackageHeader->Length);
 
-    EFI_HII_PACKAGE_HEADER* HiiPackageHeader = (EFI_HII_PACKAGE_HEADER*)((UINTN) HiiPackageListHeader + sizeof(EFI_HII_PACKAGE_LIST_HEADER));
-    UINTN j=0;
-    while ((UINTN) HiiPackageHeader < ((UINTN) HiiPackageListHeader + HiiPackageListSize)) {
-      Print(L"\tPackage[%d]: type=%s; size=0x%X\n", j++, PackageType(HiiPackageHeader->Type), HiiPackageHeader->Length);
-
-      // Go to next Package
-      HiiPackageHeader = (EFI_HII_PACKAGE_HEADER*)((UINTN) HiiPackageHeader + HiiPackageHeader->Length);
-    }
-
-    // Go to next PackageList
-    HiiPackageListHeader = (EFI_HII_PACKAGE_LIST_HEADER*)((UINTN) HiiPackageListHeader + HiiPackageListSize);
+    // Go to next Package
+    HiiPackageHeader = (EFI_HII_PACKAGE_HEADER*)((UINTN) HiiPackageHeader + HiiPackageHeader->Length);
   }
 }
 
@@ -77,50 +66,24 @@ UefiMain (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
-  EFI_STATUS Status;
-  EFI_HII_DATABASE_PROTOCOL* HiiDbProtocol;
-  Status = gBS->LocateProtocol(&gEfiHiiDatabaseProtocolGuid,
-                               NULL, 
-                               (VOID**)&HiiDbProtocol);
+  EFI_STATUS Status = HiiDbIndexInit();
   if (EFI_ERROR(Status)) {
-    Print(L"ERROR: Could not find HII Database protocol: %r\n", Status);
+    Print(L"ERROR: Could not export HII database: %r\n", Status);
     return Status;
   }
 
-  UINTN PackageListSize = 0;
-  EFI_HII_PACKAGE_LIST_HEADER* PackageList = NULL;
-
-  Status = HiiDbProtocol->ExportPackageLists(HiiDbProtocol,
-                                             NULL,		// All package lists
-                                             &PackageListSize,
-                                             PackageList);
-  if (Status != EFI_BUFFER_TOO_SMALL) {
-    Print(L"ERROR: Could not obtain package list size\n");
-    return Status;
+  UINTN ListCount = HiiDbIndexGetListCount();
+  for (UINTN i = 0; i < ListCount; i++) {
+    ParseHiiPackageList(i, HiiDbIndexGetList(i)->PackageList);
   }
 
-  Status = gBS->AllocatePool(EfiBootServicesData, 
-                             PackageListSize, 
-                             (VOID**)&PackageList);
-  if (EFI_ERROR(Status)) {
-    Print(L"ERROR: Could not allocate sufficient memory for package list: %r\n", Status);
-    return Status;
-  }
-
-
-  Status = HiiDbProtocol->ExportPackageLists(HiiDbProtocol,
-                                             NULL,
-                                             &PackageListSize,
-                                             PackageList);
-  if (EFI_ERROR(Status)) {
-    Print(L"ERROR: Could not retrieve the package list: %r\n", Status);
-    FreePool(PackageList);
-    return Status;
+  Print(L"\n");
+  for (UINTN Type = EFI_HII_PACKAGE_TYPE_GUID; Type <= EFI_HII_PACKAGE_ANIMATIONS; Type++) {
+    UINTN Count = HiiDbIndexCountByType((UINT8)Type);
+    if (Count != 0) {
+      Print(L"%s packages: %d\n", PackageType(Type), Count);
+    }
   }
 
-  ParseHiiPackageLists(PackageList, PackageListSize);
-
-  FreePool(PackageList);
-
   return EFI_SUCCESS;
 }
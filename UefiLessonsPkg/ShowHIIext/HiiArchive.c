@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/ShellLib.h>
+#include <Library/HiiDbIndexLib.h>
+
+#include "HiiArchive.h"
+
+//
+// LZSS format:
+//   Data is a sequence of groups, every group is a flag byte followed by up to 8 items.
+//   Bit i of the flag byte (starting from the LSB) describes item i:
+//     0 - literal byte
+//     1 - match, UINT16 (little-endian): bits 0..11 - distance - 1, bits 12..15 - length - LZSS_MIN_MATCH
+//
+#define LZSS_WINDOW_SIZE  4096
+#define LZSS_MIN_MATCH    3
+#define LZSS_MAX_MATCH    (LZSS_MIN_MATCH + 15)
+#define LZSS_HASH_SIZE    4096
+#define LZSS_MAX_CHAIN    32
+#define LZSS_NO_POS       MAX_UINT32
+
+#define ARCHIVE_WRITE_BUFFER_SIZE  SIZE_64KB
+
+typedef struct {
+  UINT32  *Head;                      // Last position of every 3-byte hash
+  UINT32  *Prev;                      // Previous position with the same hash, indexed by position % LZSS_WINDOW_SIZE
+} LZSS_CONTEXT;
+
+typedef struct {
+  SHELL_FILE_HANDLE FileHandle;
+  UINT8* Buffer;
+  UINTN Used;
+} ARCHIVE_WRITER;
+
+STATIC
+UINTN
+LzssHash (
+  IN CONST UINT8  *Data
+  )
+{
+  return ((Data[0] << 8) ^ (Data[1] << 4) ^ Data[2]) & (LZSS_HASH_SIZE - 1);
+}
+
+//
+// Compress the data to Output, return the compressed size or 0 if it is not smaller than the data
+//
+STATIC
+UINTN
+LzssCompress (
+  IN  LZSS_CONTEXT  *Context,
+  IN  CONST UINT8   *Data,
+  IN  UINTN         Size,
+  OUT UINT8         *Output
+  )
+{
+  SetMem32(Context->Head, LZSS_HASH_SIZE * sizeof(UINT32), LZSS_NO_POS);
+
+  UINTN OutSize = 0;
+  UINTN FlagOffset = 0;
+  UINTN ItemCount = 8;
+  UINTN Pos = 0;
+  while (Pos < Size) {
+    if (ItemCount == 8) {
+      if (OutSize + 1 + 8 * 2 > Size) {
+        return 0;
+      }
+      FlagOffset = OutSize++;
+      Output[FlagOffset] = 0;
+      ItemCount = 0;
+    }
+
+    // Find the longest match in the hash chain of the current position
+    UINTN BestLength = 0;
+    UINTN BestDistance = 0;
+    if (Pos + LZSS_MIN_MATCH <= Size) {
+      UINTN MaxLength = MIN(LZSS_MAX_MATCH, Size - Pos);
+      UINT32 Candidate = Context->Head[LzssHash(&Data[Pos])];
+      for (UINTN Chain = 0; (Chain < LZSS_MAX_CHAIN) && (Candidate != LZSS_NO_POS); Chain++) {
+        if (Pos - Candidate > LZSS_WINDOW_SIZE) {
+          break;
+        }
+        UINTN Length = 0;
+        while ((Length < MaxLength) && (Data[Candidate + Length] == Data[Pos + Length])) {
+          Length++;
+        }
+        if (Length > BestLength) {
+          BestLength = Length;
+          BestDistance = Pos - Candidate;
+          if (Length == MaxLength) {
+            break;
+          }
+        }
+        UINT32 Next = Context->Prev[Candidate % LZSS_WINDOW_SIZE];
+        if ((Next == LZSS_NO_POS) || (Next >= Candidate)) {
+          break;
+        }
+        Candidate = Next;
+      }
+    }
+
+    UINTN Advance;
+    if (BestLength >= LZSS_MIN_MATCH) {
+      UINT16 Item = (UINT16)((BestDistance - 1) | ((BestLength - LZSS_MIN_MATCH) << 12));
+      Output[FlagOffset] |= (UINT8)(1 << ItemCount);
+      Output[OutSize++] = (UINT8)(Item & 0xFF);
+      Output[OutSize++] = (UINT8)(Item >> 8);
+      Advance = BestLength;
+    } else {
+      Output[OutSize++] = Data[Pos];
+      Advance = 1;
+    }
+    ItemCount++;
+
+    // Every position of the emitted item goes to the hash chains
+    for (UINTN i = 0; i < Advance; i++, Pos++) {
+      if (Pos + LZSS_MIN_MATCH <= Size) {
+        UINTN Hash = LzssHash(&Data[Pos]);
+        Context->Prev[Pos % LZSS_WINDOW_SIZE] = Context->Head[Hash];
+        Context->Head[Hash] = (UINT32)Pos;
+      }
+    }
+  }
+
+  return (OutSize < Size) ? OutSize : 0;
+}
+
+STATIC
+EFI_STATUS
+FlushArchive (
+  IN ARCHIVE_WRITER  *Writer
+  )
+{
+  if (Writer->Used == 0) {
+    return EFI_SUCCESS;
+  }
+  UINTN Size = Writer->Used;
+  EFI_STATUS Status = ShellWriteFile(Writer->FileHandle, &Size, Writer->Buffer);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error in WriteFile: %r\n", Status);
+    return Status;
+  }
+  if (Size != Writer->Used) {
+    Print(L"Error! Not all data was written\n");
+    return EFI_DEVICE_ERROR;
+  }
+  Writer->Used = 0;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+WriteArchive (
+  IN ARCHIVE_WRITER  *Writer,
+  IN VOID            *Data,
+  IN UINTN           Size
+  )
+{
+  UINT8* Src = (UINT8*)Data;
+  while (Size != 0) {
+    UINTN Chunk = MIN(Size, ARCHIVE_WRITE_BUFFER_SIZE - Writer->Used);
+    CopyMem(Writer->Buffer + Writer->Used, Src, Chunk);
+    Writer->Used += Chunk;
+    Src += Chunk;
+    Size -= Chunk;
+    if (Writer->Used == ARCHIVE_WRITE_BUFFER_SIZE) {
+      EFI_STATUS Status = FlushArchive(Writer);
+      if (EFI_ERROR(Status)) {
+        return Status;
+      }
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+//
+// Unique packages are found through an open addressing hash table of their CRC32,
+// the hash table element is the package index + 1, 0 is an empty slot
+//
+STATIC
+UINTN
+FindPackage (
+  IN HII_ARCHIVE_PACKAGE     *Packages,
+  IN EFI_HII_PACKAGE_HEADER  **PackageData,
+  IN UINT32                  *Table,
+  IN UINTN                   TableSize,
+  IN EFI_HII_PACKAGE_HEADER  *Package,
+  IN UINT32                  Crc,
+  OUT UINTN                  *Slot
+  )
+{
+  UINTN i = Crc & (TableSize - 1);
+  while (Table[i] != 0) {
+    UINTN Index = Table[i] - 1;
+    if ((Packages[Index].Crc32 == Crc) &&
+        (Packages[Index].Size == Package->Length) &&
+        (CompareMem(PackageData[Index], Package, Package->Length) == 0)) {
+      return Index;
+    }
+    i = (i + 1) & (TableSize - 1);
+  }
+  *Slot = i;
+  return MAX_UINTN;
+}
+
+EFI_STATUS
+SaveHiiArchive (
+  IN CHAR16  *FileName
+  )
+{
+  UINTN ListCount = HiiDbIndexGetListCount();
+  UINTN RefCount = 0;
+  UINTN MaxPackageSize = 0;
+  for (UINTN i = 0; i < ListCount; i++) {
+    EFI_HII_PACKAGE_LIST_HEADER* PackageList = HiiDbIndexGetList(i)->PackageList;
+    UINT8* Ptr = (UINT8*)(PackageList + 1);
+    UINT8* End = (UINT8*)PackageList + PackageList->PackageLength;
+    while (Ptr < End) {
+      if (((EFI_HII_PACKAGE_HEADER*)Ptr)->Length < sizeof(EFI_HII_PACKAGE_HEADER)) {
+        break;
+      }
+      MaxPackageSize = MAX(MaxPackageSize, ((EFI_HII_PACKAGE_HEADER*)Ptr)->Length);
+      RefCount++;
+      Ptr += ((EFI_HII_PACKAGE_HEADER*)Ptr)->Length;
+    }
+  }
+
+  UINTN TableSize = 16;
+  while (TableSize < RefCount * 2) {
+    TableSize *= 2;
+  }
+
+  HII_ARCHIVE_LIST* Lists = AllocateZeroPool(MAX(ListCount, 1) * sizeof(HII_ARCHIVE_LIST));
+  UINT32* Refs = AllocatePool(MAX(RefCount, 1) * sizeof(UINT32));
+  HII_ARCHIVE_PACKAGE* Packages = AllocateZeroPool(MAX(RefCount, 1) * sizeof(HII_ARCHIVE_PACKAGE));
+  EFI_HII_PACKAGE_HEADER** PackageData = AllocatePool(MAX(RefCount, 1) * sizeof(EFI_HII_PACKAGE_HEADER*));
+  UINT32* Table = AllocateZeroPool(TableSize * sizeof(UINT32));
+  UINT8* Compressed = AllocatePool(MAX(MaxPackageSize, 1));
+  LZSS_CONTEXT Lzss;
+  Lzss.Head = AllocatePool(LZSS_HASH_SIZE * sizeof(UINT32));
+  Lzss.Prev = AllocatePool(LZSS_WINDOW_SIZE * sizeof(UINT32));
+  ARCHIVE_WRITER Writer;
+  Writer.Used = 0;
+  Writer.Buffer = AllocatePool(ARCHIVE_WRITE_BUFFER_SIZE);
+  Writer.FileHandle = NULL;
+
+  EFI_STATUS Status = EFI_SUCCESS;
+  if ((Lists == NULL) || (Refs == NULL) || (Packages == NULL) || (PackageData == NULL) ||
+      (Table == NULL) || (Compressed == NULL) || (Lzss.Head == NULL) || (Lzss.Prev == NULL) ||
+      (Writer.Buffer == NULL)) {
+    Print(L"Error! Can't allocate memory for the archive\n");
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Status = ShellOpenFileByName(FileName,
+                               &Writer.FileHandle,
+                               EFI_FILE_MODE_CREATE | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_READ,
+                               0);
+  if (EFI_ERROR(Status)) {
+    Print(L"Can't open file: %r\n", Status);
+    Writer.FileHandle = NULL;
+    goto Done;
+  }
+
+  //
+  // The header is written first to reserve its place, it is rewritten with the final values at the end
+  //
+  HII_ARCHIVE_HEADER Header;
+  ZeroMem(&Header, sizeof(Header));
+  Status = WriteArchive(&Writer, &Header, sizeof(Header));
+  UINT64 Offset = sizeof(Header);
+  UINT64 TotalSize = 0;
+  UINTN PackageCount = 0;
+  UINTN Ref = 0;
+  for (UINTN i = 0; (i < ListCount) && !EFI_ERROR(Status); i++) {
+    EFI_HII_PACKAGE_LIST_HEADER* PackageList = HiiDbIndexGetList(i)->PackageList;
+    CopyGuid(&Lists[i].Guid, &PackageList->PackageListGuid);
+    Lists[i].FirstRef = (UINT32)Ref;
+    TotalSize += PackageList->PackageLength;
+
+    UINT8* Ptr = (UINT8*)(PackageList + 1);
+    UINT8* End = (UINT8*)PackageList + PackageList->PackageLength;
+    while ((Ptr < End) && !EFI_ERROR(Status)) {
+      EFI_HII_PACKAGE_HEADER* Package = (EFI_HII_PACKAGE_HEADER*)Ptr;
+      if (Package->Length < sizeof(EFI_HII_PACKAGE_HEADER)) {
+        break;
+      }
+      Ptr += Package->Length;
+
+      UINT32 Crc = 0;
+      gBS->CalculateCrc32(Package, Package->Length, &Crc);
+      UINTN Slot;
+      UINTN Index = FindPackage(Packages, PackageData, Table, TableSize, Package, Crc, &Slot);
+      if (Index == MAX_UINTN) {
+        // New unique package
+        Index = PackageCount++;
+        Table[Slot] = (UINT32)(Index + 1);
+        PackageData[Index] = Package;
+        Packages[Index].Offset = Offset;
+        Packages[Index].Size = Package->Length;
+        Packages[Index].Crc32 = Crc;
+        Packages[Index].Type = (UINT8)Package->Type;
+
+        UINTN CompressedSize = LzssCompress(&Lzss, (UINT8*)Package, Package->Length, Compressed);
+        if (CompressedSize != 0) {
+          Packages[Index].Compression = HII_ARCHIVE_LZSS;
+          Packages[Index].StoredSize = (UINT32)CompressedSize;
+          Status = WriteArchive(&Writer, Compressed, CompressedSize);
+        } else {
+          Packages[Index].Compression = HII_ARCHIVE_STORED;
+          Packages[Index].StoredSize = Package->Length;
+          Status = WriteArchive(&Writer, Package, Package->Length);
+        }
+        Offset += Packages[Index].StoredSize;
+      }
+      Packages[Index].RefCount++;
+      Refs[Ref++] = (UINT32)Index;
+      Lists[i].PackageCount++;
+    }
+  }
+
+  if (!EFI_ERROR(Status)) {
+    Status = WriteArchive(&Writer, Packages, PackageCount * sizeof(HII_ARCHIVE_PACKAGE));
+  }
+  if (!EFI_ERROR(Status)) {
+    Status = WriteArchive(&Writer, Lists, ListCount * sizeof(HII_ARCHIVE_LIST));
+  }
+  if (!EFI_ERROR(Status)) {
+    Status = WriteArchive(&Writer, Refs, RefCount * sizeof(UINT32));
+  }
+  if (!EFI_ERROR(Status)) {
+    Status = FlushArchive(&Writer);
+  }
+  if (!EFI_ERROR(Status)) {
+    Header.Signature = HII_ARCHIVE_SIGNATURE;
+    Header.Version = HII_ARCHIVE_VERSION;
+    Header.ListCount = (UINT32)ListCount;
+    Header.PackageCount = (UINT32)PackageCount;
+    Header.RefCount = (UINT32)RefCount;
+    Header.IndexOffset = Offset;
+    Status = ShellSetFilePosition(Writer.FileHandle, 0);
+    if (!EFI_ERROR(Status)) {
+      Status = WriteArchive(&Writer, &Header, sizeof(Header));
+    }
+    if (!EFI_ERROR(Status)) {
+      Status = FlushArchive(&Writer);
+    }
+  }
+
+  if (!EFI_ERROR(Status)) {
+    UINT64 ArchiveSize = Offset + PackageCount * sizeof(HII_ARCHIVE_PACKAGE) +
+                         ListCount * sizeof(HII_ARCHIVE_LIST) + RefCount * sizeof(UINT32);
+    Print(L"%d package lists with %d packages (%d unique) were saved to %s\n", ListCount, RefCount, PackageCount, FileName);
+    Print(L"Size: 0x%lx -> 0x%lx bytes\n", TotalSize, ArchiveSize);
+  } else {
+    Print(L"Error! Can't write archive: %r\n", Status);
+  }
+
+Done:
+  if (Writer.FileHandle != NULL) {
+    ShellCloseFile(&Writer.FileHandle);
+  }
+  if (Writer.Buffer != NULL) {
+    FreePool(Writer.Buffer);
+  }
+  if (Lzss.Head != NULL) {
+    FreePool(Lzss.Head);
+  }
+  if (Lzss.Prev != NULL) {
+    FreePool(Lzss.Prev);
+  }
+  if (Compressed != NULL) {
+    FreePool(Compressed);
+  }
+  if (Table != NULL) {
+    FreePool(Table);
+  }
+  if (PackageData != NULL) {
+    FreePool(PackageData);
+  }
+  if (Packages != NULL) {
+    FreePool(Packages);
+  }
+  if (Refs != NULL) {
+    FreePool(Refs);
+  }
+  if (Lists != NULL) {
+    FreePool(Lists);
+  }
+  return Status;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __HII_ARCHIVE_H__
+#define __HII_ARCHIVE_H__
+
+#include <Uefi.h>
+
+//
+// Archive file layout:
+//   HII_ARCHIVE_HEADER
+//   package data, every unique package is stored once, packages follow each other without padding
+//   HII_ARCHIVE_PACKAGE[PackageCount] (at IndexOffset)
+//   HII_ARCHIVE_LIST[ListCount]
+//   UINT32[RefCount] - package indexes of all package lists, list i uses FirstRef..FirstRef + PackageCount - 1
+// Package list is restored as EFI_HII_PACKAGE_LIST_HEADER followed by its packages (including the END package).
+// Use scripts/hii_archive.py to list/extract the package lists on the host.
+//
+#define HII_ARCHIVE_SIGNATURE  SIGNATURE_64('H','I','I','_','A','R','C','H')
+#define HII_ARCHIVE_VERSION    1
+
+#define HII_ARCHIVE_STORED  0
+#define HII_ARCHIVE_LZSS    1   // See HiiArchive.c for the format
+
+#pragma pack(1)
+typedef struct {
+  UINT64 Signature;
+  UINT32 Version;
+  UINT32 ListCount;
+  UINT32 PackageCount;
+  UINT32 RefCount;
+  UINT64 IndexOffset;
+} HII_ARCHIVE_HEADER;
+
+typedef struct {
+  UINT64 Offset;          // Package data offset from the start of the file
+  UINT32 StoredSize;
+  UINT32 Size;            // Size of the package after decompression
+  UINT32 Crc32;           // CRC32 of the decompressed package
+  UINT32 RefCount;        // Number of references from the package lists
+  UINT8  Type;            // EFI_HII_PACKAGE_*
+  UINT8  Compression;     // HII_ARCHIVE_STORED or HII_ARCHIVE_LZSS
+  UINT16 Reserved;
+} HII_ARCHIVE_PACKAGE;
+
+typedef struct {
+  EFI_GUID Guid;
+  UINT32   FirstRef;
+  UINT32   PackageCount;
+} HII_ARCHIVE_LIST;
+#pragma pack()
+
+/**
+  Save all package lists from HiiDbIndexLib as a single archive file.
+**/
+EFI_STATUS
+SaveHiiArchive (
+  IN CHAR16  *FileName
+  );
+
+#endif
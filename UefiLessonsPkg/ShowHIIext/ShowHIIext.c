@@ -8,15 +8,37 @@
 #include <Library/UefiLib.h>
 
 #include <Protocol/HiiDatabase.h>
-#include <Library/MemoryAllocationLib.h>
 #include <Library/ShellLib.h>
 #include <Library/PrintLib.h>
 #include <Library/HiiLib.h>
+#include <Library/HiiDbIndexLib.h>
+#include <Library/IfrIndexLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BaseMemoryLib.h>
+
+#include "HiiArchive.h"
 
 GLOBAL_REMOVE_IF_UNREFERENCED EFI_STRING_ID mStringHelpTokenId = STRING_TOKEN(STR_HELP);
 
+#define MANIFEST_FILE_NAME  L"hii_manifest.txt"
+#define MANIFEST_NAME_SIZE  64
+
+typedef struct {
+  CHAR8    Key[MANIFEST_NAME_SIZE];
+  CHAR8    FileName[MANIFEST_NAME_SIZE];
+  UINT32   Size;
+  UINT32   Crc;
+  BOOLEAN  Present;
+} MANIFEST_ENTRY;
+
 BOOLEAN savePackageLists = FALSE;
+BOOLEAN saveIncremental = FALSE;
 UINTN savePackageIndex = 0xffffffff; // ALL
+BOOLEAN showQuestions = FALSE;
+CHAR16* questionsFileName = NULL;
+CHAR16* archiveFileName = NULL;
+CHAR16* ownerVarStoreName = NULL;
+UINTN ownerOffset = 0;
 
 EFI_STATUS WriteFile(CHAR16* FileName, VOID* Data, UINTN* Size)
 {
@@ -86,44 +108,447 @@ CHAR16* PackageType(UINTN Type)
   return L"UNKNOWN";
 }
 
-VOID ParseHiiPackageLists(EFI_HII_PACKAGE_LIST_HEADER* HiiDatabase, UINTN HiiDatabaseSize)
-{
-  EFI_HII_PACKAGE_LIST_HEADER* HiiPackageListHeader;
-  HiiPackageListHeader = (EFI_HII_PACKAGE_LIST_HEADER*) HiiDatabase;
-
-  UINTN i=0;
-  while ((UINTN) HiiPackageListHeader < ((UINTN) HiiDatabase + HiiDatabaseSize)) {
-    UINTN HiiPackageListSize = HiiPackageListHeader->PackageLength;
-    if (HiiPackageListSize == 0)
-      break;
-    if (savePackageLists) {
-      if ((savePackageIndex == 0xFFFFFFFF) || (savePackageIndex == i)) {
-        CHAR16 FileName[100];
-        UnicodeSPrint(FileName, 100, L"%04d_%g", i, HiiPackageListHeader->PackageListGuid);
-        UINTN ToWrite = HiiPackageListSize;
-        EFI_STATUS Status = WriteFile(FileName, HiiPackageListHeader, &ToWrite);
-        if (EFI_ERROR(Status)) {
-          Print(L"Error! Failed to write PackageList %d\n", i);
+VOID PackageListFileName(UINTN Index, CHAR16* FileName)
+{
+  EFI_HII_PACKAGE_LIST_HEADER* HiiPackageListHeader = HiiDbIndexGetList(Index)->PackageList;
+  UnicodeSPrint(FileName, MANIFEST_NAME_SIZE * sizeof(CHAR16), L"%04d_%g", Index, HiiPackageListHeader->PackageListGuid);
+}
+
+//
+// Manifest key is "<GUID>_<instance>", where instance is the index among the package lists with
+// the same GUID. Unlike the database index it doesn't change when other package lists are
+// added or removed, so the entries of the unchanged lists are still found on the next run.
+//
+VOID PackageListKey(UINTN Index, CHAR8* Key)
+{
+  CONST HII_DB_PACKAGE_LIST* List = HiiDbIndexGetList(Index);
+  EFI_HII_PACKAGE_LIST_HEADER* HiiPackageListHeader = List->PackageList;
+  CONST HII_DB_PACKAGE_LIST* SameGuidList;
+  UINTN Instance = 0;
+  while (((SameGuidList = HiiDbIndexFindByGuid(&HiiPackageListHeader->PackageListGuid, Instance)) != NULL) && (SameGuidList != List)) {
+    Instance++;
+  }
+  AsciiSPrint(Key, MANIFEST_NAME_SIZE, "%g_%d", HiiPackageListHeader->PackageListGuid, Instance);
+}
+
+EFI_STATUS SavePackageList(UINTN Index, EFI_HII_PACKAGE_LIST_HEADER* HiiPackageListHeader)
+{
+  CHAR16 FileName[MANIFEST_NAME_SIZE];
+  PackageListFileName(Index, FileName);
+  UINTN ToWrite = HiiPackageListHeader->PackageLength;
+  EFI_STATUS Status = WriteFile(FileName, HiiPackageListHeader, &ToWrite);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Failed to write PackageList %d\n", Index);
+  }
+  return Status;
+}
+
+EFI_STATUS ReadFile(CHAR16* FileName, CHAR8** Data, UINTN* Size)
+{
+  SHELL_FILE_HANDLE FileHandle;
+  EFI_STATUS Status = ShellOpenFileByName(FileName, &FileHandle, EFI_FILE_MODE_READ, 0);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  UINT64 FileSize;
+  Status = ShellGetFileSize(FileHandle, &FileSize);
+  if (!EFI_ERROR(Status)) {
+    // Extra byte for the null terminator
+    *Data = AllocateZeroPool((UINTN)FileSize + 1);
+    if (*Data != NULL) {
+      *Size = (UINTN)FileSize;
+      Status = ShellReadFile(FileHandle, Size, *Data);
+      if (EFI_ERROR(Status) || (*Size != FileSize)) {
+        FreePool(*Data);
+        Status = EFI_ERROR(Status) ? Status : EFI_VOLUME_CORRUPTED;
+      }
+    } else {
+      Status = EFI_OUT_OF_RESOURCES;
+    }
+  }
+  ShellCloseFile(&FileHandle);
+  return Status;
+}
+
+//
+// Manifest has one "<key> <file name> <size> <CRC32>" line per saved package list
+//
+EFI_STATUS ReadManifest(MANIFEST_ENTRY** Entries, UINTN* EntryCount)
+{
+  *Entries = NULL;
+  *EntryCount = 0;
+
+  CHAR8* Data;
+  UINTN Size;
+  EFI_STATUS Status = ReadFile(MANIFEST_FILE_NAME, &Data, &Size);
+  if (Status == EFI_NOT_FOUND) {
+    return EFI_SUCCESS;
+  } else if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't read %s: %r\n", MANIFEST_FILE_NAME, Status);
+    return Status;
+  }
+
+  UINTN LineCount = 0;
+  for (UINTN i = 0; i < Size; i++) {
+    if (Data[i] == '\n') {
+      LineCount++;
+    }
+  }
+  *Entries = AllocateZeroPool(MAX(LineCount, 1) * sizeof(MANIFEST_ENTRY));
+  if (*Entries == NULL) {
+    FreePool(Data);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CHAR8* Line = Data;
+  for (UINTN i = 0; i < LineCount; i++) {
+    CHAR8* Fields[4];
+    UINTN FieldCount = 0;
+    CHAR8* Ptr = Line;
+    while ((*Ptr != '\n') && (*Ptr != 0)) {
+      if (*Ptr == ' ') {
+        *Ptr = 0;
+      } else if (((Ptr == Line) || (*(Ptr - 1) == 0)) && (FieldCount < ARRAY_SIZE(Fields))) {
+        Fields[FieldCount++] = Ptr;
+      }
+      Ptr++;
+    }
+    *Ptr = 0;
+    Line = Ptr + 1;
+
+    MANIFEST_ENTRY* Entry = &(*Entries)[*EntryCount];
+    if ((FieldCount != ARRAY_SIZE(Fields)) ||
+        EFI_ERROR(AsciiStrCpyS(Entry->Key, MANIFEST_NAME_SIZE, Fields[0])) ||
+        EFI_ERROR(AsciiStrCpyS(Entry->FileName, MANIFEST_NAME_SIZE, Fields[1]))) {
+      continue;
+    }
+    Entry->Size = (UINT32)AsciiStrHexToUintn(Fields[2]);
+    Entry->Crc = (UINT32)AsciiStrHexToUintn(Fields[3]);
+    (*EntryCount)++;
+  }
+
+  FreePool(Data);
+  return EFI_SUCCESS;
+}
+
+BOOLEAN FileNameInUse(CHAR8* FileName, CHAR8 (*FileNames)[MANIFEST_NAME_SIZE], UINTN Count)
+{
+  for (UINTN i = 0; i < Count; i++) {
+    if (!AsciiStrCmp(FileNames[i], FileName)) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+//
+// Save all package lists as "<index>_<GUID>" files and write the manifest. In the incremental
+// mode the package lists that are in the manifest of the previous run with the same size/CRC32
+// are not saved again, their manifest entries keep the file names of the previous run.
+//
+EFI_STATUS SavePackageLists(BOOLEAN Incremental)
+{
+  //
+  // The manifest of the previous run is read in both modes to delete the files it refers to,
+  // that are not used anymore
+  //
+  MANIFEST_ENTRY* Entries = NULL;
+  UINTN EntryCount = 0;
+  EFI_STATUS Status = ReadManifest(&Entries, &EntryCount);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  UINTN ListCount = HiiDbIndexGetListCount();
+  UINTN ManifestSize = ListCount * (2 * MANIFEST_NAME_SIZE + 20) + 1;
+  CHAR8* Manifest = AllocatePool(ManifestSize);
+  MANIFEST_ENTRY** ListEntries = AllocateZeroPool(MAX(ListCount, 1) * sizeof(MANIFEST_ENTRY*));
+  CHAR8 (*FileNames)[MANIFEST_NAME_SIZE] = AllocateZeroPool(MAX(ListCount, 1) * MANIFEST_NAME_SIZE);
+  if ((Manifest == NULL) || (ListEntries == NULL) || (FileNames == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  UINTN NewCount = 0;
+  UINTN ChangedCount = 0;
+  UINTN UnchangedCount = 0;
+  for (UINTN i = 0; i < ListCount; i++) {
+    EFI_HII_PACKAGE_LIST_HEADER* PackageList = HiiDbIndexGetList(i)->PackageList;
+    UINT32 Crc = 0;
+    gBS->CalculateCrc32(PackageList, PackageList->PackageLength, &Crc);
+
+    CHAR8 Key[MANIFEST_NAME_SIZE];
+    PackageListKey(i, Key);
+    MANIFEST_ENTRY* Entry = NULL;
+    for (UINTN j = 0; j < EntryCount; j++) {
+      if (!AsciiStrCmp(Entries[j].Key, Key)) {
+        Entry = &Entries[j];
+        Entry->Present = TRUE;
+        break;
+      }
+    }
+
+    CHAR16 FileName[MANIFEST_NAME_SIZE];
+    if (Entry == NULL) {
+      NewCount++;
+    } else if (Incremental && (Entry->Size == PackageList->PackageLength) && (Entry->Crc == Crc) &&
+               !EFI_ERROR(AsciiStrToUnicodeStrS(Entry->FileName, FileName, MANIFEST_NAME_SIZE)) &&
+               !EFI_ERROR(ShellFileExists(FileName))) {
+      UnchangedCount++;
+      ListEntries[i] = Entry;
+    } else {
+      ChangedCount++;
+    }
+  }
+
+  //
+  // The file of an unchanged list can have the name of a list that is saved now, if the lists
+  // with the same GUID have moved in the database. Save such unchanged list again as well.
+  //
+  BOOLEAN Moved;
+  do {
+    Moved = FALSE;
+    for (UINTN i = 0; i < ListCount; i++) {
+      if (ListEntries[i] != NULL) {
+        continue;
+      }
+      CHAR16 FileName[MANIFEST_NAME_SIZE];
+      CHAR8 AsciiFileName[MANIFEST_NAME_SIZE];
+      PackageListFileName(i, FileName);
+      UnicodeStrToAsciiStrS(FileName, AsciiFileName, MANIFEST_NAME_SIZE);
+      for (UINTN j = 0; j < ListCount; j++) {
+        if ((ListEntries[j] != NULL) && !AsciiStrCmp(ListEntries[j]->FileName, AsciiFileName)) {
+          ListEntries[j] = NULL;
+          Moved = TRUE;
         }
       }
     }
-    if (!savePackageLists)
-      Print(L"PackageList[%d]: GUID=%g; size=0x%X\n", i, HiiPackageListHeader->PackageListGuid, HiiPackageListHeader->PackageLength);
-    i++;
+  } while (Moved);
+
+  UINTN Length = 0;
+  UINTN SavedCount = 0;
+  for (UINTN i = 0; i < ListCount; i++) {
+    EFI_HII_PACKAGE_LIST_HEADER* PackageList = HiiDbIndexGetList(i)->PackageList;
+    UINT32 Crc = 0;
+    gBS->CalculateCrc32(PackageList, PackageList->PackageLength, &Crc);
+
+    if (ListEntries[i] != NULL) {
+      AsciiStrCpyS(FileNames[i], MANIFEST_NAME_SIZE, ListEntries[i]->FileName);
+    } else {
+      CHAR16 FileName[MANIFEST_NAME_SIZE];
+      PackageListFileName(i, FileName);
+      UnicodeStrToAsciiStrS(FileName, FileNames[i], MANIFEST_NAME_SIZE);
+      if (EFI_ERROR(SavePackageList(i, PackageList))) {
+        // Don't add the list to the manifest, so it is saved again on the next run
+        continue;
+      }
+      SavedCount++;
+    }
+
+    CHAR8 Key[MANIFEST_NAME_SIZE];
+    PackageListKey(i, Key);
+    Length += AsciiSPrint(&Manifest[Length], ManifestSize - Length, "%a %a %x %08x\n", Key, FileNames[i], PackageList->PackageLength, Crc);
+  }
+
+  UINTN RemovedCount = 0;
+  for (UINTN i = 0; i < EntryCount; i++) {
+    if (!Entries[i].Present) {
+      if (Incremental) {
+        Print(L"Removed: %a\n", Entries[i].Key);
+      }
+      RemovedCount++;
+    }
+    // The file of the removed or moved package list is not in the new manifest, don't leave it behind
+    if (!FileNameInUse(Entries[i].FileName, FileNames, ListCount)) {
+      CHAR16 FileName[MANIFEST_NAME_SIZE];
+      AsciiStrToUnicodeStrS(Entries[i].FileName, FileName, MANIFEST_NAME_SIZE);
+      Status = ShellDeleteFileByName(FileName);
+      if (EFI_ERROR(Status) && (Status != EFI_NOT_FOUND)) {
+        Print(L"Error! Can't delete %s: %r\n", FileName, Status);
+      }
+    }
+  }
 
-    EFI_HII_PACKAGE_HEADER* HiiPackageHeader = (EFI_HII_PACKAGE_HEADER*)((UINTN) HiiPackageListHeader + sizeof(EFI_HII_PACKAGE_LIST_HEADER));
-    UINTN j=0;
-    while ((UINTN) HiiPackageHeader < ((UINTN) HiiPackageListHeader + HiiPackageListSize)) {
-      if (!savePackageLists)
-        Print(L"\tPackage[%d]: type=%s; size=0x%X\n", j++, PackageType(HiiPackageHeader->Type), HiiPackageHeader->Length);
+  if (Incremental) {
+    Print(L"%d new, %d changed, %d unchanged, %d removed package lists\n", NewCount, ChangedCount, UnchangedCount, RemovedCount);
+  }
 
-      // Go to next Package
-      HiiPackageHeader = (EFI_HII_PACKAGE_HEADER*)((UINTN) HiiPackageHeader + HiiPackageHeader->Length);
+  Status = EFI_SUCCESS;
+  if ((SavedCount + RemovedCount) != 0) {
+    Status = WriteFile(MANIFEST_FILE_NAME, Manifest, &Length);
+  }
+
+Done:
+  if (Manifest != NULL) {
+    FreePool(Manifest);
+  }
+  if (ListEntries != NULL) {
+    FreePool(ListEntries);
+  }
+  if (FileNames != NULL) {
+    FreePool(FileNames);
+  }
+  if (Entries != NULL) {
+    FreePool(Entries);
+  }
+  return Status;
+}
+
+VOID ParseHiiPackageList(UINTN Index, EFI_HII_PACKAGE_LIST_HEADER* HiiPackageListHeader)
+{
+  UINTN HiiPackageListSize = HiiPackageListHeader->PackageLength;
+  Print(L"PackageList[%d]: GUID=%g; size=0x%X\n", Index, HiiPackageListHeader->PackageListGuid, HiiPackageListHeader->PackageLength);
+
+  EFI_HII_PACKAGE_HEADER* HiiPackageHeader = (EFI_HII_PACKAGE_HEADER*)((UINTN) HiiPackageListHeader + sizeof(EFI_HII_PACKAGE_LIST_HEADER));
+  UINTN j=0;
+  while ((UINTN) HiiPackageHeader < ((UINTN) HiiPackageListHeader + HiiPackageListSize)) {
+    Print(L"\tPackage[%d]: type=%s; size=0x%X\n", j++, PackageType(HiiPackageHeader->Type), HiiPackageHeader->Length);
+
+    // Go to next Package
+    HiiPackageHeader = (EFI_HII_PACKAGE_HEADER*)((UINTN) HiiPackageHeader + HiiPackageHeader->Length);
+  }
+
+  CONST IFR_FORMSET* FormSet;
+  for (UINTN i = 0; (FormSet = IfrIndexFindFormSetInList(Index, i)) != NULL; i++) {
+    Print(L"\tFormSet: GUID=%g; questions=%d\n", FormSet->Guid, FormSet->QuestionCount);
+  }
+}
+
+CHAR8* QuestionType(UINT8 OpCode)
+{
+  switch(OpCode) {
+    case EFI_IFR_CHECKBOX_OP:
+      return "CHECKBOX";
+    case EFI_IFR_ONE_OF_OP:
+      return "ONE_OF";
+    case EFI_IFR_NUMERIC_OP:
+      return "NUMERIC";
+    case EFI_IFR_STRING_OP:
+      return "STRING";
+    case EFI_IFR_PASSWORD_OP:
+      return "PASSWORD";
+    case EFI_IFR_ORDERED_LIST_OP:
+      return "ORDERED_LIST";
+    case EFI_IFR_DATE_OP:
+      return "DATE";
+    case EFI_IFR_TIME_OP:
+      return "TIME";
+    case EFI_IFR_ACTION_OP:
+      return "ACTION";
+    case EFI_IFR_REF_OP:
+      return "REF";
+  }
+  return "UNKNOWN";
+}
+
+UINTN FormatQuestion(CONST IFR_QUESTION* Question, CHAR8* Buffer, UINTN BufferSize)
+{
+  CONST IFR_FORMSET* FormSet = IfrIndexGetFormSet(Question->FormSet);
+  EFI_STRING Prompt = HiiGetString(HiiDbIndexGetList(FormSet->PackageList)->Handle, Question->Prompt, NULL);
+
+  UINTN Length = AsciiSPrint(Buffer, BufferSize, "%g 0x%04x form=0x%04x %a",
+                             FormSet->Guid,
+                             Question->QuestionId,
+                             Question->FormId,
+                             QuestionType(Question->OpCode));
+  if (Question->VarStore != IFR_INDEX_NOT_FOUND) {
+    CONST IFR_VARSTORE* VarStore = IfrIndexGetVarStore(Question->VarStore);
+    if (Question->Flags & IFR_QUESTION_BIT_FIELD) {
+      Length += AsciiSPrint(&Buffer[Length], BufferSize - Length, " %a bit=%d:%d",
+                            VarStore->Name, Question->BitOffset, Question->BitWidth);
+    } else {
+      Length += AsciiSPrint(&Buffer[Length], BufferSize - Length, " %a offset=0x%x width=%d",
+                            VarStore->Name, Question->Offset, Question->Width);
     }
+  }
+  for (UINTN i = 0; i < Question->DefaultCount; i++) {
+    Length += AsciiSPrint(&Buffer[Length], BufferSize - Length, " default[%d]=0x%lx",
+                          Question->Defaults[i].DefaultId, Question->Defaults[i].Value);
+  }
+  Length += AsciiSPrint(&Buffer[Length], BufferSize - Length, " \"%s\"\n", (Prompt != NULL) ? Prompt : L"");
 
-    // Go to next PackageList
-    HiiPackageListHeader = (EFI_HII_PACKAGE_LIST_HEADER*)((UINTN) HiiPackageListHeader + HiiPackageListSize);
+  if (Prompt != NULL) {
+    FreePool(Prompt);
   }
+  return Length;
+}
+
+EFI_STATUS ShowQuestions(CHAR16* FileName)
+{
+  CHAR8 Line[512];
+  CHAR8* Buffer = NULL;
+  UINTN BufferSize = 0;
+  UINTN Size = 0;
+
+  UINTN QuestionCount = IfrIndexGetQuestionCount();
+  for (UINTN i = 0; i < QuestionCount; i++) {
+    UINTN Length = FormatQuestion(IfrIndexGetQuestion(i), Line, sizeof(Line));
+    if (FileName == NULL) {
+      Print(L"%a", Line);
+      continue;
+    }
+
+    if (Size + Length > BufferSize) {
+      UINTN NewSize = MAX(BufferSize * 2, Size + Length);
+      CHAR8* NewBuffer = ReallocatePool(BufferSize, NewSize, Buffer);
+      if (NewBuffer == NULL) {
+        Print(L"Error! Can't allocate memory for the questions\n");
+        if (Buffer != NULL) {
+          FreePool(Buffer);
+        }
+        return EFI_OUT_OF_RESOURCES;
+      }
+      Buffer = NewBuffer;
+      BufferSize = NewSize;
+    }
+    CopyMem(&Buffer[Size], Line, Length);
+    Size += Length;
+  }
+
+  if (FileName == NULL) {
+    Print(L"Total: %d questions in %d formsets, %d varstores\n",
+          QuestionCount, IfrIndexGetFormSetCount(), IfrIndexGetVarStoreCount());
+    return EFI_SUCCESS;
+  }
+
+  EFI_STATUS Status = WriteFile(FileName, Buffer, &Size);
+  if (Buffer != NULL) {
+    FreePool(Buffer);
+  }
+  return Status;
+}
+
+EFI_STATUS ShowOwners(CHAR16* VarStoreName, UINTN Offset)
+{
+  CHAR8 Name[IFR_VARSTORE_NAME_SIZE];
+  EFI_STATUS Status = UnicodeStrToAsciiStrS(VarStoreName, Name, sizeof(Name));
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Wrong varstore name: %r\n", Status);
+    return Status;
+  }
+
+  // Varstores with the same name can have different GUIDs
+  CHAR8 Line[512];
+  BOOLEAN Found = FALSE;
+  for (UINTN i = 0; i < IfrIndexGetVarStoreCount(); i++) {
+    CONST IFR_VARSTORE* VarStore = IfrIndexGetVarStore(i);
+    if (AsciiStrCmp(VarStore->Name, Name)) {
+      continue;
+    }
+    Print(L"VarStore %a %g: size=0x%x; questions=%d\n", VarStore->Name, VarStore->Guid, VarStore->Size, VarStore->QuestionCount);
+    CONST IFR_QUESTION* Question;
+    for (UINTN j = 0; (Question = IfrIndexFindOwner(i, Offset, j)) != NULL; j++) {
+      FormatQuestion(Question, Line, sizeof(Line));
+      Print(L"\t%a", Line);
+    }
+    Found = TRUE;
+  }
+  if (!Found) {
+    Print(L"Error! There is no varstore %s\n", VarStoreName);
+    return EFI_NOT_FOUND;
+  }
+  return EFI_SUCCESS;
 }
 
 VOID Usage()
@@ -153,7 +578,10 @@ INTN EFIAPI ShellAppMain(IN UINTN Argc, IN CHAR16 **Argv)
       continue;
     if (!StrCmp(Argv[i], L"save")) {
       savePackageLists = TRUE;
-      if (((i + 1) < Argc) && ((i + 1) != bOptionIndex) && ((i + 1) != hOptionIndex)) {
+      if (((i + 1) < Argc) && !StrCmp(Argv[i + 1], L"-i")) {
+        saveIncremental = TRUE;
+        i += 1;
+      } else if (((i + 1) < Argc) && ((i + 1) != bOptionIndex) && ((i + 1) != hOptionIndex)) {
         CHAR16* EndPointer;
         Status = StrDecimalToUintnS(Argv[i + 1], &EndPointer, &savePackageIndex);
         if (EFI_ERROR(Status) || (EndPointer == Argv[i + 1])) {
@@ -162,55 +590,78 @@ INTN EFIAPI ShellAppMain(IN UINTN Argc, IN CHAR16 **Argv)
         }
         i += 1;
       }
+    } else if (!StrCmp(Argv[i], L"archive")) {
+      if ((i + 1) >= Argc) {
+        Usage();
+        return EFI_INVALID_PARAMETER;
+      }
+      archiveFileName = Argv[i + 1];
+      i += 1;
+    } else if (!StrCmp(Argv[i], L"questions")) {
+      showQuestions = TRUE;
+      if (((i + 1) < Argc) && ((i + 1) != bOptionIndex) && ((i + 1) != hOptionIndex)) {
+        questionsFileName = Argv[i + 1];
+        i += 1;
+      }
+    } else if (!StrCmp(Argv[i], L"owner")) {
+      if ((i + 2) >= Argc) {
+        Usage();
+        return EFI_INVALID_PARAMETER;
+      }
+      ownerVarStoreName = Argv[i + 1];
+      ownerOffset = ShellStrToUintn(Argv[i + 2]);
+      i += 2;
     } else {
       Usage();
       return EFI_INVALID_PARAMETER;
     }
   }
 
-  EFI_HII_DATABASE_PROTOCOL* HiiDbProtocol;
-  Status = gBS->LocateProtocol(&gEfiHiiDatabaseProtocolGuid,
-                               NULL,
-                               (VOID**)&HiiDbProtocol);
+  Status = HiiDbIndexInit();
   if (EFI_ERROR(Status)) {
-    Print(L"ERROR: Could not find HII Database protocol: %r\n", Status);
+    Print(L"ERROR: Could not export HII database: %r\n", Status);
     return Status;
   }
 
-  UINTN PackageListSize = 0;
-  EFI_HII_PACKAGE_LIST_HEADER* PackageList = NULL;
+  if (archiveFileName != NULL) {
+    return SaveHiiArchive(archiveFileName);
+  }
 
-  Status = HiiDbProtocol->ExportPackageLists(HiiDbProtocol,
-                                             NULL,		// All package lists
-                                             &PackageListSize,
-                                             PackageList);
-  if (Status != EFI_BUFFER_TOO_SMALL) {
-    Print(L"ERROR: Could not obtain package list size\n");
-    return Status;
+  if (showQuestions || (ownerVarStoreName != NULL)) {
+    Status = IfrIndexInit();
+    if (EFI_ERROR(Status)) {
+      Print(L"ERROR: Could not parse FORMS packages: %r\n", Status);
+      return Status;
+    }
+    if (showQuestions) {
+      return ShowQuestions(questionsFileName);
+    }
+    return ShowOwners(ownerVarStoreName, ownerOffset);
   }
 
-  Status = gBS->AllocatePool(EfiBootServicesData,
-                             PackageListSize,
-                             (VOID**)&PackageList);
-  if (EFI_ERROR(Status)) {
-    Print(L"ERROR: Could not allocate sufficient memory for package list: %r\n", Status);
-    return Status;
+  UINTN ListCount = HiiDbIndexGetListCount();
+  if (savePackageLists && (savePackageIndex != 0xFFFFFFFF)) {
+    // Single package list is taken directly from the index
+    if (savePackageIndex >= ListCount) {
+      Print(L"Error! There is no PackageList %d\n", savePackageIndex);
+      return EFI_INVALID_PARAMETER;
+    }
+    SavePackageList(savePackageIndex, HiiDbIndexGetList(savePackageIndex)->PackageList);
+    return EFI_SUCCESS;
   }
 
+  if (savePackageLists) {
+    return SavePackageLists(saveIncremental);
+  }
 
-  Status = HiiDbProtocol->ExportPackageLists(HiiDbProtocol,
-                                             NULL,
-                                             &PackageListSize,
-                                             PackageList);
+  // Formsets are shown only in the package list output, so IFR is parsed only here
+  Status = IfrIndexInit();
   if (EFI_ERROR(Status)) {
-    Print(L"ERROR: Could not retrieve the package list: %r\n", Status);
-    FreePool(PackageList);
-    return Status;
+    Print(L"Error! Could not parse FORMS packages, formsets are not shown: %r\n", Status);
+  }
+  for (UINTN i = 0; i < ListCount; i++) {
+    ParseHiiPackageList(i, HiiDbIndexGetList(i)->PackageList);
   }
-
-  ParseHiiPackageLists(PackageList, PackageListSize);
-
-  FreePool(PackageList);
 
   return EFI_SUCCESS;
 }
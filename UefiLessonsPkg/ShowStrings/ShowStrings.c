@@ -8,7 +8,182 @@
 #include <Library/UefiLib.h>
 #include <Library/HiiLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/PrintLib.h>
+#include <Library/HiiDbIndexLib.h>
+#include <Library/HiiStringDecoderLib.h>
+#include <Library/BenchmarkLib.h>
+#include <Library/SaveFileLib.h>
 
+#define STRING_BUFFER_SIZE  1024
+
+//
+// Get the string to the reusable buffer, the buffer grows only for the longer strings
+//
+EFI_STATUS GetString(HII_STRING_DECODER* Decoder, EFI_STRING_ID StringId, CHAR16** Buffer, UINTN* BufferSize)
+{
+  UINTN Size = *BufferSize;
+  EFI_STATUS Status = HiiStringDecoderGetString(Decoder, StringId, *Buffer, &Size);
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    CHAR16* NewBuffer = ReallocatePool(*BufferSize, Size, *Buffer);
+    if (NewBuffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    *Buffer = NewBuffer;
+    *BufferSize = Size;
+    Status = HiiStringDecoderGetString(Decoder, StringId, *Buffer, &Size);
+  }
+  return Status;
+}
+
+EFI_STATUS ShowStrings(HII_STRING_DECODER* Decoder)
+{
+  UINTN BufferSize = STRING_BUFFER_SIZE;
+  CHAR16* Buffer = AllocatePool(BufferSize);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  for (UINTN i = 1; i < Decoder->StringCount; i++) {
+    if (!EFI_ERROR(GetString(Decoder, (EFI_STRING_ID)i, &Buffer, &BufferSize))) {
+      Print(L"ID=%d, %s\n", i, Buffer);
+    }
+  }
+  FreePool(Buffer);
+  return EFI_SUCCESS;
+}
+
+//
+// Save the strings of all languages as a UCS2 text file, one "<language> <ID> <string>" line per string
+//
+EFI_STATUS ExportStrings(HII_STRING_DECODER* Decoders, UINTN DecoderCount, CHAR16* FileName)
+{
+  UINTN BufferSize = STRING_BUFFER_SIZE;
+  CHAR16* Buffer = AllocatePool(BufferSize);
+  UINTN FileBufferSize = SIZE_64KB;
+  CHAR16* FileBuffer = AllocatePool(FileBufferSize);
+  if ((Buffer == NULL) || (FileBuffer == NULL)) {
+    Print(L"Error! Can't allocate memory for the strings\n");
+    if (Buffer != NULL) {
+      FreePool(Buffer);
+    }
+    if (FileBuffer != NULL) {
+      FreePool(FileBuffer);
+    }
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  EFI_STATUS Status = EFI_SUCCESS;
+  UINTN Size = 0;
+  FileBuffer[Size++] = 0xFEFF;
+  UINTN StringCount = 0;
+  for (UINTN i = 0; (i < DecoderCount) && !EFI_ERROR(Status); i++) {
+    for (UINTN j = 1; j < Decoders[i].StringCount; j++) {
+      if (!HiiStringDecoderHasString(&Decoders[i], (EFI_STRING_ID)j)) {
+        continue;
+      }
+      Status = GetString(&Decoders[i], (EFI_STRING_ID)j, &Buffer, &BufferSize);
+      if (EFI_ERROR(Status)) {
+        break;
+      }
+
+      // Line prefix, the string itself and "\r\n"
+      UINTN Length = AsciiStrLen(Decoders[i].Language) + 8 + StrLen(Buffer) + 3;
+      if ((Size + Length) * sizeof(CHAR16) > FileBufferSize) {
+        UINTN NewSize = MAX(FileBufferSize * 2, (Size + Length) * sizeof(CHAR16));
+        CHAR16* NewBuffer = ReallocatePool(FileBufferSize, NewSize, FileBuffer);
+        if (NewBuffer == NULL) {
+          Status = EFI_OUT_OF_RESOURCES;
+          break;
+        }
+        FileBuffer = NewBuffer;
+        FileBufferSize = NewSize;
+      }
+      Size += UnicodeSPrint(&FileBuffer[Size], FileBufferSize - Size * sizeof(CHAR16), L"%a %d %s\r\n",
+                            Decoders[i].Language, j, Buffer);
+      StringCount++;
+    }
+  }
+
+  if (!EFI_ERROR(Status)) {
+    Print(L"%d strings in %d languages\n", StringCount, DecoderCount);
+    Size *= sizeof(CHAR16);
+    Status = SaveFile(FileName, FileBuffer, &Size);
+  } else {
+    Print(L"Error! Can't get strings: %r\n", Status);
+  }
+  FreePool(FileBuffer);
+  FreePool(Buffer);
+  return Status;
+}
+
+//
+// Compare the lookup of every string of the language with HiiGetString() and with the decoder
+//
+EFI_STATUS BenchmarkStrings(EFI_HII_HANDLE Handle, CONST EFI_HII_STRING_PACKAGE_HDR* Package)
+{
+  if (Handle == NULL) {
+    Print(L"Error! Package list has no HII handle\n");
+    return EFI_NOT_FOUND;
+  }
+
+  UINT64 Start = BenchmarkGetTicks();
+  HII_STRING_DECODER Decoder;
+  EFI_STATUS Status = HiiStringDecoderInit(&Decoder, Package);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't decode string package: %r\n", Status);
+    return Status;
+  }
+  UINT64 InitNs = BenchmarkTicksToNs(BenchmarkGetTicks() - Start);
+
+  UINTN BufferSize = STRING_BUFFER_SIZE;
+  CHAR16* Buffer = AllocatePool(BufferSize);
+  if (Buffer == NULL) {
+    HiiStringDecoderFree(&Decoder);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  UINTN HiiCount = 0;
+  Start = BenchmarkGetTicks();
+  for (UINTN i = 1; i < Decoder.StringCount; i++) {
+    EFI_STRING String = HiiGetString(Handle, (EFI_STRING_ID)i, Decoder.Language);
+    if (String != NULL) {
+      HiiCount++;
+      FreePool(String);
+    }
+  }
+  UINT64 HiiNs = BenchmarkTicksToNs(BenchmarkGetTicks() - Start);
+
+  UINTN DecoderCount = 0;
+  Start = BenchmarkGetTicks();
+  for (UINTN i = 1; i < Decoder.StringCount; i++) {
+    if (!EFI_ERROR(GetString(&Decoder, (EFI_STRING_ID)i, &Buffer, &BufferSize))) {
+      DecoderCount++;
+    }
+  }
+  UINT64 DecoderNs = BenchmarkTicksToNs(BenchmarkGetTicks() - Start);
+
+  Print(L"Language %a, string IDs 1..%d\n", Decoder.Language, Decoder.StringCount - 1);
+  Print(L"HiiGetString:  %d strings, %ld us, %ld ns/string\n", HiiCount, HiiNs / 1000, HiiNs / MAX(HiiCount, 1));
+  Print(L"Decoder init:  %ld us\n", InitNs / 1000);
+  Print(L"Decoder:       %d strings, %ld us, %ld ns/string\n", DecoderCount, DecoderNs / 1000, DecoderNs / MAX(DecoderCount, 1));
+  if (HiiCount != DecoderCount) {
+    Print(L"Error! String count mismatch\n");
+  }
+
+  FreePool(Buffer);
+  HiiStringDecoderFree(&Decoder);
+  return EFI_SUCCESS;
+}
+
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"  ShowStrings <Package GUID> [<language>] [-o <file>] [-t]\n");
+  Print(L"\n");
+  Print(L"  <language>  - Language to show, en-US by default\n");
+  Print(L"  -o <file>   - Save strings of all languages to the file\n");
+  Print(L"  -t          - Compare string lookup time with HiiGetString()\n");
+}
 
 INTN
 EFIAPI
@@ -17,9 +192,8 @@ ShellAppMain (
   IN CHAR16 **Argv
   )
 {
-  if (Argc != 2) {
-    Print(L"Usage:\n");
-    Print(L"  ShowStrings [Package GUID]\n");
+  if (Argc < 2) {
+    Usage();
     return EFI_INVALID_PARAMETER;
   }
 
@@ -30,14 +204,60 @@ ShellAppMain (
     return EFI_INVALID_PARAMETER;
   }
 
-  EFI_HII_HANDLE* Handle = HiiGetHiiHandles(&PackageGuid);
+  CHAR8 Language[32] = "en-US";
+  CHAR16* FileName = NULL;
+  BOOLEAN Benchmark = FALSE;
+  for (UINTN i = 2; i < Argc; i++) {
+    if (!StrCmp(Argv[i], L"-o") && ((i + 1) < Argc)) {
+      FileName = Argv[++i];
+    } else if (!StrCmp(Argv[i], L"-t")) {
+      Benchmark = TRUE;
+    } else if (Argv[i][0] != L'-') {
+      Status = UnicodeStrToAsciiStrS(Argv[i], Language, sizeof(Language));
+      if (EFI_ERROR(Status)) {
+        Usage();
+        return EFI_INVALID_PARAMETER;
+      }
+    } else {
+      Usage();
+      return EFI_INVALID_PARAMETER;
+    }
+  }
 
-  for (UINTN i=1; i<0xFFFF; i++) {
-    EFI_STRING String = HiiGetString(*Handle, i, "en-US");
-    if (String != NULL) {
-      Print(L"ID=%d, %s\n", i, String);
-      FreePool(String);
+  CONST HII_DB_PACKAGE_LIST* PackageList = HiiDbIndexFindByGuid(&PackageGuid, 0);
+  if (PackageList == NULL) {
+    Print(L"Error! There is no package list with GUID %g\n", &PackageGuid);
+    return EFI_NOT_FOUND;
+  }
+
+  HII_STRING_DECODER* Decoders;
+  UINTN DecoderCount;
+  Status = HiiStringDecoderInitPackageList(PackageList->PackageList, &Decoders, &DecoderCount);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't decode string packages: %r\n", Status);
+    return Status;
+  }
+
+  if (FileName != NULL) {
+    Status = ExportStrings(Decoders, DecoderCount, FileName);
+  } else {
+    Status = EFI_NOT_FOUND;
+    for (UINTN i = 0; i < DecoderCount; i++) {
+      if (AsciiStrCmp(Decoders[i].Language, Language)) {
+        continue;
+      }
+      if (Benchmark) {
+        Status = BenchmarkStrings(PackageList->Handle, Decoders[i].Package);
+      } else {
+        Status = ShowStrings(&Decoders[i]);
+      }
+      break;
+    }
+    if (Status == EFI_NOT_FOUND) {
+      Print(L"Error! There are no %a strings\n", Language);
     }
   }
-  return EFI_SUCCESS;
+
+  HiiStringDecoderFreeArray(Decoders, DecoderCount);
+  return Status;
 }
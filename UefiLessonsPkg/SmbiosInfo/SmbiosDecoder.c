@@ -0,0 +1,649 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/PrintLib.h>
+
+#include <Protocol/Smbios.h>
+#include <Guid/SmBios.h>
+
+#include "SmbiosDecoder.h"
+
+#define FIELD_BYTE(Offset, Name)         { Offset, SmbiosFieldByte,   1, Name }
+#define FIELD_WORD(Offset, Name)         { Offset, SmbiosFieldWord,   2, Name }
+#define FIELD_DWORD(Offset, Name)        { Offset, SmbiosFieldDword,  4, Name }
+#define FIELD_QWORD(Offset, Name)        { Offset, SmbiosFieldQword,  8, Name }
+#define FIELD_STRING(Offset, Name)       { Offset, SmbiosFieldString, 1, Name }
+#define FIELD_UUID(Offset, Name)         { Offset, SmbiosFieldUuid,   16, Name }
+#define FIELD_HANDLE(Offset, Name)       { Offset, SmbiosFieldHandle, 2, Name }
+#define FIELD_BYTES(Offset, Size, Name)  { Offset, SmbiosFieldBytes,  Size, Name }
+
+//
+// Field offsets are taken from the SMBIOS specification. Fields that follow
+// variable-length arrays (e.g. Type 3 SKU Number) are not described.
+//
+STATIC CONST SMBIOS_FIELD mType0Fields[] = {
+  FIELD_STRING(0x04, "Vendor"),
+  FIELD_STRING(0x05, "BiosVersion"),
+  FIELD_WORD  (0x06, "BiosSegment"),
+  FIELD_STRING(0x08, "BiosReleaseDate"),
+  FIELD_BYTE  (0x09, "BiosSize"),
+  FIELD_QWORD (0x0A, "BiosCharacteristics"),
+  FIELD_BYTES (0x12, 2, "BiosCharacteristicsExtensionBytes"),
+  FIELD_BYTE  (0x14, "SystemBiosMajorRelease"),
+  FIELD_BYTE  (0x15, "SystemBiosMinorRelease"),
+  FIELD_BYTE  (0x16, "EmbeddedControllerFirmwareMajorRelease"),
+  FIELD_BYTE  (0x17, "EmbeddedControllerFirmwareMinorRelease"),
+  FIELD_WORD  (0x18, "ExtendedBiosSize"),
+};
+
+STATIC CONST SMBIOS_FIELD mType1Fields[] = {
+  FIELD_STRING(0x04, "Manufacturer"),
+  FIELD_STRING(0x05, "ProductName"),
+  FIELD_STRING(0x06, "Version"),
+  FIELD_STRING(0x07, "SerialNumber"),
+  FIELD_UUID  (0x08, "UUID"),
+  FIELD_BYTE  (0x18, "WakeUpType"),
+  FIELD_STRING(0x19, "SKUNumber"),
+  FIELD_STRING(0x1A, "Family"),
+};
+
+STATIC CONST SMBIOS_FIELD mType2Fields[] = {
+  FIELD_STRING(0x04, "Manufacturer"),
+  FIELD_STRING(0x05, "ProductName"),
+  FIELD_STRING(0x06, "Version"),
+  FIELD_STRING(0x07, "SerialNumber"),
+  FIELD_STRING(0x08, "AssetTag"),
+  FIELD_BYTE  (0x09, "FeatureFlag"),
+  FIELD_STRING(0x0A, "LocationInChassis"),
+  FIELD_HANDLE(0x0B, "ChassisHandle"),
+  FIELD_BYTE  (0x0D, "BoardType"),
+  FIELD_BYTE  (0x0E, "NumberOfContainedObjectHandles"),
+};
+
+STATIC CONST SMBIOS_FIELD mType3Fields[] = {
+  FIELD_STRING(0x04, "Manufacturer"),
+  FIELD_BYTE  (0x05, "Type"),
+  FIELD_STRING(0x06, "Version"),
+  FIELD_STRING(0x07, "SerialNumber"),
+  FIELD_STRING(0x08, "AssetTag"),
+  FIELD_BYTE  (0x09, "BootupState"),
+  FIELD_BYTE  (0x0A, "PowerSupplyState"),
+  FIELD_BYTE  (0x0B, "ThermalState"),
+  FIELD_BYTE  (0x0C, "SecurityStatus"),
+  FIELD_DWORD (0x0D, "OemDefined"),
+  FIELD_BYTE  (0x11, "Height"),
+  FIELD_BYTE  (0x12, "NumberofPowerCords"),
+  FIELD_BYTE  (0x13, "ContainedElementCount"),
+  FIELD_BYTE  (0x14, "ContainedElementRecordLength"),
+};
+
+STATIC CONST SMBIOS_FIELD mType4Fields[] = {
+  FIELD_STRING(0x04, "Socket"),
+  FIELD_BYTE  (0x05, "ProcessorType"),
+  FIELD_BYTE  (0x06, "ProcessorFamily"),
+  FIELD_STRING(0x07, "ProcessorManufacturer"),
+  FIELD_BYTES (0x08, 8, "ProcessorId"),
+  FIELD_STRING(0x10, "ProcessorVersion"),
+  FIELD_BYTE  (0x11, "Voltage"),
+  FIELD_WORD  (0x12, "ExternalClock"),
+  FIELD_WORD  (0x14, "MaxSpeed"),
+  FIELD_WORD  (0x16, "CurrentSpeed"),
+  FIELD_BYTE  (0x18, "Status"),
+  FIELD_BYTE  (0x19, "ProcessorUpgrade"),
+  FIELD_HANDLE(0x1A, "L1CacheHandle"),
+  FIELD_HANDLE(0x1C, "L2CacheHandle"),
+  FIELD_HANDLE(0x1E, "L3CacheHandle"),
+  FIELD_STRING(0x20, "SerialNumber"),
+  FIELD_STRING(0x21, "AssetTag"),
+  FIELD_STRING(0x22, "PartNumber"),
+  FIELD_BYTE  (0x23, "CoreCount"),
+  FIELD_BYTE  (0x24, "EnabledCoreCount"),
+  FIELD_BYTE  (0x25, "ThreadCount"),
+  FIELD_WORD  (0x26, "ProcessorCharacteristics"),
+  FIELD_WORD  (0x28, "ProcessorFamily2"),
+  FIELD_WORD  (0x2A, "CoreCount2"),
+  FIELD_WORD  (0x2C, "EnabledCoreCount2"),
+  FIELD_WORD  (0x2E, "ThreadCount2"),
+  FIELD_WORD  (0x30, "ThreadEnabled"),
+  FIELD_STRING(0x32, "SocketType"),
+};
+
+STATIC CONST SMBIOS_FIELD mType7Fields[] = {
+  FIELD_STRING(0x04, "SocketDesignation"),
+  FIELD_WORD  (0x05, "CacheConfiguration"),
+  FIELD_WORD  (0x07, "MaximumCacheSize"),
+  FIELD_WORD  (0x09, "InstalledSize"),
+  FIELD_WORD  (0x0B, "SupportedSRAMType"),
+  FIELD_WORD  (0x0D, "CurrentSRAMType"),
+  FIELD_BYTE  (0x0F, "CacheSpeed"),
+  FIELD_BYTE  (0x10, "ErrorCorrectionType"),
+  FIELD_BYTE  (0x11, "SystemCacheType"),
+  FIELD_BYTE  (0x12, "Associativity"),
+  FIELD_DWORD (0x13, "MaximumCacheSize2"),
+  FIELD_DWORD (0x17, "InstalledSize2"),
+};
+
+STATIC CONST SMBIOS_FIELD mType8Fields[] = {
+  FIELD_STRING(0x04, "InternalReferenceDesignator"),
+  FIELD_BYTE  (0x05, "InternalConnectorType"),
+  FIELD_STRING(0x06, "ExternalReferenceDesignator"),
+  FIELD_BYTE  (0x07, "ExternalConnectorType"),
+  FIELD_BYTE  (0x08, "PortType"),
+};
+
+STATIC CONST SMBIOS_FIELD mType9Fields[] = {
+  FIELD_STRING(0x04, "SlotDesignation"),
+  FIELD_BYTE  (0x05, "SlotType"),
+  FIELD_BYTE  (0x06, "SlotDataBusWidth"),
+  FIELD_BYTE  (0x07, "CurrentUsage"),
+  FIELD_BYTE  (0x08, "SlotLength"),
+  FIELD_WORD  (0x09, "SlotID"),
+  FIELD_BYTE  (0x0B, "SlotCharacteristics1"),
+  FIELD_BYTE  (0x0C, "SlotCharacteristics2"),
+  FIELD_WORD  (0x0D, "SegmentGroupNum"),
+  FIELD_BYTE  (0x0F, "BusNum"),
+  FIELD_BYTE  (0x10, "DevFuncNum"),
+  FIELD_BYTE  (0x11, "DataBusWidth"),
+  FIELD_BYTE  (0x12, "PeerGroupingCount"),
+};
+
+STATIC CONST SMBIOS_FIELD mStringCountFields[] = {
+  FIELD_BYTE  (0x04, "StringCount"),
+};
+
+STATIC CONST SMBIOS_FIELD mType13Fields[] = {
+  FIELD_BYTE  (0x04, "InstallableLanguages"),
+  FIELD_BYTE  (0x05, "Flags"),
+  FIELD_STRING(0x15, "CurrentLanguages"),
+};
+
+STATIC CONST SMBIOS_FIELD mType15Fields[] = {
+  FIELD_WORD  (0x04, "LogAreaLength"),
+  FIELD_WORD  (0x06, "LogHeaderStartOffset"),
+  FIELD_WORD  (0x08, "LogDataStartOffset"),
+  FIELD_BYTE  (0x0A, "AccessMethod"),
+  FIELD_BYTE  (0x0B, "LogStatus"),
+  FIELD_DWORD (0x0C, "LogChangeToken"),
+  FIELD_DWORD (0x10, "AccessMethodAddress"),
+  FIELD_BYTE  (0x14, "LogHeaderFormat"),
+  FIELD_BYTE  (0x15, "NumberOfSupportedLogTypeDescriptors"),
+  FIELD_BYTE  (0x16, "LengthOfLogTypeDescriptor"),
+};
+
+STATIC CONST SMBIOS_FIELD mType16Fields[] = {
+  FIELD_BYTE  (0x04, "Location"),
+  FIELD_BYTE  (0x05, "Use"),
+  FIELD_BYTE  (0x06, "MemoryErrorCorrection"),
+  FIELD_DWORD (0x07, "MaximumCapacity"),
+  FIELD_HANDLE(0x0B, "MemoryErrorInformationHandle"),
+  FIELD_WORD  (0x0D, "NumberOfMemoryDevices"),
+  FIELD_QWORD (0x0F, "ExtendedMaximumCapacity"),
+};
+
+STATIC CONST SMBIOS_FIELD mType17Fields[] = {
+  FIELD_HANDLE(0x04, "MemoryArrayHandle"),
+  FIELD_HANDLE(0x06, "MemoryErrorInformationHandle"),
+  FIELD_WORD  (0x08, "TotalWidth"),
+  FIELD_WORD  (0x0A, "DataWidth"),
+  FIELD_WORD  (0x0C, "Size"),
+  FIELD_BYTE  (0x0E, "FormFactor"),
+  FIELD_BYTE  (0x0F, "DeviceSet"),
+  FIELD_STRING(0x10, "DeviceLocator"),
+  FIELD_STRING(0x11, "BankLocator"),
+  FIELD_BYTE  (0x12, "MemoryType"),
+  FIELD_WORD  (0x13, "TypeDetail"),
+  FIELD_WORD  (0x15, "Speed"),
+  FIELD_STRING(0x17, "Manufacturer"),
+  FIELD_STRING(0x18, "SerialNumber"),
+  FIELD_STRING(0x19, "AssetTag"),
+  FIELD_STRING(0x1A, "PartNumber"),
+  FIELD_BYTE  (0x1B, "Attributes"),
+  FIELD_DWORD (0x1C, "ExtendedSize"),
+  FIELD_WORD  (0x20, "ConfiguredMemoryClockSpeed"),
+  FIELD_WORD  (0x22, "MinimumVoltage"),
+  FIELD_WORD  (0x24, "MaximumVoltage"),
+  FIELD_WORD  (0x26, "ConfiguredVoltage"),
+  FIELD_BYTE  (0x28, "MemoryTechnology"),
+  FIELD_WORD  (0x29, "MemoryOperatingModeCapability"),
+  FIELD_STRING(0x2B, "FirmwareVersion"),
+  FIELD_WORD  (0x2C, "ModuleManufacturerID"),
+  FIELD_WORD  (0x2E, "ModuleProductID"),
+  FIELD_WORD  (0x30, "MemorySubsystemControllerManufacturerID"),
+  FIELD_WORD  (0x32, "MemorySubsystemControllerProductID"),
+  FIELD_QWORD (0x34, "NonVolatileSize"),
+  FIELD_QWORD (0x3C, "VolatileSize"),
+  FIELD_QWORD (0x44, "CacheSize"),
+  FIELD_QWORD (0x4C, "LogicalSize"),
+  FIELD_DWORD (0x54, "ExtendedSpeed"),
+  FIELD_DWORD (0x58, "ExtendedConfiguredMemorySpeed"),
+};
+
+STATIC CONST SMBIOS_FIELD mType19Fields[] = {
+  FIELD_DWORD (0x04, "StartingAddress"),
+  FIELD_DWORD (0x08, "EndingAddress"),
+  FIELD_HANDLE(0x0C, "MemoryArrayHandle"),
+  FIELD_BYTE  (0x0E, "PartitionWidth"),
+  FIELD_QWORD (0x0F, "ExtendedStartingAddress"),
+  FIELD_QWORD (0x17, "ExtendedEndingAddress"),
+};
+
+STATIC CONST SMBIOS_FIELD mType20Fields[] = {
+  FIELD_DWORD (0x04, "StartingAddress"),
+  FIELD_DWORD (0x08, "EndingAddress"),
+  FIELD_HANDLE(0x0C, "MemoryDeviceHandle"),
+  FIELD_HANDLE(0x0E, "MemoryArrayMappedAddressHandle"),
+  FIELD_BYTE  (0x10, "PartitionRowPosition"),
+  FIELD_BYTE  (0x11, "InterleavePosition"),
+  FIELD_BYTE  (0x12, "InterleavedDataDepth"),
+  FIELD_QWORD (0x13, "ExtendedStartingAddress"),
+  FIELD_QWORD (0x1B, "ExtendedEndingAddress"),
+};
+
+//
+// Voltage, Temperature and Electrical Current probes share the same layout
+//
+STATIC CONST SMBIOS_FIELD mProbeFields[] = {
+  FIELD_STRING(0x04, "Description"),
+  FIELD_BYTE  (0x05, "LocationAndStatus"),
+  FIELD_WORD  (0x06, "MaximumValue"),
+  FIELD_WORD  (0x08, "MinimumValue"),
+  FIELD_WORD  (0x0A, "Resolution"),
+  FIELD_WORD  (0x0C, "Tolerance"),
+  FIELD_WORD  (0x0E, "Accuracy"),
+  FIELD_DWORD (0x10, "OEMDefined"),
+  FIELD_WORD  (0x14, "NominalValue"),
+};
+
+STATIC CONST SMBIOS_FIELD mType27Fields[] = {
+  FIELD_HANDLE(0x04, "TemperatureProbeHandle"),
+  FIELD_BYTE  (0x06, "DeviceTypeAndStatus"),
+  FIELD_BYTE  (0x07, "CoolingUnitGroup"),
+  FIELD_DWORD (0x08, "OEMDefined"),
+  FIELD_WORD  (0x0C, "NominalSpeed"),
+  FIELD_STRING(0x0E, "Description"),
+};
+
+STATIC CONST SMBIOS_FIELD mType32Fields[] = {
+  FIELD_BYTE  (0x0A, "BootStatus"),
+};
+
+STATIC CONST SMBIOS_FIELD mType38Fields[] = {
+  FIELD_BYTE  (0x04, "InterfaceType"),
+  FIELD_BYTE  (0x05, "IPMISpecificationRevision"),
+  FIELD_BYTE  (0x06, "I2CSlaveAddress"),
+  FIELD_BYTE  (0x07, "NVStorageDeviceAddress"),
+  FIELD_QWORD (0x08, "BaseAddress"),
+  FIELD_BYTE  (0x10, "BaseAddressModifier_InterruptInfo"),
+  FIELD_BYTE  (0x11, "InterruptNumber"),
+};
+
+STATIC CONST SMBIOS_FIELD mType39Fields[] = {
+  FIELD_BYTE  (0x04, "PowerUnitGroup"),
+  FIELD_STRING(0x05, "Location"),
+  FIELD_STRING(0x06, "DeviceName"),
+  FIELD_STRING(0x07, "Manufacturer"),
+  FIELD_STRING(0x08, "SerialNumber"),
+  FIELD_STRING(0x09, "AssetTagNumber"),
+  FIELD_STRING(0x0A, "ModelPartNumber"),
+  FIELD_STRING(0x0B, "RevisionLevel"),
+  FIELD_WORD  (0x0C, "MaxPowerCapacity"),
+  FIELD_WORD  (0x0E, "PowerSupplyCharacteristics"),
+  FIELD_HANDLE(0x10, "InputVoltageProbeHandle"),
+  FIELD_HANDLE(0x12, "CoolingDeviceHandle"),
+  FIELD_HANDLE(0x14, "InputCurrentProbeHandle"),
+};
+
+STATIC CONST SMBIOS_FIELD mType41Fields[] = {
+  FIELD_STRING(0x04, "ReferenceDesignation"),
+  FIELD_BYTE  (0x05, "DeviceType"),
+  FIELD_BYTE  (0x06, "DeviceTypeInstance"),
+  FIELD_WORD  (0x07, "SegmentGroupNum"),
+  FIELD_BYTE  (0x09, "BusNum"),
+  FIELD_BYTE  (0x0A, "DevFuncNum"),
+};
+
+STATIC CONST SMBIOS_FIELD mType43Fields[] = {
+  FIELD_BYTES (0x04, 4, "VendorID"),
+  FIELD_BYTE  (0x08, "MajorSpecVersion"),
+  FIELD_BYTE  (0x09, "MinorSpecVersion"),
+  FIELD_DWORD (0x0A, "FirmwareVersion1"),
+  FIELD_DWORD (0x0E, "FirmwareVersion2"),
+  FIELD_STRING(0x12, "Description"),
+  FIELD_QWORD (0x13, "Characteristics"),
+  FIELD_DWORD (0x1B, "OemDefined"),
+};
+
+#define TYPE(Type, Name, Fields)  { Type, Name, Fields, ARRAY_SIZE(Fields) }
+#define TYPE_NO_FIELDS(Type, Name)  { Type, Name, NULL, 0 }
+
+STATIC CONST SMBIOS_TYPE_INFO mTypes[] = {
+  TYPE(0,  "BIOS Information", mType0Fields),
+  TYPE(1,  "System Information", mType1Fields),
+  TYPE(2,  "Baseboard Information", mType2Fields),
+  TYPE(3,  "System Enclosure", mType3Fields),
+  TYPE(4,  "Processor Information", mType4Fields),
+  TYPE(7,  "Cache Information", mType7Fields),
+  TYPE(8,  "Port Connector Information", mType8Fields),
+  TYPE(9,  "System Slots", mType9Fields),
+  TYPE(11, "OEM Strings", mStringCountFields),
+  TYPE(12, "System Configuration Options", mStringCountFields),
+  TYPE(13, "BIOS Language Information", mType13Fields),
+  TYPE(15, "System Event Log", mType15Fields),
+  TYPE(16, "Physical Memory Array", mType16Fields),
+  TYPE(17, "Memory Device", mType17Fields),
+  TYPE(19, "Memory Array Mapped Address", mType19Fields),
+  TYPE(20, "Memory Device Mapped Address", mType20Fields),
+  TYPE(26, "Voltage Probe", mProbeFields),
+  TYPE(27, "Cooling Device", mType27Fields),
+  TYPE(28, "Temperature Probe", mProbeFields),
+  TYPE(29, "Electrical Current Probe", mProbeFields),
+  TYPE(32, "System Boot Information", mType32Fields),
+  TYPE(38, "IPMI Device Information", mType38Fields),
+  TYPE(39, "System Power Supply", mType39Fields),
+  TYPE(41, "Onboard Devices Extended Information", mType41Fields),
+  TYPE(43, "TPM Device", mType43Fields),
+  TYPE_NO_FIELDS(126, "Inactive"),
+  TYPE_NO_FIELDS(127, "End-of-Table"),
+};
+
+STATIC CONST SMBIOS_TYPE_INFO* mTypeIndex[256];
+STATIC BOOLEAN mTypeIndexReady = FALSE;
+
+CONST SMBIOS_TYPE_INFO*
+SmbiosGetTypeInfo (
+  IN UINT8  Type
+  )
+{
+  if (!mTypeIndexReady) {
+    for (UINTN i = 0; i < ARRAY_SIZE(mTypes); i++) {
+      mTypeIndex[mTypes[i].Type] = &mTypes[i];
+    }
+    mTypeIndexReady = TRUE;
+  }
+  return mTypeIndex[Type];
+}
+
+BOOLEAN
+SmbiosParseRecord (
+  IN  SMBIOS_STRUCTURE  *Header,
+  IN  UINTN             MaxSize,
+  OUT SMBIOS_RECORD     *Record
+  )
+{
+  if ((MaxSize < sizeof(SMBIOS_STRUCTURE)) || (Header->Length < sizeof(SMBIOS_STRUCTURE)) ||
+      ((UINTN)Header->Length + 2 > MaxSize)) {
+    return FALSE;
+  }
+
+  Record->Header = Header;
+  Record->StringCount = 0;
+  Record->StringOffset[0] = 0;
+
+  //
+  // String-set is terminated with a double NUL. Structure without strings
+  // still has two NUL bytes after the formatted area.
+  //
+  CONST CHAR8* Base = (CONST CHAR8*)Header;
+  UINTN Offset = Header->Length;
+  if ((Base[Offset] == 0) && (Base[Offset + 1] == 0)) {
+    Record->Size = Offset + 2;
+    return TRUE;
+  }
+
+  while (Offset < MaxSize) {
+    if (Base[Offset] == 0) {
+      Record->Size = Offset + 1;
+      return TRUE;
+    }
+    if (Record->StringCount < SMBIOS_MAX_STRINGS - 1) {
+      Record->StringOffset[++Record->StringCount] = (UINT16)Offset;
+    }
+    while ((Offset < MaxSize) && (Base[Offset] != 0)) {
+      Offset++;
+    }
+    Offset++;
+  }
+  return FALSE;
+}
+
+CONST CHAR8*
+SmbiosGetString (
+  IN SMBIOS_RECORD  *Record,
+  IN UINT8          Number
+  )
+{
+  if (Number == 0) {
+    return "";
+  }
+  if (Number > Record->StringCount) {
+    return NULL;
+  }
+  return (CONST CHAR8*)Record->Header + Record->StringOffset[Number];
+}
+
+BOOLEAN
+SmbiosFormatField (
+  IN  SMBIOS_RECORD       *Record,
+  IN  CONST SMBIOS_FIELD  *Field,
+  OUT CHAR8               *Buffer,
+  IN  UINTN               BufferSize
+  )
+{
+  if ((UINTN)Field->Offset + Field->Size > Record->Header->Length) {
+    return FALSE;
+  }
+
+  CONST UINT8* Data = (CONST UINT8*)Record->Header + Field->Offset;
+  CONST CHAR8* String;
+  switch (Field->Kind) {
+    case SmbiosFieldByte:
+      AsciiSPrint(Buffer, BufferSize, "0x%02x", *Data);
+      break;
+    case SmbiosFieldWord:
+      AsciiSPrint(Buffer, BufferSize, "0x%04x", ReadUnaligned16((CONST UINT16*)Data));
+      break;
+    case SmbiosFieldDword:
+      AsciiSPrint(Buffer, BufferSize, "0x%08x", ReadUnaligned32((CONST UINT32*)Data));
+      break;
+    case SmbiosFieldQword:
+      AsciiSPrint(Buffer, BufferSize, "0x%016lx", ReadUnaligned64((CONST UINT64*)Data));
+      break;
+    case SmbiosFieldHandle:
+      AsciiSPrint(Buffer, BufferSize, "0x%04x", ReadUnaligned16((CONST UINT16*)Data));
+      break;
+    case SmbiosFieldUuid: {
+      // SMBIOS UUID has the same byte order as EFI_GUID
+      EFI_GUID Uuid;
+      CopyMem(&Uuid, Data, sizeof(Uuid));
+      AsciiSPrint(Buffer, BufferSize, "%g", &Uuid);
+      break;
+    }
+    case SmbiosFieldString:
+      String = SmbiosGetString(Record, *Data);
+      AsciiSPrint(Buffer, BufferSize, "%a", (String != NULL) ? String : "<BAD INDEX>");
+      break;
+    case SmbiosFieldBytes: {
+      UINTN Length = 0;
+      for (UINTN i = 0; (i < Field->Size) && (Length + 4 <= BufferSize); i++) {
+        Length += AsciiSPrint(&Buffer[Length], BufferSize - Length, (i == 0) ? "%02x" : " %02x", Data[i]);
+      }
+      break;
+    }
+    default:
+      AsciiSPrint(Buffer, BufferSize, "?");
+      break;
+  }
+  return TRUE;
+}
+
+STATIC
+VOID*
+FindConfigurationTable (
+  IN EFI_GUID  *Guid
+  )
+{
+  for (UINTN i = 0; i < gST->NumberOfTableEntries; i++) {
+    if (CompareGuid(&gST->ConfigurationTable[i].VendorGuid, Guid)) {
+      return gST->ConfigurationTable[i].VendorTable;
+    }
+  }
+  return NULL;
+}
+
+STATIC
+SMBIOS_TABLE_3_0_ENTRY_POINT*
+GetEntryPoint64 (
+  VOID
+  )
+{
+  SMBIOS_TABLE_3_0_ENTRY_POINT* Smbios3 = FindConfigurationTable(&gEfiSmbios3TableGuid);
+  if ((Smbios3 != NULL) &&
+      !CompareMem(Smbios3->AnchorString, "_SM3_", sizeof(Smbios3->AnchorString)) &&
+      (Smbios3->EntryPointLength >= sizeof(SMBIOS_TABLE_3_0_ENTRY_POINT)) &&
+      (CalculateSum8((UINT8*)Smbios3, Smbios3->EntryPointLength) == 0)) {
+    return Smbios3;
+  }
+  return NULL;
+}
+
+STATIC
+SMBIOS_TABLE_ENTRY_POINT*
+GetEntryPoint32 (
+  VOID
+  )
+{
+  SMBIOS_TABLE_ENTRY_POINT* Smbios = FindConfigurationTable(&gEfiSmbiosTableGuid);
+  if ((Smbios != NULL) &&
+      !CompareMem(Smbios->AnchorString, "_SM_", sizeof(Smbios->AnchorString)) &&
+      (Smbios->EntryPointLength >= OFFSET_OF(SMBIOS_TABLE_ENTRY_POINT, SmbiosBcdRevision)) &&
+      (CalculateSum8((UINT8*)Smbios, Smbios->EntryPointLength) == 0)) {
+    return Smbios;
+  }
+  return NULL;
+}
+
+EFI_STATUS
+SmbiosWalkBuffer (
+  IN UINT8                   *Table,
+  IN UINTN                   TableSize,
+  IN UINTN                   MaxCount,
+  IN SMBIOS_RECORD_CALLBACK  Callback,
+  IN VOID                    *Context
+  )
+{
+  SMBIOS_RECORD Record;
+  UINTN Offset = 0;
+  UINTN Count = 0;
+  while ((Offset + sizeof(SMBIOS_STRUCTURE) <= TableSize) && (Count < MaxCount)) {
+    if (!SmbiosParseRecord((SMBIOS_STRUCTURE*)(Table + Offset), TableSize - Offset, &Record)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+    Count++;
+    if (!Callback(&Record, Context) || (Record.Header->Type == EFI_SMBIOS_TYPE_END_OF_TABLE)) {
+      break;
+    }
+    Offset += Record.Size;
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+WalkProtocol (
+  IN SMBIOS_RECORD_CALLBACK  Callback,
+  IN VOID                    *Context
+  )
+{
+  EFI_SMBIOS_PROTOCOL* SmbiosProtocol;
+  EFI_STATUS Status = gBS->LocateProtocol(&gEfiSmbiosProtocolGuid,
+                                          NULL,
+                                          (VOID**)&SmbiosProtocol);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+
+  SMBIOS_RECORD Record;
+  EFI_SMBIOS_HANDLE SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+  EFI_SMBIOS_TABLE_HEADER* Header;
+  while (!EFI_ERROR(SmbiosProtocol->GetNext(SmbiosProtocol, &SmbiosHandle, NULL, &Header, NULL))) {
+    // Records from the protocol are always well-formed, the size is not known in advance
+    if (!SmbiosParseRecord(Header, MAX_UINT16 + 2, &Record)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+    if (!Callback(&Record, Context)) {
+      break;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+VOID
+SmbiosGetVersion (
+  OUT UINT8  *MajorVersion,
+  OUT UINT8  *MinorVersion
+  )
+{
+  *MajorVersion = 0;
+  *MinorVersion = 0;
+
+  SMBIOS_TABLE_3_0_ENTRY_POINT* Smbios3 = GetEntryPoint64();
+  if (Smbios3 != NULL) {
+    *MajorVersion = Smbios3->MajorVersion;
+    *MinorVersion = Smbios3->MinorVersion;
+    return;
+  }
+  SMBIOS_TABLE_ENTRY_POINT* Smbios = GetEntryPoint32();
+  if (Smbios != NULL) {
+    *MajorVersion = Smbios->MajorVersion;
+    *MinorVersion = Smbios->MinorVersion;
+    return;
+  }
+  EFI_SMBIOS_PROTOCOL* SmbiosProtocol;
+  if (!EFI_ERROR(gBS->LocateProtocol(&gEfiSmbiosProtocolGuid, NULL, (VOID**)&SmbiosProtocol))) {
+    *MajorVersion = SmbiosProtocol->MajorVersion;
+    *MinorVersion = SmbiosProtocol->MinorVersion;
+  }
+}
+
+EFI_STATUS
+SmbiosWalk (
+  IN  BOOLEAN                 UseProtocol,
+  IN  SMBIOS_RECORD_CALLBACK  Callback,
+  IN  VOID                    *Context,
+  OUT SMBIOS_SOURCE           *Source
+  )
+{
+  *Source = SmbiosSourceNone;
+  if (!UseProtocol) {
+    SMBIOS_TABLE_3_0_ENTRY_POINT* Smbios3 = GetEntryPoint64();
+    if (Smbios3 != NULL) {
+      *Source = SmbiosSourceEntryPoint64;
+      // TableMaximumSize is only the upper bound, the table ends with the Type 127 structure
+      return SmbiosWalkBuffer((UINT8*)(UINTN)Smbios3->TableAddress,
+                              Smbios3->TableMaximumSize,
+                              MAX_UINTN,
+                              Callback,
+                              Context);
+    }
+
+    SMBIOS_TABLE_ENTRY_POINT* Smbios = GetEntryPoint32();
+    if (Smbios != NULL) {
+      *Source = SmbiosSourceEntryPoint32;
+      return SmbiosWalkBuffer((UINT8*)(UINTN)Smbios->TableAddress,
+                              Smbios->TableLength,
+                              Smbios->NumberOfSmbiosStructures,
+                              Callback,
+                              Context);
+    }
+  }
+
+  *Source = SmbiosSourceProtocol;
+  return WalkProtocol(Callback, Context);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __SMBIOS_DECODER_H__
+#define __SMBIOS_DECODER_H__
+
+#include <Uefi.h>
+#include <IndustryStandard/SmBios.h>
+
+#define SMBIOS_MAX_STRINGS  256     // String numbers are UINT8, 0 means "no string"
+
+//
+// Record with the precomputed string-set offsets, so every string lookup is O(1)
+//
+typedef struct {
+  SMBIOS_STRUCTURE  *Header;
+  UINTN             Size;                               // Formatted area + string-set
+  UINTN             StringCount;
+  UINT16            StringOffset[SMBIOS_MAX_STRINGS];   // StringOffset[N] is the offset of the string N from the record start
+} SMBIOS_RECORD;
+
+typedef enum {
+  SmbiosFieldByte,
+  SmbiosFieldWord,
+  SmbiosFieldDword,
+  SmbiosFieldQword,
+  SmbiosFieldString,
+  SmbiosFieldUuid,
+  SmbiosFieldHandle,
+  SmbiosFieldBytes
+} SMBIOS_FIELD_KIND;
+
+typedef struct {
+  UINT8         Offset;
+  UINT8         Kind;       // SMBIOS_FIELD_KIND
+  UINT8         Size;       // Only for SmbiosFieldBytes
+  CONST CHAR8   *Name;
+} SMBIOS_FIELD;
+
+typedef struct {
+  UINT8               Type;
+  CONST CHAR8         *Name;
+  CONST SMBIOS_FIELD  *Fields;
+  UINTN               FieldCount;
+} SMBIOS_TYPE_INFO;
+
+typedef enum {
+  SmbiosSourceNone,
+  SmbiosSourceEntryPoint64,   // SMBIOS 3.0 entry point
+  SmbiosSourceEntryPoint32,   // SMBIOS 2.x entry point
+  SmbiosSourceProtocol        // EFI_SMBIOS_PROTOCOL->GetNext
+} SMBIOS_SOURCE;
+
+/**
+  Record callback. Return FALSE to stop the walk.
+**/
+typedef
+BOOLEAN
+(*SMBIOS_RECORD_CALLBACK) (
+  IN SMBIOS_RECORD  *Record,
+  IN VOID           *Context
+  );
+
+/**
+  Check the record bounds and fill the string offsets.
+  Returns FALSE if the record doesn't fit in MaxSize bytes.
+**/
+BOOLEAN
+SmbiosParseRecord (
+  IN  SMBIOS_STRUCTURE  *Header,
+  IN  UINTN             MaxSize,
+  OUT SMBIOS_RECORD     *Record
+  );
+
+/**
+  Get the string by its number. Returns "" for the string number 0,
+  and NULL if the string doesn't exist.
+**/
+CONST CHAR8*
+SmbiosGetString (
+  IN SMBIOS_RECORD  *Record,
+  IN UINT8          Number
+  );
+
+/**
+  Get the field descriptors for the structure type. Returns NULL for the unknown types.
+**/
+CONST SMBIOS_TYPE_INFO*
+SmbiosGetTypeInfo (
+  IN UINT8  Type
+  );
+
+/**
+  Format the field value as text. Returns FALSE if the record is too short
+  to contain the field (older SMBIOS version).
+**/
+BOOLEAN
+SmbiosFormatField (
+  IN  SMBIOS_RECORD       *Record,
+  IN  CONST SMBIOS_FIELD  *Field,
+  OUT CHAR8               *Buffer,
+  IN  UINTN               BufferSize
+  );
+
+/**
+  Walk the structures of the table that is placed in memory. The walk stops
+  at the End-of-Table structure, at TableSize bytes or after MaxCount structures.
+**/
+EFI_STATUS
+SmbiosWalkBuffer (
+  IN UINT8                   *Table,
+  IN UINTN                   TableSize,
+  IN UINTN                   MaxCount,
+  IN SMBIOS_RECORD_CALLBACK  Callback,
+  IN VOID                    *Context
+  );
+
+/**
+  Walk all the structures with a single linear pass over the table from the
+  SMBIOS 3.0 (or 2.x if there is no 3.0) entry point. If UseProtocol is TRUE
+  or there is no valid entry point, EFI_SMBIOS_PROTOCOL is used instead.
+**/
+EFI_STATUS
+SmbiosWalk (
+  IN  BOOLEAN                 UseProtocol,
+  IN  SMBIOS_RECORD_CALLBACK  Callback,
+  IN  VOID                    *Context,
+  OUT SMBIOS_SOURCE           *Source
+  );
+
+/**
+  Get SMBIOS version from the entry point or from EFI_SMBIOS_PROTOCOL.
+**/
+VOID
+SmbiosGetVersion (
+  OUT UINT8  *MajorVersion,
+  OUT UINT8  *MinorVersion
+  );
+
+#endif
@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/SaveFileLib.h>
+
+#include "SmbiosDecoder.h"
+#include "SmbiosExport.h"
+
+#define LINE_SIZE   256
+#define VALUE_SIZE  128
+
+typedef struct {
+  UINT8    *Data;
+  UINTN    Size;
+  UINTN    Capacity;
+  BOOLEAN  Error;
+} EXPORT_BUFFER;
+
+typedef struct {
+  EXPORT_BUFFER  *Buffer;
+  UINTN          Count;
+} COLLECT_CONTEXT;
+
+typedef struct {
+  EXPORT_BUFFER  *Buffer;
+  UINT8          Type;
+  BOOLEAN        IsArray;
+  UINTN          Count;
+} SUMMARY_CONTEXT;
+
+//
+// Summary sections, every section is generated from the structures of one type
+//
+typedef struct {
+  UINT8        Type;
+  CONST CHAR8  *Key;
+  BOOLEAN      IsArray;
+} SUMMARY_SECTION;
+
+STATIC CONST SUMMARY_SECTION mSections[] = {
+  { EFI_SMBIOS_TYPE_BIOS_INFORMATION,       "bios",           FALSE },
+  { EFI_SMBIOS_TYPE_SYSTEM_INFORMATION,     "system",         FALSE },
+  { EFI_SMBIOS_TYPE_BASEBOARD_INFORMATION,  "baseboard",      FALSE },
+  { EFI_SMBIOS_TYPE_PROCESSOR_INFORMATION,  "processors",     TRUE  },
+  { EFI_SMBIOS_TYPE_SYSTEM_SLOTS,           "slots",          TRUE  },
+  { EFI_SMBIOS_TYPE_MEMORY_DEVICE,          "memory_devices", TRUE  },
+};
+
+STATIC
+VOID
+Append (
+  IN EXPORT_BUFFER  *Buffer,
+  IN CONST VOID     *Data,
+  IN UINTN          Size
+  )
+{
+  if (Buffer->Error) {
+    return;
+  }
+  if (Buffer->Size + Size > Buffer->Capacity) {
+    UINTN NewCapacity = (Buffer->Capacity == 0) ? SIZE_16KB : Buffer->Capacity;
+    while (Buffer->Size + Size > NewCapacity) {
+      NewCapacity *= 2;
+    }
+    UINT8* NewData = ReallocatePool(Buffer->Capacity, NewCapacity, Buffer->Data);
+    if (NewData == NULL) {
+      Buffer->Error = TRUE;
+      return;
+    }
+    Buffer->Data = NewData;
+    Buffer->Capacity = NewCapacity;
+  }
+  CopyMem(Buffer->Data + Buffer->Size, Data, Size);
+  Buffer->Size += Size;
+}
+
+STATIC
+VOID
+AppendText (
+  IN EXPORT_BUFFER  *Buffer,
+  IN CONST CHAR8    *Format,
+  ...
+  )
+{
+  CHAR8 Line[LINE_SIZE];
+  VA_LIST Marker;
+  VA_START(Marker, Format);
+  UINTN Length = AsciiVSPrint(Line, sizeof(Line), Format, Marker);
+  VA_END(Marker);
+  Append(Buffer, Line, Length);
+}
+
+STATIC
+VOID
+AppendJsonString (
+  IN EXPORT_BUFFER  *Buffer,
+  IN CONST CHAR8    *String
+  )
+{
+  Append(Buffer, "\"", 1);
+  CONST CHAR8* Start = String;
+  for (; *String != 0; String++) {
+    if ((*String == '"') || (*String == '\\') || ((UINT8)*String < ' ') || ((UINT8)*String > 0x7E)) {
+      Append(Buffer, Start, String - Start);
+      if ((*String == '"') || (*String == '\\')) {
+        AppendText(Buffer, "\\%c", *String);
+      } else {
+        AppendText(Buffer, "\\u%04x", (UINT8)*String);
+      }
+      Start = String + 1;
+    }
+  }
+  Append(Buffer, Start, String - Start);
+  Append(Buffer, "\"", 1);
+}
+
+//
+// Memory device size in MB, 0 if the device is not installed or the size is unknown
+//
+STATIC
+UINT64
+MemoryDeviceSizeMb (
+  IN SMBIOS_RECORD  *Record
+  )
+{
+  UINT8* Data = (UINT8*)Record->Header;
+  if (Record->Header->Length < 0x0E) {
+    return 0;
+  }
+  UINT16 Size = ReadUnaligned16((UINT16*)(Data + 0x0C));
+  if ((Size == 0) || (Size == 0xFFFF)) {
+    return 0;
+  }
+  if (Size == 0x7FFF) {
+    if (Record->Header->Length < 0x20) {
+      return 0;
+    }
+    return ReadUnaligned32((UINT32*)(Data + 0x1C)) & 0x7FFFFFFF;
+  }
+  if (Size & BIT15) {
+    return (Size & 0x7FFF) / 1024;    // Size in KB
+  }
+  return Size;
+}
+
+STATIC
+BOOLEAN
+CollectRecord (
+  IN SMBIOS_RECORD  *Record,
+  IN VOID           *Context
+  )
+{
+  COLLECT_CONTEXT* Collect = (COLLECT_CONTEXT*)Context;
+  Append(Collect->Buffer, Record->Header, Record->Size);
+  Collect->Count++;
+  return !Collect->Buffer->Error;
+}
+
+STATIC
+BOOLEAN
+SummaryRecord (
+  IN SMBIOS_RECORD  *Record,
+  IN VOID           *Context
+  )
+{
+  SUMMARY_CONTEXT* Summary = (SUMMARY_CONTEXT*)Context;
+  if (Record->Header->Type != Summary->Type) {
+    return TRUE;
+  }
+
+  EXPORT_BUFFER* Buffer = Summary->Buffer;
+  if (Summary->IsArray) {
+    AppendText(Buffer, "%a\n    {", (Summary->Count == 0) ? "" : ",");
+  } else {
+    AppendText(Buffer, "{");
+  }
+  AppendText(Buffer, "\"Handle\": \"0x%04x\"", Record->Header->Handle);
+
+  CONST SMBIOS_TYPE_INFO* TypeInfo = SmbiosGetTypeInfo(Record->Header->Type);
+  CHAR8 Value[VALUE_SIZE];
+  for (UINTN i = 0; (TypeInfo != NULL) && (i < TypeInfo->FieldCount); i++) {
+    if (SmbiosFormatField(Record, &TypeInfo->Fields[i], Value, sizeof(Value))) {
+      AppendText(Buffer, ", \"%a\": ", TypeInfo->Fields[i].Name);
+      AppendJsonString(Buffer, Value);
+    }
+  }
+  if (Record->Header->Type == EFI_SMBIOS_TYPE_MEMORY_DEVICE) {
+    AppendText(Buffer, ", \"SizeMB\": %ld", MemoryDeviceSizeMb(Record));
+  }
+  AppendText(Buffer, "}");
+
+  Summary->Count++;
+  // Single object sections describe only the first structure of the type
+  return Summary->IsArray;
+}
+
+EFI_STATUS
+SmbiosExport (
+  IN BOOLEAN  UseProtocol,
+  IN CHAR16   *FileName
+  )
+{
+  EXPORT_BUFFER Image;
+  EXPORT_BUFFER Summary;
+  ZeroMem(&Image, sizeof(Image));
+  ZeroMem(&Summary, sizeof(Summary));
+
+  //
+  // Copy the structures first, the summary is generated from the copy
+  // with the same decoder that is used for the console output
+  //
+  SMBIOS_EXPORT_HEADER Header;
+  ZeroMem(&Header, sizeof(Header));
+  Append(&Image, &Header, sizeof(Header));
+
+  COLLECT_CONTEXT Collect;
+  Collect.Buffer = &Image;
+  Collect.Count = 0;
+  SMBIOS_SOURCE Source;
+  EFI_STATUS Status = SmbiosWalk(UseProtocol, CollectRecord, &Collect, &Source);
+  if (!EFI_ERROR(Status) && Image.Error) {
+    Status = EFI_OUT_OF_RESOURCES;
+  }
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't collect SMBIOS structures: %r\n", Status);
+    goto Exit;
+  }
+
+  Header.Signature = SMBIOS_EXPORT_SIGNATURE;
+  Header.Version = SMBIOS_EXPORT_VERSION;
+  SmbiosGetVersion(&Header.SmbiosMajorVersion, &Header.SmbiosMinorVersion);
+  Header.Source = (UINT8)Source;
+  Header.TableOffset = sizeof(SMBIOS_EXPORT_HEADER);
+  Header.TableSize = (UINT32)(Image.Size - sizeof(SMBIOS_EXPORT_HEADER));
+  Header.StructureCount = (UINT32)Collect.Count;
+
+  SUMMARY_CONTEXT Context;
+  Context.Buffer = &Summary;
+  AppendText(&Summary, "{\n  \"smbios_version\": \"%d.%d\",\n  \"structures\": %d",
+             Header.SmbiosMajorVersion,
+             Header.SmbiosMinorVersion,
+             Header.StructureCount);
+  for (UINTN i = 0; i < ARRAY_SIZE(mSections); i++) {
+    AppendText(&Summary, ",\n  \"%a\": %a", mSections[i].Key, mSections[i].IsArray ? "[" : "");
+    Context.Type = mSections[i].Type;
+    Context.IsArray = mSections[i].IsArray;
+    Context.Count = 0;
+    SmbiosWalkBuffer(Image.Data + Header.TableOffset, Header.TableSize, MAX_UINTN, SummaryRecord, &Context);
+    if (mSections[i].IsArray) {
+      AppendText(&Summary, "%a]", (Context.Count == 0) ? "" : "\n  ");
+    } else if (Context.Count == 0) {
+      AppendText(&Summary, "null");
+    }
+  }
+  AppendText(&Summary, "\n}\n");
+  if (Summary.Error) {
+    Print(L"Error! Not enough memory for the summary\n");
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  Header.SummaryOffset = (UINT32)Image.Size;
+  Header.SummarySize = (UINT32)Summary.Size;
+  Append(&Image, Summary.Data, Summary.Size);
+  if (Image.Error) {
+    Print(L"Error! Not enough memory for the export image\n");
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+  CopyMem(Image.Data, &Header, sizeof(Header));
+
+  UINTN Size = Image.Size;
+  Status = SaveFile(FileName, Image.Data, &Size);
+  if (!EFI_ERROR(Status)) {
+    Print(L"%d structures were exported (table 0x%x bytes, summary 0x%x bytes)\n",
+          Header.StructureCount,
+          Header.TableSize,
+          Header.SummarySize);
+  }
+
+Exit:
+  if (Image.Data != NULL) {
+    FreePool(Image.Data);
+  }
+  if (Summary.Data != NULL) {
+    FreePool(Summary.Data);
+  }
+  return Status;
+}
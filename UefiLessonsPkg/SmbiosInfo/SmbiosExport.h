@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __SMBIOS_EXPORT_H__
+#define __SMBIOS_EXPORT_H__
+
+#include <Uefi.h>
+
+//
+// Export file layout (decoded on the host by scripts/smbios_diff.py):
+//   SMBIOS_EXPORT_HEADER
+//   Raw structures in the same format as the SMBIOS structure table
+//   JSON text summary of the system, processors, slots and memory devices
+//
+#define SMBIOS_EXPORT_SIGNATURE  SIGNATURE_64('S','M','B','I','O','S','E','X')
+#define SMBIOS_EXPORT_VERSION    1
+
+#pragma pack(1)
+typedef struct {
+  UINT64  Signature;
+  UINT32  Version;
+  UINT8   SmbiosMajorVersion;
+  UINT8   SmbiosMinorVersion;
+  UINT8   Source;               // SMBIOS_SOURCE
+  UINT8   Reserved;
+  UINT32  StructureCount;
+  UINT32  TableOffset;
+  UINT32  TableSize;
+  UINT32  SummaryOffset;
+  UINT32  SummarySize;
+} SMBIOS_EXPORT_HEADER;
+#pragma pack()
+
+/**
+  Collect all SMBIOS structures and their summary and save them to the file
+  with a single write.
+**/
+EFI_STATUS
+SmbiosExport (
+  IN BOOLEAN  UseProtocol,
+  IN CHAR16   *FileName
+  );
+
+#endif
@@ -9,19 +9,64 @@
 
 #include <Library/BaseMemoryLib.h>
 #include <Protocol/Smbios.h>
+#include <Protocol/ShellParameters.h>
+#include <Guid/SmBios.h>
 
-CHAR8* GetRecordString(EFI_SMBIOS_TABLE_HEADER* Record, UINTN number)
+#include "SmbiosDecoder.h"
+#include "SmbiosExport.h"
+
+#define VALUE_SIZE  128
+
+typedef struct {
+  BOOLEAN  AllTypes;
+  UINT8    Type;
+  UINTN    Count;
+} PRINT_CONTEXT;
+
+BOOLEAN PrintRecord(SMBIOS_RECORD* Record, VOID* Context)
 {
-  if (!number)
-    return "";
-
-  CHAR8* String = (CHAR8*)Record + Record->Length;
-  UINTN i=1;
-  while (i < number) {
-    String = String + AsciiStrSize(String);
-    i++;
+  PRINT_CONTEXT* PrintContext = (PRINT_CONTEXT*)Context;
+  PrintContext->Count++;
+  if (!PrintContext->AllTypes && (Record->Header->Type != PrintContext->Type)) {
+    return TRUE;
+  }
+
+  CONST SMBIOS_TYPE_INFO* TypeInfo = SmbiosGetTypeInfo(Record->Header->Type);
+  Print(L"SMBIOS Type %d (%a), Handle 0x%04x\n",
+        Record->Header->Type,
+        (TypeInfo != NULL) ? TypeInfo->Name : "Unknown",
+        Record->Header->Handle);
+
+  if (TypeInfo != NULL) {
+    CHAR8 Value[VALUE_SIZE];
+    for (UINTN i = 0; i < TypeInfo->FieldCount; i++) {
+      if (SmbiosFormatField(Record, &TypeInfo->Fields[i], Value, sizeof(Value))) {
+        Print(L"\t%a=%a\n", TypeInfo->Fields[i].Name, Value);
+      }
+    }
   }
-  return String;
+
+  //
+  // Types like OEM Strings keep all the data in the strings, for the unknown
+  // types strings are the only thing that can be shown
+  //
+  if ((TypeInfo == NULL) || (Record->Header->Type == EFI_SMBIOS_TYPE_OEM_STRINGS) ||
+      (Record->Header->Type == EFI_SMBIOS_TYPE_SYSTEM_CONFIGURATION_OPTIONS)) {
+    for (UINTN i = 1; i <= Record->StringCount; i++) {
+      Print(L"\tString%d=%a\n", i, SmbiosGetString(Record, (UINT8)i));
+    }
+  }
+  return TRUE;
+}
+
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"SmbiosInfo.efi [-p] [-t <type>]\n");
+  Print(L"SmbiosInfo.efi [-p] -o <file>\n");
+  Print(L"  -p         use EFI_SMBIOS_PROTOCOL instead of the direct entry point table walk\n");
+  Print(L"  -t <type>  show only structures of this type\n");
+  Print(L"  -o <file>  export all structures and their summary to the file\n");
 }
 
 EFI_STATUS
@@ -31,64 +76,68 @@ UefiMain (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
+  BOOLEAN UseProtocol = FALSE;
+  CHAR16* ExportFileName = NULL;
+  PRINT_CONTEXT Context;
+  Context.AllTypes = TRUE;
+  Context.Type = 0;
+  Context.Count = 0;
+
+  EFI_SHELL_PARAMETERS_PROTOCOL* ShellParameters;
+  EFI_STATUS Status = gBS->HandleProtocol(
+    ImageHandle,
+    &gEfiShellParametersProtocolGuid,
+    (VOID **) &ShellParameters
+  );
+  if (Status == EFI_SUCCESS) {
+    for (UINTN i = 1; i < ShellParameters->Argc; i++) {
+      if (!StrCmp(ShellParameters->Argv[i], L"-p")) {
+        UseProtocol = TRUE;
+      } else if (!StrCmp(ShellParameters->Argv[i], L"-t") && ((i + 1) < ShellParameters->Argc)) {
+        UINTN Type = StrDecimalToUintn(ShellParameters->Argv[++i]);
+        if (Type > MAX_UINT8) {
+          Usage();
+          return EFI_INVALID_PARAMETER;
+        }
+        Context.AllTypes = FALSE;
+        Context.Type = (UINT8)Type;
+      } else if (!StrCmp(ShellParameters->Argv[i], L"-o") && ((i + 1) < ShellParameters->Argc)) {
+        ExportFileName = ShellParameters->Argv[++i];
+      } else {
+        Usage();
+        return EFI_INVALID_PARAMETER;
+      }
+    }
+  }
+
   for (UINTN i=0; i<SystemTable->NumberOfTableEntries; i++) {
     if (CompareGuid(&(SystemTable->ConfigurationTable[i].VendorGuid), &gEfiSmbiosTableGuid)) {
-      Print(L"SMBIOS table is placed at %p\n\n", SystemTable->ConfigurationTable[i].VendorTable);
+      Print(L"SMBIOS table is placed at %p\n", SystemTable->ConfigurationTable[i].VendorTable);
+    }
+    if (CompareGuid(&(SystemTable->ConfigurationTable[i].VendorGuid), &gEfiSmbios3TableGuid)) {
+      Print(L"SMBIOS 3.0 table is placed at %p\n", SystemTable->ConfigurationTable[i].VendorTable);
     }
-  } 
-
-  EFI_SMBIOS_PROTOCOL* SmbiosProtocol;
-  EFI_STATUS Status = gBS->LocateProtocol (
-                  &gEfiSmbiosProtocolGuid,
-                  NULL,
-                  (VOID**)&SmbiosProtocol
-                  );
-  if (EFI_ERROR (Status)) {
-    return Status;
   }
+  Print(L"\n");
 
-  EFI_SMBIOS_HANDLE SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
-  EFI_SMBIOS_TABLE_HEADER* Record;
-  Status = SmbiosProtocol->GetNext(SmbiosProtocol,
-                                   &SmbiosHandle,
-                                   NULL,
-                                   &Record,
-                                   NULL);
-  while (!EFI_ERROR(Status)) {
-    Print (L"SMBIOS Type %d \n", Record->Type);
-    switch (Record->Type) {
-      case EFI_SMBIOS_TYPE_BIOS_INFORMATION: {
-        SMBIOS_TABLE_TYPE0* Type0Record = (SMBIOS_TABLE_TYPE0*) Record;
-        Print(L"\tVendor=%a\n", GetRecordString(Record, Type0Record->Vendor));
-        Print(L"\tBiosVersion=%a\n", GetRecordString(Record, Type0Record->BiosVersion));
-        Print(L"\tBiosReleaseDate=%a\n", GetRecordString(Record, Type0Record->BiosReleaseDate));
-        Print(L"\tBiosSegment=0x%x\n", Type0Record->BiosSegment);
-        Print(L"\tSystemBiosMajorRelease=0x%x\n", Type0Record->SystemBiosMajorRelease);
-        Print(L"\tSystemBiosMinorRelease=0x%x\n", Type0Record->SystemBiosMinorRelease);
-        break;
-      }
-      case EFI_SMBIOS_TYPE_SYSTEM_INFORMATION: {
-        SMBIOS_TABLE_TYPE1* Type1Record = (SMBIOS_TABLE_TYPE1*) Record;
-        Print(L"\tManufacturer=%a\n", GetRecordString(Record, Type1Record->Manufacturer));
-        Print(L"\tProductName=%a\n", GetRecordString(Record, Type1Record->ProductName));
-        Print(L"\tVersion=%a\n", GetRecordString(Record, Type1Record->Version));
-        Print(L"\tSerialNumber=%a\n", GetRecordString(Record, Type1Record->SerialNumber));
-        Print(L"\tUUID=%g\n", Type1Record->Uuid);
-        Print(L"\tWakeUpType=%d\n", Type1Record->WakeUpType);
-        Print(L"\tSKUNumber=%a\n", GetRecordString(Record, Type1Record->SKUNumber));
-        Print(L"\tFamily=%a\n", GetRecordString(Record, Type1Record->Family));
-        break;
-      }
-      default:
-        Print(L"\tTODO: Parsing for this table is not ready yet\n");
-        break;
-    }
-    Status = SmbiosProtocol->GetNext(SmbiosProtocol,
-                                     &SmbiosHandle,
-                                     NULL,
-                                     &Record,
-                                     NULL);
+  if (ExportFileName != NULL) {
+    return SmbiosExport(UseProtocol, ExportFileName);
   }
-  
+
+  SMBIOS_SOURCE Source;
+  Status = SmbiosWalk(UseProtocol, PrintRecord, &Context, &Source);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't walk SMBIOS structures: %r\n", Status);
+    return Status;
+  }
+
+  CONST CHAR16* SourceName[] = {
+    L"-",
+    L"SMBIOS 3.0 entry point",
+    L"SMBIOS 2.x entry point",
+    L"EFI_SMBIOS_PROTOCOL"
+  };
+  Print(L"\n%d structures were read from %s\n", Context.Count, SourceName[Source]);
+
   return EFI_SUCCESS;
 }
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BenchmarkLib.h>
+#include <Library/GopDrawLib.h>
+#include <Library/GlyphAtlasLib.h>
+
+#define DEFAULT_FRAMES  20
+
+typedef enum {
+  PathConOut,
+  PathAtlasBlt,
+  PathAtlasBackBuffer,
+  PathMax
+} TEXT_PATH;
+
+//
+// Cyrillic characters are drawn only if their glyphs are registered, e.g. with HIIAddRussianFont.efi,
+// otherwise both ConOut and the atlas draw them as empty cells
+//
+STATIC CONST CHAR16 mSample[] = L"The quick brown fox jumps over the lazy dog 0123456789 Съешь же ещё этих мягких французских булок ";
+
+// Same colors as the graphics console uses for EFI_LIGHTGRAY on EFI_BLACK
+STATIC CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL mForeground = { 0xC0, 0xC0, 0xC0, 0x00 };
+STATIC CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL mBackground = { 0x00, 0x00, 0x00, 0x00 };
+
+typedef struct {
+  UINTN   Columns;
+  UINTN   Rows;
+  UINTN   OffsetX;      // Text area is centered on the screen the same way the graphics console does it
+  UINTN   OffsetY;
+  CHAR16  *Text[2];     // Two screens of text, frames alternate between them, every line is Columns long
+} TEXT_SCREEN;
+
+STATIC
+CONST CHAR16*
+ScreenLine (
+  IN TEXT_SCREEN  *Screen,
+  IN UINTN        Frame,
+  IN UINTN        Row
+  )
+{
+  return Screen->Text[Frame & 1] + Row * Screen->Columns;
+}
+
+//
+// The last column is not used, so ConOut never wraps or scrolls the screen
+//
+STATIC
+EFI_STATUS
+CreateScreen (
+  IN  EFI_GRAPHICS_OUTPUT_PROTOCOL  *Gop,
+  OUT TEXT_SCREEN                   *Screen
+  )
+{
+  UINTN Columns;
+  UINTN Rows;
+  EFI_STATUS Status = gST->ConOut->QueryMode(gST->ConOut, gST->ConOut->Mode->Mode, &Columns, &Rows);
+  if (EFI_ERROR(Status)) {
+    return Status;
+  }
+  if ((Columns < 2) || (Rows == 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Screen->Columns = Columns;
+  Screen->Rows = Rows;
+  UINTN Width = Columns * EFI_GLYPH_WIDTH;
+  UINTN Height = Rows * EFI_GLYPH_HEIGHT;
+  Screen->OffsetX = (Gop->Mode->Info->HorizontalResolution > Width) ? (Gop->Mode->Info->HorizontalResolution - Width) / 2 : 0;
+  Screen->OffsetY = (Gop->Mode->Info->VerticalResolution > Height) ? (Gop->Mode->Info->VerticalResolution - Height) / 2 : 0;
+
+  UINTN SampleLength = ARRAY_SIZE(mSample) - 1;
+  for (UINTN i = 0; i < ARRAY_SIZE(Screen->Text); i++) {
+    Screen->Text[i] = AllocatePool(Rows * Columns * sizeof(CHAR16));
+    if (Screen->Text[i] == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    for (UINTN Row = 0; Row < Rows; Row++) {
+      CHAR16* Line = Screen->Text[i] + Row * Columns;
+      for (UINTN Column = 0; Column < Columns - 1; Column++) {
+        Line[Column] = mSample[(i + Row + Column) % SampleLength];
+      }
+      Line[Columns - 1] = L'\0';
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FreeScreen (
+  IN TEXT_SCREEN  *Screen
+  )
+{
+  for (UINTN i = 0; i < ARRAY_SIZE(Screen->Text); i++) {
+    if (Screen->Text[i] != NULL) {
+      FreePool(Screen->Text[i]);
+      Screen->Text[i] = NULL;
+    }
+  }
+}
+
+STATIC
+EFI_STATUS
+RedrawConOut (
+  IN TEXT_SCREEN  *Screen,
+  IN UINTN        Frame
+  )
+{
+  for (UINTN Row = 0; Row < Screen->Rows; Row++) {
+    gST->ConOut->SetCursorPosition(gST->ConOut, 0, Row);
+    EFI_STATUS Status = gST->ConOut->OutputString(gST->ConOut, (CHAR16*)ScreenLine(Screen, Frame, Row));
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+RedrawAtlasBlt (
+  IN TEXT_SCREEN                   *Screen,
+  IN GLYPH_ATLAS                   *Atlas,
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL  *Gop,
+  IN UINTN                         Frame
+  )
+{
+  for (UINTN Row = 0; Row < Screen->Rows; Row++) {
+    EFI_STATUS Status = GlyphAtlasBltString(
+      Atlas,
+      Gop,
+      Screen->OffsetX,
+      Screen->OffsetY + Row * EFI_GLYPH_HEIGHT,
+      ScreenLine(Screen, Frame, Row)
+    );
+    if (EFI_ERROR(Status)) {
+      return Status;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+RedrawAtlasBackBuffer (
+  IN TEXT_SCREEN       *Screen,
+  IN GLYPH_ATLAS       *Atlas,
+  IN GOP_DRAW_CONTEXT  *Context,
+  IN UINTN             Frame
+  )
+{
+  for (UINTN Row = 0; Row < Screen->Rows; Row++) {
+    GlyphAtlasDrawString(
+      Atlas,
+      Context,
+      Screen->OffsetX,
+      Screen->OffsetY + Row * EFI_GLYPH_HEIGHT,
+      ScreenLine(Screen, Frame, Row)
+    );
+  }
+  // All lines are transferred with a single Blt
+  return GopDrawFlushDirty(Context);
+}
+
+STATIC
+UINT64
+Fps100 (
+  IN UINT64  Frames,
+  IN UINT64  Ticks
+  )
+{
+  UINT64 Ns = BenchmarkTicksToNs(Ticks);
+  if (Ns == 0) {
+    Ns = 1;
+  }
+  return DivU64x64Remainder(MultU64x64(Frames, 100000000000ULL), Ns, NULL);
+}
+
+STATIC
+EFI_STATUS
+BenchmarkPath (
+  IN  TEXT_PATH         Path,
+  IN  TEXT_SCREEN       *Screen,
+  IN  GLYPH_ATLAS       *Atlas,
+  IN  GOP_DRAW_CONTEXT  *Context,
+  IN  UINTN             Frames,
+  OUT UINT64            *Result
+  )
+{
+  EFI_STATUS Status = EFI_SUCCESS;
+  UINT64 Start = BenchmarkGetTicks();
+  for (UINTN Frame = 0; (Frame < Frames) && !EFI_ERROR(Status); Frame++) {
+    switch (Path) {
+      case PathConOut:
+        Status = RedrawConOut(Screen, Frame);
+        break;
+      case PathAtlasBlt:
+        Status = RedrawAtlasBlt(Screen, Atlas, Context->Gop, Frame);
+        break;
+      case PathAtlasBackBuffer:
+        Status = RedrawAtlasBackBuffer(Screen, Atlas, Context, Frame);
+        break;
+      default:
+        Status = EFI_INVALID_PARAMETER;
+        break;
+    }
+  }
+  *Result = Fps100(Frames, BenchmarkGetTicks() - Start);
+  return Status;
+}
+
+VOID Usage()
+{
+  Print(L"Usage:\n");
+  Print(L"  TextBenchmark [-f <frames>]\n");
+  Print(L"    -f <frames>  full-screen redraws for every test (default %d)\n", DEFAULT_FRAMES);
+  Print(L"Run HIIAddRussianFont.efi first to get the Cyrillic glyphs in the sample text\n");
+}
+
+INTN EFIAPI ShellAppMain(IN UINTN Argc, IN CHAR16 **Argv)
+{
+  UINTN Frames = DEFAULT_FRAMES;
+  for (UINTN i = 1; i < Argc; i++) {
+    if (!StrCmp(Argv[i], L"-f") && ((i + 1) < Argc)) {
+      Frames = StrDecimalToUintn(Argv[++i]);
+    } else {
+      Usage();
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+  if (Frames == 0) {
+    Usage();
+    return EFI_INVALID_PARAMETER;
+  }
+
+  EFI_GRAPHICS_OUTPUT_PROTOCOL* Gop;
+  EFI_STATUS Status = gBS->LocateProtocol(
+    &gEfiGraphicsOutputProtocolGuid,
+    NULL,
+    (VOID **)&Gop
+  );
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't locate GOP: %r\n", Status);
+    return Status;
+  }
+
+  // Glyphs are rasterized only once, the time is reported separately from the redraws
+  GLYPH_ATLAS Atlas;
+  UINT64 AtlasStart = BenchmarkGetTicks();
+  Status = GlyphAtlasInit(&Atlas, mForeground, mBackground);
+  if (!EFI_ERROR(Status)) {
+    Status = GlyphAtlasAddRegisteredFonts(&Atlas);
+  }
+  UINT64 AtlasNs = BenchmarkTicksToNs(BenchmarkGetTicks() - AtlasStart);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't create glyph atlas: %r\n", Status);
+    GlyphAtlasFree(&Atlas);
+    return Status;
+  }
+
+  TEXT_SCREEN Screen;
+  ZeroMem(&Screen, sizeof(Screen));
+  Status = CreateScreen(Gop, &Screen);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't get text mode: %r\n", Status);
+    FreeScreen(&Screen);
+    GlyphAtlasFree(&Atlas);
+    return Status;
+  }
+
+  GOP_DRAW_CONTEXT Context;
+  Status = GopDrawInit(Gop, &Context);
+  if (EFI_ERROR(Status)) {
+    Print(L"Error! Can't allocate off-screen buffer: %r\n", Status);
+    FreeScreen(&Screen);
+    GlyphAtlasFree(&Atlas);
+    return Status;
+  }
+
+  // Nothing is printed during the benchmark, every test draws over the whole text area
+  BOOLEAN CursorVisible = gST->ConOut->Mode->CursorVisible;
+  gST->ConOut->EnableCursor(gST->ConOut, FALSE);
+  gST->ConOut->SetAttribute(gST->ConOut, EFI_TEXT_ATTR(EFI_LIGHTGRAY, EFI_BLACK));
+  gST->ConOut->ClearScreen(gST->ConOut);
+
+  UINT64 Result[PathMax];
+  EFI_STATUS PathStatus[PathMax];
+  for (UINTN Path = 0; Path < PathMax; Path++) {
+    PathStatus[Path] = BenchmarkPath((TEXT_PATH)Path, &Screen, &Atlas, &Context, Frames, &Result[Path]);
+  }
+
+  gST->ConOut->ClearScreen(gST->ConOut);
+  gST->ConOut->EnableCursor(gST->ConOut, CursorVisible);
+
+  Print(L"Full-screen text redraw, %dx%d characters, %d frames per test\n", Screen.Columns - 1, Screen.Rows, Frames);
+  Print(L"Glyph atlas: %d glyphs, %d KB, created in %ld us\n\n",
+        Atlas.GlyphCount,
+        (Atlas.PixelCount * sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL)) / 1024,
+        DivU64x32(AtlasNs, 1000));
+
+  CONST CHAR16* PathNames[] = {
+    L"ConOut",
+    L"Atlas, Blt per line",
+    L"Atlas, back buffer"
+  };
+  Print(L"%-20s  %14s  %10s\n", L"Path", L"Frames/s", L"Speedup");
+  for (UINTN Path = 0; Path < PathMax; Path++) {
+    if (EFI_ERROR(PathStatus[Path])) {
+      Print(L"%-20s  Error! %r\n", PathNames[Path], PathStatus[Path]);
+      continue;
+    }
+    Print(L"%-20s  %11ld.%02ld", PathNames[Path], DivU64x32(Result[Path], 100), ModU64x32(Result[Path], 100));
+    if (!EFI_ERROR(PathStatus[PathConOut]) && (Result[PathConOut] != 0)) {
+      UINT64 Speedup100 = DivU64x64Remainder(MultU64x64(Result[Path], 100), Result[PathConOut], NULL);
+      Print(L"  %7ld.%02ldx", DivU64x32(Speedup100, 100), ModU64x32(Speedup100, 100));
+    }
+    Print(L"\n");
+  }
+
+  GopDrawFree(&Context);
+  FreeScreen(&Screen);
+  GlyphAtlasFree(&Atlas);
+  return EFI_SUCCESS;
+}
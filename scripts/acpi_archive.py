@@ -0,0 +1,98 @@
+##
+# Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+##
+
+# List/extract ACPI tables from the archive created with 'AcpiInfo.efi archive'
+
+import os
+import struct
+import sys
+from argparse import ArgumentParser
+
+ARCHIVE_SIGNATURE = b"ACPIARCH"
+HEADER_FORMAT = "<8sIIQ"      # Signature, Version, TableCount, IndexOffset
+ENTRY_FORMAT = "<4sIQQQIB3x"  # Signature, Index, OemTableId, Address, Offset, Length, ChecksumState
+
+CHECKSUM_STATES = {0: "INVALID", 1: "OK", 2: "-"}
+
+
+def oem_table_id_file_part(oem_table_id):
+    """OEM Table ID part of the file name, the same rule as GetTableFileName() in AcpiInfo.c:
+    every byte that is not an ASCII letter or digit becomes '_', and the trailing non-alphanumeric
+    bytes (space/NUL padding, punctuation) are dropped."""
+    raw = struct.pack("<Q", oem_table_id)
+    name = "".join(chr(b) if chr(b).isascii() and chr(b).isalnum() else "_" for b in raw)
+    length = 0
+    for i, b in enumerate(raw):
+        if chr(b).isascii() and chr(b).isalnum():
+            length = i + 1
+    return name[:length]
+
+
+def read_archive(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    signature, version, count, index_offset = struct.unpack_from(HEADER_FORMAT, data, 0)
+    if signature != ARCHIVE_SIGNATURE:
+        sys.exit(f"Error! {path} is not an ACPI archive")
+    if version != 1:
+        sys.exit(f"Error! Unsupported archive version {version}")
+
+    tables = []
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+    for i in range(count):
+        sig, index, oem_table_id, address, offset, length, checksum = struct.unpack_from(ENTRY_FORMAT, data, index_offset + i * entry_size)
+        tables.append({
+            "signature": sig.decode("ascii", "replace"),
+            "index": index,
+            "oem_table_id": struct.pack("<Q", oem_table_id).decode("ascii", "replace").rstrip(" \0"),
+            "oem_table_id_file_part": oem_table_id_file_part(oem_table_id),
+            "address": address,
+            "data": data[offset:offset + length],
+            "checksum": checksum,
+        })
+
+    # Same rules as in AcpiInfo: only tables with duplicate signatures get index and OEM table ID in name
+    counts = {}
+    for t in tables:
+        counts[t["signature"]] = counts.get(t["signature"], 0) + 1
+    for t in tables:
+        if counts[t["signature"]] > 1 and t["signature"] != "FACS":
+            t["file_name"] = f"{t['signature']}_{t['index']}_{t['oem_table_id_file_part']}.aml"
+        else:
+            t["file_name"] = f"{t['signature']}.aml"
+    return tables
+
+
+def list_tables(tables):
+    print(f"{'#':>3}  {'Name':<24}{'OEM Table ID':<14}{'Address':<20}{'Length':<10}Checksum")
+    for i, t in enumerate(tables):
+        print(f"{i:>3}  {t['file_name']:<24}{t['oem_table_id']:<14}{t['address']:<#20x}{len(t['data']):<#10x}{CHECKSUM_STATES.get(t['checksum'], '?')}")
+
+
+def extract_tables(tables, out_dir):
+    os.makedirs(out_dir, exist_ok=True)
+    for t in tables:
+        with open(os.path.join(out_dir, t["file_name"]), "wb") as f:
+            f.write(t["data"])
+        print(f"Save {t['file_name']}")
+
+
+def main():
+    parser = ArgumentParser(description="List/extract ACPI tables from the archive created with 'AcpiInfo.efi archive'")
+    parser.add_argument("archive", help="archive file")
+    parser.add_argument("-x", "--extract", metavar="DIR", help="extract all tables to the directory")
+    args = parser.parse_args()
+
+    tables = read_archive(args.archive)
+    if args.extract:
+        extract_tables(tables, args.extract)
+    else:
+        list_tables(tables)
+
+
+if __name__ == "__main__":
+    main()
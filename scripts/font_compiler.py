@@ -0,0 +1,383 @@
+##
+# Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+##
+
+# Compile BDF/PSF fonts to EFI_NARROW_GLYPH/EFI_WIDE_GLYPH arrays or to a simple font package binary
+#
+# C output has the same format as 'HIIAddRussianFont/RussianFont.c', so it can replace that file as is.
+# Binary output is the package in the form that HiiAddPackages() accepts (UINT32 length followed by
+# EFI_HII_SIMPLE_FONT_PACKAGE_HDR and glyphs), the same buffer 'CreateSimpleFontPkg' creates.
+#
+# Simple font package can't share one bitmap between several characters, so the package is kept small
+# by the range selection and by dropping glyphs that don't need to be registered:
+#  - characters mapped to the same glyph several times (e.g. by the PSF unicode table) are added once,
+#  - glyphs identical to the font placeholder (BDF DEFAULT_CHAR or U+FFFD) are dropped, the character
+#    is missing from the font anyway,
+#  - empty glyphs are dropped unless the character is a whitespace.
+
+import re
+import struct
+import sys
+import unicodedata
+from argparse import ArgumentParser
+
+EFI_GLYPH_HEIGHT = 19
+EFI_GLYPH_WIDTH = 8
+
+EFI_GLYPH_NON_SPACING = 0x01
+EFI_GLYPH_WIDE = 0x02
+
+EFI_HII_PACKAGE_SIMPLE_FONTS = 0x07
+
+NARROW_GLYPH_FORMAT = f"<HB{EFI_GLYPH_HEIGHT}s"                          # UnicodeWeight, Attributes, GlyphCol1
+WIDE_GLYPH_FORMAT = f"<HB{EFI_GLYPH_HEIGHT}s{EFI_GLYPH_HEIGHT}s3x"       # UnicodeWeight, Attributes, GlyphCol1, GlyphCol2, Pad
+SIMPLE_FONT_HEADER_FORMAT = "<IHH"                                       # Header (Length:24, Type:8), NumberOfNarrowGlyphs, NumberOfWideGlyphs
+
+PSF1_MAGIC = b"\x36\x04"
+PSF1_MODE512 = 0x01
+PSF1_MODEHASTAB = 0x02
+PSF1_SEPARATOR = 0xFFFF
+PSF1_STARTSEQ = 0xFFFE
+
+PSF2_MAGIC = b"\x72\xb5\x4a\x86"
+PSF2_HEADER_FORMAT = "<4sIIIIIII"    # Magic, Version, HeaderSize, Flags, Length, CharSize, Height, Width
+PSF2_HAS_UNICODE_TABLE = 0x01
+PSF2_SEPARATOR = 0xFF
+PSF2_STARTSEQ = 0xFE
+
+
+class Glyph:
+    # Rows are integers, the most significant of 'width' bits is the leftmost pixel
+    def __init__(self, width, bitmap_width, rows, x_offset=0, y_offset=0):
+        self.width = width          # Advance width, selects the narrow or wide cell
+        self.bitmap_width = bitmap_width
+        self.rows = rows
+        self.x_offset = x_offset    # From the left side of the cell
+        self.y_offset = y_offset    # From the baseline to the bottom row, BDF style
+
+
+class Font:
+    def __init__(self):
+        self.glyphs = {}            # Code point -> Glyph
+        self.ascent = 0
+        self.descent = 0
+        self.default_char = None
+
+    def add(self, code_point, glyph):
+        # The first glyph for the code point wins
+        if code_point not in self.glyphs:
+            self.glyphs[code_point] = glyph
+
+
+def parse_bdf(path):
+    font = Font()
+    with open(path, "r", encoding="latin-1") as f:
+        lines = f.read().splitlines()
+
+    font_box = None
+    i = 0
+    while i < len(lines):
+        words = lines[i].split()
+        i += 1
+        if not words:
+            continue
+        key = words[0]
+        if key == "FONTBOUNDINGBOX":
+            font_box = [int(w) for w in words[1:5]]
+        elif key == "FONT_ASCENT":
+            font.ascent = int(words[1])
+        elif key == "FONT_DESCENT":
+            font.descent = int(words[1])
+        elif key == "DEFAULT_CHAR":
+            font.default_char = int(words[1])
+        elif key == "STARTCHAR":
+            encoding = -1
+            advance = None
+            box = font_box
+            rows = []
+            while i < len(lines):
+                words = lines[i].split()
+                i += 1
+                if not words:
+                    continue
+                if words[0] == "ENCODING":
+                    encoding = int(words[1])
+                elif words[0] == "DWIDTH":
+                    advance = int(words[1])
+                elif words[0] == "BBX":
+                    box = [int(w) for w in words[1:5]]
+                elif words[0] == "BITMAP":
+                    while i < len(lines) and lines[i].strip() != "ENDCHAR":
+                        rows.append(lines[i].strip())
+                        i += 1
+                    i += 1
+                    break
+            if encoding < 0 or box is None:
+                continue
+            width, height, x_offset, y_offset = box
+            row_bits = len(rows[0]) * 4 if rows else 0
+            # BITMAP rows are padded to bytes, drop the padding bits
+            bitmap = [int(r, 16) >> (row_bits - width) if width else 0 for r in rows[:height]]
+            font.add(encoding, Glyph(advance if advance is not None else width, width, bitmap, x_offset, y_offset))
+
+    if font_box is not None and font.ascent == 0 and font.descent == 0:
+        font.ascent = font_box[1] + font_box[3]
+        font.descent = -font_box[3]
+    return font
+
+
+def psf_bitmap(data, offset, width, height):
+    row_size = (width + 7) // 8
+    rows = []
+    for y in range(height):
+        row = int.from_bytes(data[offset + y * row_size:offset + (y + 1) * row_size], "big")
+        rows.append(row >> (row_size * 8 - width))
+    return rows
+
+
+def parse_psf(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    font = Font()
+    if data[:2] == PSF1_MAGIC:
+        mode, char_size = data[2], data[3]
+        count = 512 if mode & PSF1_MODE512 else 256
+        width, height = 8, char_size
+        offset = 4
+        bitmaps = [psf_bitmap(data, offset + i * char_size, width, height) for i in range(count)]
+        table = None
+        if mode & PSF1_MODEHASTAB:
+            pos = offset + count * char_size
+            table = []
+            for _ in range(count):
+                code_points = []
+                in_sequence = False
+                while True:
+                    (value,) = struct.unpack_from("<H", data, pos)
+                    pos += 2
+                    if value == PSF1_SEPARATOR:
+                        break
+                    if value == PSF1_STARTSEQ:
+                        in_sequence = True
+                    elif not in_sequence:
+                        code_points.append(value)
+                table.append(code_points)
+    elif data[:4] == PSF2_MAGIC:
+        _, _, header_size, flags, count, char_size, height, width = struct.unpack_from(PSF2_HEADER_FORMAT, data, 0)
+        bitmaps = [psf_bitmap(data, header_size + i * char_size, width, height) for i in range(count)]
+        table = None
+        if flags & PSF2_HAS_UNICODE_TABLE:
+            pos = header_size + count * char_size
+            table = []
+            for _ in range(count):
+                end = data.index(PSF2_SEPARATOR, pos)
+                entry = data[pos:end]
+                pos = end + 1
+                # Character sequences (e.g. letter + combining mark) can't be registered as one glyph
+                single = entry.split(bytes([PSF2_STARTSEQ]))[0]
+                table.append([ord(c) for c in single.decode("utf-8")])
+    else:
+        sys.exit(f"Error! {path} is not a PSF font")
+
+    # Without the unicode table glyph index is the code point
+    if table is None:
+        table = [[i] for i in range(count)]
+    for index, code_points in enumerate(table):
+        for code_point in code_points:
+            font.add(code_point, Glyph(width, width, bitmaps[index]))
+
+    font.ascent = height
+    font.descent = 0
+    return font
+
+
+def parse_ranges(values):
+    ranges = []
+    for value in values:
+        for item in value.split(","):
+            m = re.fullmatch(r"(?:U\+|0x)?([0-9A-Fa-f]+)(?:-(?:U\+|0x)?([0-9A-Fa-f]+))?", item.strip())
+            if not m:
+                sys.exit(f"Error! Wrong range '{item}'")
+            first = int(m.group(1), 16)
+            last = int(m.group(2), 16) if m.group(2) else first
+            if first > last:
+                sys.exit(f"Error! Wrong range '{item}'")
+            ranges.append((first, last))
+    return ranges
+
+
+class Rasterizer:
+    # Place glyphs into EFI_GLYPH_HEIGHT rows with the common baseline
+    def __init__(self, font, baseline):
+        if baseline is None:
+            # Center the font cell vertically
+            top = max((EFI_GLYPH_HEIGHT - (font.ascent + font.descent)) // 2, 0)
+            baseline = top + font.ascent
+        self.baseline = baseline
+        self.clipped = 0
+
+    def cell(self, glyph):
+        cell_width = EFI_GLYPH_WIDTH if glyph.width <= EFI_GLYPH_WIDTH else 2 * EFI_GLYPH_WIDTH
+        rows = [0] * EFI_GLYPH_HEIGHT
+        height = len(glyph.rows)
+        top = self.baseline - (glyph.y_offset + height)
+        clipped = False
+        for y, bits in enumerate(glyph.rows):
+            row = top + y
+            shift = cell_width - glyph.bitmap_width - glyph.x_offset
+            value = bits << shift if shift >= 0 else bits >> -shift
+            if value >> cell_width:
+                clipped = True
+                value &= (1 << cell_width) - 1
+            if not 0 <= row < EFI_GLYPH_HEIGHT:
+                clipped = clipped or bits != 0
+                continue
+            rows[row] = value
+        if clipped:
+            self.clipped += 1
+        return cell_width, rows
+
+
+def attributes(code_point, wide):
+    attr = EFI_GLYPH_WIDE if wide else 0
+    if unicodedata.combining(chr(code_point)):
+        attr |= EFI_GLYPH_NON_SPACING
+    return attr
+
+
+def compile_font(font, ranges, chars, baseline, keep_duplicates):
+    rasterizer = Rasterizer(font, baseline)
+
+    placeholder = None
+    for code_point in (font.default_char, 0xFFFD):
+        if code_point is not None and code_point in font.glyphs:
+            placeholder = rasterizer.cell(font.glyphs[code_point])
+            break
+
+    narrow = []
+    wide = []
+    stats = {"skipped": 0, "placeholder": 0, "empty": 0, "too_wide": 0}
+    unique = set()
+    for code_point in sorted(font.glyphs):
+        if code_point > 0xFFFF:
+            stats["skipped"] += 1
+            continue
+        if ranges and not any(first <= code_point <= last for first, last in ranges):
+            continue
+        if chars is not None and code_point not in chars:
+            continue
+        glyph = font.glyphs[code_point]
+        if glyph.width > 2 * EFI_GLYPH_WIDTH:
+            stats["too_wide"] += 1
+            continue
+        cell = rasterizer.cell(glyph)
+        if not keep_duplicates:
+            if placeholder is not None and cell == placeholder and code_point not in (font.default_char, 0xFFFD):
+                stats["placeholder"] += 1
+                continue
+            if not any(cell[1]) and not chr(code_point).isspace():
+                stats["empty"] += 1
+                continue
+        unique.add((cell[0], tuple(cell[1])))
+        cell_width, rows = cell
+        if cell_width == EFI_GLYPH_WIDTH:
+            narrow.append((code_point, attributes(code_point, False), rows))
+        else:
+            wide.append((code_point, attributes(code_point, True), rows))
+
+    if len(narrow) > 0xFFFF or len(wide) > 0xFFFF:
+        sys.exit("Error! Too many glyphs for one simple font package, select smaller ranges")
+
+    stats["unique"] = len(unique)
+    stats["clipped"] = rasterizer.clipped
+    return narrow, wide, stats
+
+
+def glyph_bytes(values):
+    return ",".join(f"0x{v:02x}" for v in values)
+
+
+def write_c(path, narrow, wide, name):
+    out = []
+    out.append("/*")
+    out.append(" * Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>")
+    out.append(" *")
+    out.append(" * SPDX-License-Identifier: MIT")
+    out.append(" */")
+    out.append("")
+    out.append("// Generated with scripts/font_compiler.py")
+    out.append("")
+    # C doesn't allow empty arrays, the dummy entry is not counted in the size variable
+    out.append(f"EFI_WIDE_GLYPH {name}WideGlyphData[] = {{")
+    for code_point, attr, rows in wide:
+        left = glyph_bytes(r >> 8 for r in rows)
+        right = glyph_bytes(r & 0xFF for r in rows)
+        out.append(f"{{ 0x{code_point:x}, 0x{attr:02x}, {{ {left}}}, {{ {right}}}, {{ 0x00,0x00,0x00}}}},")
+    if not wide:
+        out.append(f"{{ 0x00, 0x00, {{ {glyph_bytes([0] * EFI_GLYPH_HEIGHT)}}}}}")
+    out.append("};")
+    out.append(f"UINT32 {name}WideBytes = {'sizeof(' + name + 'WideGlyphData)' if wide else '0'};")
+    out.append("")
+    out.append(f"EFI_NARROW_GLYPH {name}NarrowGlyphData[] = {{")
+    for code_point, attr, rows in narrow:
+        out.append(f"{{ 0x{code_point:x}, 0x{attr:02x}, {{ {glyph_bytes(rows)}}}}},")
+    if not narrow:
+        out.append(f"{{ 0x00, 0x00, {{ {glyph_bytes([0] * EFI_GLYPH_HEIGHT)}}}}}")
+    out.append("};")
+    out.append(f"UINT32 {name}NarrowBytes = {'sizeof(' + name + 'NarrowGlyphData)' if narrow else '0'};")
+    with open(path, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+def write_package(path, narrow, wide):
+    body = b"".join(struct.pack(NARROW_GLYPH_FORMAT, cp, attr, bytes(rows)) for cp, attr, rows in narrow)
+    body += b"".join(struct.pack(WIDE_GLYPH_FORMAT, cp, attr, bytes(r >> 8 for r in rows), bytes(r & 0xFF for r in rows)) for cp, attr, rows in wide)
+    package_length = struct.calcsize(SIMPLE_FONT_HEADER_FORMAT) + len(body)
+    if package_length >= (1 << 24):
+        sys.exit("Error! Package is too big, select smaller ranges")
+    header = struct.pack(SIMPLE_FONT_HEADER_FORMAT, package_length | (EFI_HII_PACKAGE_SIMPLE_FONTS << 24), len(narrow), len(wide))
+    with open(path, "wb") as f:
+        # HiiAddPackages() takes every package with the UINT32 length prefix
+        f.write(struct.pack("<I", package_length + 4))
+        f.write(header)
+        f.write(body)
+
+
+parser = ArgumentParser(description="Compile BDF/PSF font to EFI_NARROW_GLYPH/EFI_WIDE_GLYPH arrays or to a simple font package binary")
+parser.add_argument("font", help="BDF or PSF (version 1 or 2) font file")
+parser.add_argument("-o", "--output", required=True, help="output file")
+parser.add_argument("-f", "--format", choices=["c", "bin"], default="c", help="C arrays (default) or package binary for HiiAddPackages()")
+parser.add_argument("-r", "--range", action="append", default=[], help="code points to include, e.g. 'U+0400-U+045F' or '0x4E00-0x9FFF,0x3000' (can be repeated, default is all)")
+parser.add_argument("-t", "--text", action="append", default=[], help="include only the characters used in the UTF-8 text file, e.g. the .uni strings of the driver (can be repeated)")
+parser.add_argument("-n", "--name", default="gSimpleFont", help="prefix of the C symbols (default 'gSimpleFont', the names 'HIIAddRussianFont' uses)")
+parser.add_argument("-b", "--baseline", type=int, help="baseline row in the 19-row glyph cell (default centers the font)")
+parser.add_argument("--keep-duplicates", action="store_true", help="don't drop empty and placeholder glyphs")
+args = parser.parse_args()
+
+with open(args.font, "rb") as f:
+    magic = f.read(4)
+font = parse_psf(args.font) if magic[:2] == PSF1_MAGIC or magic == PSF2_MAGIC else parse_bdf(args.font)
+if font.ascent + font.descent > EFI_GLYPH_HEIGHT:
+    print(f"Warning! Font height {font.ascent + font.descent} is bigger than {EFI_GLYPH_HEIGHT}, glyphs are clipped", file=sys.stderr)
+
+chars = None
+if args.text:
+    chars = set()
+    for path in args.text:
+        with open(path, "r", encoding="utf-8-sig") as f:
+            chars.update(ord(c) for c in f.read())
+
+narrow, wide, stats = compile_font(font, parse_ranges(args.range), chars, args.baseline, args.keep_duplicates)
+if args.format == "c":
+    write_c(args.output, narrow, wide, args.name)
+else:
+    write_package(args.output, narrow, wide)
+
+size = struct.calcsize(SIMPLE_FONT_HEADER_FORMAT) + len(narrow) * struct.calcsize(NARROW_GLYPH_FORMAT) + len(wide) * struct.calcsize(WIDE_GLYPH_FORMAT)
+print(f"Glyphs: {len(narrow)} narrow, {len(wide)} wide, {stats['unique']} unique bitmaps, package size 0x{size:X}")
+print(f"Dropped: {stats['placeholder']} placeholder, {stats['empty']} empty, {stats['too_wide']} wider than {2 * EFI_GLYPH_WIDTH} pixels, {stats['skipped']} outside of UCS-2")
+if stats["clipped"]:
+    print(f"Warning! {stats['clipped']} glyphs don't fit the cell and are clipped", file=sys.stderr)
@@ -0,0 +1,154 @@
+##
+# Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+##
+
+# List/extract HII package lists from the archive created with 'ShowHIIext.efi archive'
+
+import os
+import struct
+import sys
+import uuid
+import zlib
+from argparse import ArgumentParser
+
+ARCHIVE_SIGNATURE = b"HII_ARCH"
+HEADER_FORMAT = "<8sIIIIQ"    # Signature, Version, ListCount, PackageCount, RefCount, IndexOffset
+PACKAGE_FORMAT = "<QIIIIBBH"  # Offset, StoredSize, Size, Crc32, RefCount, Type, Compression, Reserved
+LIST_FORMAT = "<16sII"        # Guid, FirstRef, PackageCount
+
+STORED = 0
+LZSS = 1
+
+PACKAGE_TYPES = {
+    0x01: "GUID", 0x02: "FORMS", 0x04: "STRINGS", 0x05: "FONTS", 0x06: "IMAGES",
+    0x07: "SIMPLE_FONTS", 0x08: "DEVICE_PATH", 0x09: "KEYBOARD_LAYOUT", 0x0A: "ANIMATIONS",
+    0xDF: "END",
+}
+
+
+def lzss_decompress(data, size):
+    out = bytearray()
+    pos = 0
+    while len(out) < size:
+        flags = data[pos]
+        pos += 1
+        for bit in range(8):
+            if len(out) >= size:
+                break
+            if flags & (1 << bit):
+                item = data[pos] | (data[pos + 1] << 8)
+                pos += 2
+                distance = (item & 0xFFF) + 1
+                length = (item >> 12) + 3
+                # Byte by byte, the match can overlap the output
+                for _ in range(length):
+                    out.append(out[-distance])
+            else:
+                out.append(data[pos])
+                pos += 1
+    return bytes(out)
+
+
+class Archive:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+
+        signature, version, list_count, package_count, ref_count, index_offset = struct.unpack_from(HEADER_FORMAT, self.data, 0)
+        if signature != ARCHIVE_SIGNATURE:
+            sys.exit(f"Error! {path} is not an HII archive")
+        if version != 1:
+            sys.exit(f"Error! Unsupported archive version {version}")
+
+        offset = index_offset
+        self.packages = []
+        for _ in range(package_count):
+            p_offset, stored_size, size, crc, refs, p_type, compression, _ = struct.unpack_from(PACKAGE_FORMAT, self.data, offset)
+            self.packages.append({
+                "offset": p_offset, "stored_size": stored_size, "size": size, "crc": crc,
+                "refs": refs, "type": p_type, "compression": compression,
+            })
+            offset += struct.calcsize(PACKAGE_FORMAT)
+
+        lists = []
+        for _ in range(list_count):
+            guid, first_ref, count = struct.unpack_from(LIST_FORMAT, self.data, offset)
+            lists.append((uuid.UUID(bytes_le=guid), first_ref, count))
+            offset += struct.calcsize(LIST_FORMAT)
+
+        refs = struct.unpack_from(f"<{ref_count}I", self.data, offset)
+        self.lists = [{"guid": guid, "packages": list(refs[first:first + count])} for guid, first, count in lists]
+
+    def package(self, index):
+        # Only the requested package is decompressed
+        p = self.packages[index]
+        stored = self.data[p["offset"]:p["offset"] + p["stored_size"]]
+        if p["compression"] == STORED:
+            data = stored
+        elif p["compression"] == LZSS:
+            data = lzss_decompress(stored, p["size"])
+        else:
+            sys.exit(f"Error! Package {index} has unknown compression {p['compression']}")
+        if zlib.crc32(data) != p["crc"]:
+            sys.exit(f"Error! Package {index} CRC32 mismatch")
+        return data
+
+    def package_list(self, index):
+        l = self.lists[index]
+        payload = b"".join(self.package(i) for i in l["packages"])
+        return l["guid"].bytes_le + struct.pack("<I", 20 + len(payload)) + payload
+
+
+def type_name(t):
+    return PACKAGE_TYPES.get(t, f"0x{t:02X}")
+
+
+def list_lists(archive):
+    for i, l in enumerate(archive.lists):
+        size = 20 + sum(archive.packages[p]["size"] for p in l["packages"])
+        print(f"PackageList[{i}]: GUID={l['guid']}; size=0x{size:X}")
+        for j, p in enumerate(l["packages"]):
+            package = archive.packages[p]
+            print(f"\tPackage[{j}]: type={type_name(package['type'])}; size=0x{package['size']:X}; unique #{p}")
+
+
+def list_packages(archive):
+    print(f"{'#':>5}  {'Type':<16}{'Size':<10}{'Stored':<10}{'Refs':<6}CRC32")
+    for i, p in enumerate(archive.packages):
+        print(f"{i:>5}  {type_name(p['type']):<16}{p['size']:<#10x}{p['stored_size']:<#10x}{p['refs']:<6}{p['crc']:08x}")
+    total = sum(p["size"] * p["refs"] for p in archive.packages)
+    unique = sum(p["size"] for p in archive.packages)
+    stored = sum(p["stored_size"] for p in archive.packages)
+    print(f"Packages: 0x{total:X} bytes, unique: 0x{unique:X} bytes, stored: 0x{stored:X} bytes")
+
+
+def extract_lists(archive, out_dir, indexes):
+    os.makedirs(out_dir, exist_ok=True)
+    for i in indexes:
+        # Same names as 'ShowHIIext.efi save'
+        file_name = f"{i:04d}_{str(archive.lists[i]['guid']).upper()}"
+        with open(os.path.join(out_dir, file_name), "wb") as f:
+            f.write(archive.package_list(i))
+        print(f"Save {file_name}")
+
+
+parser = ArgumentParser(description="List/extract HII package lists from the archive created with 'ShowHIIext.efi archive'")
+parser.add_argument("archive", help="archive file")
+parser.add_argument("-p", "--packages", action="store_true", help="list unique packages instead of package lists")
+parser.add_argument("-x", "--extract", metavar="DIR", help="extract package lists to the directory")
+parser.add_argument("-i", "--index", type=int, action="append", help="extract only the package list with the index (can be repeated)")
+args = parser.parse_args()
+
+archive = Archive(args.archive)
+if args.extract:
+    indexes = args.index if args.index else range(len(archive.lists))
+    for i in indexes:
+        if not 0 <= i < len(archive.lists):
+            sys.exit(f"Error! There is no PackageList {i}")
+    extract_lists(archive, args.extract, indexes)
+elif args.packages:
+    list_packages(archive)
+else:
+    list_lists(archive)
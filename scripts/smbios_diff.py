@@ -0,0 +1,222 @@
+##
+# Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+##
+
+# Show/compare SMBIOS exports created with 'SmbiosInfo.efi -o <file>'
+
+import json
+import struct
+import sys
+from argparse import ArgumentParser
+
+EXPORT_SIGNATURE = b"SMBIOSEX"
+HEADER_FORMAT = "<8sIBBBBIIIII"  # Signature, Version, SmbiosMajorVersion, SmbiosMinorVersion, Source, Reserved,
+                                 # StructureCount, TableOffset, TableSize, SummaryOffset, SummarySize
+
+SOURCES = {0: "-", 1: "SMBIOS 3.0 entry point", 2: "SMBIOS 2.x entry point", 3: "EFI_SMBIOS_PROTOCOL"}
+
+# Fields that are compared: (offset, kind, name), kind is 'B', 'H', 'I', 'Q' or 's' for the string number
+FIELDS = {
+    0: [(0x04, "s", "Vendor"), (0x05, "s", "BiosVersion"), (0x08, "s", "BiosReleaseDate"),
+        (0x14, "B", "SystemBiosMajorRelease"), (0x15, "B", "SystemBiosMinorRelease")],
+    1: [(0x04, "s", "Manufacturer"), (0x05, "s", "ProductName"), (0x06, "s", "Version"),
+        (0x07, "s", "SerialNumber"), (0x19, "s", "SKUNumber"), (0x1A, "s", "Family")],
+    2: [(0x04, "s", "Manufacturer"), (0x05, "s", "ProductName"), (0x06, "s", "Version"),
+        (0x07, "s", "SerialNumber"), (0x08, "s", "AssetTag")],
+    4: [(0x04, "s", "Socket"), (0x07, "s", "ProcessorManufacturer"), (0x10, "s", "ProcessorVersion"),
+        (0x14, "H", "MaxSpeed"), (0x16, "H", "CurrentSpeed"), (0x18, "B", "Status"),
+        (0x20, "s", "SerialNumber"), (0x22, "s", "PartNumber"), (0x23, "B", "CoreCount"),
+        (0x24, "B", "EnabledCoreCount"), (0x25, "B", "ThreadCount")],
+    9: [(0x04, "s", "SlotDesignation"), (0x05, "B", "SlotType"), (0x06, "B", "SlotDataBusWidth"),
+        (0x07, "B", "CurrentUsage"), (0x0D, "H", "SegmentGroupNum"), (0x0F, "B", "BusNum"),
+        (0x10, "B", "DevFuncNum")],
+    17: [(0x10, "s", "DeviceLocator"), (0x11, "s", "BankLocator"), (0x12, "B", "MemoryType"),
+         (0x15, "H", "Speed"), (0x17, "s", "Manufacturer"), (0x18, "s", "SerialNumber"),
+         (0x1A, "s", "PartNumber"), (0x20, "H", "ConfiguredMemoryClockSpeed")],
+}
+
+# Structures of these types are matched between exports by these fields rather than by handles,
+# handles are not guaranteed to be stable across boots
+KEYS = {
+    0: [],
+    1: [],
+    2: [],
+    4: ["Socket"],
+    9: ["SlotDesignation"],
+    17: ["DeviceLocator", "BankLocator"],
+}
+
+TYPE_NAMES = {0: "BIOS", 1: "System", 2: "Baseboard", 4: "Processor", 9: "Slot", 17: "Memory Device"}
+
+
+def read_export(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < struct.calcsize(HEADER_FORMAT):
+        sys.exit(f"Error! {path} is too small")
+    (signature, version, major, minor, source, _, count,
+     table_offset, table_size, summary_offset, summary_size) = struct.unpack_from(HEADER_FORMAT, data, 0)
+    if signature != EXPORT_SIGNATURE:
+        sys.exit(f"Error! {path} is not an SMBIOS export")
+    if version != 1:
+        sys.exit(f"Error! Unsupported export version {version}")
+
+    return {
+        "version": f"{major}.{minor}",
+        "source": SOURCES.get(source, str(source)),
+        "count": count,
+        "structures": parse_table(data[table_offset:table_offset + table_size]),
+        "summary": data[summary_offset:summary_offset + summary_size].decode("ascii", "replace"),
+    }
+
+
+def parse_table(table):
+    structures = []
+    offset = 0
+    while offset + 4 <= len(table):
+        type, length, handle = struct.unpack_from("<BBH", table, offset)
+        if length < 4 or offset + length > len(table):
+            break
+        end = table.find(b"\0\0", offset + length)
+        if end < 0:
+            break
+        formatted = table[offset:offset + length]
+        strings = table[offset + length:end].split(b"\0") if end > offset + length else []
+        structures.append({
+            "type": type,
+            "handle": handle,
+            "formatted": formatted,
+            "strings": [s.decode("ascii", "replace") for s in strings],
+        })
+        offset = end + 2
+        if type == 127:
+            break
+    return structures
+
+
+def memory_size_mb(s):
+    formatted = s["formatted"]
+    if len(formatted) < 0x0E:
+        return 0
+    size = struct.unpack_from("<H", formatted, 0x0C)[0]
+    if size in (0, 0xFFFF):
+        return 0
+    if size == 0x7FFF:
+        return struct.unpack_from("<I", formatted, 0x1C)[0] & 0x7FFFFFFF if len(formatted) >= 0x20 else 0
+    if size & 0x8000:
+        return (size & 0x7FFF) // 1024
+    return size
+
+
+def decode(s):
+    fields = {}
+    formatted = s["formatted"]
+    for offset, kind, name in FIELDS[s["type"]]:
+        if kind == "s":
+            if offset >= len(formatted):
+                continue
+            number = formatted[offset]
+            fields[name] = s["strings"][number - 1] if 0 < number <= len(s["strings"]) else ""
+        else:
+            if offset + struct.calcsize(kind) > len(formatted):
+                continue
+            fields[name] = struct.unpack_from("<" + kind, formatted, offset)[0]
+    if s["type"] == 17:
+        fields["SizeMB"] = memory_size_mb(s)
+    return fields
+
+
+def inventory(export):
+    items = {}
+    for s in export["structures"]:
+        if s["type"] not in FIELDS:
+            continue
+        fields = decode(s)
+        key = (s["type"],) + tuple(fields.get(k, "") for k in KEYS[s["type"]])
+        # Keep duplicate keys apart (e.g. empty locators)
+        n = 0
+        while key + (n,) in items:
+            n += 1
+        items[key + (n,)] = fields
+    return items
+
+
+def key_name(key):
+    name = TYPE_NAMES[key[0]]
+    labels = [str(k) for k in key[1:-1] if k != ""]
+    if labels:
+        name += " " + "/".join(labels)
+    if key[-1]:
+        name += f" #{key[-1]}"
+    return name
+
+
+def show(export, raw):
+    print(f"SMBIOS {export['version']}, {export['count']} structures, read from {export['source']}")
+    if not raw and export["summary"]:
+        print(export["summary"], end="")
+        return
+    for key, fields in sorted(inventory(export).items()):
+        print(key_name(key))
+        for name, value in fields.items():
+            print(f"    {name}={value}")
+
+
+def diff(old, new):
+    old_items = inventory(old)
+    new_items = inventory(new)
+    changes = 0
+
+    if old["version"] != new["version"]:
+        print(f"~ SMBIOS version: {old['version']} -> {new['version']}")
+        changes += 1
+    for key in sorted(old_items.keys() | new_items.keys()):
+        if key not in new_items:
+            print(f"- {key_name(key)}")
+            changes += 1
+        elif key not in old_items:
+            print(f"+ {key_name(key)}")
+            changes += 1
+        else:
+            names = list(old_items[key]) + [n for n in new_items[key] if n not in old_items[key]]
+            for name in names:
+                old_value = old_items[key].get(name, "-")
+                new_value = new_items[key].get(name, "-")
+                if old_value != new_value:
+                    print(f"~ {key_name(key)}: {name}: {old_value} -> {new_value}")
+                    changes += 1
+
+    old_total = sum(f["SizeMB"] for k, f in old_items.items() if k[0] == 17)
+    new_total = sum(f["SizeMB"] for k, f in new_items.items() if k[0] == 17)
+    if old_total != new_total:
+        print(f"~ Total memory: {old_total} MB -> {new_total} MB")
+
+    if changes == 0:
+        print("No differences")
+    return changes
+
+
+def main():
+    parser = ArgumentParser(description="Show/compare SMBIOS exports created with 'SmbiosInfo.efi -o <file>'")
+    parser.add_argument("export", help="SMBIOS export file")
+    parser.add_argument("new_export", nargs="?", help="second SMBIOS export file to compare with the first one")
+    parser.add_argument("-r", "--raw", action="store_true", help="decode the structure table instead of printing the embedded summary")
+    parser.add_argument("-j", "--json", action="store_true", help="check that the embedded summary is valid JSON")
+    args = parser.parse_args()
+
+    export = read_export(args.export)
+    if args.json:
+        json.loads(export["summary"])
+    if args.new_export is None:
+        show(export, args.raw)
+        return 0
+
+    new_export = read_export(args.new_export)
+    return 1 if diff(export, new_export) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
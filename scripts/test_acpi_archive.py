@@ -0,0 +1,91 @@
+##
+# Copyright (c) 2024, Konstantin Aladyshev <aladyshev22@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+##
+
+# Round-trip test for acpi_archive.py: python3 -m unittest test_acpi_archive (from the scripts folder)
+
+import os
+import struct
+import tempfile
+import unittest
+
+from acpi_archive import (ARCHIVE_SIGNATURE, ENTRY_FORMAT, HEADER_FORMAT, extract_tables,
+                          oem_table_id_file_part, read_archive)
+
+
+def oem_id(text):
+    return struct.unpack("<Q", text.encode("ascii").ljust(8, b"\0"))[0]
+
+
+def build_archive(path, tables):
+    """tables: list of (signature, index, oem_table_id, data)"""
+    header_size = struct.calcsize(HEADER_FORMAT)
+    blob = b""
+    entries = b""
+    for address, (sig, index, oem, data) in enumerate(tables):
+        entries += struct.pack(ENTRY_FORMAT, sig.encode("ascii"), index, oem, 0x7F000000 + address * 0x1000,
+                               header_size + len(blob), len(data), 1)
+        blob += data
+    with open(path, "wb") as f:
+        f.write(struct.pack(HEADER_FORMAT, ARCHIVE_SIGNATURE, 1, len(tables), header_size + len(blob)))
+        f.write(blob)
+        f.write(entries)
+
+
+class OemTableIdFilePartTest(unittest.TestCase):
+    # Expected names follow GetTableFileName() in UefiLessonsPkg/AcpiInfo/AcpiInfo.c
+    def test_rule(self):
+        cases = {
+            "CpuSsdt": "CpuSsdt",
+            "ABC-": "ABC",
+            "CpuSsdt ": "CpuSsdt",
+            "A B.C   ": "A_B_C",
+            "Tpm2Tabl": "Tpm2Tabl",
+            "--x--": "__x",
+            "    ": "",
+        }
+        for text, expected in cases.items():
+            with self.subTest(text=text):
+                self.assertEqual(oem_table_id_file_part(oem_id(text)), expected)
+
+    def test_non_ascii(self):
+        raw = struct.unpack("<Q", b"AB\xe9CD\0\0\0")[0]
+        self.assertEqual(oem_table_id_file_part(raw), "AB_CD")
+
+
+class RoundTripTest(unittest.TestCase):
+    def test_extract(self):
+        tables = [
+            ("FACP", 0, oem_id("BOCHS   "), b"facp" * 8),
+            ("SSDT", 0, oem_id("ABC-"), b"ssdt0" * 5),
+            ("SSDT", 1, oem_id("A B.C   "), b"ssdt1" * 7),
+            ("SSDT", 2, oem_id("CpuSsdt "), b"ssdt2"),
+            ("FACS", 0, 0, b"facs" * 16),
+            ("FACS", 1, 0, b"facs"),
+        ]
+        expected_names = [
+            "FACP.aml",
+            "SSDT_0_ABC.aml",
+            "SSDT_1_A_B_C.aml",
+            "SSDT_2_CpuSsdt.aml",
+            "FACS.aml",
+            "FACS.aml",
+        ]
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "acpi.bin")
+            build_archive(path, tables)
+            parsed = read_archive(path)
+            self.assertEqual([t["file_name"] for t in parsed], expected_names)
+            self.assertEqual(parsed[3]["oem_table_id"], "CpuSsdt")
+
+            out_dir = os.path.join(tmp, "out")
+            extract_tables(parsed[:4], out_dir)
+            for (_, _, _, data), name in zip(tables[:4], expected_names[:4]):
+                with open(os.path.join(out_dir, name), "rb") as f:
+                    self.assertEqual(f.read(), data)
+
+
+if __name__ == "__main__":
+    unittest.main()